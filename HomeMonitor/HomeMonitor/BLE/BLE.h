@@ -41,6 +41,10 @@
 -(void) writeValue:(CBUUID *)serviceUUID characteristicUUID:(CBUUID *)characteristicUUID p:(CBPeripheral *)p data:(NSData *)data;
 
 -(BOOL) isConnected;
+-(UInt64) frameOverflowCount;
+-(UInt64) frameDroppedByteCount;
+-(BOOL) startCaptureToFile:(NSString *)path;
+-(void) stopCapture;
 -(void) write:(NSData *)d;
 -(void) readRSSI;
 
@@ -13,6 +13,16 @@
 
 #import "BLE.h"
 #import "BLEDefines.h"
+#import "HMOCapture.h"
+#import "HMOFrameAssembler.h"
+
+@interface BLE () {
+    HMOFrameAssembler frameAssembler;
+    HMOCaptureWriter captureWriter;
+    unsigned char recordBuffer[HMO_FRAME_ASSEMBLER_CAPACITY];
+}
+
+@end
 
 @implementation BLE
 
@@ -23,6 +33,48 @@
 
 static bool isConnected = false;
 static int rssi = 0;
+static const size_t flushLength = 64;
+
+-(id) init
+{
+    self = [super init];
+    
+    if (self)
+    {
+        HMOFrameAssemblerInit(&frameAssembler);
+    }
+    
+    return self;
+}
+
+-(UInt64) frameOverflowCount
+{
+    return frameAssembler.overflowCount;
+}
+
+-(UInt64) frameDroppedByteCount
+{
+    return frameAssembler.droppedByteCount;
+}
+
+// Records every notification payload with its receive time, for replaying the session with HMOReplay
+-(BOOL) startCaptureToFile:(NSString *)path
+{
+    [self stopCapture];
+    
+    return HMOCaptureWriterOpen(&captureWriter, [path fileSystemRepresentation]);
+}
+
+-(void) stopCapture
+{
+    if (!HMOCaptureWriterClose(&captureWriter))
+        NSLog(@"Capture could not be written completely");
+}
+
+-(void) dealloc
+{
+    [self stopCapture];
+}
 
 -(void) readRSSI
 {
@@ -203,6 +255,8 @@ static int rssi = 0;
 {
     done = false;
 
+    HMOFrameAssemblerInit(&frameAssembler);
+    
     [[self delegate] bleDidDisconnect];
     
     isConnected = false;
@@ -525,37 +579,29 @@ static bool done = false;
 
 - (void)peripheral:(CBPeripheral *)peripheral didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic error:(NSError *)error
 {
-    unsigned char data[20];
-    
-    static unsigned char buf[512];
-    static int len = 0;
-    NSInteger data_len;
-    
     if (!error)
     {
         if ([characteristic.UUID isEqual:[CBUUID UUIDWithString:@RBL_CHAR_TX_UUID]])
         {
-            data_len = characteristic.value.length;
-            [characteristic.value getBytes:data length:data_len];
+            NSData *value = characteristic.value;
             
-            if (data_len == 20)
-            {
-                memcpy(&buf[len], data, 20);
-                len += data_len;
-                
-                if (len >= 64)
-                {
-                    [[self delegate] bleDidReceiveData:buf length:len];
-                    len = 0;
-                }
-            }
-            else if (data_len < 20)
+            if (captureWriter.file != NULL)
+                HMOCaptureWriterAppend(&captureWriter, CFAbsoluteTimeGetCurrent(), [value bytes], [value length]);
+            
+            HMOFrameAssemblerAppend(&frameAssembler, [value bytes], [value length]);
+            
+            // A short notification marks the end of a batch, anything left over is a broken record
+            BOOL endOfBatch = ([value length] < 20);
+            
+            if (endOfBatch)
+                HMOFrameAssemblerDiscardPartialRecord(&frameAssembler);
+            
+            if (endOfBatch || HMOFrameAssemblerRecordBytes(&frameAssembler) >= flushLength)
             {
-                memcpy(&buf[len], data, data_len);
-                len += data_len;
+                size_t len = HMOFrameAssemblerReadRecords(&frameAssembler, recordBuffer, sizeof(recordBuffer));
                 
-                [[self delegate] bleDidReceiveData:buf length:len];
-                len = 0;
+                if (len > 0)
+                    [[self delegate] bleDidReceiveData:recordBuffer length:(int)len];
             }
         }
     }
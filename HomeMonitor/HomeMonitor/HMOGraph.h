@@ -9,15 +9,35 @@
 #import <Foundation/Foundation.h>
 #import <UIKit/UIKit.h>
 
+#import "LineGraphPlotSnapshot.h"
+
+
+/** Number of samples shown on the graph at once */
+extern const NSUInteger HMOGraphVisibleSampleCount;
 
 @interface HMOGraph : NSObject
 
 @property (nonatomic, strong, readonly) NSString *name;
-@property (nonatomic, strong, readonly) NSMutableArray *values;
 @property (nonatomic, assign, readonly) CGRect valueRange;
 @property (nonatomic, strong) UIColor *lineColor;
 
+/** Maximum number of samples kept in history */
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+/** Number of samples currently kept in history */
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/** Visible samples as CGPoints stored in NSValues, built on demand as a LineGraphPlotPoints.
+
+ x values count samples, relative to an origin that moves up every few million samples to keep them exact as floats.
+*/
+@property (nonatomic, strong, readonly) NSArray *values;
+
+/** Visible samples with their bounds, built on demand.  Bounds come from the running extrema, not a scan. */
+@property (nonatomic, strong, readonly) LineGraphPlotSnapshot *snapshot;
+
 - (instancetype)initWithName:(NSString *)name;
+- (instancetype)initWithName:(NSString *)name capacity:(NSUInteger)capacity;
 
 - (void)addValue:(Float32)value;
 
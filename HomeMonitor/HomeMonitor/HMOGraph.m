@@ -7,49 +7,163 @@
 //
 
 #import "HMOGraph.h"
+#import "HMOTimeSeries.h"
+#import "LineGraphPlotPoints.h"
+#import "LineGraphWindowExtrema.h"
+
+
+const NSUInteger HMOGraphVisibleSampleCount = 20;
+
+// One hour of 10 Hz readings
+static const NSUInteger HMOGraphDefaultCapacity = 36000;
+
+// Plotted x values are floats, which hold whole numbers exactly only up to 2^24, so they are rebased well before
+static const double HMOGraphMaximumPlotX = 4194304.0;
+
+
+@interface HMOGraph () {
+    HMOTimeSeries _series;
+    LineGraphWindowExtrema _visibleExtrema;
+    
+    // The extrema only hold samples from this x on, after a push into them failed
+    double _visibleExtremaStartX;
+    
+    // Sample indexes are kept as doubles, and plotted relative to this index
+    double _plotXOrigin;
+}
+
+@end
 
 
 @implementation HMOGraph
 
 - (instancetype)initWithName:(NSString *)name {
+    return [self initWithName:name capacity:HMOGraphDefaultCapacity];
+}
+
+- (instancetype)initWithName:(NSString *)name capacity:(NSUInteger)capacity {
     self = [super init];
     
     if (self) {
+        if (!HMOTimeSeriesInit(&_series, MAX(capacity, HMOGraphVisibleSampleCount))) {
+            return nil;
+        }
+        
+        LineGraphWindowExtremaInit(&_visibleExtrema);
+        
         _name = name;
-        _values = [[NSMutableArray alloc] init];
-        _valueRange = CGRectMake(0.0, 0.0, 20.0, 1.0);
+        _valueRange = CGRectMake(0.0, 0.0, HMOGraphVisibleSampleCount, 1.0);
         _lineColor = [UIColor blueColor];
     }
     
     return self;
 }
 
-- (void)addValue:(Float32)value {
-    CGPoint lastPoint = CGPointZero;
-    NSValue *lastPointValue = [_values lastObject];
+- (void)dealloc {
+    HMOTimeSeriesDestroy(&_series);
+    LineGraphWindowExtremaDestroy(&_visibleExtrema);
+}
+
+- (NSUInteger)capacity {
+    return _series.capacity;
+}
+
+- (NSUInteger)count {
+    return _series.count;
+}
+
+- (NSArray *)values {
+    NSUInteger count = MIN(_series.count, HMOGraphVisibleSampleCount);
+    const double *timestamps = HMOTimeSeriesTimestamps(&_series, count);
+    float *xValues = malloc(sizeof(float) * MAX(count, 1));
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        xValues[i] = timestamps[i] - _plotXOrigin;
+    }
     
-    if (lastPointValue) {
-        lastPoint = [lastPointValue CGPointValue];
+    // Values are handed to the graph view as columns, without boxing every sample
+    LineGraphPlotBuffer buffer = { xValues, HMOTimeSeriesValues(&_series, count), count, NULL, 0, 0 };
+    LineGraphPlotPoints *values = [[LineGraphPlotPoints alloc] initWithBuffer:&buffer];
+    
+    free(xValues);
+    
+    return values;
+}
+
+- (LineGraphPlotSnapshot *)snapshot {
+    LineGraphPlotPoints *values = (LineGraphPlotPoints *)self.values;
+    CGRect bounds = CGRectNull;
+    
+    if (values.count > 0) {
+        CGFloat xMin = values.xValues[0];
+        CGFloat xMax = values.xValues[values.count - 1];
+        CGFloat yMin, yMax;
+        
+        [self getVisibleMinimum:&yMin maximum:&yMax];
+        
+        bounds = CGRectMake(xMin, yMin, xMax - xMin, yMax - yMin);
     }
     
-    CGPoint newPoint = CGPointMake(lastPoint.x + 1.0, value);
+    return [[LineGraphPlotSnapshot alloc] initWithPoints:values bounds:bounds];
+}
 
-    [_values addObject:[NSValue valueWithCGPoint:newPoint]];
+/* Lowest and highest of the visible values.  These come from the sliding window extrema, unless a failed push
+ left the extrema short of the visible samples.
+*/
+- (void)getVisibleMinimum:(CGFloat *)yMin maximum:(CGFloat *)yMax {
+    NSUInteger count = MIN(_series.count, HMOGraphVisibleSampleCount);
     
-    if ([_values count] > 20) {
-        [_values removeObjectAtIndex:0];
+    if (count > 0 && *HMOTimeSeriesTimestamps(&_series, count) >= _visibleExtremaStartX && !LineGraphWindowExtremaIsEmpty(&_visibleExtrema)) {
+        *yMin = LineGraphWindowExtremaMin(&_visibleExtrema);
+        *yMax = LineGraphWindowExtremaMax(&_visibleExtrema);
+        return;
     }
+    
+    const float *values = HMOTimeSeriesValues(&_series, count);
+    float minimum = (count > 0) ? values[0] : 0.0f;
+    float maximum = minimum;
+    
+    for (NSUInteger i = 1; i < count; i++) {
+        minimum = fminf(minimum, values[i]);
+        maximum = fmaxf(maximum, values[i]);
+    }
+    
+    *yMin = minimum;
+    *yMax = maximum;
+}
 
-    if ([_values count] == 1) {
-        _valueRange.origin.y = newPoint.y;
+- (void)addValue:(Float32)value {
+    double lastX = 0.0;
+    
+    if (_series.count > 0) {
+        lastX = *HMOTimeSeriesTimestamps(&_series, 1);
+    }
+    
+    double newX = lastX + 1.0;
+    
+    HMOTimeSeriesAppend(&_series, newX, value);
+    
+    if (LineGraphWindowExtremaPush(&_visibleExtrema, newX, value)) {
+        LineGraphWindowExtremaEvictBefore(&_visibleExtrema, newX - HMOGraphVisibleSampleCount + 1);
     } else {
-        _valueRange.origin.y = fminf(_valueRange.origin.y, newPoint.y);
+        // Start the extrema over with the next sample, the visible values are scanned until they cover the window
+        LineGraphWindowExtremaRemoveAll(&_visibleExtrema);
+        _visibleExtremaStartX = newX + 1.0;
     }
     
-    CGFloat heightDelta = newPoint.y - _valueRange.origin.y;
-
-    _valueRange.origin.x = fmaxf(newPoint.x - 20.0, 0.0);
-    _valueRange.size.height = fmaxf(_valueRange.size.height, heightDelta);
+    // The graph view sees the x values jump back once, and redraws instead of scrolling
+    if (newX - _plotXOrigin > HMOGraphMaximumPlotX) {
+        _plotXOrigin = newX - HMOGraphVisibleSampleCount;
+    }
+    
+    CGFloat yMin, yMax;
+    
+    [self getVisibleMinimum:&yMin maximum:&yMax];
+    
+    // Keep a minimum height so a flat line does not collapse the range
+    _valueRange.origin.x = fmax(newX - _plotXOrigin - HMOGraphVisibleSampleCount, 0.0);
+    _valueRange.origin.y = yMin;
+    _valueRange.size.height = fmaxf(yMax - yMin, 1.0);
 }
 
 @end
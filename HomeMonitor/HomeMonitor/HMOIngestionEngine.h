@@ -0,0 +1,77 @@
+//
+//  HMOIngestionEngine.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "HMOGraph.h"
+#import "HMORecordDecoder.h"
+#import "LineGraphPlotPoints.h"
+#import "LineGraphPlotSnapshot.h"
+
+@class HMOIngestionEngine;
+
+/** Receives what the engine publishes, always on the main thread. */
+@protocol HMOIngestionEngineDelegate <NSObject>
+
+/** Pressure readings were added to the graph.
+
+ @param engine The engine publishing the update.
+ @param count Number of readings added since the previous update.
+ @param snapshot Visible samples of the graph.
+ @param valueRange Value range of the graph after the readings were added.
+*/
+- (void)ingestionEngine:(HMOIngestionEngine *)engine didAppendValueCount:(NSInteger)count snapshot:(LineGraphPlotSnapshot *)snapshot valueRange:(CGRect)valueRange;
+
+/** A temperature reading arrived, only the latest one of a batch is published. */
+- (void)ingestionEngine:(HMOIngestionEngine *)engine didUpdateTemperature:(float)temperature;
+
+@end
+
+/**
+ Turns raw sensor records into graph snapshots away from the main thread.
+
+ Records are decoded on the thread that receives them and handed to the engine's serial queue through a
+ lock-free ring.  The queue owns the graph, its history and range calculations, and publishes immutable
+ snapshots, so the main thread only lays out and animates.
+
+ Every reading is also appended to a per-sensor HMOSensorLog, and the graph starts out with the logged history.
+*/
+@interface HMOIngestionEngine : NSObject
+
+@property (nonatomic, weak) id<HMOIngestionEngineDelegate> delegate;
+
+/** Number of records dropped because the engine queue fell behind */
+@property (nonatomic, readonly) NSUInteger droppedRecordCount;
+
+/** Creates an engine adding pressure readings to graph, after loading the logged ones.  The graph is modified on
+ the engine queue from then on, and must not be modified elsewhere.
+
+ @param placeholderValues Values filling the graph if nothing was logged yet, so it does not start out empty.
+ They are not logged.
+*/
+- (instancetype)initWithGraph:(HMOGraph *)graph placeholderValues:(NSArray *)placeholderValues;
+
+/** Decodes whole records and queues them for the engine.  Must always be called from the same thread. */
+- (void)receiveRecordBytes:(const uint8_t *)bytes length:(size_t)length;
+
+/** Summarizes the logged readings of a type in [startTime, endTime), in buckets of bucketWidth seconds.
+
+ The summaries are answered from minute, hour and day rollups kept as readings arrive, reading samples only
+ for the parts of buckets that do not line up with them.
+
+ @param completion Called on the main thread with the mean of every bucket, x values in seconds from startTime
+ and gaps for buckets without readings, and the range spanning the bucket minimums and maximums.  The range is
+ CGRectNull if there were no readings.
+*/
+- (void)summarizeRecordType:(HMORecordType)type
+                   fromTime:(CFAbsoluteTime)startTime
+                     toTime:(CFAbsoluteTime)endTime
+                bucketWidth:(NSTimeInterval)bucketWidth
+                 completion:(void (^)(LineGraphPlotPoints *means, CGRect valueRange))completion;
+
+@end
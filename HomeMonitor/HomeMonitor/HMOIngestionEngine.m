@@ -0,0 +1,353 @@
+//
+//  HMOIngestionEngine.m
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#import "HMOIngestionEngine.h"
+#import "HMORecordDecoder.h"
+#import "HMORecordRing.h"
+#import "HMOSensorLog.h"
+#import "HMOSeriesRollup.h"
+
+
+// Records held between the receiving thread and the engine queue, a few seconds' worth at full rate
+static const size_t HMOIngestionRecordRingCapacity = 4096;
+
+static NSString *const HMOIngestionLogDirectoryName = @"SensorLogs";
+
+
+@interface HMOIngestionEngine () {
+    HMORecordRing _recordRing;
+    dispatch_queue_t _queue;
+    dispatch_source_t _recordSource;
+    
+    // Indexed by record type, logs that failed to open have a negative fd and ignore appends
+    HMOSensorLog _logs[kHMORecordTypeCount];
+    HMOSeriesRollup _rollups[kHMORecordTypeCount];
+    BOOL _logFailureReported;
+}
+
+@property (nonatomic, strong) HMOGraph *graph;
+
+- (void)openLogs;
+- (void)loadGraphHistory;
+- (void)rebuildRollups;
+- (void)drainRecords;
+- (void)didEnterBackground:(NSNotification *)notification;
+
+@end
+
+
+@implementation HMOIngestionEngine
+
+- (instancetype)initWithGraph:(HMOGraph *)graph placeholderValues:(NSArray *)placeholderValues {
+    self = [super init];
+    
+    if (self) {
+        for (NSInteger type = 0; type < kHMORecordTypeCount; type++) {
+            _logs[type].fd = -1;
+            HMOSeriesRollupInit(&_rollups[type], &_logs[type]);
+        }
+        
+        if (!HMORecordRingInit(&_recordRing, HMOIngestionRecordRingCapacity)) {
+            return nil;
+        }
+        
+        _graph = graph;
+        _queue = dispatch_queue_create("com.hipo.HomeMonitor.ingestion", DISPATCH_QUEUE_SERIAL);
+        
+        // Nothing else can reach the logs or the graph until the first record arrives
+        [self openLogs];
+        [self loadGraphHistory];
+        
+        if (_graph.count == 0) {
+            for (NSNumber *value in placeholderValues) {
+                [_graph addValue:value.floatValue];
+            }
+        }
+        
+        // Summarizing the whole history takes a while, queries and new records wait behind it on the queue
+        dispatch_async(_queue, ^{
+            [self rebuildRollups];
+        });
+        
+        // Wake ups arriving while the queue is busy are coalesced into one more drain
+        _recordSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, _queue);
+        
+        __weak HMOIngestionEngine *weakSelf = self;
+        
+        dispatch_source_set_event_handler(_recordSource, ^{
+            [weakSelf drainRecords];
+        });
+        
+        dispatch_resume(_recordSource);
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(didEnterBackground:)
+                                                     name:UIApplicationDidEnterBackgroundNotification
+                                                   object:nil];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    
+    if (_recordSource != nil) {
+        dispatch_source_cancel(_recordSource);
+    }
+    
+    for (NSInteger type = 0; type < kHMORecordTypeCount; type++) {
+        HMOSeriesRollupDestroy(&_rollups[type]);
+        HMOSensorLogClose(&_logs[type]);
+    }
+    
+    HMORecordRingDestroy(&_recordRing);
+}
+
+/* Opens a log per record type in Application Support.  A log that can not be opened only loses history,
+ ingestion carries on without it.
+*/
+- (void)openLogs {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSError *error = nil;
+    NSURL *supportURL = [fileManager URLForDirectory:NSApplicationSupportDirectory
+                                            inDomain:NSUserDomainMask
+                                   appropriateForURL:nil
+                                              create:YES
+                                               error:&error];
+    NSURL *directoryURL = [supportURL URLByAppendingPathComponent:HMOIngestionLogDirectoryName isDirectory:YES];
+    
+    if (directoryURL == nil || ![fileManager createDirectoryAtURL:directoryURL withIntermediateDirectories:YES attributes:nil error:&error]) {
+        NSLog(@"Sensor logs are disabled, the log directory could not be created: %@", error);
+        return;
+    }
+    
+    NSDictionary *fileNames = @{ @(kHMORecordTypeTemperature): @"temperature.log",
+                                 @(kHMORecordTypePressure): @"pressure.log",
+                                 @(kHMORecordTypeAltitude): @"altitude.log" };
+    
+    [fileNames enumerateKeysAndObjectsUsingBlock:^(NSNumber *type, NSString *fileName, BOOL *stop) {
+        NSURL *fileURL = [directoryURL URLByAppendingPathComponent:fileName isDirectory:NO];
+        HMOSensorLog *log = &_logs[type.integerValue];
+        
+        if (!HMOSensorLogOpen(log, fileURL.fileSystemRepresentation)) {
+            NSLog(@"Sensor log %@ could not be opened", fileName);
+        } else if (log->discardedSegmentCount > 0) {
+            NSLog(@"Sensor log %@ dropped %zu damaged segments", fileName, log->discardedSegmentCount);
+        }
+    }];
+}
+
+/* Fills the graph with the newest logged pressure readings, so it picks up where the last run left off.
+*/
+- (void)loadGraphHistory {
+    size_t capacity = HMOGraphVisibleSampleCount;
+    double *timestamps = malloc(sizeof(double) * capacity);
+    float *values = malloc(sizeof(float) * capacity);
+    
+    if (timestamps != NULL && values != NULL) {
+        size_t count = HMOSensorLogReadLatest(&_logs[kHMORecordTypePressure], capacity, timestamps, values);
+        
+        for (size_t i = 0; i < count; i++) {
+            [_graph addValue:values[i]];
+        }
+    }
+    
+    free(timestamps);
+    free(values);
+}
+
+/* Summarizes the logged history of every record type.  Runs on the engine queue.
+*/
+- (void)rebuildRollups {
+    for (NSInteger type = 0; type < kHMORecordTypeCount; type++) {
+        if (_logs[type].fd >= 0 && !HMOSeriesRollupRebuild(&_rollups[type])) {
+            NSLog(@"Sensor history could not be summarized");
+        }
+    }
+}
+
+- (void)summarizeRecordType:(HMORecordType)type
+                   fromTime:(CFAbsoluteTime)startTime
+                     toTime:(CFAbsoluteTime)endTime
+                bucketWidth:(NSTimeInterval)bucketWidth
+                 completion:(void (^)(LineGraphPlotPoints *, CGRect))completion {
+    NSParameterAssert(type > kHMORecordTypeUnknown && type < kHMORecordTypeCount);
+    
+    dispatch_async(_queue, ^{
+        size_t capacity = (bucketWidth > 0.0 && endTime > startTime) ? (size_t)ceil((endTime - startTime) / bucketWidth) : 0;
+        size_t count = 0;
+        uint8_t *bytes = malloc(MAX(capacity, 1) * (sizeof(double) + sizeof(size_t) + sizeof(float) * 5 + sizeof(uint32_t)));
+        
+        if (bytes == NULL) {
+            capacity = 0;
+        }
+        
+        // One allocation for the query columns and the plot buffer, widest types first to keep them aligned
+        double *startTimes = (double *)bytes;
+        size_t *gapIndexes = (size_t *)(startTimes + capacity);
+        float *minValues = (float *)(gapIndexes + capacity);
+        float *maxValues = minValues + capacity;
+        float *meanValues = maxValues + capacity;
+        float *xValues = meanValues + capacity;
+        float *yValues = xValues + capacity;
+        uint32_t *counts = (uint32_t *)(yValues + capacity);
+        
+        HMOSeriesSummaryColumns columns = { startTimes, minValues, maxValues, meanValues, counts, capacity };
+        
+        if (capacity > 0) {
+            count = HMOSeriesRollupQuery(&_rollups[type], startTime, endTime, bucketWidth, &columns);
+        }
+        
+        // Empty buckets become gaps in the line, and are left out of the range
+        CGFloat yMin = CGFLOAT_MAX, yMax = -CGFLOAT_MAX;
+        size_t pointCount = 0, gapCount = 0;
+        
+        for (size_t i = 0; i < count; i++) {
+            if (counts[i] == 0) {
+                if (pointCount > 0 && (gapCount == 0 || gapIndexes[gapCount - 1] != pointCount)) {
+                    gapIndexes[gapCount++] = pointCount;
+                }
+                
+                continue;
+            }
+            
+            xValues[pointCount] = startTimes[i] - startTime;
+            yValues[pointCount] = meanValues[i];
+            pointCount++;
+            
+            yMin = MIN(yMin, minValues[i]);
+            yMax = MAX(yMax, maxValues[i]);
+        }
+        
+        if (gapCount > 0 && gapIndexes[gapCount - 1] == pointCount) {
+            gapCount--;
+        }
+        
+        LineGraphPlotBuffer buffer = { xValues, yValues, pointCount, gapIndexes, gapCount, 0 };
+        LineGraphPlotPoints *points = [[LineGraphPlotPoints alloc] initWithBuffer:&buffer];
+        CGRect valueRange = CGRectMake(0.0, yMin, endTime - startTime, MAX(yMax - yMin, 1.0));
+        
+        if (pointCount == 0) {
+            valueRange = CGRectNull;
+        }
+        
+        free(bytes);
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(points, valueRange);
+        });
+    });
+}
+
+- (NSUInteger)droppedRecordCount {
+    return HMORecordRingDroppedCount(&_recordRing);
+}
+
+- (void)receiveRecordBytes:(const uint8_t *)bytes length:(size_t)length {
+    uint8_t types[HMO_RECORD_BATCH_CAPACITY];
+    double timestamps[HMO_RECORD_BATCH_CAPACITY];
+    float values[HMO_RECORD_BATCH_CAPACITY];
+    
+    HMORecordColumns columns = { types, timestamps, values, HMO_RECORD_BATCH_CAPACITY };
+    CFAbsoluteTime receiveTime = CFAbsoluteTimeGetCurrent();
+    size_t pushedCount = 0;
+    
+    for (size_t offset = 0; offset < length; offset += HMO_RECORD_BATCH_CAPACITY * HMO_RECORD_LENGTH) {
+        size_t count = HMORecordDecode(bytes + offset, length - offset, receiveTime, &columns);
+        
+        pushedCount += HMORecordRingPush(&_recordRing, &columns, count);
+    }
+    
+    if (pushedCount > 0) {
+        dispatch_source_merge_data(_recordSource, 1);
+    }
+}
+
+/* Applies the records waiting in the ring to the graph and publishes the result.  Runs on the engine queue.
+*/
+- (void)drainRecords {
+    uint8_t types[HMO_RECORD_BATCH_CAPACITY];
+    double timestamps[HMO_RECORD_BATCH_CAPACITY];
+    float values[HMO_RECORD_BATCH_CAPACITY];
+    
+    HMORecordColumns columns = { types, timestamps, values, HMO_RECORD_BATCH_CAPACITY };
+    
+    BOOL hasTemperature = NO;
+    float temperature = 0.0;
+    NSInteger pressureCount = 0;
+    size_t count;
+    
+    while ((count = HMORecordRingPop(&_recordRing, &columns)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            HMOSensorLog *log = &_logs[types[i]];
+            
+            if (log->fd >= 0) {
+                if (HMOSensorLogAppend(log, timestamps[i], values[i])) {
+                    HMOSeriesRollupAppend(&_rollups[types[i]], HMOSensorLogLastTimestamp(log), values[i]);
+                } else if (!_logFailureReported) {
+                    NSLog(@"Sensor log rejected a reading, it is out of order or could not be written");
+                    _logFailureReported = YES;
+                }
+            }
+            
+            if (types[i] == kHMORecordTypePressure) {
+                [_graph addValue:values[i]];
+                pressureCount++;
+            } else if (types[i] == kHMORecordTypeTemperature) {
+                temperature = values[i];
+                hasTemperature = YES;
+            }
+        }
+    }
+    
+    if (pressureCount == 0 && !hasTemperature) {
+        return;
+    }
+    
+    LineGraphPlotSnapshot *snapshot = (pressureCount > 0) ? _graph.snapshot : nil;
+    CGRect valueRange = _graph.valueRange;
+    
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (hasTemperature) {
+            [self.delegate ingestionEngine:self didUpdateTemperature:temperature];
+        }
+        
+        if (snapshot != nil) {
+            [self.delegate ingestionEngine:self didAppendValueCount:pressureCount snapshot:snapshot valueRange:valueRange];
+        }
+    });
+}
+
+/* Commits buffered readings while the app can still run, it may be terminated without further notice.
+*/
+- (void)didEnterBackground:(NSNotification *)notification {
+    UIApplication *application = [UIApplication sharedApplication];
+    __block UIBackgroundTaskIdentifier taskIdentifier = UIBackgroundTaskInvalid;
+    
+    taskIdentifier = [application beginBackgroundTaskWithExpirationHandler:^{
+        [application endBackgroundTask:taskIdentifier];
+        taskIdentifier = UIBackgroundTaskInvalid;
+    }];
+    
+    dispatch_async(_queue, ^{
+        for (NSInteger type = 0; type < kHMORecordTypeCount; type++) {
+            if (_logs[type].fd >= 0 && !HMOSensorLogSync(&_logs[type])) {
+                NSLog(@"Sensor log could not be synced");
+            }
+        }
+        
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if (taskIdentifier != UIBackgroundTaskInvalid) {
+                [application endBackgroundTask:taskIdentifier];
+                taskIdentifier = UIBackgroundTaskInvalid;
+            }
+        });
+    });
+}
+
+@end
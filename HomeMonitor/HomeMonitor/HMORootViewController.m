@@ -7,30 +7,38 @@
 //
 
 #import "BLE.h"
+#import "LineGraphAutoTickInterval.h"
 #import "LineGraphAxisAnimatorTranslate.h"
-#import "LineGraphPlotAnimation.h"
+#import "LineGraphUpdateScheduler.h"
 #import "LineGraphView.h"
 #import "PureLayout.h"
 
 #import "HMOGraph.h"
+#import "HMOIngestionEngine.h"
 #import "HMORootViewController.h"
+#import "HMOSensorSimulator.h"
+#import "HMOSimulator.h"
 
 #import "UIColor+HMOColorAdditions.h"
 
 
 @interface HMORootViewController ()
-<BLEDelegate, LineGraphViewDataSource, LineGraphViewDelegate>
+<BLEDelegate, HMOIngestionEngineDelegate, LineGraphViewDataSource, LineGraphViewDelegate>
 
 @property (nonatomic, strong) BLE *bleController;
+@property (nonatomic, strong) HMOSensorSimulator *sensorSimulator;
 @property (nonatomic, strong) UIButton *connectButton;
 @property (nonatomic, strong) LineGraphView *graphView;
+@property (nonatomic, strong) LineGraphUpdateScheduler *updateScheduler;
 @property (nonatomic, strong) HMOGraph *graph;
+@property (nonatomic, strong) HMOIngestionEngine *ingestionEngine;
+@property (nonatomic, strong) LineGraphPlotSnapshot *graphSnapshot;
+@property (nonatomic, assign) CGRect graphValueRange;
+@property (nonatomic, strong) LineGraphAutoTickInterval *pressureTickInterval;
 @property (nonatomic, strong) UILabel *temperatureLabel;
 
 - (void)didTapConnectButton:(id)sender;
 
-- (void)updateGraph;
-
 @end
 
 
@@ -49,9 +57,37 @@
         
         [_graph setLineColor:[UIColor graphColor]];
         
+        _pressureTickInterval = [LineGraphAutoTickInterval autoTickInterval];
+        
+        // Shown only if there is no logged history yet
+        NSMutableArray *placeholderValues = [NSMutableArray array];
+        HMOSimulatorOptions options;
+        HMOSimulatorSignal signal;
+        
+        HMOSimulatorOptionsInit(&options);
+        HMOSimulatorSignalInit(&signal, &options.models[kHMORecordTypePressure], arc4random());
+        
         for (NSInteger i = 0; i < 22; i++) {
-            [_graph addValue:99700 + (arc4random_uniform(20) - 10)];
+            [placeholderValues addObject:@(lroundf(HMOSimulatorSignalSample(&signal, i / options.rates[kHMORecordTypePressure])))];
         }
+        
+        // The graph is only modified by the engine from here on, the view reads the snapshots it publishes.
+        // The engine fills it with logged history or the placeholders, and receives nothing before the BLE delegate is called.
+        _ingestionEngine = [[HMOIngestionEngine alloc] initWithGraph:_graph placeholderValues:placeholderValues];
+        
+        [_ingestionEngine setDelegate:self];
+        
+        // Read before any records can reach the engine queue
+        _graphSnapshot = _graph.snapshot;
+        _graphValueRange = _graph.valueRange;
+        
+#if TARGET_IPHONE_SIMULATOR
+        // There is no Bluetooth in the iOS Simulator, a simulated board feeds the engine instead
+        _sensorSimulator = [[HMOSensorSimulator alloc] init];
+        
+        [_sensorSimulator setDelegate:self];
+        [_sensorSimulator start];
+#endif
     }
     
     return self;
@@ -98,9 +134,12 @@
     [_graphView setGraphInsets:UIEdgeInsetsZero];
     [_graphView setAnimationDuration:0.2];
     [_graphView setXAxisPosition:kLineGraphAxisPositionNone];
-    [_graphView setYAxisPosition:kLineGraphAxisPositionNone];
+    [_graphView setYAxisPosition:kLineGraphAxisPositionRight];
+    [_graphView setLabelFont:[UIFont fontWithName:@"AzoSans-Regular" size:11.0]];
     [_graphView setAxisColor:[UIColor blackColor]];
     [_graphView setTickLength:1];
+    [_graphView setStreaming:YES];
+    [_graphView setStreamingTileWidth:HMOGraphVisibleSampleCount / 4.0];
     
     [self.view addSubview:_graphView];
     
@@ -109,7 +148,15 @@
     [_graphView autoSetDimension:ALDimensionHeight toSize:200.0];
     [_graphView autoPinEdge:ALEdgeTop toEdge:ALEdgeBottom ofView:pressureSeparatorView withOffset:20.0];
     
-    [_graphView setValueRange:_graph.valueRange];
+    [_graphView setValueRange:_graphValueRange];
+    
+    __weak HMORootViewController *weakSelf = self;
+    
+    _updateScheduler = [[LineGraphUpdateScheduler alloc] initWithGraphView:_graphView];
+    
+    [_updateScheduler setUpdateBlock:^(LineGraphView *graphView) {
+        [graphView setValueRange:weakSelf.graphValueRange];
+    }];
     
     UILabel *temperatureTitleLabel = [[UILabel alloc] initForAutoLayout];
     
@@ -228,7 +275,11 @@
 }
 
 - (NSArray *)lineGraphView:(LineGraphView *)lineGraphView plotPointsForPlot:(NSUInteger)plot {
-    return _graph.values;
+    return _graphSnapshot.points;
+}
+
+- (LineGraphPlotSnapshot *)lineGraphView:(LineGraphView *)lineGraphView snapshotForPlot:(NSUInteger)plot {
+    return _graphSnapshot;
 }
 
 - (UIColor *)lineGraphView:(LineGraphView *)lineGraphView lineColorForPlot:(NSUInteger)plot {
@@ -243,6 +294,10 @@
     return @[@(1)];
 }
 
+- (LineGraphTickInterval *)yAxisTickIntervalInLineGraphView:(LineGraphView *)lineGraphView {
+    return _pressureTickInterval;
+}
+
 #pragma mark - Bluetooth LE delegate
 
 - (void)bleDidConnect {
@@ -256,44 +311,24 @@
 }
 
 - (void)bleDidReceiveData:(unsigned char *)data length:(int)length {
-    NSLog(@"Length: %d", length);
-    
-    // parse data, all commands are in 5-byte
-    for (int i = 0; i < length; i += 5) {
-        Float32 readingValue = data[i + 1] << 24 | data[i + 2] << 16 | data[i + 3] << 8 | data[i + 4];
-
-        if (data[i] == 0x0A) {
-            [_temperatureLabel setText:[NSString stringWithFormat:@"%1.1f", readingValue]];
-            NSLog(@"TEMPERATURE: %1.2f Celcius", readingValue);
-        } else if (data[i] == 0x0B) {
-            [_graph addValue:readingValue];
-            NSLog(@"PRESSURE: %1.2f Pa", readingValue);
-        } else if (data[i] == 0x0C) {
-            NSLog(@"ALTITUDE: %1.2fm", readingValue);
-        }
-    }
-    
-    dispatch_async(dispatch_get_main_queue(), ^{
-        [self updateGraph];
-    });
+    [_ingestionEngine receiveRecordBytes:data length:length];
 }
 
 - (void)bleDidUpdateRSSI:(NSNumber *)rssi {
     NSLog(@">>> RSSI: %@", rssi);
 }
 
-#pragma mark - Graph updates
+#pragma mark - Ingestion engine delegate
 
-- (void)updateGraph {
-    [_graphView beginUpdates];
-    
-    [_graphView insertPointsAtIndexPath:[NSIndexPath indexPathForRow:[_graph.values count] - 1 inSection:0]
-                                  count:1
-                               animator:[LineGraphPlotAnimation animationOfType:kLineGraphAnimationStroke]];
-    
-    [_graphView setValueRange:_graph.valueRange];
+- (void)ingestionEngine:(HMOIngestionEngine *)engine didAppendValueCount:(NSInteger)count snapshot:(LineGraphPlotSnapshot *)snapshot valueRange:(CGRect)valueRange {
+    _graphSnapshot = snapshot;
+    _graphValueRange = valueRange;
     
-    [_graphView endUpdates];
+    [_updateScheduler appendPointsToPlot:0 count:count];
+}
+
+- (void)ingestionEngine:(HMOIngestionEngine *)engine didUpdateTemperature:(float)temperature {
+    [_temperatureLabel setText:[NSString stringWithFormat:@"%1.1f", temperature]];
 }
 
 @end
@@ -0,0 +1,39 @@
+//
+//  HMOSensorSimulator.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "BLE.h"
+#import "HMOSimulator.h"
+
+/**
+ Stands in for BLE where there is no sensor board, such as in the iOS Simulator.
+
+ Notifications come from an HMOSimulator as they fall due and go through the same frame assembly and batching
+ rules as BLE, so the delegate receives whole records through bleDidReceiveData:length: exactly as it would
+ from a board.  Delivery happens on the main thread.
+*/
+@interface HMOSensorSimulator : NSObject
+
+@property (nonatomic, weak) id<BLEDelegate> delegate;
+
+@property (nonatomic, readonly, getter=isRunning) BOOL running;
+
+/** Number of records dropped because the frame assembler was full */
+@property (nonatomic, readonly) UInt64 frameOverflowCount;
+
+/** Creates a simulator for one board with the default rates and link faults of HMOSimulatorOptionsInit. */
+- (instancetype)init;
+
+/** Creates a simulator with the given options.  The start time is ignored, simulated time starts at zero. */
+- (instancetype)initWithOptions:(const HMOSimulatorOptions *)options;
+
+/** Starts or resumes delivering notifications, simulated time does not pass while stopped. */
+- (void)start;
+- (void)stop;
+
+@end
@@ -0,0 +1,171 @@
+//
+//  HMOSensorSimulator.m
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#import <QuartzCore/QuartzCore.h>
+
+#import "HMOFrameAssembler.h"
+#import "HMOSensorSimulator.h"
+
+
+// How often due notifications are delivered, several batches of a fast board arrive together like on a busy link
+static const NSTimeInterval HMOSensorSimulatorTickInterval = 0.05;
+
+// Same batching rules as BLE
+static const size_t HMOSensorSimulatorFullNotificationLength = 20;
+static const size_t HMOSensorSimulatorFlushLength = 64;
+
+
+@interface HMOSensorSimulator () {
+    HMOSimulator _simulator;
+    HMOFrameAssembler _frameAssembler;
+    unsigned char _recordBuffer[HMO_FRAME_ASSEMBLER_CAPACITY];
+    
+    // The first notification that was not due yet at the last tick
+    HMOCaptureNotification _pendingNotification;
+    BOOL _hasPendingNotification;
+    BOOL _isFinished;
+    
+    dispatch_source_t _timer;
+    CFTimeInterval _startTime;
+    NSTimeInterval _elapsedTime;
+}
+
+@property (nonatomic, readwrite, getter=isRunning) BOOL running;
+
+- (void)deliverDueNotifications;
+- (void)receiveNotification:(const HMOCaptureNotification *)notification;
+
+@end
+
+
+@implementation HMOSensorSimulator
+
+- (instancetype)init {
+    HMOSimulatorOptions options;
+    
+    HMOSimulatorOptionsInit(&options);
+    
+    return [self initWithOptions:&options];
+}
+
+- (instancetype)initWithOptions:(const HMOSimulatorOptions *)options {
+    self = [super init];
+    
+    if (self) {
+        HMOSimulatorOptions simulatorOptions = *options;
+        
+        simulatorOptions.startTime = 0.0;
+        
+        if (!HMOSimulatorInit(&_simulator, &simulatorOptions)) {
+            return nil;
+        }
+        
+        HMOFrameAssemblerInit(&_frameAssembler);
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    if (_timer != nil) {
+        dispatch_source_cancel(_timer);
+    }
+    
+    HMOSimulatorDestroy(&_simulator);
+}
+
+- (UInt64)frameOverflowCount {
+    return _frameAssembler.overflowCount;
+}
+
+- (void)start {
+    if (_running) {
+        return;
+    }
+    
+    [self setRunning:YES];
+    
+    _startTime = CACurrentMediaTime() - _elapsedTime;
+    _timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    
+    uint64_t interval = (uint64_t)(HMOSensorSimulatorTickInterval * NSEC_PER_SEC);
+    
+    dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 10);
+    
+    __weak HMOSensorSimulator *weakSelf = self;
+    
+    dispatch_source_set_event_handler(_timer, ^{
+        [weakSelf deliverDueNotifications];
+    });
+    
+    dispatch_resume(_timer);
+}
+
+- (void)stop {
+    if (!_running) {
+        return;
+    }
+    
+    [self setRunning:NO];
+    
+    _elapsedTime = CACurrentMediaTime() - _startTime;
+    
+    dispatch_source_cancel(_timer);
+    _timer = nil;
+}
+
+/* Hands the delegate every notification whose receive time has passed, and stops once the simulator runs out.
+*/
+- (void)deliverDueNotifications {
+    NSTimeInterval simulatedTime = CACurrentMediaTime() - _startTime;
+    
+    while (!_isFinished) {
+        if (!_hasPendingNotification) {
+            _hasPendingNotification = HMOSimulatorNext(&_simulator, &_pendingNotification);
+            
+            if (!_hasPendingNotification) {
+                _isFinished = YES;
+                break;
+            }
+        }
+        
+        if (_pendingNotification.receiveTime > simulatedTime) {
+            break;
+        }
+        
+        _hasPendingNotification = NO;
+        
+        [self receiveNotification:&_pendingNotification];
+    }
+    
+    if (_isFinished) {
+        [self stop];
+    }
+}
+
+/* Does what BLE does with a notification of the TX characteristic.
+*/
+- (void)receiveNotification:(const HMOCaptureNotification *)notification {
+    HMOFrameAssemblerAppend(&_frameAssembler, notification->bytes, notification->length);
+    
+    // A short notification marks the end of a batch, anything left over is a broken record
+    BOOL endOfBatch = (notification->length < HMOSensorSimulatorFullNotificationLength);
+    
+    if (endOfBatch) {
+        HMOFrameAssemblerDiscardPartialRecord(&_frameAssembler);
+    }
+    
+    if (endOfBatch || HMOFrameAssemblerRecordBytes(&_frameAssembler) >= HMOSensorSimulatorFlushLength) {
+        size_t length = HMOFrameAssemblerReadRecords(&_frameAssembler, _recordBuffer, sizeof(_recordBuffer));
+        
+        if (length > 0) {
+            [_delegate bleDidReceiveData:_recordBuffer length:(int)length];
+        }
+    }
+}
+
+@end
@@ -0,0 +1,36 @@
+//
+//  LineGraphAutoTickInterval.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphTickInterval.h"
+
+/**
+ Tick interval that picks 1, 2 or 5 times a power of ten to suit the length of the axis.
+
+ Return one from yAxisTickIntervalInLineGraphView: or xAxisTickIntervalInLineGraphView: and keep returning the
+ same object, LineGraphView updates it before every layout.  The interval only changes once tick spacing moves
+ past its limits by the hysteresis fraction, so a range that moves with every sample keeps its ticks.
+*/
+@interface LineGraphAutoTickInterval : LineGraphTickInterval
+
+/** Smallest distance between ticks, in points.  Defaults to 40. */
+@property (nonatomic) CGFloat minimumSpacing;
+
+/** Fraction of minimumSpacing the spacing has to move past before the interval changes.  Defaults to 0.25. */
+@property (nonatomic) CGFloat hysteresis;
+
++ (LineGraphAutoTickInterval *)autoTickInterval;
+
+/** Chooses the interval for a range shown over the given length of axis.
+
+ @param start Start of the range.
+ @param end End of the range.
+ @param length Length of the axis, in points.
+ @param labelLength Length of the widest label along the axis, ticks are spaced far enough to fit it.
+*/
+- (void)updateForStart:(CGFloat)start end:(CGFloat)end length:(CGFloat)length labelLength:(CGFloat)labelLength;
+
+@end
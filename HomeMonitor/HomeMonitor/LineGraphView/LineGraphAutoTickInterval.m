@@ -0,0 +1,72 @@
+//
+//  LineGraphAutoTickInterval.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphAutoTickInterval.h"
+#import "LineGraphTickGenerator.h"
+
+// Space kept between neighbouring labels
+static const CGFloat LineGraphAutoTickLabelPadding = 8.f;
+
+@interface LineGraphAutoTickInterval () {
+    LineGraphDecimal _step;
+}
+
+@end
+
+@implementation LineGraphAutoTickInterval
+
++ (LineGraphAutoTickInterval *)autoTickInterval {
+    return [[LineGraphAutoTickInterval alloc] initWithInterval:nil offset:[NSDecimalNumber zero] scale:NSDecimalNoScale];
+}
+
+- (id)initWithInterval:(NSDecimalNumber *)interval offset:(NSDecimalNumber *)offset scale:(short)scale {
+    self = [super initWithInterval:interval offset:offset scale:scale];
+    
+    if (self) {
+        _minimumSpacing = 40.f;
+        _hysteresis = 0.25f;
+    }
+    
+    return self;
+}
+
+- (void)updateForStart:(CGFloat)start end:(CGFloat)end length:(CGFloat)length labelLength:(CGFloat)labelLength {
+    double range = end - start;
+    
+    if (!(range > 0) || !(length > 0)) {
+        return;
+    }
+    
+    double spacing = MAX(self.minimumSpacing, labelLength + LineGraphAutoTickLabelPadding);
+    double pointsPerUnit = length / range;
+    LineGraphDecimal step = _step;
+    
+    if (self.interval == nil) {
+        step = LineGraphNiceStep(spacing / pointsPerUnit);
+    } else if (self.interval.doubleValue * pointsPerUnit < spacing * (1.0 - self.hysteresis)) {
+        // Ticks are too close together
+        step = LineGraphNiceStep(spacing / pointsPerUnit);
+    } else {
+        LineGraphDecimal smallerStep = LineGraphNiceStepBelow(_step);
+        
+        // The next smaller interval would fit comfortably
+        if ([self decimalNumberForStep:smallerStep].doubleValue * pointsPerUnit >= spacing * (1.0 + self.hysteresis)) {
+            step = LineGraphNiceStep(spacing / pointsPerUnit);
+        }
+    }
+    
+    if (self.interval == nil || step.mantissa != _step.mantissa || step.exponent != _step.exponent) {
+        _step = step;
+        self.interval = [self decimalNumberForStep:step];
+    }
+}
+
+- (NSDecimalNumber *)decimalNumberForStep:(LineGraphDecimal)step {
+    return [NSDecimalNumber decimalNumberWithMantissa:step.mantissa exponent:step.exponent isNegative:NO];
+}
+
+@end
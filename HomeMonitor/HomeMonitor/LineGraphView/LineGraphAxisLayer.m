@@ -10,6 +10,7 @@
 #import "LineGraphUtils.h"
 #import "LineGraphAxisAnimator.h"
 #import "CALayer+LineGraphAnimation.h"
+#import "LineGraphLabelMetrics.h"
 
 static NSUInteger TICK_PADDING = 2;
 
@@ -137,7 +138,7 @@ static NSUInteger TICK_PADDING = 2;
 }
 
 - (CGRect)frameForValue:(float)floatValue label:(NSString *)label plotArea:(CGRect)plotArea valueRange:(CGRect)valueRange {
-    CGRect labelRect = [label boundingRectWithSize:CGSizeMake(0,0) options:NSStringDrawingUsesDeviceMetrics attributes:@{NSFontAttributeName:self.labelFont} context:nil];
+    CGRect labelRect = [[LineGraphLabelMetrics sharedMetrics] deviceBoundsForLabel:label font:self.labelFont];
     
     CGFloat labelPositionX, labelPositionY;
     
@@ -0,0 +1,133 @@
+//
+//  LineGraphDecimation.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "LineGraphDecimation.h"
+
+size_t LineGraphDecimationThreshold(float width, float columnWidth) {
+    size_t columns = (size_t)ceilf(fabsf(width) / columnWidth) + 1;
+
+    return (columns * 2 < 3) ? 3 : columns * 2;
+}
+
+/* Writes the distinct indexes of a finished column in ascending order. */
+static size_t EmitColumn(const float *xs, const float *ys, size_t first, size_t last, size_t min, size_t max, float *outXs, float *outYs) {
+    size_t indexes[4] = { first, (min < max) ? min : max, (min < max) ? max : min, last };
+    size_t count = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        if (i > 0 && indexes[i] == indexes[i - 1]) {
+            continue;
+        }
+
+        outXs[count] = xs[indexes[i]];
+        outYs[count] = ys[indexes[i]];
+        count++;
+    }
+
+    return count;
+}
+
+size_t LineGraphDecimateMinMax(const float *xs, const float *ys, size_t count, float columnWidth, float *outXs, float *outYs) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t outCount = 0;
+    size_t first = 0, min = 0, max = 0;
+    float columnEnd = (floorf(xs[0] / columnWidth) + 1) * columnWidth;
+
+    for (size_t i = 1; i < count; i++) {
+        if (xs[i] >= columnEnd) {
+            outCount += EmitColumn(xs, ys, first, i - 1, min, max, outXs + outCount, outYs + outCount);
+
+            first = min = max = i;
+            columnEnd = (floorf(xs[i] / columnWidth) + 1) * columnWidth;
+            continue;
+        }
+
+        if (ys[i] < ys[min]) {
+            min = i;
+        }
+
+        if (ys[i] > ys[max]) {
+            max = i;
+        }
+    }
+
+    outCount += EmitColumn(xs, ys, first, count - 1, min, max, outXs + outCount, outYs + outCount);
+
+    return outCount;
+}
+
+size_t LineGraphDecimateLargestTriangle(const float *xs, const float *ys, size_t count, size_t threshold, float *outXs, float *outYs) {
+    if (threshold >= count || threshold < 3) {
+        memcpy(outXs, xs, sizeof(float) * count);
+        memcpy(outYs, ys, sizeof(float) * count);
+        return count;
+    }
+
+    // First and last points are fixed, the remaining ones are split into threshold - 2 buckets.
+    double bucketSize = (double)(count - 2) / (double)(threshold - 2);
+    size_t selected = 0;
+    size_t outCount = 0;
+
+    outXs[outCount] = xs[0];
+    outYs[outCount] = ys[0];
+    outCount++;
+
+    for (size_t bucket = 0; bucket < threshold - 2; bucket++) {
+        size_t start = (size_t)(bucket * bucketSize) + 1;
+        size_t end = (size_t)((bucket + 1) * bucketSize) + 1;
+
+        // The next bucket's average stands in for the point that will be selected there.
+        size_t nextStart = end;
+        size_t nextEnd = (size_t)((bucket + 2) * bucketSize) + 1;
+
+        if (nextEnd > count) {
+            nextEnd = count;
+        }
+
+        double averageX = 0, averageY = 0;
+
+        for (size_t i = nextStart; i < nextEnd; i++) {
+            averageX += xs[i];
+            averageY += ys[i];
+        }
+
+        averageX /= (double)(nextEnd - nextStart);
+        averageY /= (double)(nextEnd - nextStart);
+
+        double selectedX = xs[selected];
+        double selectedY = ys[selected];
+        double largestArea = -1;
+        size_t largestIndex = start;
+
+        for (size_t i = start; i < end; i++) {
+            double area = fabs((selectedX - averageX) * (ys[i] - selectedY) - (selectedX - xs[i]) * (averageY - selectedY));
+
+            if (area > largestArea) {
+                largestArea = area;
+                largestIndex = i;
+            }
+        }
+
+        outXs[outCount] = xs[largestIndex];
+        outYs[outCount] = ys[largestIndex];
+        outCount++;
+
+        selected = largestIndex;
+    }
+
+    outXs[outCount] = xs[count - 1];
+    outYs[outCount] = ys[count - 1];
+    outCount++;
+
+    return outCount;
+}
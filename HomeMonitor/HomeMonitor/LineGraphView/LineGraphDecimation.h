@@ -0,0 +1,48 @@
+//
+//  LineGraphDecimation.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphDecimation_h
+#define LineGraphView_LineGraphDecimation_h
+
+#include <stddef.h>
+
+/** Defines how plots with more points than pixel columns are reduced before drawing */
+typedef enum {
+    /** Every point is drawn */
+    kLineGraphDecimationNone,
+    /** Keeps the first, last, minimum and maximum point of every pixel column, preserves spikes exactly */
+    kLineGraphDecimationMinMax,
+    /** Largest-Triangle-Three-Buckets, keeps about two points per pixel column chosen for visual similarity */
+    kLineGraphDecimationLargestTriangle
+} LineGraphDecimationMode;
+
+/** Reduces a run of points to the first, last, minimum and maximum point of every column.
+
+ Points must be in ascending x order.  Output arrays must hold count entries.
+
+ @param xs x coordinates, in the same unit as columnWidth.
+ @param ys y coordinates.
+ @param count Number of points.
+ @param columnWidth Width of a pixel column.
+ @param outXs Decimated x coordinates.
+ @param outYs Decimated y coordinates.
+ @return Number of points written.
+*/
+size_t LineGraphDecimateMinMax(const float *xs, const float *ys, size_t count, float columnWidth, float *outXs, float *outYs);
+
+/** Reduces a run of points to threshold points using Largest-Triangle-Three-Buckets.
+
+ The first and last points are always kept.  Output arrays must hold count entries.
+
+ @return Number of points written, count if count <= threshold.
+*/
+size_t LineGraphDecimateLargestTriangle(const float *xs, const float *ys, size_t count, size_t threshold, float *outXs, float *outYs);
+
+/** Number of points a run spanning the given width can be reduced to while keeping two points per column */
+size_t LineGraphDecimationThreshold(float width, float columnWidth);
+
+#endif
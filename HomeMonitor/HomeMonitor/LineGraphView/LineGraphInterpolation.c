@@ -0,0 +1,109 @@
+//
+//  LineGraphInterpolation.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "LineGraphInterpolation.h"
+
+static size_t AppendUnique(float *out, size_t count, float value) {
+    if (isnan(value) || (count > 0 && out[count - 1] == value)) {
+        return count;
+    }
+
+    out[count] = value;
+
+    return count + 1;
+}
+
+size_t LineGraphMergeSortedUnique(const float *first, size_t firstCount, const float *second, size_t secondCount, float *out) {
+    size_t i = 0, j = 0, count = 0;
+
+    while (i < firstCount || j < secondCount) {
+        if (i < firstCount && isnan(first[i])) {
+            i++;
+        } else if (j < secondCount && isnan(second[j])) {
+            j++;
+        } else if (j == secondCount || (i < firstCount && first[i] <= second[j])) {
+            count = AppendUnique(out, count, first[i++]);
+        } else {
+            count = AppendUnique(out, count, second[j++]);
+        }
+    }
+
+    return count;
+}
+
+void LineGraphInterpolateAtPlotX(const LineGraphInterpolationSource *source, const float *targets, size_t targetCount, float *outXs, float *outYs) {
+    if (targetCount == 0 || source->count == 0) {
+        return;
+    }
+
+    const float *plotXs = source->plotXs;
+    const float *xs = source->xs;
+    const float *ys = source->ys;
+    size_t count = source->count;
+    size_t last = 0;
+
+    outXs[0] = xs[0];
+    outYs[0] = ys[0];
+
+    for (size_t i = 1; i < targetCount; i++) {
+        float x = targets[i];
+
+        if (last == count - 1 || x <= plotXs[last]) {
+            outXs[i] = xs[last];
+            outYs[i] = ys[last];
+            continue;
+        }
+
+        // Advance past every point left of x, so each source point is visited once over all targets
+        size_t next = last + 1;
+        bool interpolate = false;
+
+        while (next < count) {
+            if (isnan(plotXs[next])) {
+                size_t after = next + 1;
+
+                while (after < count && isnan(plotXs[after])) {
+                    after++;
+                }
+
+                if (after == count || x < plotXs[after]) {
+                    // Inside or past a trailing gap, hold the point before it
+                    break;
+                }
+
+                next = after;
+                continue;
+            }
+
+            if (x < plotXs[next]) {
+                interpolate = true;
+                break;
+            }
+
+            last = next;
+
+            if (x == plotXs[next]) {
+                break;
+            }
+
+            next++;
+        }
+
+        if (interpolate) {
+            float xPoint = xs[last] + ((xs[next] - xs[last]) * ((x - plotXs[last]) / (plotXs[next] - plotXs[last])));
+
+            outXs[i] = xPoint;
+            outYs[i] = ys[last] + ((ys[next] - ys[last]) * ((xPoint - xs[last]) / (xs[next] - xs[last])));
+        } else {
+            outXs[i] = xs[last];
+            outYs[i] = ys[last];
+        }
+    }
+}
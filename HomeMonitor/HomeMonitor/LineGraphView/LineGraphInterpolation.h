@@ -0,0 +1,44 @@
+//
+//  LineGraphInterpolation.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphInterpolation_h
+#define LineGraphView_LineGraphInterpolation_h
+
+#include <stddef.h>
+
+/**
+ Points of a plot, with their x positions in the plot area computed once up front.
+
+ Gaps are marked with NAN in plotXs.  Points other than gaps must be in ascending x order.
+*/
+typedef struct {
+    const float *plotXs;
+    const float *xs;
+    const float *ys;
+    size_t count;
+} LineGraphInterpolationSource;
+
+/** Merges two ascending runs of plot x positions into one without duplicates, skipping NAN gap markers.
+
+ @param out Must hold firstCount + secondCount values.
+ @return Number of values written.
+*/
+size_t LineGraphMergeSortedUnique(const float *first, size_t firstCount, const float *second, size_t secondCount, float *out);
+
+/** Samples the line through the source points at every target plot x position, in one pass over both.
+
+ The first output is always the first source point.  Targets left of the current point repeat it, targets past
+ the last point repeat the last point, and targets between two points are interpolated linearly.  Lines are never
+ interpolated across a gap, targets inside one repeat the point before it.
+
+ @param targets Ascending plot x positions.
+ @param outXs x values of the sampled points, in data space.
+ @param outYs y values of the sampled points, in data space.
+*/
+void LineGraphInterpolateAtPlotX(const LineGraphInterpolationSource *source, const float *targets, size_t targetCount, float *outXs, float *outYs);
+
+#endif
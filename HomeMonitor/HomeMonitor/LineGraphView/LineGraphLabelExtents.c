@@ -0,0 +1,175 @@
+//
+//  LineGraphLabelExtents.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphLabelExtents.h"
+
+static void AddToMaxima(LineGraphLabelExtents *extents, const LineGraphLabelExtent *extent) {
+    if (extents->maxWidthCount == 0 || extent->width > extents->maxWidth) {
+        extents->maxWidth = extent->width;
+        extents->maxWidthCount = 1;
+    } else if (extent->width == extents->maxWidth) {
+        extents->maxWidthCount += 1;
+    }
+
+    if (extents->maxHeightCount == 0 || extent->height > extents->maxHeight) {
+        extents->maxHeight = extent->height;
+        extents->maxHeightCount = 1;
+    } else if (extent->height == extents->maxHeight) {
+        extents->maxHeightCount += 1;
+    }
+}
+
+static void RecalculateMaxima(LineGraphLabelExtents *extents) {
+    extents->maxWidth = extents->maxHeight = 0;
+    extents->maxWidthCount = extents->maxHeightCount = 0;
+
+    for (size_t i = 0; i < extents->count; i++) {
+        AddToMaxima(extents, LineGraphLabelExtentsAt(extents, i));
+    }
+}
+
+/* Called after the extent was unlinked.  A full pass is only needed when no other label has the same maximum. */
+static void RemoveFromMaxima(LineGraphLabelExtents *extents, const LineGraphLabelExtent *extent) {
+    bool needsRecalculation = false;
+
+    if (extent->width == extents->maxWidth && --extents->maxWidthCount == 0) {
+        needsRecalculation = true;
+    }
+
+    if (extent->height == extents->maxHeight && --extents->maxHeightCount == 0) {
+        needsRecalculation = true;
+    }
+
+    if (needsRecalculation) {
+        RecalculateMaxima(extents);
+    }
+}
+
+static bool Reserve(LineGraphLabelExtents *extents) {
+    if (extents->count < extents->capacity) {
+        return true;
+    }
+
+    size_t capacity = (extents->capacity > 0) ? extents->capacity * 2 : 16;
+    LineGraphLabelExtent *storage = realloc(extents->extents, sizeof(LineGraphLabelExtent) * capacity);
+
+    if (storage == NULL) {
+        return false;
+    }
+
+    extents->extents = storage;
+    extents->capacity = capacity;
+
+    return true;
+}
+
+void LineGraphLabelExtentsInit(LineGraphLabelExtents *extents) {
+    memset(extents, 0, sizeof(LineGraphLabelExtents));
+    extents->isAscending = true;
+}
+
+void LineGraphLabelExtentsDestroy(LineGraphLabelExtents *extents) {
+    free(extents->extents);
+
+    LineGraphLabelExtentsInit(extents);
+}
+
+void LineGraphLabelExtentsRemoveAll(LineGraphLabelExtents *extents) {
+    extents->offset = 0;
+    extents->count = 0;
+    extents->maxWidth = extents->maxHeight = 0;
+    extents->maxWidthCount = extents->maxHeightCount = 0;
+    extents->isAscending = true;
+}
+
+bool LineGraphLabelExtentsAppend(LineGraphLabelExtents *extents, float value, float width, float height) {
+    if (!Reserve(extents)) {
+        return false;
+    }
+
+    if (extents->offset + extents->count == extents->capacity) {
+        // Reuse the space of labels trimmed from the front
+        memmove(extents->extents, extents->extents + extents->offset, sizeof(LineGraphLabelExtent) * extents->count);
+        extents->offset = 0;
+    }
+
+    if (extents->count > 0 && !(value > LineGraphLabelExtentsAt(extents, extents->count - 1)->value)) {
+        extents->isAscending = false;
+    }
+
+    LineGraphLabelExtent *extent = &extents->extents[extents->offset + extents->count];
+    extent->value = value;
+    extent->width = width;
+    extent->height = height;
+
+    extents->count += 1;
+    AddToMaxima(extents, extent);
+
+    return true;
+}
+
+bool LineGraphLabelExtentsPrepend(LineGraphLabelExtents *extents, float value, float width, float height) {
+    if (!Reserve(extents)) {
+        return false;
+    }
+
+    if (extents->offset == 0) {
+        // Move the labels to the end of the storage to make room at the front
+        size_t offset = extents->capacity - extents->count;
+
+        memmove(extents->extents + offset, extents->extents, sizeof(LineGraphLabelExtent) * extents->count);
+        extents->offset = offset;
+    }
+
+    if (extents->count > 0 && !(value < LineGraphLabelExtentsAt(extents, 0)->value)) {
+        extents->isAscending = false;
+    }
+
+    extents->offset -= 1;
+
+    LineGraphLabelExtent *extent = &extents->extents[extents->offset];
+    extent->value = value;
+    extent->width = width;
+    extent->height = height;
+
+    extents->count += 1;
+    AddToMaxima(extents, extent);
+
+    return true;
+}
+
+void LineGraphLabelExtentsTrim(LineGraphLabelExtents *extents, float minValue, float maxValue) {
+    while (extents->count > 0) {
+        const LineGraphLabelExtent *first = LineGraphLabelExtentsAt(extents, 0);
+
+        if (first->value >= minValue && first->value <= maxValue) {
+            break;
+        }
+
+        extents->offset += 1;
+        extents->count -= 1;
+        RemoveFromMaxima(extents, first);
+    }
+
+    while (extents->count > 0) {
+        const LineGraphLabelExtent *last = LineGraphLabelExtentsAt(extents, extents->count - 1);
+
+        if (last->value >= minValue && last->value <= maxValue) {
+            break;
+        }
+
+        extents->count -= 1;
+        RemoveFromMaxima(extents, last);
+    }
+
+    if (extents->count == 0) {
+        LineGraphLabelExtentsRemoveAll(extents);
+    }
+}
@@ -0,0 +1,60 @@
+//
+//  LineGraphLabelExtents.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphLabelExtents_h
+#define LineGraphView_LineGraphLabelExtents_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Size of the label drawn at an axis tick */
+typedef struct {
+    float value;
+    float width;
+    float height;
+} LineGraphLabelExtent;
+
+/**
+ Label sizes of an axis, with running maxima of their widths and heights.
+
+ Labels are added at either end and trimmed by value, so scrolling an axis by a tick only touches the labels
+ that came into or went out of view.  The maxima are only recalculated when the last label of the largest size
+ is removed.
+*/
+typedef struct {
+    /** Live extents start at offset */
+    LineGraphLabelExtent *extents;
+    size_t capacity;
+    size_t offset;
+    size_t count;
+    float maxWidth;
+    float maxHeight;
+    /** Number of extents at the maximum sizes */
+    size_t maxWidthCount;
+    size_t maxHeightCount;
+    /** Whether values are in strictly ascending order, which allows walking in from the ends */
+    bool isAscending;
+} LineGraphLabelExtents;
+
+void LineGraphLabelExtentsInit(LineGraphLabelExtents *extents);
+void LineGraphLabelExtentsDestroy(LineGraphLabelExtents *extents);
+void LineGraphLabelExtentsRemoveAll(LineGraphLabelExtents *extents);
+
+/** Adds a label after the last one.  Returns false if storage could not be grown. */
+bool LineGraphLabelExtentsAppend(LineGraphLabelExtents *extents, float value, float width, float height);
+
+/** Adds a label before the first one.  Returns false if storage could not be grown. */
+bool LineGraphLabelExtentsPrepend(LineGraphLabelExtents *extents, float value, float width, float height);
+
+/** Removes labels from both ends while their values are outside of [minValue, maxValue]. */
+void LineGraphLabelExtentsTrim(LineGraphLabelExtents *extents, float minValue, float maxValue);
+
+static inline const LineGraphLabelExtent *LineGraphLabelExtentsAt(const LineGraphLabelExtents *extents, size_t index) {
+    return &extents->extents[extents->offset + index];
+}
+
+#endif
@@ -0,0 +1,39 @@
+//
+//  LineGraphLabelMetrics.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ Measures axis labels without running text layout for every label on every draw.
+
+ Recently measured labels are kept in a least recently used cache keyed by font and string.  Label widths
+ are otherwise summed from a table of character advances built once per font, and only labels with characters
+ outside of printable ASCII go through full text layout.  For use on the main thread.
+*/
+@interface LineGraphLabelMetrics : NSObject
+
+/** Maximum number of labels kept across all fonts.  Defaults to 512. */
+@property (nonatomic) NSUInteger capacity;
+
+/** Number of measurements answered from the cache */
+@property (nonatomic, readonly) NSUInteger hitCount;
+
+/** Number of measurements that were not in the cache */
+@property (nonatomic, readonly) NSUInteger missCount;
+
++ (LineGraphLabelMetrics *)sharedMetrics;
+
+/** Typographic size of a single line label, like sizeWithAttributes: without kerning. */
+- (CGSize)sizeForLabel:(NSString *)label font:(UIFont *)font;
+
+/** Bounds of the label's glyphs, like boundingRectWithSize: with NSStringDrawingUsesDeviceMetrics. */
+- (CGRect)deviceBoundsForLabel:(NSString *)label font:(UIFont *)font;
+
+- (void)removeAllLabels;
+
+@end
@@ -0,0 +1,298 @@
+//
+//  LineGraphLabelMetrics.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <CoreText/CoreText.h>
+
+#import "LineGraphLabelMetrics.h"
+
+/* Printable ASCII, which covers the numeric labels of the axes */
+#define LINE_GRAPH_FIRST_TABLE_CHARACTER 0x20
+#define LINE_GRAPH_LAST_TABLE_CHARACTER 0x7E
+
+/* A measured label, linked into the cache's recency list */
+@interface LineGraphLabelEntry : NSObject {
+@public
+    NSString *_label;
+    NSMutableDictionary *__unsafe_unretained _owner;
+    LineGraphLabelEntry *_next;
+    LineGraphLabelEntry *__unsafe_unretained _previous;
+    CGSize _size;
+    CGRect _deviceBounds;
+    BOOL _hasSize;
+    BOOL _hasDeviceBounds;
+}
+
+@end
+
+@implementation LineGraphLabelEntry
+
+@end
+
+/* Advance table and measured labels of a single font */
+@interface LineGraphFontMetrics : NSObject {
+@public
+    CGFloat _advances[LINE_GRAPH_LAST_TABLE_CHARACTER - LINE_GRAPH_FIRST_TABLE_CHARACTER + 1];
+    CGFloat _lineHeight;
+    NSMutableDictionary *_labels;
+}
+
+- (id)initWithFont:(UIFont *)font;
+
+@end
+
+@implementation LineGraphFontMetrics
+
+- (id)initWithFont:(UIFont *)font {
+    self = [super init];
+    
+    if (self) {
+        CTFontRef ctFont = CTFontCreateWithName((__bridge CFStringRef)font.fontName, font.pointSize, NULL);
+        
+        for (unichar character = LINE_GRAPH_FIRST_TABLE_CHARACTER; character <= LINE_GRAPH_LAST_TABLE_CHARACTER; character++) {
+            CGGlyph glyph;
+            CGSize advance;
+            CGFloat width = -1;
+            
+            // Characters the font has no glyph for are left to full text layout, which can substitute fonts
+            if (CTFontGetGlyphsForCharacters(ctFont, &character, &glyph, 1)) {
+                CTFontGetAdvancesForGlyphs(ctFont, kCTFontHorizontalOrientation, &glyph, &advance, 1);
+                width = advance.width;
+            }
+            
+            _advances[character - LINE_GRAPH_FIRST_TABLE_CHARACTER] = width;
+        }
+        
+        CFRelease(ctFont);
+        
+        _lineHeight = font.lineHeight;
+        _labels = [NSMutableDictionary dictionary];
+    }
+    
+    return self;
+}
+
+/* Sums the advances of the label's characters, returning FALSE if any of them is not in the table. */
+- (BOOL)getWidth:(CGFloat *)width forLabel:(NSString *)label {
+    NSUInteger length = label.length;
+    unichar characters[64];
+    CGFloat sum = 0;
+    
+    if (length > sizeof(characters) / sizeof(unichar)) {
+        return FALSE;
+    }
+    
+    [label getCharacters:characters range:NSMakeRange(0, length)];
+    
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar character = characters[i];
+        
+        if (character < LINE_GRAPH_FIRST_TABLE_CHARACTER || character > LINE_GRAPH_LAST_TABLE_CHARACTER) {
+            return FALSE;
+        }
+        
+        CGFloat advance = _advances[character - LINE_GRAPH_FIRST_TABLE_CHARACTER];
+        
+        if (advance < 0) {
+            return FALSE;
+        }
+        
+        sum += advance;
+    }
+    
+    *width = sum;
+    
+    return TRUE;
+}
+
+@end
+
+@interface LineGraphLabelMetrics () {
+    NSMutableDictionary *_fonts;
+    LineGraphLabelEntry *_first;
+    LineGraphLabelEntry *__unsafe_unretained _last;
+    NSUInteger _count;
+}
+
+@end
+
+@implementation LineGraphLabelMetrics
+
++ (LineGraphLabelMetrics *)sharedMetrics {
+    static LineGraphLabelMetrics *sharedMetrics = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        sharedMetrics = [[LineGraphLabelMetrics alloc] init];
+    });
+    
+    return sharedMetrics;
+}
+
+- (id)init {
+    self = [super init];
+    
+    if (self) {
+        _capacity = 512;
+        _fonts = [NSMutableDictionary dictionary];
+        
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(removeAllLabels)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (CGSize)sizeForLabel:(NSString *)label font:(UIFont *)font {
+    LineGraphFontMetrics *fontMetrics = [self metricsForFont:font];
+    LineGraphLabelEntry *entry = [self entryForLabel:label fontMetrics:fontMetrics];
+    
+    if (entry->_hasSize) {
+        _hitCount++;
+        return entry->_size;
+    }
+    
+    _missCount++;
+    
+    CGFloat width;
+    
+    if ([fontMetrics getWidth:&width forLabel:label]) {
+        entry->_size = CGSizeMake(width, fontMetrics->_lineHeight);
+    } else {
+        entry->_size = [label sizeWithAttributes:@{NSFontAttributeName:font}];
+    }
+    
+    entry->_hasSize = TRUE;
+    
+    return entry->_size;
+}
+
+- (CGRect)deviceBoundsForLabel:(NSString *)label font:(UIFont *)font {
+    LineGraphFontMetrics *fontMetrics = [self metricsForFont:font];
+    LineGraphLabelEntry *entry = [self entryForLabel:label fontMetrics:fontMetrics];
+    
+    if (entry->_hasDeviceBounds) {
+        _hitCount++;
+        return entry->_deviceBounds;
+    }
+    
+    _missCount++;
+    
+    // Ink bounds depend on glyph shapes rather than advances, so these always need text layout
+    entry->_deviceBounds = [label boundingRectWithSize:CGSizeMake(0,0) options:NSStringDrawingUsesDeviceMetrics attributes:@{NSFontAttributeName:font} context:nil];
+    entry->_hasDeviceBounds = TRUE;
+    
+    return entry->_deviceBounds;
+}
+
+- (void)removeAllLabels {
+    [_fonts removeAllObjects];
+    
+    // Unlink iteratively, so a long list is not released recursively
+    while (_first != nil) {
+        LineGraphLabelEntry *next = _first->_next;
+        _first->_next = nil;
+        _first = next;
+    }
+    
+    _last = nil;
+    _count = 0;
+}
+
+- (void)setCapacity:(NSUInteger)capacity {
+    _capacity = capacity;
+    
+    while (_count > _capacity) {
+        [self removeLastEntry];
+    }
+}
+
+#pragma mark - Cache
+
+- (LineGraphFontMetrics *)metricsForFont:(UIFont *)font {
+    LineGraphFontMetrics *fontMetrics = _fonts[font];
+    
+    if (fontMetrics == nil) {
+        fontMetrics = [[LineGraphFontMetrics alloc] initWithFont:font];
+        _fonts[font] = fontMetrics;
+    }
+    
+    return fontMetrics;
+}
+
+/* Returns the entry for the label, creating it if needed, and moves it to the front of the recency list.
+*/
+- (LineGraphLabelEntry *)entryForLabel:(NSString *)label fontMetrics:(LineGraphFontMetrics *)fontMetrics {
+    LineGraphLabelEntry *entry = fontMetrics->_labels[label];
+    
+    if (entry == nil) {
+        entry = [[LineGraphLabelEntry alloc] init];
+        entry->_label = [label copy];
+        entry->_owner = fontMetrics->_labels;
+        fontMetrics->_labels[entry->_label] = entry;
+        _count++;
+    } else if (entry == _first) {
+        return entry;
+    } else {
+        [self unlinkEntry:entry];
+    }
+    
+    entry->_next = _first;
+    entry->_previous = nil;
+    
+    if (_first != nil) {
+        _first->_previous = entry;
+    }
+    
+    _first = entry;
+    
+    if (_last == nil) {
+        _last = entry;
+    }
+    
+    while (_count > _capacity && _last != entry) {
+        [self removeLastEntry];
+    }
+    
+    return entry;
+}
+
+- (void)unlinkEntry:(LineGraphLabelEntry *)entry {
+    if (entry->_previous != nil) {
+        entry->_previous->_next = entry->_next;
+    } else {
+        _first = entry->_next;
+    }
+    
+    if (entry->_next != nil) {
+        entry->_next->_previous = entry->_previous;
+    } else {
+        _last = entry->_previous;
+    }
+    
+    entry->_next = nil;
+    entry->_previous = nil;
+}
+
+- (void)removeLastEntry {
+    LineGraphLabelEntry *entry = _last;
+    
+    if (entry == nil) {
+        return;
+    }
+    
+    [self unlinkEntry:entry];
+    [entry->_owner removeObjectForKey:entry->_label];
+    _count--;
+}
+
+@end
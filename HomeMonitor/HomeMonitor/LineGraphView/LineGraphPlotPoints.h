@@ -0,0 +1,55 @@
+//
+//  LineGraphPlotPoints.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ Points of a plot lent to LineGraphView as columns.  The view copies what it needs during the call, so the
+ buffers only have to stay valid until the data source method returns.
+*/
+typedef struct {
+    /** x values in ascending order, relative to xOrigin */
+    const float *xs;
+    const float *ys;
+    size_t count;
+    /** Ascending indexes of the points that start a new line, leaving a gap before them */
+    const size_t *gapIndexes;
+    size_t gapCount;
+    /** Changes whenever the points change.  A plot whose generation matches the last load is not copied
+     again, 0 means the points are always copied. */
+    uint64_t generation;
+    /** Added to every x value, so points far from 0 can be lent without losing their steps to float */
+    double xOrigin;
+} LineGraphPlotBuffer;
+
+/**
+ Plot points held as x and y columns, with NAN x and y values where the plot has a gap.
+
+ Works as an array of CGPoints stored as NSValues, with NSNull for gaps, boxing points as they are accessed,
+ so it can be used anywhere plot points are expected.  LineGraphView reads the columns directly.
+
+ x values are kept relative to xOrigin, so the float columns of points far from 0 still tell them apart.
+*/
+@interface LineGraphPlotPoints : NSArray
+
+@property (nonatomic, readonly) double xOrigin;
+@property (nonatomic, readonly) const float *xValues;
+@property (nonatomic, readonly) const float *yValues;
+
+/** Generation of the buffer the points were copied from, 0 if they were not copied from one */
+@property (nonatomic, readonly) uint64_t generation;
+
+/** Copies the points in buffer. */
+- (id)initWithBuffer:(const LineGraphPlotBuffer *)buffer;
+
+/** Columns for an array of plot points, which is returned as is if it already is a LineGraphPlotPoints.  Other
+ arrays are unboxed once, relative to their first point, and kept for accessing the points as objects.
+*/
++ (LineGraphPlotPoints *)pointsWithArray:(NSArray *)array;
+
+@end
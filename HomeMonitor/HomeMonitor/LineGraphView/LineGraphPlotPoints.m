@@ -0,0 +1,153 @@
+//
+//  LineGraphPlotPoints.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphPlotPoints.h"
+
+@interface LineGraphPlotPoints () {
+    float *_values;
+    NSUInteger _count;
+    /** Array the points were unboxed from, if any */
+    NSArray *_array;
+}
+
+@end
+
+@implementation LineGraphPlotPoints
+
+- (id)initWithBuffer:(const LineGraphPlotBuffer *)buffer {
+    self = [super init];
+    
+    if (self) {
+        _count = buffer->count + buffer->gapCount;
+        _values = malloc(sizeof(float) * MAX(_count, 1) * 2);
+        _generation = buffer->generation;
+        _xOrigin = buffer->xOrigin;
+        
+        if (_values == NULL) {
+            return nil;
+        }
+        
+        _xValues = _values;
+        _yValues = _values + _count;
+        
+        float *xValues = _values;
+        float *yValues = _values + _count;
+        NSUInteger index = 0;
+        size_t gap = 0;
+        size_t start = 0;
+        
+        // Copy the runs between gaps whole, with a NAN point in front of every run but the first
+        while (start < buffer->count) {
+            size_t end = buffer->count;
+            
+            while (gap < buffer->gapCount && buffer->gapIndexes[gap] <= start) {
+                gap++;
+            }
+            
+            if (gap < buffer->gapCount && buffer->gapIndexes[gap] < end) {
+                end = buffer->gapIndexes[gap];
+            }
+            
+            if (start > 0) {
+                xValues[index] = yValues[index] = NAN;
+                index++;
+            }
+            
+            memcpy(xValues + index, buffer->xs + start, sizeof(float) * (end - start));
+            memcpy(yValues + index, buffer->ys + start, sizeof(float) * (end - start));
+            index += end - start;
+            start = end;
+        }
+        
+        // Gap indexes out of range or repeated do not add a gap
+        _count = index;
+    }
+    
+    return self;
+}
+
+- (id)initWithPointArray:(NSArray *)array {
+    self = [super init];
+    
+    if (self) {
+        _array = [array copy];
+        _count = _array.count;
+        _values = malloc(sizeof(float) * MAX(_count, 1) * 2);
+        
+        if (_values == NULL) {
+            return nil;
+        }
+        
+        _xValues = _values;
+        _yValues = _values + _count;
+        
+        float *xValues = _values;
+        float *yValues = _values + _count;
+        NSUInteger index = 0;
+        BOOL hasOrigin = NO;
+        
+        for (id value in _array) {
+            if ([value isEqual:[NSNull null]]) {
+                xValues[index] = yValues[index] = NAN;
+            } else {
+                CGPoint point = [(NSValue *)value CGPointValue];
+                
+                // CGFloat x values such as timestamps only fit a float as offsets from a nearby origin
+                if (!hasOrigin) {
+                    _xOrigin = point.x;
+                    hasOrigin = YES;
+                }
+                
+                xValues[index] = point.x - _xOrigin;
+                yValues[index] = point.y;
+            }
+            
+            index++;
+        }
+    }
+    
+    return self;
+}
+
++ (LineGraphPlotPoints *)pointsWithArray:(NSArray *)array {
+    if ([array isKindOfClass:[LineGraphPlotPoints class]]) {
+        return (LineGraphPlotPoints *)array;
+    }
+    
+    return [[LineGraphPlotPoints alloc] initWithPointArray:array];
+}
+
+- (void)dealloc {
+    free(_values);
+}
+
+- (NSUInteger)count {
+    return _count;
+}
+
+- (id)objectAtIndex:(NSUInteger)index {
+    if (_array != nil) {
+        return [_array objectAtIndex:index];
+    }
+    
+    if (index >= _count) {
+        [NSException raise:NSRangeException format:@"Index %lu beyond bounds [0 .. %lu]", (unsigned long)index, (unsigned long)_count];
+    }
+    
+    if (isnan(_xValues[index])) {
+        return [NSNull null];
+    }
+    
+    return [NSValue valueWithCGPoint:CGPointMake(_xOrigin + _xValues[index], _yValues[index])];
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    // Immutable, and copying through NSArray would box every point
+    return self;
+}
+
+@end
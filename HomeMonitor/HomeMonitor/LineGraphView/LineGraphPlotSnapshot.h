@@ -0,0 +1,32 @@
+//
+//  LineGraphPlotSnapshot.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+/**
+ Immutable points of a plot along with their bounds.
+
+ Snapshots are meant to be built away from the main thread, by whatever owns the data, and handed to
+ LineGraphView through lineGraphView:snapshotForPlot:.  The view reads the bounds instead of scanning the
+ points, and a snapshot can be shared between threads and views as nothing in it changes.
+*/
+@interface LineGraphPlotSnapshot : NSObject
+
+/** CGPoints stored as NSValues in ascending x-axis order, NSNull marks a gap */
+@property (nonatomic, copy, readonly) NSArray *points;
+
+/** Smallest rectangle containing all points, CGRectNull if there are none */
+@property (nonatomic, readonly) CGRect bounds;
+
+/** Snapshot of the given points, scanning them for their bounds. */
++ (LineGraphPlotSnapshot *)snapshotWithPoints:(NSArray *)points;
+
+/** Snapshot of points whose bounds are already known, such as from sliding window extrema. */
+- (id)initWithPoints:(NSArray *)points bounds:(CGRect)bounds;
+
+@end
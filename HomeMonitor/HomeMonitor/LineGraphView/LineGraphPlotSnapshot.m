@@ -0,0 +1,38 @@
+//
+//  LineGraphPlotSnapshot.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphPlotSnapshot.h"
+
+@implementation LineGraphPlotSnapshot
+
++ (LineGraphPlotSnapshot *)snapshotWithPoints:(NSArray *)points {
+    CGRect bounds = CGRectNull;
+    
+    for (id value in points) {
+        if ([value isEqual:[NSNull null]]) {
+            continue;
+        }
+        
+        CGPoint point = [value CGPointValue];
+        bounds = CGRectUnion(bounds, CGRectMake(point.x, point.y, 0.0, 0.0));
+    }
+    
+    return [[LineGraphPlotSnapshot alloc] initWithPoints:points bounds:bounds];
+}
+
+- (id)initWithPoints:(NSArray *)points bounds:(CGRect)bounds {
+    self = [super init];
+    
+    if (self) {
+        _points = [points copy];
+        _bounds = bounds;
+    }
+    
+    return self;
+}
+
+@end
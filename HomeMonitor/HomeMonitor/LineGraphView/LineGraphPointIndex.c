@@ -0,0 +1,210 @@
+//
+//  LineGraphPointIndex.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphPointIndex.h"
+
+static bool Reserve(float **values, size_t *capacity, size_t required) {
+    if (required <= *capacity) {
+        return true;
+    }
+
+    size_t newCapacity = (*capacity > 0) ? *capacity : 64;
+
+    while (newCapacity < required) {
+        newCapacity *= 2;
+    }
+
+    float *newValues = realloc(*values, sizeof(float) * newCapacity);
+
+    if (newValues == NULL) {
+        return false;
+    }
+
+    *values = newValues;
+    *capacity = newCapacity;
+
+    return true;
+}
+
+static int ComparePairs(const void *a, const void *b) {
+    float ax = *(const float *)a;
+    float bx = *(const float *)b;
+
+    return (ax > bx) - (ax < bx);
+}
+
+/* Sets spacing if no point is more than one step away from an even grid.  Sensor readings taken at a fixed rate do, and so do
+ the sample numbers used as x values by many graphs.
+*/
+static void UpdateSpacing(LineGraphPointIndex *index) {
+    index->spacing = 0;
+
+    if (index->count < 2) {
+        return;
+    }
+
+    float first = index->xs[0];
+    float spacing = (index->xs[index->count - 1] - first) / (float)(index->count - 1);
+
+    if (!(spacing > 0)) {
+        return;
+    }
+
+    for (size_t i = 1; i < index->count - 1; i++) {
+        float deviation = index->xs[i] - (first + spacing * (float)i);
+
+        if (deviation > spacing || deviation < -spacing) {
+            return;
+        }
+    }
+
+    index->spacing = spacing;
+}
+
+/* Moves an estimated position to the lower bound of x, returning false if it is more than the scan limit away. */
+static bool ScanToLowerBound(const LineGraphPointIndex *index, float x, size_t *position) {
+    size_t result = *position;
+
+    for (size_t step = 0; step < LINE_GRAPH_POINT_INDEX_SCAN_LIMIT; step++) {
+        if (result > 0 && index->xs[result - 1] >= x) {
+            result--;
+        } else if (result < index->count && index->xs[result] < x) {
+            result++;
+        } else {
+            *position = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void LineGraphPointIndexInit(LineGraphPointIndex *index) {
+    memset(index, 0, sizeof(LineGraphPointIndex));
+}
+
+void LineGraphPointIndexDestroy(LineGraphPointIndex *index) {
+    free(index->xs);
+    free(index->ys);
+    free(index->scratch);
+
+    LineGraphPointIndexInit(index);
+}
+
+void LineGraphPointIndexRemoveAll(LineGraphPointIndex *index) {
+    index->count = 0;
+    index->spacing = 0;
+}
+
+bool LineGraphPointIndexMergePoints(LineGraphPointIndex *index, const float *xs, const float *ys, size_t count) {
+    size_t capacity = index->capacity;
+    size_t required = index->count + count;
+
+    if (!Reserve(&index->xs, &capacity, required) || !Reserve(&index->ys, &index->capacity, required)) {
+        return false;
+    }
+
+    bool isSorted = true;
+
+    for (size_t i = 1; i < count && isSorted; i++) {
+        isSorted = xs[i - 1] <= xs[i];
+    }
+
+    if (!isSorted) {
+        // Sort (x, y) pairs together, then read them back as two strided arrays
+        if (!Reserve(&index->scratch, &index->scratchCapacity, count * 2)) {
+            return false;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            index->scratch[i * 2] = xs[i];
+            index->scratch[i * 2 + 1] = ys[i];
+        }
+
+        qsort(index->scratch, count, sizeof(float) * 2, ComparePairs);
+    }
+
+    const float *runXs = isSorted ? xs : index->scratch;
+    const float *runYs = isSorted ? ys : index->scratch + 1;
+    size_t stride = isSorted ? 1 : 2;
+
+    // Merge from the back so existing points are moved at most once and no extra buffer is needed
+    size_t i = index->count;
+    size_t j = count;
+    size_t k = required;
+
+    while (j > 0) {
+        if (i > 0 && index->xs[i - 1] > runXs[(j - 1) * stride]) {
+            i--;
+            k--;
+            index->xs[k] = index->xs[i];
+            index->ys[k] = index->ys[i];
+        } else {
+            j--;
+            k--;
+            index->xs[k] = runXs[j * stride];
+            index->ys[k] = runYs[j * stride];
+        }
+    }
+
+    index->count = required;
+
+    UpdateSpacing(index);
+
+    return true;
+}
+
+size_t LineGraphPointIndexLowerBound(const LineGraphPointIndex *index, float x) {
+    if (index->count == 0) {
+        return 0;
+    }
+
+    if (index->spacing > 0) {
+        float estimate = (x - index->xs[0]) / index->spacing;
+        size_t position = 0;
+
+        if (estimate >= (float)index->count) {
+            position = index->count;
+        } else if (estimate > 0) {
+            position = (size_t)ceilf(estimate);
+        }
+
+        if (ScanToLowerBound(index, x, &position)) {
+            return position;
+        }
+    }
+
+    // Halve the range without branching on the comparison, which the compiler turns into a conditional move
+    const float *base = index->xs;
+    size_t length = index->count;
+
+    while (length > 1) {
+        size_t half = length / 2;
+        base += (base[half - 1] < x) ? half : 0;
+        length -= half;
+    }
+
+    return (size_t)(base - index->xs) + (*base < x);
+}
+
+size_t LineGraphPointIndexClosest(const LineGraphPointIndex *index, float x) {
+    size_t position = LineGraphPointIndexLowerBound(index, x);
+
+    if (position == index->count) {
+        return position - 1;
+    }
+
+    if (position > 0 && x - index->xs[position - 1] < index->xs[position] - x) {
+        return position - 1;
+    }
+
+    return position;
+}
@@ -0,0 +1,55 @@
+//
+//  LineGraphPointIndex.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphPointIndex_h
+#define LineGraphView_LineGraphPointIndex_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Number of positions a lookup on evenly spaced points scans from its estimate before falling back to binary search */
+#define LINE_GRAPH_POINT_INDEX_SCAN_LIMIT 8
+
+/**
+ Points of one or more plots merged into a single run sorted by x, for finding the point closest to a touch.
+
+ x and y values live in separate arrays so searches only touch the x values.
+*/
+typedef struct {
+    float *xs;
+    float *ys;
+    size_t count;
+    size_t capacity;
+    /** Sorting space for runs that are not already in ascending x order */
+    float *scratch;
+    size_t scratchCapacity;
+    /** Distance between points if no point is more than one step away from an even grid, 0 otherwise */
+    float spacing;
+} LineGraphPointIndex;
+
+void LineGraphPointIndexInit(LineGraphPointIndex *index);
+void LineGraphPointIndexDestroy(LineGraphPointIndex *index);
+void LineGraphPointIndexRemoveAll(LineGraphPointIndex *index);
+
+/** Merges a run of points into the index, keeping it sorted by x.  Points already in the index come first
+ among equal x values.  The run is sorted first if it is not in ascending x order.
+
+ @return false if storage could not be grown, in which case the index is unchanged.
+*/
+bool LineGraphPointIndexMergePoints(LineGraphPointIndex *index, const float *xs, const float *ys, size_t count);
+
+/** Position of the first point with an x value not less than x, or count if there is none.
+
+ On evenly spaced points the position is estimated from the spacing and corrected by a short scan, otherwise
+ it is found by binary search.
+*/
+size_t LineGraphPointIndexLowerBound(const LineGraphPointIndex *index, float x);
+
+/** Position of the point closest to x, preferring the higher one on ties.  The index must not be empty. */
+size_t LineGraphPointIndexClosest(const LineGraphPointIndex *index, float x);
+
+#endif
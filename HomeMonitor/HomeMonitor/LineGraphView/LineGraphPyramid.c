@@ -0,0 +1,302 @@
+//
+//  LineGraphPyramid.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphPyramid.h"
+
+static void BucketMerge(LineGraphPyramidBucket *bucket, const LineGraphPyramidBucket *next) {
+    if (next->count == 0) {
+        return;
+    }
+
+    if (bucket->count == 0) {
+        *bucket = *next;
+        return;
+    }
+
+    if (next->min < bucket->min) {
+        bucket->min = next->min;
+        bucket->minX = next->minX;
+    }
+
+    if (next->max > bucket->max) {
+        bucket->max = next->max;
+        bucket->maxX = next->maxX;
+    }
+
+    bucket->lastX = next->lastX;
+    bucket->sum += next->sum;
+    bucket->count += next->count;
+}
+
+static bool LevelPush(LineGraphPyramidLevel *level, const LineGraphPyramidBucket *bucket) {
+    if (level->offset + level->count == level->capacity) {
+        if (level->offset > 0 && level->offset >= level->count) {
+            // More than half of the storage holds evicted buckets, reuse it before growing
+            memmove(level->buckets, level->buckets + level->offset, sizeof(LineGraphPyramidBucket) * level->count);
+            level->offset = 0;
+        } else {
+            size_t capacity = (level->capacity > 0) ? level->capacity * 2 : 64;
+            LineGraphPyramidBucket *buckets = realloc(level->buckets, sizeof(LineGraphPyramidBucket) * capacity);
+
+            if (buckets == NULL) {
+                return false;
+            }
+
+            level->buckets = buckets;
+            level->capacity = capacity;
+        }
+    }
+
+    level->buckets[level->offset + level->count] = *bucket;
+    level->count += 1;
+
+    return true;
+}
+
+/* Merges the points of a bucket on the given level that have not been evicted.  A partly evicted bucket is
+ rebuilt from its children on the level below, which are stored as long as any of their points are live.  Points
+ of a partly evicted bucket on level 0 are not kept, so it is skipped.
+*/
+static void BucketMergeLive(const LineGraphPyramid *pyramid, size_t level, const LineGraphPyramidBucket *next, LineGraphPyramidBucket *bucket) {
+    if (next->count == 0 || next->lastX < pyramid->evictedX) {
+        return;
+    }
+
+    if (next->firstX >= pyramid->evictedX) {
+        BucketMerge(bucket, next);
+        return;
+    }
+
+    if (level == 0) {
+        return;
+    }
+
+    const LineGraphPyramidLevel *childLevel = &pyramid->levels[level - 1];
+    const LineGraphPyramidBucket *children = childLevel->buckets + childLevel->offset;
+    size_t low = 0, high = childLevel->count;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (children[middle].firstX < next->firstX) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    for (size_t i = low; i < childLevel->count && children[i].lastX <= next->lastX; i++) {
+        BucketMergeLive(pyramid, level - 1, &children[i], bucket);
+    }
+}
+
+void LineGraphPyramidInit(LineGraphPyramid *pyramid) {
+    memset(pyramid, 0, sizeof(LineGraphPyramid));
+    pyramid->lastX = -INFINITY;
+    pyramid->evictedX = -INFINITY;
+    pyramid->isValid = true;
+}
+
+void LineGraphPyramidDestroy(LineGraphPyramid *pyramid) {
+    // Levels above levelCount may still own storage after an eviction
+    for (size_t i = 0; i < LINE_GRAPH_PYRAMID_MAX_LEVELS; i++) {
+        free(pyramid->levels[i].buckets);
+    }
+
+    LineGraphPyramidInit(pyramid);
+}
+
+void LineGraphPyramidRemoveAll(LineGraphPyramid *pyramid) {
+    for (size_t i = 0; i < LINE_GRAPH_PYRAMID_MAX_LEVELS; i++) {
+        LineGraphPyramidLevel *level = &pyramid->levels[i];
+
+        level->offset = 0;
+        level->count = 0;
+        memset(&level->pending, 0, sizeof(LineGraphPyramidBucket));
+    }
+
+    pyramid->lastX = -INFINITY;
+    pyramid->evictedX = -INFINITY;
+    pyramid->isValid = true;
+}
+
+bool LineGraphPyramidAppend(LineGraphPyramid *pyramid, double x, float y) {
+    if (!pyramid->isValid || x < pyramid->lastX) {
+        pyramid->isValid = false;
+        return false;
+    }
+
+    if (pyramid->levelCount == 0) {
+        pyramid->levelCount = 1;
+    }
+
+    LineGraphPyramidBucket point = { x, x, x, x, y, y, y, 1 };
+
+    BucketMerge(&pyramid->levels[0].pending, &point);
+    pyramid->lastX = x;
+
+    // Carry completed buckets upwards, like incrementing a binary counter
+    for (size_t i = 0; i < LINE_GRAPH_PYRAMID_MAX_LEVELS; i++) {
+        LineGraphPyramidLevel *level = &pyramid->levels[i];
+
+        if (level->pending.count < ((uint32_t)LINE_GRAPH_PYRAMID_BASE_SIZE << i)) {
+            break;
+        }
+
+        if (!LevelPush(level, &level->pending)) {
+            pyramid->isValid = false;
+            return false;
+        }
+
+        if (i + 1 < LINE_GRAPH_PYRAMID_MAX_LEVELS) {
+            if (pyramid->levelCount < i + 2) {
+                pyramid->levelCount = i + 2;
+            }
+
+            BucketMerge(&pyramid->levels[i + 1].pending, &level->pending);
+        }
+
+        memset(&level->pending, 0, sizeof(LineGraphPyramidBucket));
+    }
+
+    return true;
+}
+
+void LineGraphPyramidEvictBefore(LineGraphPyramid *pyramid, double x) {
+    if (x <= pyramid->evictedX) {
+        return;
+    }
+
+    pyramid->evictedX = x;
+
+    size_t levelCount = 0;
+
+    // Levels dropped from levelCount by an earlier eviction may still hold evicted buckets
+    for (size_t i = 0; i < LINE_GRAPH_PYRAMID_MAX_LEVELS; i++) {
+        LineGraphPyramidLevel *level = &pyramid->levels[i];
+
+        while (level->count > 0 && level->buckets[level->offset].lastX < x) {
+            level->offset += 1;
+            level->count -= 1;
+        }
+
+        if (level->count == 0) {
+            level->offset = 0;
+        }
+
+        // A pending bucket with only evicted points starts over, so it never leaks into a completed bucket
+        if (level->pending.count > 0 && level->pending.lastX < x) {
+            memset(&level->pending, 0, sizeof(LineGraphPyramidBucket));
+        }
+
+        // Reading a level skips its partly evicted first bucket, so only levels with a whole bucket left are kept
+        if (level->count > 0 && level->buckets[level->offset + level->count - 1].firstX >= x) {
+            levelCount = i + 1;
+        }
+    }
+
+    if (levelCount == 0 && pyramid->levels[0].pending.count > 0) {
+        levelCount = 1;
+    }
+
+    pyramid->levelCount = levelCount;
+}
+
+bool LineGraphPyramidLevelForColumnWidth(const LineGraphPyramid *pyramid, double columnWidth, size_t *level) {
+    if (!pyramid->isValid || pyramid->levelCount == 0 || pyramid->levels[0].count < 2) {
+        return false;
+    }
+
+    const LineGraphPyramidLevel *baseLevel = &pyramid->levels[0];
+    const LineGraphPyramidBucket *first = &baseLevel->buckets[baseLevel->offset];
+    const LineGraphPyramidBucket *last = &baseLevel->buckets[baseLevel->offset + baseLevel->count - 1];
+    double bucketWidth = (last->lastX - first->firstX) / baseLevel->count;
+
+    if (bucketWidth > columnWidth || bucketWidth <= 0) {
+        return false;
+    }
+
+    size_t result = 0;
+
+    while (result + 1 < pyramid->levelCount && bucketWidth * 2 <= columnWidth) {
+        bucketWidth *= 2;
+        result += 1;
+    }
+
+    *level = result;
+
+    return true;
+}
+
+const LineGraphPyramidBucket *LineGraphPyramidBucketsInRange(const LineGraphPyramid *pyramid, size_t level, double xMin, double xMax, size_t *count) {
+    *count = 0;
+
+    if (level >= pyramid->levelCount) {
+        return NULL;
+    }
+
+    const LineGraphPyramidLevel *pyramidLevel = &pyramid->levels[level];
+    const LineGraphPyramidBucket *buckets = pyramidLevel->buckets + pyramidLevel->offset;
+    size_t bucketCount = pyramidLevel->count;
+
+    // The first bucket may still summarize evicted points
+    while (bucketCount > 0 && buckets->firstX < pyramid->evictedX) {
+        buckets++;
+        bucketCount--;
+    }
+
+    size_t low = 0, high = bucketCount;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (buckets[middle].lastX < xMin) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    size_t start = (low > 0) ? low - 1 : 0;
+
+    high = bucketCount;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (buckets[middle].firstX <= xMax) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    size_t end = (low < bucketCount) ? low + 1 : bucketCount;
+
+    *count = end - start;
+
+    return buckets + start;
+}
+
+bool LineGraphPyramidTailBucket(const LineGraphPyramid *pyramid, size_t level, LineGraphPyramidBucket *bucket) {
+    memset(bucket, 0, sizeof(LineGraphPyramidBucket));
+
+    if (level >= pyramid->levelCount) {
+        return false;
+    }
+
+    // Pending buckets hold consecutive runs, the highest level's run comes first
+    for (size_t i = level + 1; i-- > 0;) {
+        BucketMergeLive(pyramid, i, &pyramid->levels[i].pending, bucket);
+    }
+
+    return bucket->count > 0;
+}
@@ -0,0 +1,88 @@
+//
+//  LineGraphPyramid.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphPyramid_h
+#define LineGraphView_LineGraphPyramid_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of points summarized by a bucket on the lowest level.  Each level above doubles it. */
+#define LINE_GRAPH_PYRAMID_BASE_SIZE 8
+
+#define LINE_GRAPH_PYRAMID_MAX_LEVELS 40
+
+/** Summary of a run of consecutive points */
+typedef struct {
+    double firstX;
+    double lastX;
+    /** x values of the minimum and maximum points, to place them on the path */
+    double minX;
+    double maxX;
+    double sum;
+    float min;
+    float max;
+    uint32_t count;
+} LineGraphPyramidBucket;
+
+typedef struct {
+    /** Completed buckets, live ones start at offset */
+    LineGraphPyramidBucket *buckets;
+    size_t capacity;
+    size_t offset;
+    size_t count;
+    /** Bucket being filled with completed buckets from the level below, or points on level 0 */
+    LineGraphPyramidBucket pending;
+} LineGraphPyramidLevel;
+
+/**
+ Min/max/mean summaries of a plot at power-of-two resolutions, like mipmaps of an image.
+
+ Points must be appended in ascending x order.  A completed bucket is merged into the level above,
+ so an append costs amortized O(1) and reading a level is proportional to the number of buckets read.
+*/
+typedef struct {
+    LineGraphPyramidLevel levels[LINE_GRAPH_PYRAMID_MAX_LEVELS];
+    size_t levelCount;
+    double lastX;
+    /** Cleared by an out of order append, until all points are removed */
+    bool isValid;
+    /** Buckets starting before this x value hold evicted points and are skipped when read */
+    double evictedX;
+} LineGraphPyramid;
+
+void LineGraphPyramidInit(LineGraphPyramid *pyramid);
+void LineGraphPyramidDestroy(LineGraphPyramid *pyramid);
+void LineGraphPyramidRemoveAll(LineGraphPyramid *pyramid);
+
+/** Adds a point to the high end of the x-axis.  Returns false and invalidates the pyramid if x is out of order
+ or storage could not be grown. */
+bool LineGraphPyramidAppend(LineGraphPyramid *pyramid, double x, float y);
+
+/** Removes all points with an x value lower than x.  Buckets are dropped once all of their points are evicted,
+ and levelCount shrinks to the levels still holding points. */
+void LineGraphPyramidEvictBefore(LineGraphPyramid *pyramid, double x);
+
+/** Finds the coarsest level with buckets no wider than columnWidth on average.
+
+ @return false if even the lowest level is too coarse or the pyramid is invalid, in which case points should be
+ drawn directly.
+*/
+bool LineGraphPyramidLevelForColumnWidth(const LineGraphPyramid *pyramid, double columnWidth, size_t *level);
+
+/** Completed buckets on a level overlapping [xMin, xMax], plus one neighbouring bucket on each side so lines
+ can be drawn to the edges.  The returned buckets are contiguous and owned by the pyramid.
+
+ @param count Number of buckets returned.
+*/
+const LineGraphPyramidBucket *LineGraphPyramidBucketsInRange(const LineGraphPyramid *pyramid, size_t level, double xMin, double xMax, size_t *count);
+
+/** Summary of the points after the last completed bucket on a level.  Returns false if there are none. */
+bool LineGraphPyramidTailBucket(const LineGraphPyramid *pyramid, size_t level, LineGraphPyramidBucket *bucket);
+
+#endif
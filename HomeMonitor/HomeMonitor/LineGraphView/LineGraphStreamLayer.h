@@ -0,0 +1,40 @@
+//
+//  LineGraphStreamLayer.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ Draws a plot as a strip of tiles, each covering a fixed width of x values, that scrolls with the value range.
+
+ Moving the x range only moves the strip, so paths are drawn when a tile comes into view or receives new points,
+ rather than every time the range moves.  Changing the y range or the x scale draws every tile again.  Points
+ must be in ascending x order and are only expected to be added at the end.
+*/
+@interface LineGraphStreamLayer : CALayer
+
+/** Width of a tile, in x values.  Defaults to 0, which uses the width of the value range. */
+@property (nonatomic) CGFloat tileWidth;
+
+/** Number of tiles currently in the strip */
+@property (nonatomic, readonly) NSUInteger tileCount;
+
+/** Brings the tiles up to date with the given points and scrolls the strip to the value range.
+
+ @param points Points of the plot, as NSValue wrapped CGPoints with NSNull marking gaps.
+ @param valueRange Value range shown within the bounds of the layer.
+ @param styleLayer Layer whose stroke attributes are copied to the tiles.
+ @param duration Duration of the scroll animation, tiles are moved without animation if 0.
+*/
+- (void)updateWithPoints:(NSArray *)points
+              valueRange:(CGRect)valueRange
+              styleLayer:(CAShapeLayer *)styleLayer
+                duration:(CFTimeInterval)duration;
+
+/** Removes all tiles, so the next update draws them again */
+- (void)removeAllTiles;
+
+@end
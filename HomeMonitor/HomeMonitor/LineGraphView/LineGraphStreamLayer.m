@@ -0,0 +1,293 @@
+//
+//  LineGraphStreamLayer.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphStreamLayer.h"
+#import "LineGraphUtils.h"
+
+/** Tiles scrolled past before the strip is drawn again from a new origin, so positions keep their precision */
+#define LINE_GRAPH_STREAM_MAX_TILE_INDEX 1024
+
+@interface LineGraphStreamLayer () {
+    CALayer *_contentLayer;
+    NSMutableArray *_tiles;
+    NSMutableArray *_reusableTiles;
+    
+    /* x value at the origin of the content layer, tile i starts at _originValue + i * _drawnTileWidth */
+    double _originValue;
+    NSInteger _firstTileIndex;
+    /* One past the highest tile index drawn */
+    NSInteger _drawnTileEnd;
+    double _lastDrawnX;
+    
+    CGSize _drawnSize;
+    CGRect _drawnValueRange;
+    CGFloat _drawnTileWidth;
+}
+
+@end
+
+@implementation LineGraphStreamLayer
+
+- (id)init {
+    self = [super init];
+    
+    if (self) {
+        self.masksToBounds = TRUE;
+        
+        _contentLayer = [CALayer layer];
+        _contentLayer.anchorPoint = CGPointZero;
+        [self addSublayer:_contentLayer];
+        
+        _tiles = [NSMutableArray array];
+        _reusableTiles = [NSMutableArray array];
+        _lastDrawnX = -INFINITY;
+    }
+    
+    return self;
+}
+
+- (id<CAAction>)actionForKey:(NSString *)event {
+    return nil;
+}
+
+- (NSUInteger)tileCount {
+    return _tiles.count;
+}
+
+- (void)removeAllTiles {
+    for (CAShapeLayer *tile in _tiles) {
+        [tile removeFromSuperlayer];
+        tile.path = NULL;
+    }
+    
+    [_reusableTiles addObjectsFromArray:_tiles];
+    [_tiles removeAllObjects];
+    
+    _drawnTileEnd = _firstTileIndex = 0;
+    _lastDrawnX = -INFINITY;
+}
+
+- (void)updateWithPoints:(NSArray *)points
+              valueRange:(CGRect)valueRange
+              styleLayer:(CAShapeLayer *)styleLayer
+                duration:(CFTimeInterval)duration {
+    
+    if (CGRectGetWidth(valueRange) <= 0 || CGRectGetWidth(self.bounds) <= 0) {
+        [self removeAllTiles];
+        return;
+    }
+    
+    [CATransaction begin];
+    [CATransaction setDisableActions:TRUE];
+    
+    CGFloat tileWidth = (self.tileWidth > 0) ? self.tileWidth : CGRectGetWidth(valueRange);
+    double lastX = -INFINITY;
+    
+    for (NSUInteger i = points.count; i-- > 0;) {
+        if (![points[i] isEqual:[NSNull null]]) {
+            lastX = [(NSValue *)points[i] CGPointValue].x;
+            break;
+        }
+    }
+    
+    // Anything but a move of the x range to the right, or points going back in x, changes the drawing of every tile
+    BOOL needsRedraw = (_tiles.count == 0
+                        || !CGSizeEqualToSize(self.bounds.size, _drawnSize)
+                        || tileWidth != _drawnTileWidth
+                        || CGRectGetWidth(valueRange) != CGRectGetWidth(_drawnValueRange)
+                        || CGRectGetMinY(valueRange) != CGRectGetMinY(_drawnValueRange)
+                        || CGRectGetHeight(valueRange) != CGRectGetHeight(_drawnValueRange)
+                        || lastX < _lastDrawnX
+                        || floor((CGRectGetMinX(valueRange) - _originValue) / tileWidth) > LINE_GRAPH_STREAM_MAX_TILE_INDEX
+                        || floor((CGRectGetMinX(valueRange) - _originValue) / tileWidth) - 1 < _firstTileIndex);
+    
+    if (needsRedraw) {
+        [self removeAllTiles];
+        
+        _originValue = floor(CGRectGetMinX(valueRange) / tileWidth) * tileWidth;
+        _drawnSize = self.bounds.size;
+        _drawnTileWidth = tileWidth;
+        _contentLayer.frame = CGRectMake(0, 0, 0, CGRectGetHeight(self.bounds));
+    }
+    
+    _drawnValueRange = valueRange;
+    
+    // The tile left of the range is kept for the segment that crosses into view
+    NSInteger firstIndex = (NSInteger)floor((CGRectGetMinX(valueRange) - _originValue) / tileWidth) - 1;
+    NSInteger lastIndex = (NSInteger)floor((CGRectGetMaxX(valueRange) - _originValue) / tileWidth);
+    
+    // Recycle tiles that scrolled out on the left
+    while (_tiles.count > 0 && _firstTileIndex < firstIndex) {
+        CAShapeLayer *tile = _tiles[0];
+        [tile removeFromSuperlayer];
+        [_reusableTiles addObject:tile];
+        [_tiles removeObjectAtIndex:0];
+        _firstTileIndex++;
+    }
+    
+    if (_tiles.count == 0) {
+        _firstTileIndex = firstIndex;
+        _drawnTileEnd = firstIndex;
+    }
+    
+    while (_firstTileIndex + (NSInteger)_tiles.count <= lastIndex) {
+        CAShapeLayer *tile = [_reusableTiles lastObject];
+        
+        if (tile != nil) {
+            [_reusableTiles removeLastObject];
+        } else {
+            tile = [CAShapeLayer layer];
+            tile.fillColor = nil;
+        }
+        
+        [_tiles addObject:tile];
+        [_contentLayer addSublayer:tile];
+    }
+    
+    // The tile holding the last drawn point gets the segments to any new points, tiles after it are new
+    NSInteger dirtyIndex = _drawnTileEnd;
+    
+    if (lastX > _lastDrawnX) {
+        if (_lastDrawnX > -INFINITY) {
+            dirtyIndex = MIN(dirtyIndex, (NSInteger)floor((_lastDrawnX - _originValue) / tileWidth));
+        } else {
+            dirtyIndex = _firstTileIndex;
+        }
+    }
+    
+    dirtyIndex = MAX(dirtyIndex, _firstTileIndex);
+    
+    if (dirtyIndex <= lastIndex) {
+        [self drawTilesFromIndex:dirtyIndex toIndex:lastIndex points:points valueRange:valueRange styleLayer:styleLayer];
+    }
+    
+    _drawnTileEnd = MAX(_drawnTileEnd, lastIndex + 1);
+    _lastDrawnX = lastX;
+    
+    CGFloat scale = CGRectGetWidth(self.bounds) / CGRectGetWidth(valueRange);
+    CGPoint position = CGPointMake(-(CGRectGetMinX(valueRange) - _originValue) * scale, 0);
+    
+    if (duration > 0 && !needsRedraw) {
+        CABasicAnimation *animation = [CABasicAnimation animationWithKeyPath:@"position"];
+        animation.fromValue = [NSValue valueWithCGPoint:_contentLayer.position];
+        animation.toValue = [NSValue valueWithCGPoint:position];
+        animation.duration = duration;
+        
+        [_contentLayer addAnimation:animation forKey:@"position"];
+    }
+    
+    _contentLayer.position = position;
+    
+    [CATransaction commit];
+}
+
+/* Draws the tiles in [firstIndex, lastIndex] in a single pass over the points at the end of the plot.  Each tile
+ draws the segments starting within it, so segments crossing into the next tile are not drawn twice.  The first
+ tile of the strip also draws the segment coming in from the point before it.
+*/
+- (void)drawTilesFromIndex:(NSInteger)firstIndex
+                   toIndex:(NSInteger)lastIndex
+                    points:(NSArray *)points
+                valueRange:(CGRect)valueRange
+                styleLayer:(CAShapeLayer *)styleLayer {
+    
+    NSUInteger tileCount = lastIndex - firstIndex + 1;
+    CGMutablePathRef *paths = malloc(sizeof(CGMutablePathRef) * tileCount);
+    
+    // Without tiles the next update finds nothing drawn and draws every tile again
+    if (paths == NULL) {
+        [self removeAllTiles];
+        return;
+    }
+    
+    CGFloat scale = CGRectGetWidth(self.bounds) / CGRectGetWidth(valueRange);
+    CGRect frame = CGRectMake(0, 0, CGRectGetWidth(self.bounds), CGRectGetHeight(self.bounds));
+    double firstTileStart = _originValue + firstIndex * _drawnTileWidth;
+    
+    for (NSUInteger i = 0; i < tileCount; i++) {
+        paths[i] = CGPathCreateMutable();
+    }
+    
+    // Only points at the end of the plot are new, so find the first one in the range from the back
+    NSUInteger start = points.count;
+    
+    while (start > 0) {
+        id value = points[start - 1];
+        
+        if (![value isEqual:[NSNull null]] && [(NSValue *)value CGPointValue].x < firstTileStart) {
+            break;
+        }
+        
+        start--;
+    }
+    
+    if (start > 0 && firstIndex == _firstTileIndex) {
+        start--;
+    }
+    
+    NSInteger previousTile = NSIntegerMin;
+    
+    for (NSUInteger i = start; i < points.count; i++) {
+        id value = points[i];
+        
+        if ([value isEqual:[NSNull null]]) {
+            previousTile = NSIntegerMin;
+            continue;
+        }
+        
+        CGPoint point = [(NSValue *)value CGPointValue];
+        NSInteger tile = (NSInteger)floor((point.x - _originValue) / _drawnTileWidth);
+        CGFloat y = OffsetYForValue(point.y, frame, valueRange);
+        
+        if (tile < firstIndex) {
+            CGFloat x = (point.x - _originValue - firstIndex * _drawnTileWidth) * scale;
+            CGPathMoveToPoint(paths[0], NULL, x, y);
+            previousTile = firstIndex;
+            continue;
+        }
+        
+        // Finish the last segment of the previous tile
+        if (previousTile >= firstIndex && previousTile < tile) {
+            CGFloat x = (point.x - _originValue - previousTile * _drawnTileWidth) * scale;
+            CGPathAddLineToPoint(paths[previousTile - firstIndex], NULL, x, y);
+        }
+        
+        if (tile > lastIndex) {
+            break;
+        }
+        
+        CGMutablePathRef path = paths[tile - firstIndex];
+        CGFloat x = (point.x - _originValue - tile * _drawnTileWidth) * scale;
+        
+        if (previousTile == tile) {
+            CGPathAddLineToPoint(path, NULL, x, y);
+        } else {
+            CGPathMoveToPoint(path, NULL, x, y);
+        }
+        
+        previousTile = tile;
+    }
+    
+    for (NSUInteger i = 0; i < tileCount; i++) {
+        NSInteger tileIndex = firstIndex + i;
+        CAShapeLayer *tile = _tiles[tileIndex - _firstTileIndex];
+        
+        tile.frame = CGRectMake(tileIndex * _drawnTileWidth * scale, 0, _drawnTileWidth * scale, CGRectGetHeight(self.bounds));
+        tile.lineWidth = styleLayer.lineWidth;
+        tile.lineCap = styleLayer.lineCap;
+        tile.lineJoin = styleLayer.lineJoin;
+        tile.lineDashPattern = styleLayer.lineDashPattern;
+        tile.strokeColor = styleLayer.strokeColor;
+        tile.path = paths[i];
+        
+        CGPathRelease(paths[i]);
+    }
+    
+    free(paths);
+}
+
+@end
@@ -0,0 +1,272 @@
+//
+//  LineGraphTickGenerator.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphTickGenerator.h"
+
+// Mantissas are kept below this so additions can not overflow
+#define MANTISSA_LIMIT (INT64_MAX / 4)
+
+static const double PowersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool MultiplyByPowerOfTen(int64_t value, int power, int64_t *result) {
+    for (int i = 0; i < power; i++) {
+        if (value > MANTISSA_LIMIT / 10 || value < -MANTISSA_LIMIT / 10) {
+            return false;
+        }
+
+        value *= 10;
+    }
+
+    *result = value;
+
+    return true;
+}
+
+static bool Multiply(int64_t a, int64_t b, int64_t *result) {
+    if (a != 0 && (b > MANTISSA_LIMIT / llabs(a) || b < -MANTISSA_LIMIT / llabs(a))) {
+        return false;
+    }
+
+    *result = a * b;
+
+    return true;
+}
+
+/* Rounds to a multiple of unit, halfway cases away from zero like NSRoundPlain. */
+static int64_t RoundPlain(int64_t value, int64_t unit) {
+    if (unit <= 1) {
+        return value;
+    }
+
+    int64_t remainder = value % unit;
+    int64_t result = value - remainder;
+
+    if (remainder >= 0 && remainder * 2 >= unit) {
+        result += unit;
+    } else if (remainder < 0 && -remainder * 2 >= unit) {
+        result -= unit;
+    }
+
+    return result;
+}
+
+bool LineGraphDecimalParse(const char *string, LineGraphDecimal *decimal) {
+    bool isNegative = false;
+    bool hasPoint = false;
+    bool hasDigits = false;
+    int64_t mantissa = 0;
+    int exponent = 0;
+
+    if (*string == '-') {
+        isNegative = true;
+        string++;
+    }
+
+    for (; *string != '\0'; string++) {
+        if (*string == '.' && !hasPoint) {
+            hasPoint = true;
+        } else if (*string >= '0' && *string <= '9') {
+            if (mantissa > (MANTISSA_LIMIT - 9) / 10) {
+                return false;
+            }
+
+            mantissa = mantissa * 10 + (*string - '0');
+            exponent -= hasPoint ? 1 : 0;
+            hasDigits = true;
+        } else {
+            return false;
+        }
+    }
+
+    decimal->mantissa = isNegative ? -mantissa : mantissa;
+    decimal->exponent = exponent;
+
+    return hasDigits && exponent >= LINE_GRAPH_DECIMAL_MIN_EXPONENT;
+}
+
+size_t LineGraphDecimalFormat(LineGraphDecimal decimal, char *string) {
+    int64_t mantissa = decimal.mantissa;
+    int exponent = decimal.exponent;
+
+    if (mantissa == 0) {
+        strcpy(string, "0");
+        return 1;
+    }
+
+    // Drop trailing zeros, the way NSDecimal compacts its values
+    while (mantissa % 10 == 0) {
+        mantissa /= 10;
+        exponent += 1;
+    }
+
+    char digits[24];
+    size_t digitCount = 0;
+    uint64_t magnitude = (mantissa < 0) ? -(uint64_t)mantissa : (uint64_t)mantissa;
+
+    while (magnitude > 0) {
+        digits[digitCount++] = '0' + (char)(magnitude % 10);
+        magnitude /= 10;
+    }
+
+    size_t length = 0;
+
+    if (mantissa < 0) {
+        string[length++] = '-';
+    }
+
+    if (exponent >= 0) {
+        while (digitCount > 0) {
+            string[length++] = digits[--digitCount];
+        }
+
+        for (int i = 0; i < exponent; i++) {
+            string[length++] = '0';
+        }
+    } else if ((size_t)-exponent >= digitCount) {
+        string[length++] = '0';
+        string[length++] = '.';
+
+        for (size_t i = digitCount; i < (size_t)-exponent; i++) {
+            string[length++] = '0';
+        }
+
+        while (digitCount > 0) {
+            string[length++] = digits[--digitCount];
+        }
+    } else {
+        while (digitCount > 0) {
+            if (digitCount == (size_t)-exponent) {
+                string[length++] = '.';
+            }
+
+            string[length++] = digits[--digitCount];
+        }
+    }
+
+    string[length] = '\0';
+
+    return length;
+}
+
+double LineGraphDecimalToDouble(LineGraphDecimal decimal) {
+    double value = (double)decimal.mantissa;
+    int exponent = decimal.exponent;
+
+    // Powers of ten up to 1e22 are exact, so a single multiplication or division rounds correctly
+    while (exponent > 22) {
+        value *= PowersOfTen[22];
+        exponent -= 22;
+    }
+
+    while (exponent < -22) {
+        value /= PowersOfTen[22];
+        exponent += 22;
+    }
+
+    return (exponent >= 0) ? value * PowersOfTen[exponent] : value / PowersOfTen[-exponent];
+}
+
+LineGraphDecimal LineGraphNiceStep(double minimumStep) {
+    int exponent = (int)floor(log10(minimumStep));
+    double fraction = minimumStep / pow(10, exponent);
+    LineGraphDecimal step = { 1, exponent };
+
+    // Rounding in log10 can leave the fraction just outside [1, 10)
+    if (fraction <= 1) {
+        step.mantissa = 1;
+    } else if (fraction <= 2) {
+        step.mantissa = 2;
+    } else if (fraction <= 5) {
+        step.mantissa = 5;
+    } else {
+        step.exponent += 1;
+    }
+
+    return step;
+}
+
+LineGraphDecimal LineGraphNiceStepBelow(LineGraphDecimal step) {
+    switch (step.mantissa) {
+        case 5:
+            step.mantissa = 2;
+            break;
+        case 2:
+            step.mantissa = 1;
+            break;
+        default:
+            step.mantissa = 5;
+            step.exponent -= 1;
+            break;
+    }
+
+    return step;
+}
+
+long LineGraphTicksGenerate(LineGraphDecimal interval, double intervalValue, LineGraphDecimal offset, double offsetValue, short scale, double start, double end, LineGraphDecimal *ticks, size_t maxCount) {
+    // Work in units of the finest exponent, so interval and offset are both integers
+    int exponent = (interval.exponent < offset.exponent) ? interval.exponent : offset.exponent;
+    int64_t intervalUnits, offsetUnits;
+
+    if (!MultiplyByPowerOfTen(interval.mantissa, interval.exponent - exponent, &intervalUnits)
+        || !MultiplyByPowerOfTen(offset.mantissa, offset.exponent - exponent, &offsetUnits)) {
+        return -1;
+    }
+
+    // Results are rounded to multiples of 10^-scale, a no-op if that is coarser than the working exponent
+    int64_t roundingUnit = 1;
+
+    if (scale != LINE_GRAPH_DECIMAL_NO_SCALE && -scale > exponent && !MultiplyByPowerOfTen(1, -scale - exponent, &roundingUnit)) {
+        return -1;
+    }
+
+    double steps = floor((start + offsetValue) / intervalValue);
+    int64_t value;
+
+    if (!(fabs(steps) < (double)MANTISSA_LIMIT) || !Multiply((int64_t)steps, intervalUnits, &value)) {
+        return -1;
+    }
+
+    value = RoundPlain(RoundPlain(value, roundingUnit) - offsetUnits, roundingUnit);
+
+    size_t count = 0;
+
+    while (count < maxCount) {
+        double tick = LineGraphDecimalToDouble((LineGraphDecimal){ value, exponent });
+
+        if (!(tick <= end)) {
+            break;
+        }
+
+        if (tick >= start) {
+            ticks[count].mantissa = value;
+            ticks[count].exponent = exponent;
+            count++;
+        }
+
+        if (value > MANTISSA_LIMIT - llabs(intervalUnits) || value < -MANTISSA_LIMIT + llabs(intervalUnits)) {
+            return -1;
+        }
+
+        int64_t next = RoundPlain(value + intervalUnits, roundingUnit);
+
+        // An interval that is zero, negative or rounds away would never reach the end
+        if (next <= value) {
+            break;
+        }
+
+        value = next;
+    }
+
+    return (long)count;
+}
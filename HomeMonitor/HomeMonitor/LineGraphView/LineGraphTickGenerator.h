@@ -0,0 +1,67 @@
+//
+//  LineGraphTickGenerator.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphTickGenerator_h
+#define LineGraphView_LineGraphTickGenerator_h
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Disables rounding, same value as NSDecimalNoScale */
+#define LINE_GRAPH_DECIMAL_NO_SCALE SHRT_MAX
+
+/** Lowest exponent accepted by LineGraphDecimalParse, which bounds the length of formatted strings */
+#define LINE_GRAPH_DECIMAL_MIN_EXPONENT -40
+
+/** Longest string written by LineGraphDecimalFormat, including the terminating NUL */
+#define LINE_GRAPH_DECIMAL_STRING_LENGTH 64
+
+/** Exact decimal value of mantissa * 10^exponent */
+typedef struct {
+    int64_t mantissa;
+    int exponent;
+} LineGraphDecimal;
+
+/** Parses a plain decimal string such as "-12.50", as written by -[NSDecimalNumber stringValue].
+
+ @return false if the string is not a plain decimal, or has too many digits to calculate ticks with.
+*/
+bool LineGraphDecimalParse(const char *string, LineGraphDecimal *decimal);
+
+/** Writes the shortest plain decimal representation, matching -[NSDecimalNumber stringValue].
+
+ @param string Must hold LINE_GRAPH_DECIMAL_STRING_LENGTH characters.
+ @return Length of the string.
+*/
+size_t LineGraphDecimalFormat(LineGraphDecimal decimal, char *string);
+
+/** Closest double to a decimal value. */
+double LineGraphDecimalToDouble(LineGraphDecimal decimal);
+
+/** Smallest step of the form 1, 2 or 5 times a power of ten that is at least minimumStep, which must be positive. */
+LineGraphDecimal LineGraphNiceStep(double minimumStep);
+
+/** Next smaller step of the form 1, 2 or 5 times a power of ten. */
+LineGraphDecimal LineGraphNiceStepBelow(LineGraphDecimal step);
+
+/**
+ Calculates the ticks of an axis in one pass, with the same rounding as NSDecimalNumber arithmetic.
+
+ Ticks start at floor((start + offset) / interval) * interval - offset and step by interval, every result
+ rounded to scale decimal places like an NSDecimalNumberBehaviors with NSRoundPlain.  Ticks between start
+ and end are written to ticks, up to maxCount of them.
+
+ @param intervalValue Value of interval as a double, used for the first tick like NSDecimalNumber does.
+ @param offsetValue Value of offset as a double.
+ @param ticks Output ticks, all with the same exponent.
+ @return Number of ticks written, or -1 if the calculation does not fit in 64-bit integers.
+*/
+long LineGraphTicksGenerate(LineGraphDecimal interval, double intervalValue, LineGraphDecimal offset, double offsetValue, short scale, double start, double end, LineGraphDecimal *ticks, size_t maxCount);
+
+#endif
@@ -11,15 +11,20 @@
 
 @interface LineGraphTickInterval : NSObject <NSDecimalNumberBehaviors>
 
-@property (nonatomic, readonly) NSDecimalNumber *interval;
+@property (nonatomic, strong) NSDecimalNumber *interval;
 @property (nonatomic, readonly) NSDecimalNumber *offset;
 @property (nonatomic) short scale;
 @property (nonatomic, copy) NSString *(^labelBlock)(NSDecimalNumber *);
 
 + (LineGraphTickInterval *)intervalWithInterval:(NSDecimalNumber *)interval offset:(NSDecimalNumber *)offset scale:(short)scale;
+- (id)initWithInterval:(NSDecimalNumber *)interval offset:(NSDecimalNumber *)offset scale:(short)scale;
 
 - (NSArray *)ticksForStart:(CGFloat)start end:(CGFloat)end;
 - (NSArray *)labelsForStart:(CGFloat)start end:(CGFloat)end;
 
+/** Calculates ticks and their labels in a single pass.  Either pointer may be NULL.  At most 1000 ticks are
+ returned, and an interval that does not advance yields a single tick. */
+- (void)getTicks:(NSArray **)ticks labels:(NSArray **)labels forStart:(CGFloat)start end:(CGFloat)end;
+
 
 @end
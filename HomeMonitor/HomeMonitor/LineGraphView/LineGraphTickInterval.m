@@ -7,6 +7,18 @@
 //
 
 #import "LineGraphTickInterval.h"
+#import "LineGraphTickGenerator.h"
+
+// Axes never need more ticks than this, and it bounds the loop for tiny intervals
+static const NSUInteger LineGraphTickIntervalMaxTickCount = 1000;
+
+@interface LineGraphTickInterval () {
+    LineGraphDecimal _fixedInterval;
+    LineGraphDecimal _fixedOffset;
+    BOOL _hasFixedPoint;
+}
+
+@end
 
 @implementation LineGraphTickInterval
 
@@ -18,39 +30,148 @@
     self = [super init];
     
     if (self) {
-        _interval = interval;
         _offset = offset;
         _scale = scale;
+        
+        self.interval = interval;
     }
     
     return self;
 }
 
+- (void)setInterval:(NSDecimalNumber *)interval {
+    _interval = interval;
+    
+    // Most intervals fit in 64-bit fixed point, the rest are stepped with NSDecimalNumber
+    _hasFixedPoint = (interval != nil && _offset != nil
+                      && LineGraphDecimalParse([[interval stringValue] UTF8String], &_fixedInterval)
+                      && LineGraphDecimalParse([[_offset stringValue] UTF8String], &_fixedOffset));
+}
+
 - (NSArray *)ticksForStart:(CGFloat)start end:(CGFloat)end {
-    NSDecimalNumber *value = [[[[NSDecimalNumber alloc] initWithDouble:floor((start + self.offset.doubleValue) / self.interval.doubleValue)] decimalNumberByMultiplyingBy:self.interval withBehavior:self] decimalNumberBySubtracting:self.offset withBehavior:self];
+    NSArray *ticks = nil;
+    
+    [self getTicks:&ticks labels:NULL forStart:start end:end];
+    
+    return ticks;
+}
 
-    NSMutableArray *returnArray = [NSMutableArray array];
+- (NSArray *)labelsForStart:(CGFloat)start end:(CGFloat)end {
+    NSArray *labels = nil;
     
-    while (value.doubleValue <= end) {
-        if (value.doubleValue >= start)
-            [returnArray addObject:[value copy]];
-        value = [value decimalNumberByAdding:self.interval withBehavior:self];
+    [self getTicks:NULL labels:&labels forStart:start end:end];
+    
+    return labels;
+}
+
+- (void)getTicks:(NSArray **)ticks labels:(NSArray **)labels forStart:(CGFloat)start end:(CGFloat)end {
+    if (self.interval == nil) {
+        if (ticks != NULL) {
+            *ticks = @[];
+        }
+        
+        if (labels != NULL) {
+            *labels = @[];
+        }
+        
+        return;
     }
     
-    return returnArray;
+    LineGraphDecimal *fixedTicks = NULL;
+    long tickCount = -1;
+    
+    // Without room for the fixed point ticks they are generated as decimal numbers instead
+    if (_hasFixedPoint) {
+        fixedTicks = malloc(sizeof(LineGraphDecimal) * LineGraphTickIntervalMaxTickCount);
+    }
+    
+    if (fixedTicks != NULL) {
+        tickCount = LineGraphTicksGenerate(_fixedInterval, self.interval.doubleValue, _fixedOffset, self.offset.doubleValue,
+                                           self.scale, start, end, fixedTicks, LineGraphTickIntervalMaxTickCount);
+    }
+    
+    if (tickCount < 0) {
+        free(fixedTicks);
+        
+        NSArray *decimalTicks = [self decimalTicksForStart:start end:end];
+        
+        if (ticks != NULL) {
+            *ticks = decimalTicks;
+        }
+        
+        if (labels != NULL) {
+            NSMutableArray *decimalLabels = [NSMutableArray arrayWithCapacity:decimalTicks.count];
+            
+            for (NSDecimalNumber *value in decimalTicks) {
+                [decimalLabels addObject:self.labelBlock ? self.labelBlock(value) : [value stringValue]];
+            }
+            
+            *labels = decimalLabels;
+        }
+        
+        return;
+    }
+    
+    NSMutableArray *tickValues = (ticks != NULL) ? [NSMutableArray arrayWithCapacity:tickCount] : nil;
+    NSMutableArray *labelValues = (labels != NULL) ? [NSMutableArray arrayWithCapacity:tickCount] : nil;
+    char string[LINE_GRAPH_DECIMAL_STRING_LENGTH];
+    
+    for (long i = 0; i < tickCount; i++) {
+        LineGraphDecimal tick = fixedTicks[i];
+        NSDecimalNumber *value = nil;
+        
+        if (ticks != NULL || self.labelBlock != nil) {
+            value = [NSDecimalNumber decimalNumberWithMantissa:(tick.mantissa < 0) ? -(unsigned long long)tick.mantissa : (unsigned long long)tick.mantissa
+                                                      exponent:tick.exponent
+                                                    isNegative:tick.mantissa < 0];
+        }
+        
+        if (ticks != NULL) {
+            [tickValues addObject:value];
+        }
+        
+        if (labelValues == nil) {
+            continue;
+        }
+        
+        if (self.labelBlock) {
+            [labelValues addObject:self.labelBlock(value)];
+        } else {
+            size_t length = LineGraphDecimalFormat(tick, string);
+            [labelValues addObject:[[NSString alloc] initWithBytes:string length:length encoding:NSASCIIStringEncoding]];
+        }
+    }
+    
+    free(fixedTicks);
+    
+    if (ticks != NULL) {
+        *ticks = tickValues;
+    }
+    
+    if (labels != NULL) {
+        *labels = labelValues;
+    }
 }
 
-- (NSArray *)labelsForStart:(CGFloat)start end:(CGFloat)end {
+/* Steps through the range with NSDecimalNumber arithmetic, for values that do not fit in fixed point.
+*/
+- (NSArray *)decimalTicksForStart:(CGFloat)start end:(CGFloat)end {
     NSDecimalNumber *value = [[[[NSDecimalNumber alloc] initWithDouble:floor((start + self.offset.doubleValue) / self.interval.doubleValue)] decimalNumberByMultiplyingBy:self.interval withBehavior:self] decimalNumberBySubtracting:self.offset withBehavior:self];
-    
+
     NSMutableArray *returnArray = [NSMutableArray array];
     
-    while (value.doubleValue <= end) {
+    while (value.doubleValue <= end && returnArray.count < LineGraphTickIntervalMaxTickCount) {
         if (value.doubleValue >= start)
-            [returnArray addObject:self.labelBlock ? self.labelBlock(value) : [value stringValue]];
-        value = [value decimalNumberByAdding:self.interval withBehavior:self];
+            [returnArray addObject:[value copy]];
+        
+        NSDecimalNumber *nextValue = [value decimalNumberByAdding:self.interval withBehavior:self];
+        
+        if ([nextValue compare:value] != NSOrderedDescending)
+            break;
+        
+        value = nextValue;
     }
-
+    
     return returnArray;
 }
 
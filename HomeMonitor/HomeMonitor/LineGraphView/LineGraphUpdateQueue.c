@@ -0,0 +1,381 @@
+//
+//  LineGraphUpdateQueue.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphUpdateQueue.h"
+
+bool LineGraphUpdateQueueInit(LineGraphUpdateQueue *queue, size_t capacity) {
+    memset(queue, 0, sizeof(LineGraphUpdateQueue));
+
+    size_t slotCount = 2;
+
+    while (slotCount < capacity) {
+        slotCount *= 2;
+    }
+
+    queue->slots = malloc(sizeof(LineGraphUpdateSlot) * slotCount);
+
+    if (queue->slots == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < slotCount; i++) {
+        queue->slots[i].sequence = i;
+    }
+
+    queue->mask = slotCount - 1;
+
+    return true;
+}
+
+void LineGraphUpdateQueueDestroy(LineGraphUpdateQueue *queue) {
+    free(queue->slots);
+    memset(queue, 0, sizeof(LineGraphUpdateQueue));
+}
+
+bool LineGraphUpdateQueuePush(LineGraphUpdateQueue *queue, const LineGraphUpdate *update) {
+    size_t position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED);
+
+    for (;;) {
+        LineGraphUpdateSlot *slot = &queue->slots[position & queue->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+        if (difference == 0) {
+            // The slot is free for this position, claim it unless another producer got there first
+            if (__atomic_compare_exchange_n(&queue->enqueuePosition, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->update = *update;
+                __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (difference < 0) {
+            // The consumer has not freed the slot from the previous lap yet
+            __atomic_store_n(&queue->overflowed, 1, __ATOMIC_RELEASE);
+            return false;
+        } else {
+            position = __atomic_load_n(&queue->enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+size_t LineGraphUpdateQueuePopBatch(LineGraphUpdateQueue *queue, LineGraphUpdate *updates, size_t maxCount) {
+    size_t position = queue->dequeuePosition;
+    size_t count = 0;
+
+    while (count < maxCount) {
+        LineGraphUpdateSlot *slot = &queue->slots[position & queue->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+
+        // Empty, or the producer that claimed this slot is still writing it
+        if (sequence != position + 1) {
+            break;
+        }
+
+        updates[count++] = slot->update;
+        __atomic_store_n(&slot->sequence, position + queue->mask + 1, __ATOMIC_RELEASE);
+        position++;
+    }
+
+    __atomic_store_n(&queue->dequeuePosition, position, __ATOMIC_RELAXED);
+
+    return count;
+}
+
+bool LineGraphUpdateQueueTakeOverflow(LineGraphUpdateQueue *queue) {
+    return __atomic_exchange_n(&queue->overflowed, 0, __ATOMIC_ACQ_REL) != 0;
+}
+
+bool LineGraphUpdateQueueClaimSchedule(LineGraphUpdateQueue *queue) {
+    // Orders the push before the check, against the opposite order in LineGraphUpdateQueueReleaseSchedule
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return __atomic_exchange_n(&queue->scheduled, 1, __ATOMIC_ACQ_REL) == 0;
+}
+
+bool LineGraphUpdateQueueReleaseSchedule(LineGraphUpdateQueue *queue) {
+    __atomic_store_n(&queue->scheduled, 0, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // A producer that saw the queue scheduled before the release relies on this check to get its update drained
+    LineGraphUpdateSlot *slot = &queue->slots[queue->dequeuePosition & queue->mask];
+    bool isEmpty = (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != queue->dequeuePosition + 1);
+
+    if (isEmpty && __atomic_load_n(&queue->overflowed, __ATOMIC_ACQUIRE) == 0) {
+        return false;
+    }
+
+    return LineGraphUpdateQueueClaimSchedule(queue);
+}
+
+/* Folds next into update if both can be applied as one update, returning whether it did. */
+static bool MergeUpdate(LineGraphUpdate *update, const LineGraphUpdate *next) {
+    if (update->type != next->type || update->plot != next->plot) {
+        return false;
+    }
+
+    switch (update->type) {
+        case kLineGraphUpdateAppend:
+            update->count += next->count;
+            return true;
+
+        case kLineGraphUpdateInsert:
+            // Rows inserted anywhere within or right after the block extend it
+            if (next->row >= update->row && next->row <= update->row + update->count) {
+                update->count += next->count;
+                return true;
+            }
+
+            return false;
+
+        case kLineGraphUpdateDelete:
+            // Deleting the rows that moved into the block's place, or the rows right before it
+            if (next->row == update->row) {
+                update->count += next->count;
+                return true;
+            }
+
+            if (next->row + next->count == update->row) {
+                update->row = next->row;
+                update->count += next->count;
+                return true;
+            }
+
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+size_t LineGraphUpdatesMerge(LineGraphUpdate *updates, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t mergedCount = 1;
+
+    for (size_t i = 1; i < count; i++) {
+        if (!MergeUpdate(&updates[mergedCount - 1], &updates[i])) {
+            updates[mergedCount++] = updates[i];
+        }
+    }
+
+    return mergedCount;
+}
+
+/* Rebasing keeps two lists in the batch buffer, each sorted by plot and row: the rows deleted so far, in the
+ indexes before the batch, and the rows inserted so far, in the indexes after the updates seen so far.  Inserted
+ rows that are deleted again simply drop out of the second list.
+*/
+typedef struct {
+    LineGraphUpdate *ranges;
+    size_t count;
+} RangeList;
+
+static bool RangeBefore(const LineGraphUpdate *range, uint32_t plot, int64_t row) {
+    return range->plot < plot || (range->plot == plot && range->row < row);
+}
+
+static void RangeListInsert(RangeList *list, uint32_t type, uint32_t plot, int64_t row, int64_t count) {
+    size_t i = 0;
+
+    while (i < list->count && RangeBefore(&list->ranges[i], plot, row)) {
+        i++;
+    }
+
+    memmove(&list->ranges[i + 1], &list->ranges[i], sizeof(LineGraphUpdate) * (list->count - i));
+    list->ranges[i] = (LineGraphUpdate){ type, plot, row, count };
+    list->count++;
+}
+
+static void RangeListRemove(RangeList *list, size_t i) {
+    memmove(&list->ranges[i], &list->ranges[i + 1], sizeof(LineGraphUpdate) * (list->count - i - 1));
+    list->count--;
+}
+
+/* Joins the ranges of the plot that ended up touching each other */
+static void RangeListJoin(RangeList *list, uint32_t plot) {
+    for (size_t i = 1; i < list->count; i++) {
+        LineGraphUpdate *previous = &list->ranges[i - 1];
+
+        if (previous->plot == plot && list->ranges[i].plot == plot && previous->row + previous->count == list->ranges[i].row) {
+            previous->count += list->ranges[i].count;
+            RangeListRemove(list, i--);
+        }
+    }
+}
+
+static int64_t RangeListTotal(const RangeList *list, uint32_t plot) {
+    int64_t total = 0;
+
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->ranges[i].plot == plot) {
+            total += list->ranges[i].count;
+        }
+    }
+
+    return total;
+}
+
+/* Number of inserted rows in front of row */
+static int64_t InsertedRowsBefore(const RangeList *inserts, uint32_t plot, int64_t row) {
+    int64_t total = 0;
+
+    for (size_t i = 0; i < inserts->count; i++) {
+        const LineGraphUpdate *range = &inserts->ranges[i];
+
+        if (range->plot == plot && range->row < row) {
+            total += ((range->row + range->count < row) ? range->row + range->count : row) - range->row;
+        }
+    }
+
+    return total;
+}
+
+/* Index before the batch of the given remaining original row */
+static int64_t OriginalRow(const RangeList *deletes, uint32_t plot, int64_t ordinal) {
+    int64_t row = ordinal;
+
+    for (size_t i = 0; i < deletes->count; i++) {
+        const LineGraphUpdate *range = &deletes->ranges[i];
+
+        if (range->plot == plot && range->row <= row) {
+            row += range->count;
+        }
+    }
+
+    return row;
+}
+
+static void RebaseInsert(RangeList *inserts, uint32_t plot, int64_t row, int64_t count) {
+    bool isJoined = false;
+
+    for (size_t i = 0; i < inserts->count; i++) {
+        LineGraphUpdate *range = &inserts->ranges[i];
+
+        if (range->plot != plot) {
+            continue;
+        }
+
+        if (range->row > row) {
+            range->row += count;
+        } else if (range->row + range->count >= row) {
+            // Within or right after rows inserted before, which grow by the new ones
+            range->count += count;
+            isJoined = true;
+        }
+    }
+
+    if (!isJoined) {
+        RangeListInsert(inserts, kLineGraphUpdateInsert, plot, row, count);
+    }
+
+    RangeListJoin(inserts, plot);
+}
+
+static void RebaseDelete(RangeList *deletes, RangeList *inserts, uint32_t plot, int64_t row, int64_t count) {
+    int64_t insertedBefore = InsertedRowsBefore(inserts, plot, row);
+    int64_t originalCount = count - (InsertedRowsBefore(inserts, plot, row + count) - insertedBefore);
+
+    // The original rows left in the deleted rows follow each other once the rows deleted earlier are counted in
+    if (originalCount > 0) {
+        int64_t first = OriginalRow(deletes, plot, row - insertedBefore);
+        int64_t last = OriginalRow(deletes, plot, row - insertedBefore + originalCount - 1);
+
+        for (size_t i = 0; i < deletes->count; i++) {
+            if (deletes->ranges[i].plot == plot && deletes->ranges[i].row > first && deletes->ranges[i].row < last) {
+                RangeListRemove(deletes, i--);
+            }
+        }
+
+        RangeListInsert(deletes, kLineGraphUpdateDelete, plot, first, last - first + 1);
+        RangeListJoin(deletes, plot);
+    }
+
+    for (size_t i = 0; i < inserts->count; i++) {
+        LineGraphUpdate *range = &inserts->ranges[i];
+
+        if (range->plot != plot || range->row + range->count <= row) {
+            continue;
+        }
+
+        int64_t start = (range->row > row) ? range->row : row;
+        int64_t end = (range->row + range->count < row + count) ? range->row + range->count : row + count;
+
+        if (end > start) {
+            range->count -= end - start;
+        }
+
+        range->row = (range->row >= row + count) ? range->row - count : ((range->row > row) ? row : range->row);
+
+        if (range->count == 0) {
+            RangeListRemove(inserts, i--);
+        }
+    }
+
+    RangeListJoin(inserts, plot);
+}
+
+bool LineGraphUpdatesRebase(const LineGraphUpdate *updates, size_t count, LineGraphUpdatePointCount pointCount, void *context,
+                            LineGraphUpdate *batch, size_t *batchCount) {
+    size_t deleteCount = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        deleteCount += (updates[i].type == kLineGraphUpdateDelete);
+    }
+
+    // Every update adds at most one range to its list, so deletes fit in front of the inserts
+    RangeList deletes = { batch, 0 };
+    RangeList inserts = { batch + deleteCount, 0 };
+
+    *batchCount = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const LineGraphUpdate *update = &updates[i];
+        int64_t length = pointCount(context, update->plot) + RangeListTotal(&inserts, update->plot) - RangeListTotal(&deletes, update->plot);
+
+        if (update->count < 0 || length < 0) {
+            return false;
+        }
+
+        if (update->count == 0) {
+            continue;
+        }
+
+        switch (update->type) {
+            case kLineGraphUpdateInsert:
+                if (update->row < 0 || update->row > length) {
+                    return false;
+                }
+
+                RebaseInsert(&inserts, update->plot, update->row, update->count);
+                break;
+
+            case kLineGraphUpdateDelete:
+                if (update->row < 0 || update->row + update->count > length) {
+                    return false;
+                }
+
+                RebaseDelete(&deletes, &inserts, update->plot, update->row, update->count);
+                break;
+
+            case kLineGraphUpdateAppend:
+                RebaseInsert(&inserts, update->plot, length, update->count);
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    memmove(batch + deletes.count, inserts.ranges, sizeof(LineGraphUpdate) * inserts.count);
+    *batchCount = deletes.count + inserts.count;
+
+    return true;
+}
@@ -0,0 +1,107 @@
+//
+//  LineGraphUpdateQueue.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphUpdateQueue_h
+#define LineGraphView_LineGraphUpdateQueue_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of the cache lines the producer and consumer positions are kept apart by */
+#define LINE_GRAPH_CACHE_LINE_SIZE 64
+
+typedef enum {
+    /** Points inserted at row, in the indexes after the update */
+    kLineGraphUpdateInsert,
+    /** Points deleted at row, in the indexes before the update */
+    kLineGraphUpdateDelete,
+    /** Points added to the end of the plot, row is unused */
+    kLineGraphUpdateAppend
+} LineGraphUpdateType;
+
+/** A pending change to the points of a plot */
+typedef struct {
+    uint32_t type;
+    uint32_t plot;
+    int64_t row;
+    int64_t count;
+} LineGraphUpdate;
+
+typedef struct {
+    size_t sequence;
+    LineGraphUpdate update;
+} LineGraphUpdateSlot;
+
+/**
+ Bounded lock-free queue of plot updates, filled from any thread and drained by a single consumer.
+
+ Every slot carries a sequence number telling producers and the consumer whose turn it is, so a push is one
+ compare-and-swap on the enqueue position and a pop needs none.
+*/
+typedef struct {
+    LineGraphUpdateSlot *slots;
+    size_t mask;
+    char enqueuePadding[LINE_GRAPH_CACHE_LINE_SIZE];
+    size_t enqueuePosition;
+    char dequeuePadding[LINE_GRAPH_CACHE_LINE_SIZE - sizeof(size_t)];
+    size_t dequeuePosition;
+    char flagsPadding[LINE_GRAPH_CACHE_LINE_SIZE - sizeof(size_t)];
+    /** Set by pushes that found the queue full, their updates are lost */
+    int overflowed;
+    /** Set while the consumer has been asked to drain the queue */
+    int scheduled;
+} LineGraphUpdateQueue;
+
+/** Sets up an empty queue holding at least capacity updates.  Returns false if storage could not be allocated. */
+bool LineGraphUpdateQueueInit(LineGraphUpdateQueue *queue, size_t capacity);
+void LineGraphUpdateQueueDestroy(LineGraphUpdateQueue *queue);
+
+/** Adds an update from any thread.  Returns false and marks the queue as overflowed if it is full. */
+bool LineGraphUpdateQueuePush(LineGraphUpdateQueue *queue, const LineGraphUpdate *update);
+
+/** Removes up to maxCount updates in the order they were pushed.  Only one thread may pop.
+
+ @return Number of updates written to updates.
+*/
+size_t LineGraphUpdateQueuePopBatch(LineGraphUpdateQueue *queue, LineGraphUpdate *updates, size_t maxCount);
+
+/** Clears the overflow mark, returning whether it was set */
+bool LineGraphUpdateQueueTakeOverflow(LineGraphUpdateQueue *queue);
+
+/** Marks the queue as scheduled, returning true if it was not, in which case the caller must schedule a drain. */
+bool LineGraphUpdateQueueClaimSchedule(LineGraphUpdateQueue *queue);
+
+/** Called by the consumer when it stops draining.  Returns true if updates arrived in the meantime, in which case
+ the queue stays scheduled and the consumer must keep draining.
+*/
+bool LineGraphUpdateQueueReleaseSchedule(LineGraphUpdateQueue *queue);
+
+/** Merges neighbouring updates that can be expressed as one, like consecutive inserts into the same block of rows
+ or appends to the same plot.  The order of the remaining updates is kept, each still in the indexes left by the
+ ones before it.
+
+ @return Number of updates left at the start of updates.
+*/
+size_t LineGraphUpdatesMerge(LineGraphUpdate *updates, size_t count);
+
+/** Number of points a plot had before the updates being rebased */
+typedef int64_t (*LineGraphUpdatePointCount)(void *context, uint32_t plot);
+
+/** Rewrites updates that were pushed one after another, each in the indexes left by the ones before it, as one
+ batch the way an update block applies it: deletes in the indexes before the batch, followed by inserts in the
+ indexes after it.  Appends become inserts at the end of their plot, touching rows are joined, and rows inserted
+ and deleted again within the batch drop out.
+
+ @param batch Room for count updates.
+ @return False if an update reaches past the end of its plot, in which case the updates do not describe the
+ change and the plots have to be reloaded.
+*/
+bool LineGraphUpdatesRebase(const LineGraphUpdate *updates, size_t count, LineGraphUpdatePointCount pointCount, void *context,
+                            LineGraphUpdate *batch, size_t *batchCount);
+
+#endif
@@ -0,0 +1,49 @@
+//
+//  LineGraphUpdateScheduler.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <UIKit/UIKit.h>
+
+#import "LineGraphView.h"
+
+/**
+ Collects point insertions, deletions and appends from any thread and applies them to a LineGraphView at most
+ once per display refresh.
+
+ Every queued update is in the indexes left by the update queued before it, the way the data changed.  Updates
+ arriving within the same frame are merged where possible and applied in a single update block.  When
+ updates arrive faster than the frames, or while the previous update is still animating, the intermediate states
+ are shown without animation so the graph keeps up with the data.
+*/
+@interface LineGraphUpdateScheduler : NSObject
+
+@property (nonatomic, readonly, weak) LineGraphView *graphView;
+
+/** Animator for inserted and appended points.  Defaults to a stroke animation. */
+@property (nonatomic, strong) id<LineGraphPlotAnimator> insertAnimator;
+
+/** Animator for deleted points.  Defaults to a fade out. */
+@property (nonatomic, strong) id<LineGraphPlotAnimator> deleteAnimator;
+
+/** Called on the main thread within every update block, before it ends.  Use it to set the value range. */
+@property (nonatomic, copy) void (^updateBlock)(LineGraphView *graphView);
+
+/** Number of update blocks applied without animation because updates arrived too quickly */
+@property (nonatomic, readonly) NSUInteger coalescedUpdateCount;
+
+- (id)initWithGraphView:(LineGraphView *)graphView;
+
+/** Queues an insertion, see insertPointsAtIndexPath:count:animator:.  Safe to call from any thread. */
+- (void)insertPointsAtIndexPath:(NSIndexPath *)indexPath count:(NSInteger)count;
+
+/** Queues a deletion, see deletePointsAtIndexPath:count:animator:.  Safe to call from any thread. */
+- (void)deletePointsAtIndexPath:(NSIndexPath *)indexPath count:(NSUInteger)count;
+
+/** Queues points added to the end of a plot, see appendPointsToPlot:count:animator:.  Safe to call from any thread. */
+- (void)appendPointsToPlot:(NSUInteger)plot count:(NSInteger)count;
+
+@end
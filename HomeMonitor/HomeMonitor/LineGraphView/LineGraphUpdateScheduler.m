@@ -0,0 +1,170 @@
+//
+//  LineGraphUpdateScheduler.m
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#import "LineGraphUpdateScheduler.h"
+#import "LineGraphPlotAnimation.h"
+#import "LineGraphUpdateQueue.h"
+
+/** Updates the queue holds between two frames, more than that reload the graph instead */
+#define LINE_GRAPH_UPDATE_QUEUE_CAPACITY 1024
+
+@interface LineGraphUpdateScheduler () {
+    LineGraphUpdateQueue _queue;
+    LineGraphUpdate *_updates;
+    LineGraphUpdate *_batchUpdates;
+    CADisplayLink *_displayLink;
+    CFTimeInterval _animationEndTime;
+}
+
+@end
+
+@implementation LineGraphUpdateScheduler
+
+- (id)initWithGraphView:(LineGraphView *)graphView {
+    self = [super init];
+    
+    if (self) {
+        _graphView = graphView;
+        _insertAnimator = [LineGraphPlotAnimation animationOfType:kLineGraphAnimationStroke];
+        _deleteAnimator = [LineGraphPlotAnimation animationOfType:kLineGraphAnimationFadeOut];
+        _updates = malloc(sizeof(LineGraphUpdate) * LINE_GRAPH_UPDATE_QUEUE_CAPACITY);
+        _batchUpdates = malloc(sizeof(LineGraphUpdate) * LINE_GRAPH_UPDATE_QUEUE_CAPACITY);
+        
+        if (_updates == NULL || _batchUpdates == NULL || !LineGraphUpdateQueueInit(&_queue, LINE_GRAPH_UPDATE_QUEUE_CAPACITY)) {
+            free(_updates);
+            free(_batchUpdates);
+            return nil;
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [_displayLink invalidate];
+    
+    LineGraphUpdateQueueDestroy(&_queue);
+    free(_updates);
+    free(_batchUpdates);
+}
+
+- (void)insertPointsAtIndexPath:(NSIndexPath *)indexPath count:(NSInteger)count {
+    LineGraphUpdate update = { kLineGraphUpdateInsert, (uint32_t)indexPath.section, indexPath.row, count };
+    [self pushUpdate:&update];
+}
+
+- (void)deletePointsAtIndexPath:(NSIndexPath *)indexPath count:(NSUInteger)count {
+    LineGraphUpdate update = { kLineGraphUpdateDelete, (uint32_t)indexPath.section, indexPath.row, count };
+    [self pushUpdate:&update];
+}
+
+- (void)appendPointsToPlot:(NSUInteger)plot count:(NSInteger)count {
+    LineGraphUpdate update = { kLineGraphUpdateAppend, (uint32_t)plot, 0, count };
+    [self pushUpdate:&update];
+}
+
+/* Queues the update and makes sure a display link is running to apply it.  An update that does not fit is
+ dropped, the queue remembers the overflow and the next frame reloads the graph instead.
+*/
+- (void)pushUpdate:(const LineGraphUpdate *)update {
+    LineGraphUpdateQueuePush(&_queue, update);
+    
+    if (LineGraphUpdateQueueClaimSchedule(&_queue)) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self startDisplayLink];
+        });
+    }
+}
+
+- (void)startDisplayLink {
+    if (_displayLink == nil) {
+        // The display link retains the scheduler until it is invalidated once the queue runs dry
+        _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidFire:)];
+        [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+    }
+}
+
+- (void)displayLinkDidFire:(CADisplayLink *)displayLink {
+    [self applyUpdates];
+    
+    if (!LineGraphUpdateQueueReleaseSchedule(&_queue)) {
+        [_displayLink invalidate];
+        _displayLink = nil;
+    }
+}
+
+static int64_t GraphViewPointCount(void *context, uint32_t plot) {
+    return (int64_t)[(__bridge LineGraphView *)context numberOfPointsInPlot:plot];
+}
+
+/* Drains the queue into a single update block on the graph view.  Every queued update is in the indexes left by
+ the one before it, while an update block takes deletes before and inserts after the whole block, so the updates
+ are rebased onto the points the graph view has before they are applied.
+*/
+- (void)applyUpdates {
+    LineGraphView *graphView = self.graphView;
+    BOOL overflowed = LineGraphUpdateQueueTakeOverflow(&_queue);
+    size_t count = LineGraphUpdateQueuePopBatch(&_queue, _updates, LINE_GRAPH_UPDATE_QUEUE_CAPACITY);
+    
+    if (graphView == nil || (count == 0 && !overflowed)) {
+        return;
+    }
+    
+    size_t mergedCount = LineGraphUpdatesMerge(_updates, count);
+    size_t batchCount = 0;
+    
+    // Lost updates, or ones that do not fit the points shown, no longer describe the change
+    if (overflowed || !LineGraphUpdatesRebase(_updates, mergedCount, GraphViewPointCount, (__bridge void *)graphView, _batchUpdates, &batchCount)) {
+        if (self.updateBlock != nil) {
+            self.updateBlock(graphView);
+        }
+        
+        [graphView reloadData];
+        return;
+    }
+    
+    CFTimeInterval now = CACurrentMediaTime();
+    CFTimeInterval duration = graphView.animationDuration;
+    
+    // Several updates in one frame or one still animating means the input is outpacing the display
+    BOOL isAnimated = (mergedCount == count && now >= _animationEndTime);
+    
+    [graphView beginUpdates];
+    
+    for (size_t i = 0; i < batchCount; i++) {
+        const LineGraphUpdate *update = &_batchUpdates[i];
+        NSIndexPath *indexPath = [NSIndexPath indexPathForRow:(NSInteger)update->row inSection:update->plot];
+        
+        // Appends come out of the rebase as inserts at the end of their plot
+        switch (update->type) {
+            case kLineGraphUpdateInsert:
+                [graphView insertPointsAtIndexPath:indexPath count:(NSInteger)update->count animator:self.insertAnimator];
+                break;
+                
+            case kLineGraphUpdateDelete:
+                [graphView deletePointsAtIndexPath:indexPath count:(NSUInteger)update->count animator:self.deleteAnimator];
+                break;
+        }
+    }
+    
+    if (self.updateBlock != nil) {
+        self.updateBlock(graphView);
+    }
+    
+    if (isAnimated) {
+        [graphView endUpdates];
+        _animationEndTime = now + duration;
+    } else {
+        graphView.animationDuration = 0;
+        [graphView endUpdates];
+        graphView.animationDuration = duration;
+        
+        _coalescedUpdateCount++;
+    }
+}
+
+@end
@@ -12,6 +12,9 @@
 #import "LineGraphAxisLayer.h"
 #import "LineGraphTickInterval.h"
 #import "LineGraphRangeCalculator.h"
+#import "LineGraphDecimation.h"
+#import "LineGraphPlotPoints.h"
+#import "LineGraphPlotSnapshot.h"
 
 @class LineGraphView;
 
@@ -63,6 +66,26 @@ typedef NS_ENUM(NSInteger, LineGraphReplaceStyle) {
 - (CGFloat)lineGraphView:(LineGraphView *)lineGraphView lineWidthForPlot:(NSUInteger)plot;
 
 @optional
+/** Points of the plot as an immutable snapshot, usually built off the main thread.  If implemented,
+ lineGraphView:plotPointsForPlot: is not called and the value range is calculated from the snapshot bounds
+ without scanning the points.
+ 
+ @param lineGraphView The view requesting the information.
+ @param plot Index of the requested plot.
+*/
+- (LineGraphPlotSnapshot *)lineGraphView:(LineGraphView *)lineGraphView snapshotForPlot:(NSUInteger)plot;
+
+/** Lends the points of the plot as float columns, so no object is created per point.  If the generation of
+ the buffer matches the one from the last load, the plot keeps its points without copying them again.
+ Generations should not repeat across plots, a counter shared by all plots works.
+ 
+ @param lineGraphView The view requesting the information.
+ @param buffer Buffer to fill in, the arrays only need to stay valid until the method returns.
+ @param plot Index of the requested plot.
+ @return NO to have lineGraphView:plotPointsForPlot: called instead.
+*/
+- (BOOL)lineGraphView:(LineGraphView *)lineGraphView getPlotBuffer:(LineGraphPlotBuffer *)buffer forPlot:(NSUInteger)plot;
+
 /** Return a LineGraphTickInterval object describing how the x-axis of the view should be labeled.
  If this method returns an object, xAxisTickMarksInLineGraphView: and labelsForXAxisTickMarksInGraphView:
  will not be called.
@@ -212,9 +235,37 @@ typedef NS_ENUM(NSInteger, LineGraphReplaceStyle) {
 /** Defines whether plot lines appear on top of the axes.  Defaults to TRUE. */
 @property (nonatomic) BOOL plotShouldOverlayAxes;
 
+/** How plots with more points than pixel columns are reduced before their paths are built.  Defaults to
+ kLineGraphDecimationMinMax, which also keeps a min/max pyramid of every plot so zoomed out paths are built from
+ one summary per pixel column.  Takes effect on the next reload or update. */
+@property (nonatomic) LineGraphDecimationMode decimationMode;
+
+/** Draws plots as strips of tiles that scroll with the x value range, for live data added to the end of plots
+ while the range slides along.  Moving the range animates the strips instead of building new paths, so updates
+ no longer animate individual operations.  Plots are clipped to the plot area.  Defaults to FALSE. */
+@property (nonatomic) BOOL streaming;
+
+/** Width of a streaming tile in x values.  Defaults to 0, which uses the width of the value range. */
+@property (nonatomic) CGFloat streamingTileWidth;
+
 /** Reload data from the dataSource */
 - (void)reloadData;
 
+/** Line width, color, cap, join and dash pattern of plots are kept between updates, and only asked for again
+ after reloadData or a change in plots.  Call this when the style of a plot changes, it is asked for on the next
+ update.
+ 
+ @param plot Index of the plot.
+*/
+- (void)reloadStyleForPlot:(NSUInteger)plot;
+
+/** Number of points the plot had when data was last loaded.  Within an update block, the number before the block.
+ 
+ @param plot Index of the plot.
+ @return 0 if there is no such plot.
+*/
+- (NSUInteger)numberOfPointsInPlot:(NSUInteger)plot;
+
 /** Calls animateToFrame:duration: using the animationDuration property.
  
   @param frame The updated frame.
@@ -279,6 +330,15 @@ typedef NS_ENUM(NSInteger, LineGraphReplaceStyle) {
 */
 - (void)insertPointsAtIndexPath:(NSIndexPath *)indexPath count:(NSInteger)count animator:(id<LineGraphPlotAnimator>)animator;
 
+/** Animates points added to the end of a plot.  The start index is resolved once the data has been reloaded, so
+ it stays correct when the data source drops points from the start at the same time.
+ 
+ @param plot Plot the points were added to.
+ @param count Number of data points added.
+ @param animator Animator instance for animating the insertion.
+*/
+- (void)appendPointsToPlot:(NSUInteger)plot count:(NSInteger)count animator:(id<LineGraphPlotAnimator>)animator;
+
 /** Calls deletePointsAtIndexPath:count:withPointAnimation: with default animation of kLineGraphAnimationFadeOut
 
  @param indexPath Start index (pre-reload) of the data section to be deleted.
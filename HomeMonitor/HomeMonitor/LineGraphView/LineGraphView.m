@@ -10,6 +10,14 @@
 #import "LineGraphUtils.h"
 #import "CALayer+LineGraphAnimation.h"
 #import "LineGraphPlotAnimation.h"
+#import "LineGraphWindowExtrema.h"
+#import "LineGraphPyramid.h"
+#import "LineGraphPointIndex.h"
+#import "LineGraphInterpolation.h"
+#import "LineGraphAutoTickInterval.h"
+#import "LineGraphLabelMetrics.h"
+#import "LineGraphLabelExtents.h"
+#import "LineGraphStreamLayer.h"
 
 #define CLAMP(min, value, max) (MIN(max, MAX(min, value)))
 
@@ -21,9 +29,31 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     kLineGraphAnchorRight = 2
 };
 
+/* Path last drawn for a plot and what it was drawn for, so it can be reused while only the value range changes
+ or points are added to the end.
+*/
+typedef struct {
+    /** NULL when the plot has to be drawn again */
+    CGPathRef path;
+    CGRect plotArea;
+    CGRect valueRange;
+    /** Whether the path has exactly one element per point, so elements can be dropped and added per point */
+    BOOL isSimple;
+    /** Number of points drawn into the path */
+    NSUInteger pointCount;
+    /** Points added to the end and removed from the start of the plot since the path was drawn */
+    NSUInteger appendedCount;
+    NSUInteger droppedCount;
+    /** Number of points in the plot as of the last loadData */
+    NSUInteger plotPointCount;
+    /** Points added by extending rather than drawing the plot, bounded to limit accumulated rounding */
+    NSUInteger extendedCount;
+} LineGraphPlotPath;
+
 @interface LineGraphView () {
     NSUInteger _plotCount;
     NSMutableArray *_plotPoints;
+    NSMutableArray *_plotSnapshots;
     CGRect _plotArea;
     CGRect _valueRange;
     NSArray *_yTicks;
@@ -32,13 +62,17 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     NSArray *_xLabels;
     CGFloat _xAxisHeight;
     CGFloat _yAxisWidth;
-    NSDictionary *_yLabelHeightsByValue;
-    NSDictionary *_xLabelWidthsByValue;
+    CGFloat _xLabelMaxWidth;
+    LineGraphLabelExtents _yLabelExtents;
+    LineGraphLabelExtents _xLabelExtents;
+    UIFont *_labelExtentsFont;
     NSMutableArray *_lineWidths;
     NSMutableArray *_lineCaps;
     NSMutableArray *_lineJoins;
     NSMutableArray *_strokeColors;
     NSMutableArray *_dashPatterns;
+    BOOL _plotStylesValid;
+    NSMutableIndexSet *_invalidStylePlots;
     NSMutableArray *_gestureRecognizers;
     NSMutableArray *_touchHandlers;
     
@@ -60,18 +94,100 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     
     NSMutableArray *_plotMasks;
     
+    LineGraphWindowExtrema *_plotExtrema;
+    NSUInteger _plotExtremaCount;
+    BOOL _plotExtremaValid;
+    
+    LineGraphPyramid *_plotPyramids;
+    NSUInteger _plotPyramidCount;
+    BOOL _plotPyramidsValid;
+    
+    LineGraphPointIndex *_plotIndexes;
+    NSUInteger _plotIndexCount;
+    NSMutableIndexSet *_indexedPlots;
+    
+    LineGraphPlotPath *_plotPaths;
+    NSUInteger _plotPathCount;
+    
+    BOOL _isEndingUpdates;
+    
     NSMutableArray *_layersToRemove;
     NSUInteger _animatingLayerCount;
     
     BOOL _dataSourceLoaded;
 }
 
-- (CGPoint)findClosestDataPointForX:(float)x plot:(NSUInteger)plot;
+- (CGPoint)findClosestDataPointForX:(CGFloat)x plot:(NSUInteger)plot;
 - (void)handleGesture:(UIGestureRecognizer *)gesture;
-- (CGMutablePathRef)pathForPlot:(NSUInteger)plot;
+- (CGPathRef)pathForPlot:(NSUInteger)plot;
 
 @end
 
+/* OffsetXForValue worked out in double precision, for an x value stored as an offset from xOrigin.  Going
+ through float would draw x values far from 0, such as timestamps, in coarse steps.
+*/
+static CGFloat OffsetXForOriginValue(double xOrigin, double x, CGRect bounds, CGRect valueRange) {
+    return CGRectGetWidth(bounds) * ((xOrigin - CGRectGetMinX(valueRange)) + x) / CGRectGetWidth(valueRange);
+}
+
+/* Fills plotXValues, xValues and yValues with the given points, marking gaps with NAN.  Returns the origin the x
+ values are relative to.
+*/
+static double CopyInterpolationPoints(NSArray *points, CGRect plotArea, CGRect valueRange, float *plotXValues, float *xValues, float *yValues) {
+    LineGraphPlotPoints *plotPoints = [LineGraphPlotPoints pointsWithArray:points];
+    NSUInteger count = plotPoints.count;
+    double xOrigin = plotPoints.xOrigin;
+    
+    memcpy(xValues, plotPoints.xValues, sizeof(float) * count);
+    memcpy(yValues, plotPoints.yValues, sizeof(float) * count);
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        plotXValues[i] = isnan(xValues[i]) ? NAN : CGRectGetMinX(plotArea) + OffsetXForOriginValue(xOrigin, xValues[i], plotArea, valueRange);
+    }
+    
+    return xOrigin;
+}
+
+/* Returns the transform that moves a path drawn for one plot area and value range to another one.
+*/
+static CGAffineTransform TransformBetweenRanges(CGRect fromPlotArea, CGRect fromValueRange, CGRect toPlotArea, CGRect toValueRange) {
+    CGAffineTransform transform = CGAffineTransformTranslate(CGAffineTransformIdentity, OffsetXForValue(CGRectGetMinX(fromValueRange), toPlotArea, toValueRange), OffsetYForValue(CGRectGetMaxY(fromValueRange), toPlotArea, toValueRange));
+    
+    return CGAffineTransformScale(transform, toPlotArea.size.width / fromPlotArea.size.width * CGRectGetWidth(fromValueRange) / CGRectGetWidth(toValueRange), toPlotArea.size.height / fromPlotArea.size.height * CGRectGetHeight(fromValueRange) / CGRectGetHeight(toValueRange));
+}
+
+typedef struct {
+    CGMutablePathRef path;
+    const CGAffineTransform *transform;
+    NSUInteger skipCount;
+    NSUInteger elementCount;
+} PathCopyContext;
+
+static void CopyPathElement(void *info, const CGPathElement *element) {
+    PathCopyContext *context = info;
+    
+    context->elementCount++;
+    
+    if (context->elementCount <= context->skipCount) {
+        return;
+    }
+    
+    // Simple paths only hold points, the first one kept starts the path
+    if (element->type == kCGPathElementMoveToPoint || element->type == kCGPathElementAddLineToPoint) {
+        CGPoint point = element->points[0];
+        
+        if (context->elementCount == context->skipCount + 1) {
+            CGPathMoveToPoint(context->path, context->transform, point.x, point.y);
+        } else {
+            CGPathAddLineToPoint(context->path, context->transform, point.x, point.y);
+        }
+    }
+}
+
+static void CountPathElement(void *info, const CGPathElement *element) {
+    (*(NSUInteger *)info)++;
+}
+
 @implementation LineGraphView
 
 @synthesize valueRange = valueRange_;
@@ -95,6 +211,7 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         self.axisAnimator = nil;
         
         _plotShouldOverlayAxes = TRUE;
+        _decimationMode = kLineGraphDecimationMinMax;
         
         _plotLayers = [NSMutableArray array];
         
@@ -109,12 +226,47 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         
         _touchHandlers = [NSMutableArray array];
         _layersToRemove = [NSMutableArray array];
+        _indexedPlots = [NSMutableIndexSet indexSet];
+        _invalidStylePlots = [NSMutableIndexSet indexSet];
+        
+        LineGraphLabelExtentsInit(&_yLabelExtents);
+        LineGraphLabelExtentsInit(&_xLabelExtents);
         
         _dataSourceLoaded = FALSE;
     }
     
     return self;
 }
+
+- (void)dealloc {
+    for (NSUInteger plot = 0; plot < _plotExtremaCount; plot++) {
+        LineGraphWindowExtremaDestroy(&_plotExtrema[plot]);
+    }
+    
+    free(_plotExtrema);
+    
+    for (NSUInteger plot = 0; plot < _plotPyramidCount; plot++) {
+        LineGraphPyramidDestroy(&_plotPyramids[plot]);
+    }
+    
+    free(_plotPyramids);
+    
+    for (NSUInteger plot = 0; plot < _plotIndexCount; plot++) {
+        LineGraphPointIndexDestroy(&_plotIndexes[plot]);
+    }
+    
+    free(_plotIndexes);
+    
+    for (NSUInteger plot = 0; plot < _plotPathCount; plot++) {
+        CGPathRelease(_plotPaths[plot].path);
+    }
+    
+    free(_plotPaths);
+    
+    LineGraphLabelExtentsDestroy(&_yLabelExtents);
+    LineGraphLabelExtentsDestroy(&_xLabelExtents);
+}
+
 - (void)layoutSubviews {
     //NSLog(@"layoutSubviews");
     if (_dataSource && !_dataSourceLoaded) {
@@ -130,6 +282,7 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
 - (void)setDataSource:(id<LineGraphViewDataSource>)dataSource {
     _dataSource = dataSource;
     _dataSourceLoaded = FALSE;
+    _plotStylesValid = FALSE;
     [self setNeedsLayout];
 }
 
@@ -138,10 +291,65 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         CAShapeLayer *layer = _plotLayers[plot];
         layer.frame = _plotArea;
         
+        if (self.streaming) {
+            continue;
+        }
+        
         CGPathRef path = [self pathForPlot:plot];
-        layer.path = path;
+        
+        if (layer.path != path) {
+            layer.path = path;
+        }
+        
         CGPathRelease(path);
     }
+    
+    if (self.streaming) {
+        [self updateStreamLayersWithDuration:0];
+    }
+}
+
+/* Scrolls the stream layer of every plot to the current value range, adding stream layers to plot layers that
+ don't have one yet.
+*/
+- (void)updateStreamLayersWithDuration:(CFTimeInterval)duration {
+    for (NSUInteger plot = 0; plot < _plotCount; plot++) {
+        CAShapeLayer *layer = _plotLayers[plot];
+        LineGraphStreamLayer *streamLayer = [self streamLayerForPlotLayer:layer];
+        
+        if (streamLayer == nil) {
+            streamLayer = [[LineGraphStreamLayer alloc] init];
+            [layer addSublayer:streamLayer];
+        }
+        
+        layer.path = NULL;
+        streamLayer.frame = layer.bounds;
+        streamLayer.tileWidth = self.streamingTileWidth;
+        
+        [streamLayer updateWithPoints:_plotPoints[plot] valueRange:_valueRange styleLayer:layer duration:duration];
+    }
+}
+
+- (LineGraphStreamLayer *)streamLayerForPlotLayer:(CALayer *)layer {
+    for (CALayer *sublayer in layer.sublayers) {
+        if ([sublayer isKindOfClass:[LineGraphStreamLayer class]]) {
+            return (LineGraphStreamLayer *)sublayer;
+        }
+    }
+    
+    return nil;
+}
+
+- (void)setStreaming:(BOOL)streaming {
+    _streaming = streaming;
+    
+    if (!streaming) {
+        for (CALayer *layer in _plotLayers) {
+            [[self streamLayerForPlotLayer:layer] removeFromSuperlayer];
+        }
+    }
+    
+    [self setNeedsLayout];
 }
 
 - (void)setPlotShouldOverlayAxes:(BOOL)plotShouldOverlayAxes {
@@ -157,6 +365,8 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
 }
 
 - (void)reloadData {
+    _plotStylesValid = FALSE;
+    
     [self loadData];
     [self resizePlotArea];
     
@@ -169,15 +379,21 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     for (int plot = 0; plot < _plotCount; plot++) {
         CAShapeLayer *layer = [self layerForPlot:plot];
 
-        CGPathRef path = [self pathForPlot:plot];
-        layer.path = path;
-        CGPathRelease(path);
+        if (!self.streaming) {
+            CGPathRef path = [self pathForPlot:plot];
+            layer.path = path;
+            CGPathRelease(path);
+        }
         
         [self.layer addSublayer:layer];
         
         [_plotLayers addObject:layer];
     }
     
+    if (self.streaming) {
+        [self updateStreamLayersWithDuration:0];
+    }
+    
     [self resizeAxisLayersWithDuration:0];
 }
 
@@ -211,17 +427,20 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     for (NSMutableArray *plotMask in _plotMasks) {
         if ([plotMask[0] intValue] == maskedPlot) {
             plotMask[1] = @(targetPlot);
+            [_indexedPlots removeAllIndexes];
             return;
         }
     }
     
     [_plotMasks addObject:[NSMutableArray arrayWithArray:@[@(maskedPlot), @(targetPlot)]]];
+    [_indexedPlots removeAllIndexes];
 }
 
 - (void)removeMaskForPlot:(NSUInteger)maskedPlot {
     for (NSMutableArray *plotMask in _plotMasks) {
         if ([plotMask[0] intValue] == maskedPlot) {
             [_plotMasks removeObjectIdenticalTo:plotMask];
+            [_indexedPlots removeAllIndexes];
             return;
         }
     }
@@ -229,60 +448,103 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
 
 /* Finds the closest data point to X, a data value, in the given plot.  For use with gestures.
 */
-- (CGPoint)findClosestDataPointForX:(float)x plot:(NSUInteger)plot {
-    NSMutableArray *pointValues = [NSMutableArray arrayWithArray:[_plotPoints objectAtIndex:plot]];
-
-    // We start with the data points for the given plot, then add any data points in plots that are
-    // masked to the plot.
-    for (NSArray *plotMask in _plotMasks) {
-        if ([plotMask[1] intValue] == plot) {
-            for (NSValue *dataPoint in _plotPoints[[plotMask[0] intValue]]) {
-                [pointValues addObject:dataPoint];
-            }
-        }
+- (CGPoint)findClosestDataPointForX:(CGFloat)x plot:(NSUInteger)plot {
+    LineGraphPointIndex *index = [self pointIndexForPlot:plot];
+    
+    if (index == NULL || index->count == 0) {
+        return CGPointZero;
     }
     
-    // Then, because we may have added masked values, we re-sort the pointValues array.
-    NSArray *sortedPointValues = [pointValues sortedArrayUsingComparator:^(id a, id b) {
-        float ax = [a CGPointValue].x;
-        float bx = [b CGPointValue].x;
+    // The index is kept relative to the plot's origin, see pointIndexForPlot:
+    double xOrigin = [_plotPoints[plot] xOrigin];
+    size_t position = LineGraphPointIndexClosest(index, x - xOrigin);
+    
+    return CGPointMake(xOrigin + index->xs[position], index->ys[position]);
+}
+
+/* Returns the data points of the given plot and any plots masked to it, merged and sorted by x relative to the
+ plot's xOrigin.  The index is built on first use after the data or masks change, so moving a touch around only
+ searches it.  Returns NULL if the index could not be built, it is tried again on the next call.
+*/
+- (LineGraphPointIndex *)pointIndexForPlot:(NSUInteger)plot {
+    if (_plotIndexCount != _plotCount) {
+        for (NSUInteger i = 0; i < _plotIndexCount; i++) {
+            LineGraphPointIndexDestroy(&_plotIndexes[i]);
+        }
         
-        if (ax > bx)
-            return (NSComparisonResult)NSOrderedDescending;
+        free(_plotIndexes);
         
-        if (bx < ax)
-            return (NSComparisonResult)NSOrderedAscending;
+        _plotIndexes = calloc(_plotCount, sizeof(LineGraphPointIndex));
+        _plotIndexCount = (_plotIndexes != NULL) ? _plotCount : 0;
         
-        return (NSComparisonResult)NSOrderedSame;
-    }];
-
-    // Then, we create an array with just the X values from sortedPointValues, so that we can
-    // do a binary search to find the closest index value.
-    NSMutableArray *xValues = [NSMutableArray arrayWithCapacity:sortedPointValues.count];
+        for (NSUInteger i = 0; i < _plotIndexCount; i++) {
+            LineGraphPointIndexInit(&_plotIndexes[i]);
+        }
+        
+        [_indexedPlots removeAllIndexes];
+    }
     
-    for (NSValue *value in sortedPointValues) {
-        [xValues addObject:@(value.CGPointValue.x)];
+    if (plot >= _plotIndexCount) {
+        return NULL;
     }
     
-    NSUInteger index = [xValues indexOfObject:@(x) inSortedRange:NSMakeRange(0, xValues.count) options:NSBinarySearchingFirstEqual | NSBinarySearchingInsertionIndex usingComparator:^(id a, id b) {
-        return [a compare:b];
-    }];
+    LineGraphPointIndex *index = &_plotIndexes[plot];
     
-    // Now we should have an index of the lowest value that is higher than our desired X.  Figure out whether
-    // index or index+1 is the closest, and return.
-    if (index == 0) {
-        index = 0;
-    } else if (index == xValues.count) {
-        --index;
-    } else {
-        CGFloat leftDifference = x - [xValues[index - 1] floatValue];
-        CGFloat rightDifference = [xValues[index] floatValue] - x;
-        if (leftDifference < rightDifference) {
-            --index;
+    if ([_indexedPlots containsIndex:plot]) {
+        return index;
+    }
+    
+    LineGraphPointIndexRemoveAll(index);
+    
+    // We start with the data points for the given plot, then merge in any data points in plots that are
+    // masked to the plot.
+    NSMutableArray *sourcePlots = [NSMutableArray arrayWithObject:@(plot)];
+    
+    for (NSArray *plotMask in _plotMasks) {
+        if ([plotMask[1] intValue] == plot && [plotMask[0] unsignedIntegerValue] < _plotCount) {
+            [sourcePlots addObject:plotMask[0]];
+        }
+    }
+    
+    double xOrigin = [_plotPoints[plot] xOrigin];
+    
+    for (NSNumber *sourcePlot in sourcePlots) {
+        LineGraphPlotPoints *dataPoints = _plotPoints[[sourcePlot unsignedIntegerValue]];
+        float *xValues = malloc(sizeof(float) * MAX(dataPoints.count, 1) * 2);
+        
+        if (xValues == NULL) {
+            LineGraphPointIndexRemoveAll(index);
+            return NULL;
+        }
+        
+        float *yValues = xValues + dataPoints.count;
+        double xOffset = dataPoints.xOrigin - xOrigin;
+        NSUInteger count = 0;
+        
+        for (NSUInteger i = 0; i < dataPoints.count; i++) {
+            if (isnan(dataPoints.xValues[i])) {
+                continue;
+            }
+            
+            xValues[count] = xOffset + dataPoints.xValues[i];
+            yValues[count] = dataPoints.yValues[i];
+            count++;
+        }
+        
+        BOOL isMerged = LineGraphPointIndexMergePoints(index, xValues, yValues, count);
+        
+        free(xValues);
+        
+        // A partly built index is dropped rather than searched
+        if (!isMerged) {
+            LineGraphPointIndexRemoveAll(index);
+            return NULL;
         }
     }
     
-    return [(NSValue *)sortedPointValues[index] CGPointValue];
+    [_indexedPlots addIndex:plot];
+    
+    return index;
 }
 
 - (void)cancelTouches {
@@ -300,7 +562,8 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         NSMutableArray *values = [NSMutableArray arrayWithCapacity:gesture.numberOfTouches];
         for (int touchIndex = 0; touchIndex < gesture.numberOfTouches; touchIndex++) {
             CGPoint point = [gesture locationOfTouch:touchIndex inView:self];
-            [values addObject:@(ValueForPlotX(point.x, _plotArea, _valueRange))];
+            CGFloat value = CGRectGetMinX(_valueRange) + CGRectGetWidth(_valueRange) * (point.x - CGRectGetMinX(_plotArea)) / CGRectGetWidth(_plotArea);
+            [values addObject:@(value)];
         }
         NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES];
         [values sortUsingDescriptors:@[sortDescriptor]];
@@ -312,9 +575,9 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
             NSMutableArray *pointValues = [NSMutableArray arrayWithCapacity:gesture.numberOfTouches];
             
             for (int touchIndex = 0; touchIndex < gesture.numberOfTouches; touchIndex++) {
-                CGPoint closestPoint = [self findClosestDataPointForX:[values[touchIndex] floatValue] plot:plot];
+                CGPoint closestPoint = [self findClosestDataPointForX:[values[touchIndex] doubleValue] plot:plot];
                 
-                [coordinates addObject:[NSValue valueWithCGPoint:CGPointMake(OffsetXForValue(closestPoint.x, _plotArea, _valueRange), OffsetYForValue(closestPoint.y,_plotArea,_valueRange))]];
+                [coordinates addObject:[NSValue valueWithCGPoint:CGPointMake(OffsetXForOriginValue(0, closestPoint.x, _plotArea, _valueRange), OffsetYForValue(closestPoint.y,_plotArea,_valueRange))]];
                 [pointValues addObject:[NSValue valueWithCGPoint:closestPoint]];
             }
             
@@ -377,10 +640,180 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     [_touchHandlers addObject:@[touchHandler, @(plot)]];
 }
 
-/* Compute the path for the given plot based on current data.
+/* Compute the path for the given plot based on current data.  The last path drawn for the plot is reused
+ when possible, so the returned path is retained and must not be modified.
 */
-- (CGMutablePathRef)pathForPlot:(NSUInteger)plot {
-    return [self pathForPlotPoints:[_plotPoints objectAtIndex:plot] frame:_plotArea valueRange:_valueRange];
+- (CGPathRef)pathForPlot:(NSUInteger)plot {
+    CGPathRef path = [self cachedPathForPlot:plot];
+    
+    if (path != NULL) {
+        return path;
+    }
+    
+    BOOL isSimple = FALSE;
+    path = [self pyramidPathForPlot:plot];
+    
+    if (path == NULL) {
+        NSArray *dataPoints = [_plotPoints objectAtIndex:plot];
+        path = [self pathForPlotPoints:dataPoints frame:_plotArea valueRange:_valueRange];
+        
+        // Gaps and decimation both leave fewer elements than points
+        NSUInteger elementCount = 0;
+        CGPathApply(path, &elementCount, CountPathElement);
+        isSimple = (elementCount > 0 && elementCount == dataPoints.count);
+    }
+    
+    if (plot < _plotPathCount) {
+        LineGraphPlotPath *plotPath = &_plotPaths[plot];
+        
+        CGPathRelease(plotPath->path);
+        plotPath->path = CGPathRetain(path);
+        plotPath->plotArea = _plotArea;
+        plotPath->valueRange = _valueRange;
+        plotPath->isSimple = isSimple;
+        plotPath->pointCount = [_plotPoints[plot] count];
+        plotPath->plotPointCount = plotPath->pointCount;
+        plotPath->appendedCount = 0;
+        plotPath->droppedCount = 0;
+        plotPath->extendedCount = 0;
+    }
+    
+    return path;
+}
+
+/* Returns the last path drawn for the plot if it still applies, otherwise moves it into the current plot area
+ and value range with a single transform, drops the elements of points removed from the start and adds the
+ points appended to the end.  Returns NULL if the plot has to be drawn again.
+*/
+- (CGPathRef)cachedPathForPlot:(NSUInteger)plot {
+    if (plot >= _plotPathCount || _plotPaths[plot].path == NULL) {
+        return NULL;
+    }
+    
+    LineGraphPlotPath *plotPath = &_plotPaths[plot];
+    BOOL isSameRange = CGRectEqualToRect(plotPath->plotArea, _plotArea) && CGRectEqualToRect(plotPath->valueRange, _valueRange);
+    
+    if (plotPath->appendedCount == 0 && plotPath->droppedCount == 0 && isSameRange) {
+        return CGPathRetain(plotPath->path);
+    }
+    
+    LineGraphPlotPoints *dataPoints = _plotPoints[plot];
+    NSUInteger pointCount = dataPoints.count;
+    double xOrigin = dataPoints.xOrigin;
+    
+    if (!plotPath->isSimple || pointCount != plotPath->pointCount - plotPath->droppedCount + plotPath->appendedCount
+        || plotPath->extendedCount + plotPath->appendedCount > pointCount) {
+        return NULL;
+    }
+    
+    // Plots dense enough to be decimated are drawn again, so columns stay aligned
+    if (self.decimationMode != kLineGraphDecimationNone) {
+        float width = OffsetXForOriginValue(xOrigin, dataPoints.xValues[pointCount - 1], _plotArea, _valueRange) - OffsetXForOriginValue(xOrigin, dataPoints.xValues[0], _plotArea, _valueRange);
+        
+        if (pointCount > LineGraphDecimationThreshold(width, 1.f / self.contentScaleFactor)) {
+            return NULL;
+        }
+    }
+    
+    CGAffineTransform transform = CGAffineTransformIdentity;
+    
+    if (!isSameRange) {
+        transform = TransformBetweenRanges(plotPath->plotArea, plotPath->valueRange, _plotArea, _valueRange);
+    }
+    
+    CGMutablePathRef path;
+    
+    if (plotPath->droppedCount == 0) {
+        path = CGPathCreateMutableCopyByTransformingPath(plotPath->path, &transform);
+    } else {
+        PathCopyContext context = { CGPathCreateMutable(), &transform, plotPath->droppedCount, 0 };
+        CGPathApply(plotPath->path, &context, CopyPathElement);
+        path = context.path;
+    }
+    
+    for (NSUInteger i = pointCount - plotPath->appendedCount; i < pointCount; i++) {
+        if (isnan(dataPoints.xValues[i])) {
+            CGPathRelease(path);
+            return NULL;
+        }
+        
+        CGFloat x = OffsetXForOriginValue(xOrigin, dataPoints.xValues[i], _plotArea, _valueRange);
+        CGFloat y = OffsetYForValue(dataPoints.yValues[i], _plotArea, _valueRange);
+        
+        if (CGPathIsEmpty(path)) {
+            CGPathMoveToPoint(path, NULL, x, y);
+        } else {
+            CGPathAddLineToPoint(path, NULL, x, y);
+        }
+    }
+    
+    CGPathRelease(plotPath->path);
+    plotPath->path = CGPathRetain(path);
+    plotPath->plotArea = _plotArea;
+    plotPath->valueRange = _valueRange;
+    plotPath->pointCount = pointCount;
+    plotPath->extendedCount += plotPath->appendedCount;
+    plotPath->appendedCount = 0;
+    plotPath->droppedCount = 0;
+    
+    return path;
+}
+
+/* Builds the path for the given plot from the pyramid level matching the pixel columns of the plot area, so the
+ cost depends on the width of the view rather than the number of points.  Returns NULL if the plot has fewer
+ points than columns, or its points can not be summarized.
+*/
+- (CGMutablePathRef)pyramidPathForPlot:(NSUInteger)plot {
+    if (self.decimationMode != kLineGraphDecimationMinMax || plot >= _plotPyramidCount || !_plotPyramidsValid) {
+        return NULL;
+    }
+    
+    LineGraphPyramid *pyramid = &_plotPyramids[plot];
+    double columnWidth = CGRectGetWidth(_valueRange) / (CGRectGetWidth(_plotArea) * self.contentScaleFactor);
+    size_t level;
+    
+    if (!LineGraphPyramidLevelForColumnWidth(pyramid, columnWidth, &level)) {
+        return NULL;
+    }
+    
+    size_t bucketCount;
+    const LineGraphPyramidBucket *buckets = LineGraphPyramidBucketsInRange(pyramid, level,
+                                                                           CGRectGetMinX(_valueRange),
+                                                                           CGRectGetMaxX(_valueRange),
+                                                                           &bucketCount);
+    
+    CGMutablePathRef path = CGPathCreateMutable();
+    LineGraphPyramidBucket tailBucket;
+    BOOL hasTail = LineGraphPyramidTailBucket(pyramid, level, &tailBucket);
+    
+    for (size_t i = 0; i < bucketCount + (hasTail ? 1 : 0); i++) {
+        const LineGraphPyramidBucket *bucket = (i < bucketCount) ? &buckets[i] : &tailBucket;
+        
+        // Draw the extremes of every bucket in the order they were recorded
+        CGPoint first = CGPointMake(bucket->minX, bucket->min);
+        CGPoint second = CGPointMake(bucket->maxX, bucket->max);
+        
+        if (bucket->maxX < bucket->minX) {
+            CGPoint swap = first;
+            first = second;
+            second = swap;
+        }
+        
+        CGFloat x = OffsetXForOriginValue(0, first.x, _plotArea, _valueRange);
+        CGFloat y = OffsetYForValue(first.y, _plotArea, _valueRange);
+        
+        if (i == 0) {
+            CGPathMoveToPoint(path, NULL, x, y);
+        } else {
+            CGPathAddLineToPoint(path, NULL, x, y);
+        }
+        
+        if (!CGPointEqualToPoint(first, second)) {
+            CGPathAddLineToPoint(path, NULL, OffsetXForOriginValue(0, second.x, _plotArea, _valueRange), OffsetYForValue(second.y, _plotArea, _valueRange));
+        }
+    }
+    
+    return path;
 }
 
 - (void)resizeAxisLayersWithDuration:(CFTimeInterval)duration {
@@ -419,69 +852,127 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     
     // Now, examine the label sizes, which were calculated in loadData, to see if the plotArea
     // needs to be further shrunk to fit labels.
-    UIEdgeInsets minInsets = UIEdgeInsetsMake(0,0,0,0);
+    UIEdgeInsets minInsets = [self insetsForYLabelsInPlotArea:plotArea];
     
-    if (_yLabelHeightsByValue != nil) {
-        for (NSString *key in _yLabelHeightsByValue) {
-            float y = PlotYForValue([key floatValue], plotArea, _valueRange);
-            float height = [[_yLabelHeightsByValue objectForKey:key] floatValue] * 1.2;
-            
-            float topY = y - ceilf(height / 4);
-            float bottomY = y + ceilf(height / 4);
-            
-            if (topY < 0) {
-                minInsets.top = MAX(minInsets.top, ceil(abs(topY)));
-            } else if (bottomY > CGRectGetMaxY(self.bounds)) {
-                minInsets.bottom = MAX(minInsets.bottom, ceil(bottomY - CGRectGetMaxY(self.bounds)));
-            }
-        }
+    if (minInsets.top > 0) {
+        plotArea.origin.y += minInsets.top;
+        plotArea.size.height -= minInsets.top;
+    }
+    
+    if (minInsets.bottom > 0) {
+        plotArea.size.height -= minInsets.bottom;
+    }
+    
+    UIEdgeInsets xInsets = [self insetsForXLabelsInPlotArea:plotArea];
+    
+    if (xInsets.left > 0) {
+        plotArea.origin.x += xInsets.left;
+        plotArea.size.width -= xInsets.left;
+    }
+    
+    if (xInsets.right > 0) {
+        plotArea.size.width -= xInsets.right;
+    }
+    
+    return plotArea;
+}
+
+/* Returns the top and bottom insets needed to keep y axis labels within the view.  Labels only overflow
+ near an edge, so they are visited from each end until one is too far in for even the tallest label to overflow.
+*/
+- (UIEdgeInsets)insetsForYLabelsInPlotArea:(CGRect)plotArea {
+    UIEdgeInsets insets = UIEdgeInsetsZero;
+    size_t count = _yLabelExtents.count;
+    float maxReach = ceilf(_yLabelExtents.maxHeight * 1.2 / 4);
+    BOOL isOrdered = _yLabelExtents.isAscending && CGRectGetHeight(plotArea) > 0 && CGRectGetHeight(_valueRange) > 0;
+    
+    // Highest values are at the top
+    for (size_t i = count; i-- > 0;) {
+        const LineGraphLabelExtent *extent = LineGraphLabelExtentsAt(&_yLabelExtents, i);
+        float y = PlotYForValue(extent->value, plotArea, _valueRange);
         
-        if (minInsets.top > 0) {
-            plotArea.origin.y += minInsets.top;
-            plotArea.size.height -= minInsets.top;
+        if (isOrdered && y - maxReach >= 0) {
+            break;
         }
         
-        if (minInsets.bottom > 0) {
-            plotArea.size.height -= minInsets.bottom;
+        float topY = y - ceilf(extent->height * 1.2 / 4);
+        
+        if (topY < 0) {
+            insets.top = MAX(insets.top, ceil(abs(topY)));
         }
     }
     
+    for (size_t i = 0; i < count; i++) {
+        const LineGraphLabelExtent *extent = LineGraphLabelExtentsAt(&_yLabelExtents, i);
+        float y = PlotYForValue(extent->value, plotArea, _valueRange);
+        
+        if (isOrdered && y + maxReach <= CGRectGetMaxY(self.bounds)) {
+            break;
+        }
+        
+        float reach = ceilf(extent->height * 1.2 / 4);
+        float topY = y - reach;
+        float bottomY = y + reach;
+        
+        if (topY >= 0 && bottomY > CGRectGetMaxY(self.bounds)) {
+            insets.bottom = MAX(insets.bottom, ceil(bottomY - CGRectGetMaxY(self.bounds)));
+        }
+    }
     
-    if (_xLabelWidthsByValue != nil) {
-        for (NSString *key in _xLabelWidthsByValue) {
-            float x = PlotXForValue([key floatValue], plotArea, _valueRange);
-            float width = [[_xLabelWidthsByValue objectForKey:key] floatValue];
-            
-            float leftX = x - ceilf(width / 2);
-            
-            if (self.xAlignment == kLineGraphXAlignCenter) {
-                leftX = x - ceilf(width / 2);
-            } else if (self.xAlignment == kLineGraphXAlignRight) {
-                leftX = x - ceilf(width) - 2;
-            } else if (self.xAlignment == kLineGraphXAlignLeft) {
-                leftX = x + 2;
-            }
-            
-            float rightX = leftX + ceilf(width);
-            
-            if (leftX < 0) {
-                minInsets.left = MAX(minInsets.left, ceil(abs(leftX)));
-            } else if (rightX > CGRectGetMaxX(self.bounds)) {
-                minInsets.right = MAX(minInsets.right, ceil(rightX - CGRectGetMaxX(self.bounds)));
-            }
+    return insets;
+}
+
+/* Returns the left and right insets needed to keep x axis labels within the view, walking in from both ends
+ like insetsForYLabelsInPlotArea:.
+*/
+- (UIEdgeInsets)insetsForXLabelsInPlotArea:(CGRect)plotArea {
+    UIEdgeInsets insets = UIEdgeInsetsZero;
+    size_t count = _xLabelExtents.count;
+    float maxWidth = ceilf(_xLabelExtents.maxWidth) + 2;
+    BOOL isOrdered = _xLabelExtents.isAscending && CGRectGetWidth(plotArea) > 0 && CGRectGetWidth(_valueRange) > 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        const LineGraphLabelExtent *extent = LineGraphLabelExtentsAt(&_xLabelExtents, i);
+        float x = PlotXForValue(extent->value, plotArea, _valueRange);
+        
+        if (isOrdered && x - maxWidth >= 0) {
+            break;
+        }
+        
+        float leftX = [self leftXForLabelExtent:extent atX:x];
+        
+        if (leftX < 0) {
+            insets.left = MAX(insets.left, ceil(abs(leftX)));
         }
+    }
+    
+    for (size_t i = count; i-- > 0;) {
+        const LineGraphLabelExtent *extent = LineGraphLabelExtentsAt(&_xLabelExtents, i);
+        float x = PlotXForValue(extent->value, plotArea, _valueRange);
         
-        if (minInsets.left > 0) {
-            plotArea.origin.x += minInsets.left;
-            plotArea.size.width -= minInsets.left;
+        if (isOrdered && x + maxWidth <= CGRectGetMaxX(self.bounds)) {
+            break;
         }
         
-        if (minInsets.right > 0) {
-            plotArea.size.width -= minInsets.right;
+        float leftX = [self leftXForLabelExtent:extent atX:x];
+        float rightX = leftX + ceilf(extent->width);
+        
+        if (leftX >= 0 && rightX > CGRectGetMaxX(self.bounds)) {
+            insets.right = MAX(insets.right, ceil(rightX - CGRectGetMaxX(self.bounds)));
         }
     }
     
-    return plotArea;
+    return insets;
+}
+
+- (float)leftXForLabelExtent:(const LineGraphLabelExtent *)extent atX:(float)x {
+    if (self.xAlignment == kLineGraphXAlignRight) {
+        return x - ceilf(extent->width) - 2;
+    } else if (self.xAlignment == kLineGraphXAlignLeft) {
+        return x + 2;
+    }
+    
+    return x - ceilf(extent->width / 2);
 }
 
 
@@ -528,13 +1019,13 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         }
     }
 
-    if (_lineCaps == nil) {
+    if (_lineCaps == nil || [_lineCaps[plot] isEqual:[NSNull null]]) {
         layer.lineCap = (layer.lineDashPattern == nil) ? kCALineCapRound : kCALineCapButt;
     } else {
         layer.lineCap = _lineCaps[plot];
     }
     
-    if (_lineJoins == nil) {
+    if (_lineJoins == nil || [_lineJoins[plot] isEqual:[NSNull null]]) {
         layer.lineJoin = kCALineJoinRound;
     } else {
         layer.lineJoin = _lineJoins[plot];
@@ -548,192 +1039,624 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
      */
 
     _plotCount = [self.dataSource numberOfPlotsInLineGraphView:self];
+    [_indexedPlots removeAllIndexes];
+    
+    NSArray *previousPlotPoints = _plotPoints;
+    NSArray *previousPlotSnapshots = _plotSnapshots;
+    BOOL hasPlotBuffers = [self.dataSource respondsToSelector:@selector(lineGraphView:getPlotBuffer:forPlot:)];
+    NSIndexSet *changedPlots = (previousPlotPoints.count == _plotCount) ? [self changedPlotsInUpdate] : nil;
+    
     _plotPoints = [NSMutableArray arrayWithCapacity:_plotCount];
-    _lineWidths = [NSMutableArray arrayWithCapacity:_plotCount];
-    _strokeColors = [NSMutableArray arrayWithCapacity:_plotCount];
+    
+    if ([self.dataSource respondsToSelector:@selector(lineGraphView:snapshotForPlot:)]) {
+        _plotSnapshots = [NSMutableArray arrayWithCapacity:_plotCount];
+    } else {
+        _plotSnapshots = nil;
+    }
     
     for (NSUInteger plot = 0; plot < _plotCount; plot++) {
-        [_plotPoints addObject:[self.dataSource lineGraphView:self plotPointsForPlot:plot]];
-        [_lineWidths addObject:@([self.dataSource lineGraphView:self lineWidthForPlot:plot])];
-        [_strokeColors addObject:[self.dataSource lineGraphView:self lineColorForPlot:plot]];
+        LineGraphPlotPoints *plotPoints = nil;
+        
+        // Plots the update block did not touch keep their points
+        if (changedPlots != nil && ![changedPlots containsIndex:plot]
+            && (_plotSnapshots == nil || previousPlotSnapshots.count == _plotCount)) {
+            
+            if (_plotSnapshots != nil) {
+                [_plotSnapshots addObject:previousPlotSnapshots[plot]];
+            }
+            
+            [_plotPoints addObject:previousPlotPoints[plot]];
+            continue;
+        }
+        
+        if (_plotSnapshots != nil) {
+            LineGraphPlotSnapshot *snapshot = [self.dataSource lineGraphView:self snapshotForPlot:plot];
+            
+            [_plotSnapshots addObject:snapshot];
+            plotPoints = [LineGraphPlotPoints pointsWithArray:snapshot.points];
+        } else if (hasPlotBuffers) {
+            LineGraphPlotBuffer buffer = { NULL, NULL, 0, NULL, 0, 0 };
+            
+            if ([self.dataSource lineGraphView:self getPlotBuffer:&buffer forPlot:plot]) {
+                LineGraphPlotPoints *previousPoints = (previousPlotPoints.count == _plotCount) ? previousPlotPoints[plot] : nil;
+                
+                if (buffer.generation != 0 && previousPoints.generation == buffer.generation) {
+                    plotPoints = previousPoints;
+                } else {
+                    plotPoints = [[LineGraphPlotPoints alloc] initWithBuffer:&buffer];
+                }
+            }
+        }
+        
+        // Arrays are unboxed into columns once here, instead of by every consumer of the points
+        if (plotPoints == nil) {
+            plotPoints = [LineGraphPlotPoints pointsWithArray:[self.dataSource lineGraphView:self plotPointsForPlot:plot]];
+        }
+        
+        [_plotPoints addObject:plotPoints];
     }
     
-    if ([self.dataSource respondsToSelector:@selector(lineGraphView:lineCapForPlot:)]) {
-        _lineJoins = [NSMutableArray arrayWithCapacity:_plotCount];
-        for (NSUInteger plot = 0; plot < _plotCount; plot++) {
-            [_lineJoins addObject:[self.dataSource lineGraphView:self lineJoinForPlot:plot]];
+    [self loadPlotStyles];
+
+    if (_isEndingUpdates) {
+        [self resolveAppendOperations];
+    }
+    
+    [self updatePlotPaths];
+    
+    if (self.decimationMode == kLineGraphDecimationMinMax) {
+        [self updatePlotPyramids];
+    } else {
+        _plotPyramidsValid = FALSE;
+    }
+
+    /* STEP 2: calculate the valueRange, if it's not being set by the user, and store in _valueRange
+     */
+    
+    if (_plotSnapshots != nil && (CGRectEqualToRect(self.valueRange, CGRectZero) || self.valueRangeObject != nil)) {
+        CGRect bounds = CGRectNull;
+        
+        // Snapshots come with their bounds, so the points are not scanned and no extrema are kept
+        for (LineGraphPlotSnapshot *snapshot in _plotSnapshots) {
+            bounds = CGRectUnion(bounds, snapshot.bounds);
+        }
+        
+        _valueRange = CGRectIsNull(bounds) ? CGRectZero : bounds;
+        _plotExtremaValid = FALSE;
+        
+        if (self.valueRangeObject) {
+            _valueRange = [self.valueRangeObject getValueRangeFromRange:_valueRange];
+        }
+        
+    } else if (CGRectEqualToRect(self.valueRange, CGRectZero) || self.valueRangeObject != nil) {
+        
+        CGFloat xMin = [[[_plotPoints firstObject] firstObject] CGPointValue].x;
+        CGFloat xMax = [[[_plotPoints firstObject] lastObject] CGPointValue].x;
+        CGFloat yMin = [[[_plotPoints firstObject] firstObject] CGPointValue].y;
+        CGFloat yMax = yMin;
+        
+        [self updatePlotExtrema];
+        
+        for (int i = 0; i < _plotCount; i++) {
+            NSArray *dataPoints = [_plotPoints objectAtIndex:i];
+            LineGraphWindowExtrema *extrema = &_plotExtrema[i];
+            
+            if (!LineGraphWindowExtremaIsEmpty(extrema)) {
+                yMin = MIN(yMin, LineGraphWindowExtremaMin(extrema));
+                yMax = MAX(yMax, LineGraphWindowExtremaMax(extrema));
+            }
+            
+            xMin = MIN(xMin, [[dataPoints firstObject] CGPointValue].x);
+            xMax = MAX(xMax, [[dataPoints lastObject] CGPointValue].x);
+        }
+        
+        _valueRange = CGRectMake(xMin, yMin, xMax - xMin, yMax - yMin);
+        
+        if (self.valueRangeObject) {
+            _valueRange = [self.valueRangeObject getValueRangeFromRange:_valueRange];
+        }
+        
+    } else {
+        _valueRange = self.valueRange;
+        
+        // Extrema are only maintained while the range is being calculated
+        _plotExtremaValid = FALSE;
+    }
+
+    /* STEP 3: Calculate the width and height required for the axes.
+     Store label dimensions for future use by calculatePlotArea.
+     */
+    
+    // Labels of a tick interval only depend on the tick value, so ones still in range keep their sizes
+    BOOL reusesLabelExtents = [self.labelFont isEqual:_labelExtentsFont];
+    _labelExtentsFont = self.labelFont;
+    
+    if (self.yAxisPosition == kLineGraphAxisPositionNone) {
+        LineGraphLabelExtentsRemoveAll(&_yLabelExtents);
+    }
+    
+    if (self.xAxisPosition == kLineGraphAxisPositionNone) {
+        LineGraphLabelExtentsRemoveAll(&_xLabelExtents);
+    }
+    
+    if (self.yAxisPosition != kLineGraphAxisPositionNone) {
+        // Step 1: calculate the required width
+        
+        BOOL hasTickInterval = FALSE;
+        
+        if ([self.dataSource respondsToSelector:@selector(yAxisTickIntervalInLineGraphView:)]) {
+            LineGraphTickInterval *tickInterval = [self.dataSource yAxisTickIntervalInLineGraphView:self];
+            
+            if ([tickInterval isKindOfClass:[LineGraphAutoTickInterval class]]) {
+                CGFloat length = CGRectGetHeight(self.bounds) - self.graphInsets.top - self.graphInsets.bottom;
+                [(LineGraphAutoTickInterval *)tickInterval updateForStart:CGRectGetMinY(_valueRange) end:CGRectGetMaxY(_valueRange) length:length labelLength:self.labelFont.lineHeight];
+            }
+            
+            NSArray *ticks = nil, *labels = nil;
+            [tickInterval getTicks:&ticks labels:&labels forStart:CGRectGetMinY(_valueRange) end:CGRectGetMaxY(_valueRange)];
+            _yTicks = ticks;
+            _yLabels = labels;
+            hasTickInterval = (ticks != nil);
+        } else {
+            _yTicks = nil;
+            _yLabels = nil;
+        }
+        
+        if (_yTicks == nil) {
+            if ([self.dataSource respondsToSelector:@selector(yAxisTickMarksInLineGraphView:)]) {
+                _yTicks = [self.dataSource yAxisTickMarksInLineGraphView:self];
+            } else {
+                _yTicks = @[];
+            }
+        }
+    
+        if (_yLabels == nil) {
+            if ([self.dataSource respondsToSelector:@selector(labelsForYAxisTickMarksInGraphView:)]) {
+                _yLabels = [self.dataSource labelsForYAxisTickMarksInGraphView:self];
+            } else {
+                _yLabels = @[];
+            }
+        }
+        
+        [self updateLabelExtents:&_yLabelExtents
+                        forTicks:_yTicks
+                          labels:_yLabels
+                        minValue:CGRectGetMinY(_valueRange)
+                        maxValue:CGRectGetMaxY(_valueRange)
+                     reuseLabels:(reusesLabelExtents && hasTickInterval)];
+        
+        if (_yTicks.count > 0) {
+            _yAxisWidth = ceil(_yLabelExtents.maxWidth) + self.tickLength + 2;
+        } else {
+            _yAxisWidth = self.tickLength;
+        }
+    }
+    
+    if (self.xAxisPosition != kLineGraphAxisPositionNone) {
+        BOOL hasTickInterval = FALSE;
+        
+        if ([self.dataSource respondsToSelector:@selector(xAxisTickIntervalInLineGraphView:)]) {
+            LineGraphTickInterval *tickInterval = [self.dataSource xAxisTickIntervalInLineGraphView:self];
+            
+            // Label widths are only known after ticks are chosen, so the widest label of the last layout is used
+            if ([tickInterval isKindOfClass:[LineGraphAutoTickInterval class]]) {
+                CGFloat length = CGRectGetWidth(self.bounds) - self.graphInsets.left - self.graphInsets.right;
+                [(LineGraphAutoTickInterval *)tickInterval updateForStart:CGRectGetMinX(_valueRange) end:CGRectGetMaxX(_valueRange) length:length labelLength:_xLabelMaxWidth];
+            }
+            
+            NSArray *ticks = nil, *labels = nil;
+            [tickInterval getTicks:&ticks labels:&labels forStart:CGRectGetMinX(_valueRange) end:CGRectGetMaxX(_valueRange)];
+            _xTicks = ticks;
+            _xLabels = labels;
+            hasTickInterval = (ticks != nil);
+        } else {
+            _xTicks = nil;
+            _xLabels = nil;
+        }
+        
+        if (_xTicks == nil) {
+            if ([self.dataSource respondsToSelector:@selector(xAxisTickMarksInLineGraphView:)]) {
+                _xTicks = [self.dataSource xAxisTickMarksInLineGraphView:self];
+            } else {
+                _xTicks = @[];
+            }
+        }
+        
+        if (_xLabels == nil) {
+            if ([self.dataSource respondsToSelector:@selector(labelsForXAxisTickMarksInGraphView:)]) {
+                _xLabels = [self.dataSource labelsForXAxisTickMarksInGraphView:self];
+            } else {
+                _xLabels = @[];
+            }
+        }
+        
+        [self updateLabelExtents:&_xLabelExtents
+                        forTicks:_xTicks
+                          labels:_xLabels
+                        minValue:CGRectGetMinX(_valueRange)
+                        maxValue:CGRectGetMaxX(_valueRange)
+                     reuseLabels:(reusesLabelExtents && hasTickInterval)];
+        
+        if (_xTicks.count > 0) {
+            _xAxisHeight = ceil(_xLabelExtents.maxHeight * 1.2 / 2) + 3 + (self.xAlignment == kLineGraphXAlignCenter ? self.tickLength : 0);
+            _xLabelMaxWidth = _xLabelExtents.maxWidth;
+        } else {
+            _xAxisHeight = self.tickLength;
+        }
+    }
+}
+
+/* Brings the label sizes of an axis up to date with its visible ticks.  When reuseLabels is set, labels still
+ in range keep their sizes and only the ticks scrolled in at either end are measured.  Anything else, like ticks
+ that are out of order or no longer line up with the stored ones, measures all labels again.
+*/
+- (void)updateLabelExtents:(LineGraphLabelExtents *)extents
+                  forTicks:(NSArray *)ticks
+                    labels:(NSArray *)labels
+                  minValue:(float)minValue
+                  maxValue:(float)maxValue
+               reuseLabels:(BOOL)reuseLabels {
+    NSUInteger count = MIN(ticks.count, labels.count);
+    
+    if (reuseLabels) {
+        LineGraphLabelExtentsTrim(extents, minValue, maxValue);
+    } else {
+        LineGraphLabelExtentsRemoveAll(extents);
+    }
+    
+    if (extents->count > 0) {
+        float firstValue = LineGraphLabelExtentsAt(extents, 0)->value;
+        float lastValue = LineGraphLabelExtentsAt(extents, extents->count - 1)->value;
+        float previousValue = -INFINITY;
+        size_t matchedCount = 0;
+        BOOL isMatching = TRUE;
+        
+        for (NSUInteger i = 0; i < count && isMatching; i++) {
+            float tickValue = [ticks[i] floatValue];
+            
+            if (tickValue < minValue || tickValue > maxValue) {
+                continue;
+            }
+            
+            if (tickValue <= previousValue) {
+                isMatching = FALSE;
+            } else if (tickValue >= firstValue && tickValue <= lastValue) {
+                isMatching = (matchedCount < extents->count && LineGraphLabelExtentsAt(extents, matchedCount)->value == tickValue);
+                matchedCount++;
+            }
+            
+            previousValue = tickValue;
+        }
+        
+        if (isMatching && matchedCount == extents->count) {
+            for (NSUInteger i = count; i-- > 0;) {
+                float tickValue = [ticks[i] floatValue];
+                
+                if (tickValue >= minValue && tickValue < firstValue) {
+                    CGSize labelSize = [[LineGraphLabelMetrics sharedMetrics] sizeForLabel:labels[i] font:self.labelFont];
+                    LineGraphLabelExtentsPrepend(extents, tickValue, labelSize.width, labelSize.height);
+                }
+            }
+            
+            for (NSUInteger i = 0; i < count; i++) {
+                float tickValue = [ticks[i] floatValue];
+                
+                if (tickValue > lastValue && tickValue <= maxValue) {
+                    CGSize labelSize = [[LineGraphLabelMetrics sharedMetrics] sizeForLabel:labels[i] font:self.labelFont];
+                    LineGraphLabelExtentsAppend(extents, tickValue, labelSize.width, labelSize.height);
+                }
+            }
+            
+            return;
+        }
+        
+        LineGraphLabelExtentsRemoveAll(extents);
+    }
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        float tickValue = [ticks[i] floatValue];
+        
+        if (tickValue >= minValue && tickValue <= maxValue) {
+            CGSize labelSize = [[LineGraphLabelMetrics sharedMetrics] sizeForLabel:labels[i] font:self.labelFont];
+            LineGraphLabelExtentsAppend(extents, tickValue, labelSize.width, labelSize.height);
         }
-    } else {
-        _lineJoins = nil;
     }
+}
 
-    if ([self.dataSource respondsToSelector:@selector(lineGraphView:lineJoinForPlot:)]) {
-        _lineCaps = [NSMutableArray arrayWithCapacity:_plotCount];
-        for (NSUInteger plot = 0; plot < _plotCount; plot++) {
-            [_lineCaps addObject:[self.dataSource lineGraphView:self lineCapForPlot:plot]];
+/* Plots whose points were changed by the update block being ended, or nil if every plot has to be reloaded.
+*/
+- (NSIndexSet *)changedPlotsInUpdate {
+    if (!_isEndingUpdates || _insertPlots.count > 0 || _deletePlots.count > 0) {
+        return nil;
+    }
+    
+    NSMutableIndexSet *plots = [NSMutableIndexSet indexSet];
+    
+    for (NSArray *operation in _updateOperations) {
+        NSString *operTag = operation[0];
+        
+        if ([operTag isEqualToString:@"insert"] || [operTag isEqualToString:@"delete"]) {
+            [plots addIndex:[(NSIndexPath *)operation[1] section]];
+        } else if ([operTag isEqualToString:@"append"]) {
+            [plots addIndex:[operation[1] unsignedIntegerValue]];
+        } else {
+            [plots addIndex:[operation[3] unsignedIntegerValue]];
         }
-    } else {
-        _lineCaps = nil;
     }
     
-    if ([self.dataSource respondsToSelector:@selector(lineGraphView:dashPatternForPlot:)]) {
-        _dashPatterns = [NSMutableArray arrayWithCapacity:_plotCount];
+    return plots;
+}
+
+/* Asks the data source for the line styles of every plot after a reload or a change in plots, and otherwise
+ only for the plots passed to reloadStyleForPlot: since the last load.
+*/
+- (void)loadPlotStyles {
+    BOOL hasLineCaps = [self.dataSource respondsToSelector:@selector(lineGraphView:lineCapForPlot:)];
+    BOOL hasLineJoins = [self.dataSource respondsToSelector:@selector(lineGraphView:lineJoinForPlot:)];
+    BOOL hasDashPatterns = [self.dataSource respondsToSelector:@selector(lineGraphView:dashPatternForPlot:)];
+    NSIndexSet *plots = _invalidStylePlots;
+    
+    if (!_plotStylesValid || _lineWidths.count != _plotCount || (_isEndingUpdates && (_insertPlots.count > 0 || _deletePlots.count > 0))) {
+        plots = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, _plotCount)];
+        
+        _lineWidths = [NSMutableArray arrayWithCapacity:_plotCount];
+        _strokeColors = [NSMutableArray arrayWithCapacity:_plotCount];
+        _lineCaps = hasLineCaps ? [NSMutableArray arrayWithCapacity:_plotCount] : nil;
+        _lineJoins = hasLineJoins ? [NSMutableArray arrayWithCapacity:_plotCount] : nil;
+        _dashPatterns = hasDashPatterns ? [NSMutableArray arrayWithCapacity:_plotCount] : nil;
+        
         for (NSUInteger plot = 0; plot < _plotCount; plot++) {
-            NSArray *dashPattern = [self.dataSource lineGraphView:self dashPatternForPlot:plot];
-            if (dashPattern == nil)
-                [_dashPatterns addObject:[NSNull null]];
-            else
-                [_dashPatterns addObject:dashPattern];
+            [_lineWidths addObject:[NSNull null]];
+            [_strokeColors addObject:[NSNull null]];
+            [_lineCaps addObject:[NSNull null]];
+            [_lineJoins addObject:[NSNull null]];
+            [_dashPatterns addObject:[NSNull null]];
         }
-    } else {
-        _dashPatterns = nil;
     }
-
-    /* STEP 2: calculate the valueRange, if it's not being set by the user, and store in _valueRange
-     */
     
-    if (CGRectEqualToRect(self.valueRange, CGRectZero) || self.valueRangeObject != nil) {
+    [plots enumerateIndexesUsingBlock:^(NSUInteger plot, BOOL *stop) {
+        if (plot >= _plotCount) {
+            *stop = TRUE;
+            return;
+        }
         
-        CGFloat xMin = [[[_plotPoints firstObject] firstObject] CGPointValue].x;
-        CGFloat xMax = [[[_plotPoints firstObject] lastObject] CGPointValue].x;
-        CGFloat yMin = [[[_plotPoints firstObject] firstObject] CGPointValue].y;
-        CGFloat yMax = yMin;
+        _lineWidths[plot] = @([self.dataSource lineGraphView:self lineWidthForPlot:plot]);
+        _strokeColors[plot] = [self.dataSource lineGraphView:self lineColorForPlot:plot];
         
-        for (int i = 0; i < _plotCount; i++) {
-            NSArray *dataPoints = [_plotPoints objectAtIndex:i];
-            for (NSValue *point in dataPoints) {
-                float y = [point CGPointValue].y;
-                yMin = MIN(yMin, y);
-                yMax = MAX(yMax, y);
-            }
-            
-            xMin = MIN(xMin, [[dataPoints firstObject] CGPointValue].x);
-            xMax = MAX(xMax, [[dataPoints lastObject] CGPointValue].x);
+        if (hasLineCaps) {
+            _lineCaps[plot] = [self.dataSource lineGraphView:self lineCapForPlot:plot] ?: [NSNull null];
         }
         
-        _valueRange = CGRectMake(xMin, yMin, xMax - xMin, yMax - yMin);
+        if (hasLineJoins) {
+            _lineJoins[plot] = [self.dataSource lineGraphView:self lineJoinForPlot:plot] ?: [NSNull null];
+        }
         
-        if (self.valueRangeObject) {
-            _valueRange = [self.valueRangeObject getValueRangeFromRange:_valueRange];
+        if (hasDashPatterns) {
+            _dashPatterns[plot] = [self.dataSource lineGraphView:self dashPatternForPlot:plot] ?: [NSNull null];
         }
+    }];
+    
+    [_invalidStylePlots removeAllIndexes];
+    _plotStylesValid = TRUE;
+}
+
+- (void)reloadStyleForPlot:(NSUInteger)plot {
+    [_invalidStylePlots addIndex:plot];
+}
+
+- (NSUInteger)numberOfPointsInPlot:(NSUInteger)plot {
+    return (plot < _plotCount) ? [_plotPoints[plot] count] : 0;
+}
+
+/* Turns queued appends into inserts at the end of the reloaded plot points.
+*/
+- (void)resolveAppendOperations {
+    for (NSUInteger i = 0; i < _updateOperations.count; i++) {
+        NSArray *operation = _updateOperations[i];
         
-    } else {
-        _valueRange = self.valueRange;
+        if (![operation[0] isEqualToString:@"append"]) {
+            continue;
+        }
+        
+        NSUInteger plot = [operation[1] unsignedIntegerValue];
+        NSInteger pointCount = (plot < _plotCount) ? [_plotPoints[plot] count] : 0;
+        NSInteger count = MIN([operation[2] integerValue], pointCount);
+        
+        if (count <= 0) {
+            [_updateOperations removeObjectAtIndex:i--];
+            continue;
+        }
+        
+        _updateOperations[i] = @[@"insert", [NSIndexPath indexPathForRow:pointCount - count inSection:plot], @(count), operation[3]];
     }
+}
 
-    /* STEP 3: Calculate the width and height required for the axes.
-     Store label dimensions for future use by calculatePlotArea.
-     */
+/* Returns the number of points appended to the end of the given plot by the update block currently being
+ ended, or -1 if the plot was changed in any other way.  Points dropped from the start of the plot are fine,
+ they fall out of the extrema window by x value.
+*/
+- (NSInteger)appendedPointCountForPlot:(NSUInteger)plot {
+    if (!_isEndingUpdates || _insertPlots.count > 0 || _deletePlots.count > 0) {
+        return -1;
+    }
     
-    _yLabelHeightsByValue = nil;
-    _xLabelWidthsByValue = nil;
+    NSUInteger pointCount = [_plotPoints[plot] count];
+    NSInteger appendedCount = 0;
+    NSUInteger lowestInsertRow = pointCount;
     
-    if (self.yAxisPosition != kLineGraphAxisPositionNone) {
-        // Step 1: calculate the required width
+    for (NSArray *operation in _updateOperations) {
+        NSString *operTag = operation[0];
+        
+        if ([operTag isEqualToString:@"insert"]) {
+            NSIndexPath *indexPath = operation[1];
+            
+            if (indexPath.section == plot) {
+                appendedCount += [operation[2] integerValue];
+                lowestInsertRow = MIN(lowestInsertRow, indexPath.row);
+            }
+        } else if ([operTag isEqualToString:@"delete"]) {
+            NSIndexPath *indexPath = operation[1];
+            
+            if (indexPath.section == plot && indexPath.row != 0) {
+                return -1;
+            }
+        } else if ([operation[3] integerValue] == plot) {
+            return -1;
+        }
+    }
+    
+    if ((NSUInteger)appendedCount > pointCount || lowestInsertRow < pointCount - appendedCount) {
+        return -1;
+    }
+    
+    return appendedCount;
+}
+
+/* Brings the sliding window extrema of every plot up to date with _plotPoints.  Plots that only had
+ points appended during an update block are extended in place, everything else is rebuilt.
+*/
+- (void)updatePlotExtrema {
+    BOOL canExtend = _plotExtremaValid && _plotExtremaCount == _plotCount;
+    
+    if (_plotExtremaCount != _plotCount) {
+        for (NSUInteger plot = 0; plot < _plotExtremaCount; plot++) {
+            LineGraphWindowExtremaDestroy(&_plotExtrema[plot]);
+        }
         
-        CGFloat maxWidth = 0;
+        free(_plotExtrema);
         
-        if ([self.dataSource respondsToSelector:@selector(yAxisTickIntervalInLineGraphView:)]) {
-            LineGraphTickInterval *tickInterval = [self.dataSource yAxisTickIntervalInLineGraphView:self];
-            _yTicks = [tickInterval ticksForStart:CGRectGetMinY(_valueRange) end:CGRectGetMaxY(_valueRange)];
-            _yLabels = [tickInterval labelsForStart:CGRectGetMinY(_valueRange) end:CGRectGetMaxY(_valueRange)];
+        _plotExtrema = calloc(_plotCount, sizeof(LineGraphWindowExtrema));
+        _plotExtremaCount = _plotCount;
+        
+        for (NSUInteger plot = 0; plot < _plotExtremaCount; plot++) {
+            LineGraphWindowExtremaInit(&_plotExtrema[plot]);
+        }
+    }
+    
+    for (NSUInteger plot = 0; plot < _plotCount; plot++) {
+        LineGraphPlotPoints *dataPoints = _plotPoints[plot];
+        LineGraphWindowExtrema *extrema = &_plotExtrema[plot];
+        NSInteger appendedCount = canExtend ? [self appendedPointCountForPlot:plot] : -1;
+        NSUInteger startIndex = 0;
+        
+        if (appendedCount >= 0) {
+            startIndex = dataPoints.count - appendedCount;
         } else {
-            _yTicks = nil;
-            _yLabels = nil;
+            LineGraphWindowExtremaRemoveAll(extrema);
         }
         
-        if (_yTicks == nil) {
-            if ([self.dataSource respondsToSelector:@selector(yAxisTickMarksInLineGraphView:)]) {
-                _yTicks = [self.dataSource yAxisTickMarksInLineGraphView:self];
-            } else {
-                _yTicks = @[];
+        for (NSUInteger i = startIndex; i < dataPoints.count; i++) {
+            if (!isnan(dataPoints.xValues[i])) {
+                LineGraphWindowExtremaPush(extrema, dataPoints.xOrigin + dataPoints.xValues[i], dataPoints.yValues[i]);
             }
         }
+        
+        if (dataPoints.count > 0 && !isnan(dataPoints.xValues[0])) {
+            LineGraphWindowExtremaEvictBefore(extrema, dataPoints.xOrigin + dataPoints.xValues[0]);
+        }
+    }
     
-        if (_yLabels == nil) {
-            if ([self.dataSource respondsToSelector:@selector(labelsForYAxisTickMarksInGraphView:)]) {
-                _yLabels = [self.dataSource labelsForYAxisTickMarksInGraphView:self];
-            } else {
-                _yLabels = @[];
-            }
+    _plotExtremaValid = TRUE;
+}
+
+/* Brings the pyramid of every plot up to date with _plotPoints, the same way as updatePlotExtrema.  Plots with
+ gaps are left invalid, as buckets can not span them.
+*/
+- (void)updatePlotPyramids {
+    BOOL canExtend = _plotPyramidsValid && _plotPyramidCount == _plotCount;
+    
+    if (_plotPyramidCount != _plotCount) {
+        for (NSUInteger plot = 0; plot < _plotPyramidCount; plot++) {
+            LineGraphPyramidDestroy(&_plotPyramids[plot]);
         }
         
-        if (_yTicks.count > 0) {
-            for (int i = 0; i < _yTicks.count; i++) {
-                float tickValue = [[_yTicks objectAtIndex:i] floatValue];
-                
-                if (tickValue >= CGRectGetMinY(_valueRange) && tickValue <= CGRectGetMaxY(_valueRange)) {
-                    NSString *label = [_yLabels objectAtIndex:i];
-                    CGSize labelSize = [label sizeWithAttributes:@{NSFontAttributeName:self.labelFont}];
-                    maxWidth = MAX(maxWidth, labelSize.width);
-                    
-                    if (_yLabelHeightsByValue == nil) {
-                        _yLabelHeightsByValue = [NSMutableDictionary dictionary];
-                    }
-                    
-                    [_yLabelHeightsByValue setValue:[NSNumber numberWithFloat:labelSize.height] forKey:[NSString stringWithFormat:@"%f", tickValue]];
-                }
-            }
-            _yAxisWidth = ceil(maxWidth) + self.tickLength + 2;
-        } else {
-            _yAxisWidth = self.tickLength;
+        free(_plotPyramids);
+        
+        _plotPyramids = calloc(_plotCount, sizeof(LineGraphPyramid));
+        _plotPyramidCount = _plotCount;
+        
+        for (NSUInteger plot = 0; plot < _plotPyramidCount; plot++) {
+            LineGraphPyramidInit(&_plotPyramids[plot]);
         }
     }
     
-    if (self.xAxisPosition != kLineGraphAxisPositionNone) {
-        CGFloat maxLabelHeight = 0;
+    for (NSUInteger plot = 0; plot < _plotCount; plot++) {
+        LineGraphPlotPoints *dataPoints = _plotPoints[plot];
+        LineGraphPyramid *pyramid = &_plotPyramids[plot];
+        NSInteger appendedCount = canExtend ? [self appendedPointCountForPlot:plot] : -1;
+        NSUInteger startIndex = 0;
         
-        if ([self.dataSource respondsToSelector:@selector(xAxisTickIntervalInLineGraphView:)]) {
-            LineGraphTickInterval *tickInterval = [self.dataSource xAxisTickIntervalInLineGraphView:self];
-            _xTicks = [tickInterval ticksForStart:CGRectGetMinX(_valueRange) end:CGRectGetMaxX(_valueRange)];
-            _xLabels = [tickInterval labelsForStart:CGRectGetMinX(_valueRange) end:CGRectGetMaxX(_valueRange)];
+        if (appendedCount >= 0) {
+            startIndex = dataPoints.count - appendedCount;
         } else {
-            _xTicks = nil;
-            _xLabels = nil;
+            LineGraphPyramidRemoveAll(pyramid);
         }
         
-        if (_xTicks == nil) {
-            if ([self.dataSource respondsToSelector:@selector(xAxisTickMarksInLineGraphView:)]) {
-                _xTicks = [self.dataSource xAxisTickMarksInLineGraphView:self];
-            } else {
-                _xTicks = @[];
+        for (NSUInteger i = startIndex; i < dataPoints.count && pyramid->isValid; i++) {
+            if (isnan(dataPoints.xValues[i])) {
+                pyramid->isValid = false;
+                break;
             }
+            
+            LineGraphPyramidAppend(pyramid, dataPoints.xOrigin + dataPoints.xValues[i], dataPoints.yValues[i]);
         }
         
-        if (_xLabels == nil) {
-            if ([self.dataSource respondsToSelector:@selector(labelsForXAxisTickMarksInGraphView:)]) {
-                _xLabels = [self.dataSource labelsForXAxisTickMarksInGraphView:self];
-            } else {
-                _xLabels = @[];
-            }
+        if (dataPoints.count > 0 && pyramid->isValid) {
+            LineGraphPyramidEvictBefore(pyramid, dataPoints.xOrigin + dataPoints.xValues[0]);
         }
+    }
+    
+    _plotPyramidsValid = TRUE;
+}
+
+/* Records the points appended to and dropped from every plot since its path was last drawn, so pathForPlot:
+ can extend that path.  Paths of plots changed in any other way are released.
+*/
+- (void)updatePlotPaths {
+    if (_plotPathCount != _plotCount) {
+        [self removePlotPaths];
         
-        if (_xTicks.count > 0) {
-            for (int i = 0; i < _xTicks.count; i++) {
-                if (i >= _xLabels.count)
-                    break;
-                
-                float tickValue = [[_xTicks objectAtIndex:i] floatValue];
-                
-                if (tickValue >= CGRectGetMinX(_valueRange) && tickValue <= CGRectGetMaxX(_valueRange)) {
-                    NSString *label = [_xLabels objectAtIndex:i];
-                    CGSize labelSize = [label sizeWithAttributes:@{NSFontAttributeName:self.labelFont}];
-                    maxLabelHeight = MAX(maxLabelHeight, labelSize.height * 1.2);
-                    
-                    if (_xLabelWidthsByValue == nil) {
-                        _xLabelWidthsByValue = [NSMutableDictionary dictionary];
-                    }
-                    
-                    [_xLabelWidthsByValue setValue:[NSNumber numberWithFloat:labelSize.width] forKey:[NSString stringWithFormat:@"%f", tickValue]];
-                }
+        free(_plotPaths);
+        
+        _plotPaths = calloc(_plotCount, sizeof(LineGraphPlotPath));
+        _plotPathCount = _plotCount;
+    }
+    
+    for (NSUInteger plot = 0; plot < _plotPathCount; plot++) {
+        LineGraphPlotPath *plotPath = &_plotPaths[plot];
+        NSUInteger pointCount = [_plotPoints[plot] count];
+        NSInteger appendedCount = (plotPath->path != NULL) ? [self appendedPointCountForPlot:plot] : -1;
+        
+        if (appendedCount >= 0 && plotPath->plotPointCount + appendedCount >= pointCount) {
+            plotPath->appendedCount += appendedCount;
+            plotPath->droppedCount += plotPath->plotPointCount + appendedCount - pointCount;
+            
+            if (plotPath->droppedCount >= plotPath->pointCount || (!plotPath->isSimple && plotPath->appendedCount + plotPath->droppedCount > 0)) {
+                CGPathRelease(plotPath->path);
+                plotPath->path = NULL;
             }
-            _xAxisHeight = ceil(maxLabelHeight / 2) + 3 + (self.xAlignment == kLineGraphXAlignCenter ? self.tickLength : 0);
         } else {
-            _xAxisHeight = self.tickLength;
+            CGPathRelease(plotPath->path);
+            plotPath->path = NULL;
         }
+        
+        plotPath->plotPointCount = pointCount;
     }
 }
 
+- (void)removePlotPaths {
+    for (NSUInteger plot = 0; plot < _plotPathCount; plot++) {
+        CGPathRelease(_plotPaths[plot].path);
+        _plotPaths[plot].path = NULL;
+    }
+}
+
+- (void)setDecimationMode:(LineGraphDecimationMode)decimationMode {
+    _decimationMode = decimationMode;
+    
+    [self removePlotPaths];
+}
+
 - (void)animateToFrame:(CGRect)frame duration:(CFTimeInterval)duration {
     [self.layer animateFromFrame:self.frame toFrame:frame duration:duration];
     
@@ -742,11 +1665,21 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     
     for (int plot = 0; plot < _plotCount; plot++) {
         CAShapeLayer *layer = [_plotLayers objectAtIndex:plot];
+        
+        if (self.streaming) {
+            [layer animateFromFrame:layer.frame toFrame:_plotArea duration:duration];
+            continue;
+        }
+        
         CGPathRef path = [self pathForPlot:plot];
         [layer animateFromFrame:layer.frame toFrame:_plotArea duration:duration path:path];
         CGPathRelease(path);
     }
     
+    if (self.streaming) {
+        [self updateStreamLayersWithDuration:0];
+    }
+    
     [self resizeAxisLayersWithDuration:duration];
 }
 
@@ -796,60 +1729,31 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
 //    }
 //}
 
-/* Utility method for interpolating values for prettier replace path transformation. */
-- (NSArray *)interpolateDataPointsForXValues:(NSOrderedSet *)values
-                                  fromPoints:(NSArray *)points
-                                    plotArea:(CGRect)plotArea
-                                  valueRange:(CGRect)valueRange {
-    
-    NSUInteger lastIndex = 0;
-    BOOL lastValueReached = FALSE;
+/* Utility method for interpolating values for prettier replace path transformation.  The source's x values are
+ relative to xOrigin.  Returns nil if there is no room to interpolate in.
+*/
+- (NSArray *)interpolateDataPointsForPlotXValues:(const float *)plotXValues
+                                           count:(NSUInteger)count
+                                      fromSource:(const LineGraphInterpolationSource *)source
+                                         xOrigin:(double)xOrigin {
     
-    NSMutableArray *interpolatedPoints = [NSMutableArray array];
-    [interpolatedPoints addObject:[points firstObject]];
+    float *xValues = malloc(sizeof(float) * count * 2);
     
-    for (NSUInteger i = 1; i < values.count; i++) {
-        float x = [(NSNumber *)values[i] floatValue];
-        
-        CGPoint lastPointValue = [points[lastIndex] CGPointValue];
-        
-        float lastPointX = PlotXForValue([points[lastIndex] CGPointValue].x, plotArea, valueRange);
-        
-        if (lastValueReached) {
-            [interpolatedPoints addObject:[points lastObject]];
-        } else if (x <= lastPointX) {
-            [interpolatedPoints addObject:points[lastIndex]];
-        } else {
-            BOOL found = FALSE;
-            for (NSUInteger nextIndex = lastIndex + 1; nextIndex < points.count; nextIndex++) {
-                CGPoint nextPointValue = [points[nextIndex] CGPointValue];
-                float nextPointX = PlotXForValue(nextPointValue.x, plotArea, valueRange);
-                
-                if (x < nextPointX) {
-                    float xPoint = lastPointValue.x + ((nextPointValue.x - lastPointValue.x) * ((x - lastPointX) / (nextPointX - lastPointX)));
-                    float y = lastPointValue.y + ((nextPointValue.y - lastPointValue.y) * ((xPoint - lastPointValue.x) / (nextPointValue.x - lastPointValue.x)));
-                    [interpolatedPoints addObject:[NSValue valueWithCGPoint:CGPointMake(xPoint, y)]];
-                    found = TRUE;
-                    break;
-                } else if (x == nextPointX) {
-                    [interpolatedPoints addObject:points[nextIndex]];
-                    lastIndex = nextIndex;
-                    found = TRUE;
-                    break;
-                } else {
-                    lastIndex = nextIndex;
-                    lastPointValue = [points[lastIndex] CGPointValue];
-                    lastPointX = PlotXForValue(lastPointValue.x, plotArea, valueRange);
-                }
-            }
-            if (!found) {
-                [interpolatedPoints addObject:[points lastObject]];
-                lastValueReached = TRUE;
-            }
-        }
+    if (xValues == NULL) {
+        return nil;
     }
     
-    return [NSArray arrayWithArray:interpolatedPoints];
+    float *yValues = xValues + count;
+    
+    LineGraphInterpolateAtPlotX(source, plotXValues, count, xValues, yValues);
+    
+    // Points without a value are NAN, which the columns already treat as gaps
+    LineGraphPlotBuffer buffer = { xValues, yValues, count, NULL, 0, 0, xOrigin };
+    LineGraphPlotPoints *interpolatedPoints = [[LineGraphPlotPoints alloc] initWithBuffer:&buffer];
+    
+    free(xValues);
+    
+    return interpolatedPoints;
 }
 
 - (void)beginUpdates {
@@ -857,8 +1761,9 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     _beginUpdateTicksX = [_xTicks copy];
     _beginUpdateTicksY = [_yTicks copy];
     
+    // Points are immutable, they are only copied if a deletion has to mark them
     for (NSInteger plot = 0; plot < _plotCount; plot++) {
-        [_beginUpdatePlotPoints addObject:[_plotPoints[plot] mutableCopy]];
+        [_beginUpdatePlotPoints addObject:_plotPoints[plot]];
     }
     
     _beginUpdateValueRange = _valueRange;
@@ -873,6 +1778,7 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     float duration = self.animationDuration;
     
     BOOL plotAreaAnimated = FALSE;
+    BOOL needsReload = FALSE;
     
     CGRect origPlotArea = _plotArea;
     
@@ -888,20 +1794,25 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     
     /* Next, reload data and do all of the usual calculations.
      */
+    _isEndingUpdates = TRUE;
     [self loadData];
+    _isEndingUpdates = FALSE;
     [self resizePlotArea];
     [self resizeAxisLayersWithDuration:duration];
 
     CGRect newPlotArea = _plotArea;
     
+    if (self.streaming) {
+        [self endStreamingUpdatesWithDuration:duration];
+        return;
+    }
+    
     /* Now we calculate a transformation from the previous plotArea and valueRange into the newly calculated ones.
      This will be used to transform partial paths.  Not sure if this is still useful with the changes to path
      calculation, but is still used in a couple places.  Probably slightly more efficient than calculating the
      opposing path with pathForPlotPoints.
      */
-    CGAffineTransform transform = CGAffineTransformTranslate(CGAffineTransformIdentity, OffsetXForValue(CGRectGetMinX(_beginUpdateValueRange), newPlotArea, _valueRange), OffsetYForValue(CGRectGetMaxY(_beginUpdateValueRange), newPlotArea, _valueRange));
-    
-    transform = CGAffineTransformScale(transform, newPlotArea.size.width / origPlotArea.size.width * CGRectGetWidth(_beginUpdateValueRange) / CGRectGetWidth(_valueRange), newPlotArea.size.height / origPlotArea.size.height * CGRectGetHeight(_beginUpdateValueRange) / CGRectGetHeight(_valueRange));
+    CGAffineTransform transform = TransformBetweenRanges(origPlotArea, _beginUpdateValueRange, newPlotArea, _valueRange);
     
     /* Animate out any plots marked for deletion, in reverse index order.
     */
@@ -967,6 +1878,11 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
             id<LineGraphPlotAnimator>animator = operation[3];
 
             NSMutableArray *dataPoints = _beginUpdatePlotPoints[indexPath.section];
+            
+            if (![dataPoints isKindOfClass:[NSMutableArray class]]) {
+                dataPoints = [dataPoints mutableCopy];
+                _beginUpdatePlotPoints[indexPath.section] = dataPoints;
+            }
 
             if (duration > 0 && animator.animation != nil) {
                 
@@ -1017,11 +1933,11 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
                     anchorLocation |= kLineGraphAnchorRight;
                 }
                 
-                CGPathRef startPath = [self pathForPlotPoints:subPlotPoints frame:startFrame valueRange:subValueRangeStart];
+                CGPathRef startPath = [self animationPathForPlotPoints:subPlotPoints frame:startFrame valueRange:subValueRangeStart anchorRange:CGRectZero anchorLocation:0];
                 animationLayer.path = startPath;
                 CGPathRelease(startPath);
                 
-                CGPathRef endPath = [self pathForPlotPoints:subPlotPoints frame:endFrame valueRange:subValueRangeStart anchorRange:subValueRangeEnd anchorLocation:anchorLocation];
+                CGPathRef endPath = [self animationPathForPlotPoints:subPlotPoints frame:endFrame valueRange:subValueRangeStart anchorRange:subValueRangeEnd anchorLocation:anchorLocation];
                 [animationLayer animateFromFrame:startFrame toFrame:endFrame duration:duration path:endPath];
                 CGPathRelease(endPath);
                 
@@ -1094,11 +2010,11 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
                     anchorLocation |= kLineGraphAnchorRight;
                 }
                 
-                CGPathRef startPath = [self pathForPlotPoints:subPlotPoints frame:startFrame valueRange:subValueRangeEnd anchorRange:subValueRangeStart anchorLocation:anchorLocation];
+                CGPathRef startPath = [self animationPathForPlotPoints:subPlotPoints frame:startFrame valueRange:subValueRangeEnd anchorRange:subValueRangeStart anchorLocation:anchorLocation];
                 animationLayer.path = startPath;
                 CGPathRelease(startPath);
                 
-                CGPathRef endPath = [self pathForPlotPoints:subPlotPoints frame:endFrame valueRange:subValueRangeEnd];
+                CGPathRef endPath = [self animationPathForPlotPoints:subPlotPoints frame:endFrame valueRange:subValueRangeEnd anchorRange:CGRectZero anchorLocation:0];
                 [animationLayer animateFromFrame:startFrame toFrame:endFrame duration:duration path:endPath];
                 CGPathRelease(endPath);
                 
@@ -1134,6 +2050,12 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
             
             NSMutableArray *fromDataPoints = _beginUpdatePlotPoints[plot];
             
+            // The removed points are blanked out below
+            if (![fromDataPoints isKindOfClass:[NSMutableArray class]]) {
+                fromDataPoints = [fromDataPoints mutableCopy];
+                _beginUpdatePlotPoints[plot] = fromDataPoints;
+            }
+            
             if (fromEndIndex >= fromDataPoints.count || [fromDataPoints[fromEndIndex] isEqual:[NSNull null]]) {
                 fromEndIndex -= 1;
             }
@@ -1149,21 +2071,40 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
             // If we're using an interpolated style, then for both ranges we need to interpolate the values that
             // there are corresponding X values for in the other data set.
             if (animationStyle == kLineGraphReplaceStyleInterpolate) {
-                NSMutableOrderedSet *combinedX = [[NSMutableOrderedSet alloc] init];
+                NSUInteger fromCount = fromSubrange.count;
+                NSUInteger toCount = toSubrange.count;
                 
-                for (NSValue *value in fromSubrange) {
-                    [combinedX addObject:@(PlotXForValue(value.CGPointValue.x, origPlotArea, _beginUpdateValueRange))];
-                }
+                // Plot x positions are computed once per point, then both ranges are sampled at their union
+                float *fromValues = malloc(sizeof(float) * fromCount * 3);
+                float *toValues = malloc(sizeof(float) * toCount * 3);
+                float *combinedX = malloc(sizeof(float) * (fromCount + toCount));
+                BOOL isInterpolated = (fromValues != NULL && toValues != NULL && combinedX != NULL);
                 
-                for (NSValue *value in toSubrange) {
-                    [combinedX addObject:@(PlotXForValue(value.CGPointValue.x, newPlotArea, _valueRange))];
+                if (isInterpolated) {
+                    double fromXOrigin = CopyInterpolationPoints(fromSubrange, origPlotArea, _beginUpdateValueRange, fromValues, fromValues + fromCount, fromValues + fromCount * 2);
+                    double toXOrigin = CopyInterpolationPoints(toSubrange, newPlotArea, _valueRange, toValues, toValues + toCount, toValues + toCount * 2);
+                    
+                    NSUInteger combinedCount = LineGraphMergeSortedUnique(fromValues, fromCount, toValues, toCount, combinedX);
+                    
+                    if (combinedCount > 0) {
+                        LineGraphInterpolationSource fromSource = { fromValues, fromValues + fromCount, fromValues + fromCount * 2, fromCount };
+                        LineGraphInterpolationSource toSource = { toValues, toValues + toCount, toValues + toCount * 2, toCount };
+                        
+                        fromSubrange = [self interpolateDataPointsForPlotXValues:combinedX count:combinedCount fromSource:&fromSource xOrigin:fromXOrigin];
+                        toSubrange = [self interpolateDataPointsForPlotXValues:combinedX count:combinedCount fromSource:&toSource xOrigin:toXOrigin];
+                        isInterpolated = (fromSubrange != nil && toSubrange != nil);
+                    }
                 }
                 
-                NSSortDescriptor *sortDescriptor = [NSSortDescriptor sortDescriptorWithKey:@"self" ascending:YES];
-                [combinedX sortUsingDescriptors:@[sortDescriptor]];
+                free(fromValues);
+                free(toValues);
+                free(combinedX);
                 
-                fromSubrange = [self interpolateDataPointsForXValues:combinedX fromPoints:fromSubrange plotArea:origPlotArea valueRange:_beginUpdateValueRange];
-                toSubrange = [self interpolateDataPointsForXValues:combinedX fromPoints:toSubrange plotArea:newPlotArea valueRange:_valueRange];
+                // Without room to interpolate in, the whole update is shown without animation
+                if (!isInterpolated) {
+                    needsReload = TRUE;
+                    break;
+                }
             }
             
             CGPoint fromStartPoint = [(NSValue *)fromDataPoints[fromStartIndex] CGPointValue];
@@ -1187,11 +2128,11 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
             
             /* Calculate the start and end paths, animate, mark animation layer for removal once complete.
              */
-            CGPathRef startPath = [self pathForPlotPoints:fromSubrange frame:startFrame valueRange:fromValueRange];
+            CGPathRef startPath = [self animationPathForPlotPoints:fromSubrange frame:startFrame valueRange:fromValueRange anchorRange:CGRectZero anchorLocation:0];
             animationLayer.path = startPath;
             CGPathRelease(startPath);
             
-            CGPathRef endPath = [self pathForPlotPoints:toSubrange frame:endFrame valueRange:toValueRange];
+            CGPathRef endPath = [self animationPathForPlotPoints:toSubrange frame:endFrame valueRange:toValueRange anchorRange:CGRectZero anchorLocation:0];
             [animationLayer animateFromFrame:startFrame toFrame:endFrame duration:duration path:endPath];
             CGPathRelease(endPath);
             
@@ -1219,16 +2160,30 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
         }
     }
     
+    if (needsReload) {
+        for (CALayer *layer in _layersToRemove) {
+            [layer removeFromSuperlayer];
+        }
+        
+        [_layersToRemove removeAllObjects];
+        _animatingLayerCount = 0;
+        
+        [self reloadData];
+        return;
+    }
+    
     /* Any data points that haven't been removed by delete/replace actions need to be animated into the
      new value range, unless no animations were called at all, in which case we can just directly place
-     the new path.
+     the new path.  That path extends the last one drawn when points were only appended.
     */
     for (NSInteger plot = 0; plot < _plotCount; plot++) {
         CAShapeLayer *layer = _plotLayers[plot];
-        CGPathRef newPath = CGPathCreateCopyByTransformingPath(layer.path, &transform);
+        CGPathRef newPath;
         if (plotAreaAnimated) {
+            newPath = CGPathCreateCopyByTransformingPath(layer.path, &transform);
             [layer animateFromFrame:origPlotArea toFrame:newPlotArea duration:duration path:newPath];
         } else {
+            newPath = [self pathForPlot:plot];
             layer.path = newPath;
         }
         CGPathRelease(newPath);
@@ -1240,51 +2195,146 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
     _animatingLayerCount = [_layersToRemove count];
 }
 
+/* Ends an update block in streaming mode.  Plot layers are recreated if plots were inserted or deleted, then
+ every plot scrolls to the new value range in one animation.
+*/
+- (void)endStreamingUpdatesWithDuration:(CFTimeInterval)duration {
+    if (_insertPlots.count > 0 || _deletePlots.count > 0 || _plotLayers.count != _plotCount) {
+        for (CALayer *plotLayer in _plotLayers) {
+            [plotLayer removeFromSuperlayer];
+        }
+        
+        [_plotLayers removeAllObjects];
+        
+        for (NSUInteger plot = 0; plot < _plotCount; plot++) {
+            CAShapeLayer *layer = [self layerForPlot:plot];
+            [self.layer addSublayer:layer];
+            [_plotLayers addObject:layer];
+        }
+        
+        duration = 0;
+    }
+    
+    for (CAShapeLayer *layer in _plotLayers) {
+        layer.frame = _plotArea;
+    }
+    
+    [self updateStreamLayersWithDuration:duration];
+}
+
 /* Creates a path with the given points.  Anchor range is provided to allow
  the ends of the path to be part of a different value range, for use with
- animations.
+ animations.  Decimation is left out when the path has to match another one
+ point for point.
 */
 - (CGMutablePathRef)pathForPlotPoints:(NSArray *)dataPoints
                                 frame:(CGRect)frame
                            valueRange:(CGRect)valueRange
                           anchorRange:(CGRect)anchorRange
-                       anchorLocation:(NSInteger)anchorLocation {
+                       anchorLocation:(NSInteger)anchorLocation
+                            decimated:(BOOL)decimated {
     
     CGMutablePathRef path = CGPathCreateMutable();
     
-    BOOL skipNext = TRUE;
-    for (id value in dataPoints) {
-        if ([value isEqual:[NSNull null]]) {
-            skipNext = TRUE;
+    LineGraphPlotPoints *plotPoints = [LineGraphPlotPoints pointsWithArray:dataPoints];
+    NSUInteger count = plotPoints.count;
+    double xOrigin = plotPoints.xOrigin;
+    float *xValues = malloc(sizeof(float) * count * (decimated ? 4 : 2));
+    
+    // Without room for the decimated points every point is added, and without room for those the path stays empty
+    if (xValues == NULL && decimated) {
+        decimated = FALSE;
+        xValues = malloc(sizeof(float) * count * 2);
+    }
+    
+    if (xValues == NULL) {
+        return path;
+    }
+    
+    float *yValues = xValues + count;
+    float *decimatedXValues = decimated ? yValues + count : NULL;
+    float *decimatedYValues = decimated ? decimatedXValues + count : NULL;
+    NSUInteger segmentLength = 0;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        if (isnan(plotPoints.xValues[i])) {
+            [self addSegmentToPath:path xValues:xValues yValues:yValues count:segmentLength
+                  decimatedXValues:decimatedXValues decimatedYValues:decimatedYValues];
+            segmentLength = 0;
             continue;
         }
 
-        CGPoint point = [(NSValue *)value CGPointValue];
-
-        CGFloat x, y;
+        CGPoint point = CGPointMake(plotPoints.xValues[i], plotPoints.yValues[i]);
         
-        if ((anchorLocation & kLineGraphAnchorLeft && value == dataPoints.firstObject)
-            || (anchorLocation & kLineGraphAnchorRight && value == dataPoints.lastObject)) {
-            x = OffsetXForValue(point.x, frame, anchorRange);
-            y = OffsetYForValue(point.y, frame, anchorRange);
+        if ((anchorLocation & kLineGraphAnchorLeft && i == 0)
+            || (anchorLocation & kLineGraphAnchorRight && i == count - 1)) {
+            xValues[segmentLength] = OffsetXForOriginValue(xOrigin, point.x, frame, anchorRange);
+            yValues[segmentLength] = OffsetYForValue(point.y, frame, anchorRange);
         } else {
-            x = OffsetXForValue(point.x, frame, valueRange);
-            y = OffsetYForValue(point.y, frame, valueRange);
+            xValues[segmentLength] = OffsetXForOriginValue(xOrigin, point.x, frame, valueRange);
+            yValues[segmentLength] = OffsetYForValue(point.y, frame, valueRange);
         }
         
-        if (skipNext) {
-            CGPathMoveToPoint(path, NULL, x, y);
-            skipNext = FALSE;
-        } else {
-            CGPathAddLineToPoint(path, NULL, x, y);
-        }
+        segmentLength++;
     }
     
+    [self addSegmentToPath:path xValues:xValues yValues:yValues count:segmentLength
+          decimatedXValues:decimatedXValues decimatedYValues:decimatedYValues];
+    
+    free(xValues);
+    
     return path;
 }
 
+/* Adds a continuous run of plot coordinates to the path, decimating it first if there are more points
+ than the run has pixel columns.  Decimated buffers must be able to hold count points, or be NULL to add
+ every point.
+*/
+- (void)addSegmentToPath:(CGMutablePathRef)path
+                 xValues:(const float *)xValues
+                 yValues:(const float *)yValues
+                   count:(NSUInteger)count
+        decimatedXValues:(float *)decimatedXValues
+        decimatedYValues:(float *)decimatedYValues {
+    
+    if (count == 0) {
+        return;
+    }
+    
+    float columnWidth = 1.f / self.contentScaleFactor;
+    size_t threshold = (decimatedXValues != NULL) ? LineGraphDecimationThreshold(xValues[count - 1] - xValues[0], columnWidth) : count;
+    
+    if (count > threshold && self.decimationMode == kLineGraphDecimationMinMax) {
+        count = LineGraphDecimateMinMax(xValues, yValues, count, columnWidth, decimatedXValues, decimatedYValues);
+        xValues = decimatedXValues;
+        yValues = decimatedYValues;
+    } else if (count > threshold && self.decimationMode == kLineGraphDecimationLargestTriangle) {
+        count = LineGraphDecimateLargestTriangle(xValues, yValues, count, threshold, decimatedXValues, decimatedYValues);
+        xValues = decimatedXValues;
+        yValues = decimatedYValues;
+    }
+    
+    CGPathMoveToPoint(path, NULL, xValues[0], yValues[0]);
+    
+    for (NSUInteger i = 1; i < count; i++) {
+        CGPathAddLineToPoint(path, NULL, xValues[i], yValues[i]);
+    }
+}
+
 - (CGMutablePathRef)pathForPlotPoints:(NSArray *)dataPoints frame:(CGRect)frame valueRange:(CGRect)valueRange {
-    return [self pathForPlotPoints:dataPoints frame:frame valueRange:valueRange anchorRange:CGRectZero anchorLocation:0];
+    return [self pathForPlotPoints:dataPoints frame:frame valueRange:valueRange anchorRange:CGRectZero anchorLocation:0 decimated:TRUE];
+}
+
+/* Creates the start or end path of an animation.  Path animations interpolate between paths element by element,
+ so both ends are drawn with every point; decimating them separately could leave different element counts.
+*/
+- (CGMutablePathRef)animationPathForPlotPoints:(NSArray *)dataPoints
+                                         frame:(CGRect)frame
+                                    valueRange:(CGRect)valueRange
+                                   anchorRange:(CGRect)anchorRange
+                                anchorLocation:(NSInteger)anchorLocation {
+    
+    return [self pathForPlotPoints:dataPoints frame:frame valueRange:valueRange anchorRange:anchorRange anchorLocation:anchorLocation decimated:FALSE];
 }
 
 - (void)insertPointsAtIndexPath:(NSIndexPath *)indexPath count:(NSInteger)count animator:(id<LineGraphPlotAnimator>)animator {
@@ -1298,6 +2348,10 @@ typedef NS_ENUM(NSInteger, LineGraphAnchorLocation) {
                          animator:[LineGraphPlotAnimation animationOfType:kLineGraphAnimationFadeIn]];
 }
 
+- (void)appendPointsToPlot:(NSUInteger)plot count:(NSInteger)count animator:(id<LineGraphPlotAnimator>)animator {
+    [_updateOperations addObject:@[@"append", @(plot), @(count), animator]];
+}
+
 - (void)deletePointsAtIndexPath:(NSIndexPath *)indexPath count:(NSUInteger)count animator:(id<LineGraphPlotAnimator>)animator {
     [_updateOperations addObject:@[@"delete", indexPath, @(count), animator]];
 }
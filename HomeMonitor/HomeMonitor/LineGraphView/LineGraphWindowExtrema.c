@@ -0,0 +1,142 @@
+//
+//  LineGraphWindowExtrema.c
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LineGraphWindowExtrema.h"
+
+static LineGraphExtremaEntry *DequeEntryAt(const LineGraphExtremaDeque *deque, size_t index) {
+    index += deque->head;
+
+    if (index >= deque->capacity) {
+        index -= deque->capacity;
+    }
+
+    return &deque->entries[index];
+}
+
+static bool DequeGrow(LineGraphExtremaDeque *deque) {
+    size_t capacity = (deque->capacity > 0) ? deque->capacity * 2 : 16;
+    LineGraphExtremaEntry *entries = malloc(sizeof(LineGraphExtremaEntry) * capacity);
+
+    if (entries == NULL) {
+        return false;
+    }
+
+    // Unwrap into the new buffer so head starts at zero again.
+    size_t firstCount = deque->capacity - deque->head;
+
+    if (firstCount > deque->count) {
+        firstCount = deque->count;
+    }
+
+    if (deque->count > 0) {
+        memcpy(entries, &deque->entries[deque->head], sizeof(LineGraphExtremaEntry) * firstCount);
+        memcpy(entries + firstCount, deque->entries, sizeof(LineGraphExtremaEntry) * (deque->count - firstCount));
+    }
+
+    free(deque->entries);
+
+    deque->entries = entries;
+    deque->capacity = capacity;
+    deque->head = 0;
+
+    return true;
+}
+
+/* Makes room for one more entry without changing the entries already stored. */
+static bool DequeReserve(LineGraphExtremaDeque *deque) {
+    return deque->count < deque->capacity || DequeGrow(deque);
+}
+
+/* Drops entries from the back that can no longer be an extremum, then appends the new entry.
+ With isMinimum set, the deque keeps ascending y values, otherwise descending ones.  There must be room for one
+ more entry.
+*/
+static void DequePush(LineGraphExtremaDeque *deque, double x, double y, bool isMinimum) {
+    while (deque->count > 0) {
+        double backY = DequeEntryAt(deque, deque->count - 1)->y;
+
+        if ((isMinimum && backY < y) || (!isMinimum && backY > y)) {
+            break;
+        }
+
+        deque->count -= 1;
+    }
+
+    LineGraphExtremaEntry *entry = DequeEntryAt(deque, deque->count);
+    entry->x = x;
+    entry->y = y;
+
+    deque->count += 1;
+}
+
+static void DequeEvictBefore(LineGraphExtremaDeque *deque, double x) {
+    while (deque->count > 0 && deque->entries[deque->head].x < x) {
+        deque->head += 1;
+        deque->count -= 1;
+
+        if (deque->head == deque->capacity) {
+            deque->head = 0;
+        }
+    }
+}
+
+void LineGraphWindowExtremaInit(LineGraphWindowExtrema *extrema) {
+    memset(extrema, 0, sizeof(LineGraphWindowExtrema));
+    extrema->lastX = -INFINITY;
+}
+
+void LineGraphWindowExtremaDestroy(LineGraphWindowExtrema *extrema) {
+    free(extrema->minimums.entries);
+    free(extrema->maximums.entries);
+
+    LineGraphWindowExtremaInit(extrema);
+}
+
+void LineGraphWindowExtremaRemoveAll(LineGraphWindowExtrema *extrema) {
+    extrema->minimums.head = extrema->minimums.count = 0;
+    extrema->maximums.head = extrema->maximums.count = 0;
+    extrema->lastX = -INFINITY;
+}
+
+bool LineGraphWindowExtremaPush(LineGraphWindowExtrema *extrema, double x, double y) {
+    // Both deques grow before either changes, so a failed push leaves the window as it was
+    if (!DequeReserve(&extrema->minimums) || !DequeReserve(&extrema->maximums)) {
+        return false;
+    }
+
+    DequePush(&extrema->minimums, x, y, true);
+    DequePush(&extrema->maximums, x, y, false);
+
+    extrema->lastX = x;
+
+    return true;
+}
+
+void LineGraphWindowExtremaEvictBefore(LineGraphWindowExtrema *extrema, double x) {
+    DequeEvictBefore(&extrema->minimums, x);
+    DequeEvictBefore(&extrema->maximums, x);
+
+    if (extrema->minimums.count == 0) {
+        extrema->lastX = -INFINITY;
+    }
+}
+
+bool LineGraphWindowExtremaIsEmpty(const LineGraphWindowExtrema *extrema) {
+    return extrema->minimums.count == 0;
+}
+
+double LineGraphWindowExtremaMin(const LineGraphWindowExtrema *extrema) {
+    return extrema->minimums.entries[extrema->minimums.head].y;
+}
+
+double LineGraphWindowExtremaMax(const LineGraphWindowExtrema *extrema) {
+    return extrema->maximums.entries[extrema->maximums.head].y;
+}
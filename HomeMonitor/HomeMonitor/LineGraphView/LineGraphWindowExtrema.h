@@ -0,0 +1,60 @@
+//
+//  LineGraphWindowExtrema.h
+//  LineGraphView
+//
+//  Copyright (c) 2014 Hippo Foundry. All rights reserved.
+//
+
+#ifndef LineGraphView_LineGraphWindowExtrema_h
+#define LineGraphView_LineGraphWindowExtrema_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    double x;
+    double y;
+} LineGraphExtremaEntry;
+
+/* Growable ring buffer of entries with monotonic y values */
+typedef struct {
+    LineGraphExtremaEntry *entries;
+    size_t capacity;
+    size_t head;
+    size_t count;
+} LineGraphExtremaDeque;
+
+/**
+ Sliding-window minimum and maximum of a plot, with amortized O(1) push and eviction.
+
+ Points must be pushed in ascending x order, and are evicted from the low end of the x-axis.
+ Only the points that can still become the minimum or maximum are stored.
+*/
+typedef struct {
+    LineGraphExtremaDeque minimums;
+    LineGraphExtremaDeque maximums;
+    /** x value of the last pushed point, -INFINITY when empty */
+    double lastX;
+} LineGraphWindowExtrema;
+
+void LineGraphWindowExtremaInit(LineGraphWindowExtrema *extrema);
+void LineGraphWindowExtremaDestroy(LineGraphWindowExtrema *extrema);
+void LineGraphWindowExtremaRemoveAll(LineGraphWindowExtrema *extrema);
+
+/** Adds a point to the high end of the window.  Returns false and leaves the window unchanged if storage could not
+ be grown.
+*/
+bool LineGraphWindowExtremaPush(LineGraphWindowExtrema *extrema, double x, double y);
+
+/** Removes all points with an x value lower than x. */
+void LineGraphWindowExtremaEvictBefore(LineGraphWindowExtrema *extrema, double x);
+
+bool LineGraphWindowExtremaIsEmpty(const LineGraphWindowExtrema *extrema);
+
+/** Minimum y value in the window.  The window must not be empty. */
+double LineGraphWindowExtremaMin(const LineGraphWindowExtrema *extrema);
+
+/** Maximum y value in the window.  The window must not be empty. */
+double LineGraphWindowExtremaMax(const LineGraphWindowExtrema *extrema);
+
+#endif
@@ -0,0 +1,166 @@
+//
+//  HMOCapture.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <string.h>
+
+#include "HMOCapture.h"
+#include "HMOChecksum.h"
+
+#define HMO_CAPTURE_VERSION 1
+#define HMO_CAPTURE_HEADER_LENGTH 12
+
+/** Receive time, payload length and checksum in front of every payload */
+#define HMO_CAPTURE_ENTRY_HEADER_LENGTH 14
+
+static const uint8_t HMOCaptureMagic[8] = { 'H', 'M', 'O', 'C', 'A', 'P', 'T', '1' };
+
+static void StoreLittleEndian(uint8_t *bytes, uint64_t value, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        bytes[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static uint64_t LoadLittleEndian(const uint8_t *bytes, size_t length) {
+    uint64_t value = 0;
+
+    for (size_t i = length; i-- > 0;) {
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+}
+
+static uint32_t EntryChecksum(const uint8_t *header, const uint8_t *bytes, size_t length) {
+    uint32_t checksum = HMOChecksumUpdate(0, header, 10);
+
+    return (length > 0) ? HMOChecksumUpdate(checksum, bytes, length) : checksum;
+}
+
+bool HMOCaptureWriterOpen(HMOCaptureWriter *writer, const char *path) {
+    writer->count = 0;
+    writer->file = fopen(path, "wb");
+
+    if (writer->file == NULL) {
+        return false;
+    }
+
+    uint8_t header[HMO_CAPTURE_HEADER_LENGTH];
+
+    memcpy(header, HMOCaptureMagic, sizeof(HMOCaptureMagic));
+    StoreLittleEndian(header + 8, HMO_CAPTURE_VERSION, 4);
+
+    if (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header)) {
+        fclose(writer->file);
+        writer->file = NULL;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool HMOCaptureWriterAppend(HMOCaptureWriter *writer, double receiveTime, const uint8_t *bytes, size_t length) {
+    if (writer->file == NULL || length > HMO_CAPTURE_MAX_PAYLOAD_LENGTH) {
+        return false;
+    }
+
+    uint8_t header[HMO_CAPTURE_ENTRY_HEADER_LENGTH];
+    uint64_t timeBits;
+
+    memcpy(&timeBits, &receiveTime, sizeof(timeBits));
+    StoreLittleEndian(header, timeBits, 8);
+    StoreLittleEndian(header + 8, length, 2);
+    StoreLittleEndian(header + 10, EntryChecksum(header, bytes, length), 4);
+
+    // An empty notification has no payload, and may come without bytes
+    if (fwrite(header, 1, sizeof(header), writer->file) != sizeof(header) ||
+        (length > 0 && fwrite(bytes, 1, length, writer->file) != length)) {
+        return false;
+    }
+
+    writer->count += 1;
+
+    return true;
+}
+
+bool HMOCaptureWriterClose(HMOCaptureWriter *writer) {
+    if (writer->file == NULL) {
+        return true;
+    }
+
+    bool isWritten = (fclose(writer->file) == 0);
+
+    writer->file = NULL;
+
+    return isWritten;
+}
+
+bool HMOCaptureReaderOpen(HMOCaptureReader *reader, const char *path) {
+    reader->count = 0;
+    reader->isDamaged = false;
+    reader->file = fopen(path, "rb");
+
+    if (reader->file == NULL) {
+        return false;
+    }
+
+    uint8_t header[HMO_CAPTURE_HEADER_LENGTH];
+
+    if (fread(header, 1, sizeof(header), reader->file) != sizeof(header) ||
+        memcmp(header, HMOCaptureMagic, sizeof(HMOCaptureMagic)) != 0 ||
+        LoadLittleEndian(header + 8, 4) != HMO_CAPTURE_VERSION) {
+        fclose(reader->file);
+        reader->file = NULL;
+
+        return false;
+    }
+
+    return true;
+}
+
+bool HMOCaptureReaderNext(HMOCaptureReader *reader, HMOCaptureNotification *notification) {
+    if (reader->file == NULL || reader->isDamaged) {
+        return false;
+    }
+
+    uint8_t header[HMO_CAPTURE_ENTRY_HEADER_LENGTH];
+    size_t headerLength = fread(header, 1, sizeof(header), reader->file);
+
+    if (headerLength == 0 && feof(reader->file)) {
+        return false;
+    }
+
+    // A capture cut off while recording ends in a partial entry
+    if (headerLength != sizeof(header)) {
+        reader->isDamaged = true;
+        return false;
+    }
+
+    size_t length = (size_t)LoadLittleEndian(header + 8, 2);
+
+    if (length > HMO_CAPTURE_MAX_PAYLOAD_LENGTH ||
+        fread(notification->bytes, 1, length, reader->file) != length ||
+        EntryChecksum(header, notification->bytes, length) != (uint32_t)LoadLittleEndian(header + 10, 4)) {
+        reader->isDamaged = true;
+        return false;
+    }
+
+    uint64_t timeBits = LoadLittleEndian(header, 8);
+
+    memcpy(&notification->receiveTime, &timeBits, sizeof(timeBits));
+    notification->length = length;
+    reader->count += 1;
+
+    return true;
+}
+
+void HMOCaptureReaderClose(HMOCaptureReader *reader) {
+    if (reader->file != NULL) {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
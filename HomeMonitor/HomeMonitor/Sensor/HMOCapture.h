@@ -0,0 +1,63 @@
+//
+//  HMOCapture.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOCapture_h
+#define HomeMonitor_HMOCapture_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** Longest notification payload a capture holds, well above the 20 bytes a BLE notification carries */
+#define HMO_CAPTURE_MAX_PAYLOAD_LENGTH 512
+
+/** A raw notification payload as it arrived from the peripheral */
+typedef struct {
+    /** Seconds, in the clock the capture was recorded with */
+    double receiveTime;
+    size_t length;
+    uint8_t bytes[HMO_CAPTURE_MAX_PAYLOAD_LENGTH];
+} HMOCaptureNotification;
+
+/**
+ Records notification payloads to a capture file, so a session can be replayed without the hardware.
+
+ A capture is an 8-byte "HMOCAPT1" magic and a 4-byte version, followed by one entry per notification: the
+ receive time as a double, the payload length as 16 bits and a CRC-32C of the three, then the payload.  All
+ fields are little endian.
+*/
+typedef struct {
+    FILE *file;
+    uint64_t count;
+} HMOCaptureWriter;
+
+typedef struct {
+    FILE *file;
+    uint64_t count;
+    /** Set when reading stopped at a cut off or damaged entry instead of the end of the file */
+    bool isDamaged;
+} HMOCaptureReader;
+
+/** Creates or replaces the capture at path.  Returns false on I/O errors. */
+bool HMOCaptureWriterOpen(HMOCaptureWriter *writer, const char *path);
+
+/** Adds a notification.  Returns false on I/O errors, or if the payload is longer than a capture holds. */
+bool HMOCaptureWriterAppend(HMOCaptureWriter *writer, double receiveTime, const uint8_t *bytes, size_t length);
+
+/** Flushes and closes the capture.  Returns false if buffered entries could not be written. */
+bool HMOCaptureWriterClose(HMOCaptureWriter *writer);
+
+/** Opens the capture at path.  Returns false on I/O errors or if the file is not a capture. */
+bool HMOCaptureReaderOpen(HMOCaptureReader *reader, const char *path);
+
+/** Reads the next notification.  Returns false at the end of the capture or at a damaged entry. */
+bool HMOCaptureReaderNext(HMOCaptureReader *reader, HMOCaptureNotification *notification);
+
+void HMOCaptureReaderClose(HMOCaptureReader *reader);
+
+#endif
@@ -0,0 +1,41 @@
+//
+//  HMOChecksum.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <pthread.h>
+
+#include "HMOChecksum.h"
+
+/** Reflected CRC-32C polynomial */
+#define HMO_CHECKSUM_POLYNOMIAL 0x82F63B78u
+
+static uint32_t ChecksumTable[256];
+static pthread_once_t ChecksumTableOnce = PTHREAD_ONCE_INIT;
+
+static void BuildChecksumTable(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t value = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            value = (value & 1) ? (value >> 1) ^ HMO_CHECKSUM_POLYNOMIAL : value >> 1;
+        }
+
+        ChecksumTable[i] = value;
+    }
+}
+
+uint32_t HMOChecksumUpdate(uint32_t checksum, const void *bytes, size_t length) {
+    pthread_once(&ChecksumTableOnce, BuildChecksumTable);
+
+    const uint8_t *byte = bytes;
+    uint32_t value = ~checksum;
+
+    for (size_t i = 0; i < length; i++) {
+        value = ChecksumTable[(value ^ byte[i]) & 0xFF] ^ (value >> 8);
+    }
+
+    return ~value;
+}
@@ -0,0 +1,19 @@
+//
+//  HMOChecksum.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOChecksum_h
+#define HomeMonitor_HMOChecksum_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Continues a CRC-32C (Castagnoli) checksum over length more bytes.  Start with a checksum of 0, feeding the
+ bytes in pieces gives the same result as feeding them at once.
+*/
+uint32_t HMOChecksumUpdate(uint32_t checksum, const void *bytes, size_t length);
+
+#endif
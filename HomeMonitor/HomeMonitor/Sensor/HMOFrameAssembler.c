@@ -0,0 +1,86 @@
+//
+//  HMOFrameAssembler.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <string.h>
+
+#include "HMOFrameAssembler.h"
+
+#define HMO_FRAME_ASSEMBLER_MASK (HMO_FRAME_ASSEMBLER_CAPACITY - 1)
+
+void HMOFrameAssemblerInit(HMOFrameAssembler *assembler) {
+    assembler->head = 0;
+    assembler->tail = 0;
+    assembler->overflowCount = 0;
+    assembler->droppedByteCount = 0;
+}
+
+void HMOFrameAssemblerAppend(HMOFrameAssembler *assembler, const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        uint32_t used = assembler->tail - assembler->head;
+
+        // Head is always on a record boundary, so evicting in record steps keeps the stream aligned.
+        if (used == HMO_FRAME_ASSEMBLER_CAPACITY) {
+            assembler->head += HMO_RECORD_LENGTH;
+            assembler->overflowCount += 1;
+            continue;
+        }
+
+        uint32_t offset = assembler->tail & HMO_FRAME_ASSEMBLER_MASK;
+        size_t count = HMO_FRAME_ASSEMBLER_CAPACITY - used;
+
+        if (count > length) {
+            count = length;
+        }
+
+        if (count > HMO_FRAME_ASSEMBLER_CAPACITY - offset) {
+            count = HMO_FRAME_ASSEMBLER_CAPACITY - offset;
+        }
+
+        memcpy(&assembler->bytes[offset], bytes, count);
+
+        assembler->tail += (uint32_t)count;
+        bytes += count;
+        length -= count;
+    }
+}
+
+size_t HMOFrameAssemblerRecordBytes(const HMOFrameAssembler *assembler) {
+    uint32_t used = assembler->tail - assembler->head;
+
+    return used - (used % HMO_RECORD_LENGTH);
+}
+
+size_t HMOFrameAssemblerReadRecords(HMOFrameAssembler *assembler, uint8_t *output, size_t capacity) {
+    size_t count = HMOFrameAssemblerRecordBytes(assembler);
+
+    capacity -= capacity % HMO_RECORD_LENGTH;
+
+    if (count > capacity) {
+        count = capacity;
+    }
+
+    uint32_t offset = assembler->head & HMO_FRAME_ASSEMBLER_MASK;
+    size_t firstCount = HMO_FRAME_ASSEMBLER_CAPACITY - offset;
+
+    if (firstCount >= count) {
+        memcpy(output, &assembler->bytes[offset], count);
+    } else {
+        memcpy(output, &assembler->bytes[offset], firstCount);
+        memcpy(output + firstCount, assembler->bytes, count - firstCount);
+    }
+
+    assembler->head += (uint32_t)count;
+
+    return count;
+}
+
+void HMOFrameAssemblerDiscardPartialRecord(HMOFrameAssembler *assembler) {
+    uint32_t partial = (assembler->tail - assembler->head) % HMO_RECORD_LENGTH;
+
+    assembler->tail -= partial;
+    assembler->droppedByteCount += partial;
+}
@@ -0,0 +1,57 @@
+//
+//  HMOFrameAssembler.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOFrameAssembler_h
+#define HomeMonitor_HMOFrameAssembler_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Every sensor reading is sent as a 1-byte type followed by a 4-byte big-endian value */
+#define HMO_RECORD_LENGTH 5
+
+/** Must be a power of two */
+#define HMO_FRAME_ASSEMBLER_CAPACITY 512
+
+/**
+ Fixed-capacity ring buffer that glues BLE notification payloads back together and only
+ ever hands out whole records.  Does not allocate, plain C so it can be used outside of the app.
+
+ When the buffer fills up the oldest whole records are evicted to make room, so the most
+ recent readings always survive.
+*/
+typedef struct {
+    uint8_t bytes[HMO_FRAME_ASSEMBLER_CAPACITY];
+    uint32_t head;
+    uint32_t tail;
+
+    /** Number of whole records evicted because the buffer was full */
+    uint64_t overflowCount;
+    /** Number of bytes discarded from incomplete records */
+    uint64_t droppedByteCount;
+} HMOFrameAssembler;
+
+void HMOFrameAssemblerInit(HMOFrameAssembler *assembler);
+
+/** Appends a notification payload, evicting old records if there is not enough room. */
+void HMOFrameAssemblerAppend(HMOFrameAssembler *assembler, const uint8_t *bytes, size_t length);
+
+/** Number of buffered bytes that belong to whole records. */
+size_t HMOFrameAssemblerRecordBytes(const HMOFrameAssembler *assembler);
+
+/** Copies as many whole records as fit into output and removes them from the buffer.
+
+ @return Number of bytes written, always a multiple of HMO_RECORD_LENGTH.
+*/
+size_t HMOFrameAssemblerReadRecords(HMOFrameAssembler *assembler, uint8_t *output, size_t capacity);
+
+/** Drops a trailing incomplete record, if any, so the next payload starts on a record boundary.
+ Should be called when the peripheral signals the end of a batch.
+*/
+void HMOFrameAssemblerDiscardPartialRecord(HMOFrameAssembler *assembler);
+
+#endif
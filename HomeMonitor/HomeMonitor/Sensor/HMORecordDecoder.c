@@ -0,0 +1,58 @@
+//
+//  HMORecordDecoder.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <string.h>
+
+#include "HMORecordDecoder.h"
+
+static const uint8_t HMORecordTypeTable[256] = {
+    [HMO_RECORD_CODE_TEMPERATURE] = kHMORecordTypeTemperature,
+    [HMO_RECORD_CODE_PRESSURE] = kHMORecordTypePressure,
+    [HMO_RECORD_CODE_ALTITUDE] = kHMORecordTypeAltitude
+};
+
+/* Readings are big-endian.  memcpy + bswap compiles down to a single unaligned load and
+ a byte-reverse instruction (REV on ARM, BSWAP/MOVBE on x86), which is as good as a
+ vector shuffle gets for a 5-byte stride.
+*/
+static inline int32_t HMORecordReadValue(const uint8_t *bytes) {
+    uint32_t raw;
+
+    memcpy(&raw, bytes, sizeof(raw));
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (int32_t)raw;
+#else
+    return (int32_t)__builtin_bswap32(raw);
+#endif
+}
+
+size_t HMORecordDecode(const uint8_t *bytes, size_t length, double timestamp, HMORecordColumns *columns) {
+    size_t recordCount = length / HMO_RECORD_LENGTH;
+
+    if (recordCount > columns->capacity) {
+        recordCount = columns->capacity;
+    }
+
+    uint8_t *types = columns->types;
+    double *timestamps = columns->timestamps;
+    float *values = columns->values;
+    size_t count = 0;
+
+    // Every record is written to the next free slot, which is only claimed if the type is known.
+    for (size_t i = 0; i < recordCount; i++, bytes += HMO_RECORD_LENGTH) {
+        uint8_t type = HMORecordTypeTable[bytes[0]];
+
+        types[count] = type;
+        timestamps[count] = timestamp;
+        values[count] = (float)HMORecordReadValue(bytes + 1);
+
+        count += (type != kHMORecordTypeUnknown);
+    }
+
+    return count;
+}
@@ -0,0 +1,57 @@
+//
+//  HMORecordDecoder.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMORecordDecoder_h
+#define HomeMonitor_HMORecordDecoder_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HMOFrameAssembler.h"
+
+/** Type byte sent by the sensor board in front of every reading */
+#define HMO_RECORD_CODE_TEMPERATURE 0x0A
+#define HMO_RECORD_CODE_PRESSURE 0x0B
+#define HMO_RECORD_CODE_ALTITUDE 0x0C
+
+/** Maximum number of records handed out by a single HMOFrameAssembler read */
+#define HMO_RECORD_BATCH_CAPACITY (HMO_FRAME_ASSEMBLER_CAPACITY / HMO_RECORD_LENGTH)
+
+/** Decoded record types, unknown codes are never emitted */
+typedef enum {
+    kHMORecordTypeUnknown = 0,
+    /** Degrees Celsius */
+    kHMORecordTypeTemperature,
+    /** Pascals */
+    kHMORecordTypePressure,
+    /** Meters */
+    kHMORecordTypeAltitude,
+    kHMORecordTypeCount
+} HMORecordType;
+
+/** Structure-of-arrays output for HMORecordDecode.  All arrays must hold at least capacity entries. */
+typedef struct {
+    uint8_t *types;
+    double *timestamps;
+    float *values;
+    size_t capacity;
+} HMORecordColumns;
+
+/** Decodes a buffer of whole records in a single pass.
+
+ At most capacity records are read from bytes, so a buffer longer than
+ capacity * HMO_RECORD_LENGTH must be decoded in chunks.  Trailing partial records are ignored.
+
+ @param bytes Record bytes as handed out by HMOFrameAssembler.
+ @param length Length of bytes.
+ @param timestamp Receive time stamped on every decoded record.
+ @param columns Output columns.
+ @return Number of records written to columns.
+*/
+size_t HMORecordDecode(const uint8_t *bytes, size_t length, double timestamp, HMORecordColumns *columns);
+
+#endif
@@ -0,0 +1,114 @@
+//
+//  HMORecordRing.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "HMORecordRing.h"
+
+_Static_assert(offsetof(HMORecordRing, head) - offsetof(HMORecordRing, tail) >= HMO_CACHE_LINE_SIZE,
+               "The producer and consumer positions must be a cache line apart");
+
+bool HMORecordRingInit(HMORecordRing *ring, size_t capacity) {
+    memset(ring, 0, sizeof(HMORecordRing));
+
+    size_t slotCount = 2;
+
+    while (slotCount < capacity) {
+        slotCount *= 2;
+    }
+
+    ring->types = malloc(sizeof(uint8_t) * slotCount);
+    ring->timestamps = malloc(sizeof(double) * slotCount);
+    ring->values = malloc(sizeof(float) * slotCount);
+    ring->mask = slotCount - 1;
+
+    if (ring->types == NULL || ring->timestamps == NULL || ring->values == NULL) {
+        HMORecordRingDestroy(ring);
+        return false;
+    }
+
+    return true;
+}
+
+void HMORecordRingDestroy(HMORecordRing *ring) {
+    free(ring->types);
+    free(ring->timestamps);
+    free(ring->values);
+
+    memset(ring, 0, sizeof(HMORecordRing));
+}
+
+/* Copies count records between two sets of columns, starting at the given indexes. */
+static void CopyRecords(uint8_t *types, double *timestamps, float *values, size_t index,
+                        const uint8_t *sourceTypes, const double *sourceTimestamps, const float *sourceValues, size_t sourceIndex,
+                        size_t count) {
+    memcpy(types + index, sourceTypes + sourceIndex, sizeof(uint8_t) * count);
+    memcpy(timestamps + index, sourceTimestamps + sourceIndex, sizeof(double) * count);
+    memcpy(values + index, sourceValues + sourceIndex, sizeof(float) * count);
+}
+
+size_t HMORecordRingPush(HMORecordRing *ring, const HMORecordColumns *columns, size_t count) {
+    size_t capacity = ring->mask + 1;
+    size_t tail = ring->tail;
+
+    if (tail - ring->cachedHead + count > capacity) {
+        ring->cachedHead = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    }
+
+    size_t freeCount = capacity - (tail - ring->cachedHead);
+    size_t pushCount = (count < freeCount) ? count : freeCount;
+
+    if (pushCount < count) {
+        __atomic_fetch_add(&ring->droppedCount, count - pushCount, __ATOMIC_RELAXED);
+    }
+
+    if (pushCount == 0) {
+        return 0;
+    }
+
+    // The free slots wrap around the end of the storage at most once
+    size_t index = tail & ring->mask;
+    size_t firstCount = (pushCount < capacity - index) ? pushCount : capacity - index;
+
+    CopyRecords(ring->types, ring->timestamps, ring->values, index, columns->types, columns->timestamps, columns->values, 0, firstCount);
+    CopyRecords(ring->types, ring->timestamps, ring->values, 0, columns->types, columns->timestamps, columns->values, firstCount, pushCount - firstCount);
+
+    __atomic_store_n(&ring->tail, tail + pushCount, __ATOMIC_RELEASE);
+
+    return pushCount;
+}
+
+size_t HMORecordRingPop(HMORecordRing *ring, HMORecordColumns *columns) {
+    size_t capacity = ring->mask + 1;
+    size_t head = ring->head;
+
+    if (ring->cachedTail - head < columns->capacity) {
+        ring->cachedTail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    }
+
+    size_t available = ring->cachedTail - head;
+    size_t popCount = (columns->capacity < available) ? columns->capacity : available;
+
+    if (popCount == 0) {
+        return 0;
+    }
+
+    size_t index = head & ring->mask;
+    size_t firstCount = (popCount < capacity - index) ? popCount : capacity - index;
+
+    CopyRecords(columns->types, columns->timestamps, columns->values, 0, ring->types, ring->timestamps, ring->values, index, firstCount);
+    CopyRecords(columns->types, columns->timestamps, columns->values, firstCount, ring->types, ring->timestamps, ring->values, 0, popCount - firstCount);
+
+    __atomic_store_n(&ring->head, head + popCount, __ATOMIC_RELEASE);
+
+    return popCount;
+}
+
+size_t HMORecordRingDroppedCount(const HMORecordRing *ring) {
+    return __atomic_load_n(&ring->droppedCount, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,64 @@
+//
+//  HMORecordRing.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMORecordRing_h
+#define HomeMonitor_HMORecordRing_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HMORecordDecoder.h"
+
+/** Size of the cache lines the producer and consumer positions are kept apart by */
+#define HMO_CACHE_LINE_SIZE 64
+
+/**
+ Bounded lock-free ring of decoded records between exactly one producer thread and one consumer thread.
+
+ Records are stored as columns, like HMORecordColumns, and pushed and popped in batches so a whole BLE read
+ costs one pair of atomic operations on each side.  Each side keeps its own position and a cached copy of the
+ other side's on a separate cache line, and only reloads the other side's position when the cached one says
+ the ring is full or empty.
+*/
+typedef struct {
+    uint8_t *types;
+    double *timestamps;
+    float *values;
+    size_t mask;
+    /** Written by the producer only, starts a cache line of its own */
+    size_t tail __attribute__((aligned(HMO_CACHE_LINE_SIZE)));
+    size_t cachedHead;
+    /** Records the producer could not fit, read by anyone */
+    size_t droppedCount;
+    /** Written by the consumer only, starts the next cache line */
+    size_t head __attribute__((aligned(HMO_CACHE_LINE_SIZE)));
+    size_t cachedTail;
+} HMORecordRing;
+
+/** Sets up an empty ring holding at least capacity records.  Returns false if storage could not be allocated. */
+bool HMORecordRingInit(HMORecordRing *ring, size_t capacity);
+void HMORecordRingDestroy(HMORecordRing *ring);
+
+/** Adds the first count records of columns.  Producer thread only.
+
+ Records that do not fit are dropped and added to droppedCount.
+
+ @return Number of records added.
+*/
+size_t HMORecordRingPush(HMORecordRing *ring, const HMORecordColumns *columns, size_t count);
+
+/** Removes up to columns->capacity records in the order they were pushed.  Consumer thread only.
+
+ @return Number of records written to columns.
+*/
+size_t HMORecordRingPop(HMORecordRing *ring, HMORecordColumns *columns);
+
+/** Number of records dropped because the ring was full.  Safe to call from any thread. */
+size_t HMORecordRingDroppedCount(const HMORecordRing *ring);
+
+#endif
@@ -0,0 +1,313 @@
+//
+//  HMOReplay.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
+
+#include "HMOChecksum.h"
+#include "HMOFrameAssembler.h"
+#include "HMORecordDecoder.h"
+#include "HMORecordRing.h"
+#include "HMOReplay.h"
+#include "HMOTimeSeries.h"
+#include "LineGraphDecimation.h"
+#include "LineGraphWindowExtrema.h"
+
+/** Notifications shorter than a full BLE payload end a batch, as in BLE */
+#define HMO_REPLAY_FULL_NOTIFICATION_LENGTH 20
+
+/** Same capacity as the ingestion engine's ring */
+#define HMO_REPLAY_RING_CAPACITY 4096
+
+/** Plotted x values are rebased past this, as HMOGraph does */
+#define HMO_REPLAY_MAXIMUM_PLOT_X 4194304.0
+
+typedef struct {
+    HMOFrameAssembler assembler;
+    uint8_t recordBytes[HMO_FRAME_ASSEMBLER_CAPACITY];
+    uint8_t types[HMO_RECORD_BATCH_CAPACITY];
+    double timestamps[HMO_RECORD_BATCH_CAPACITY];
+    float values[HMO_RECORD_BATCH_CAPACITY];
+    HMORecordRing ring;
+
+    HMOTimeSeries series;
+    LineGraphWindowExtrema extrema;
+    double plotXOrigin;
+    /** Visible samples and the path they are reduced to */
+    float *xs;
+    float *ys;
+    float *pathXs;
+    float *pathYs;
+
+    double *latencies;
+    size_t latencyCapacity;
+} HMOReplayPipeline;
+
+static double MonotonicTime(void) {
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebase;
+
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+
+    return (double)mach_absolute_time() * timebase.numer / timebase.denom / 1e9;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+static void WaitUntil(double time) {
+    double remaining;
+
+    while ((remaining = time - MonotonicTime()) > 0) {
+        struct timespec duration = { (time_t)remaining, (long)((remaining - floor(remaining)) * 1e9) };
+
+        nanosleep(&duration, NULL);
+    }
+}
+
+static int CompareLatencies(const void *first, const void *second) {
+    double a = *(const double *)first, b = *(const double *)second;
+
+    return (a > b) - (a < b);
+}
+
+static double Percentile(const double *sorted, size_t count, double fraction) {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t index = (size_t)ceil(fraction * count);
+
+    return sorted[(index > 0) ? index - 1 : 0];
+}
+
+static bool RecordLatency(HMOReplayPipeline *pipeline, HMOReplayReport *report, double latency) {
+    if (report->batchCount == pipeline->latencyCapacity) {
+        size_t capacity = (pipeline->latencyCapacity > 0) ? pipeline->latencyCapacity * 2 : 1024;
+        double *latencies = realloc(pipeline->latencies, sizeof(double) * capacity);
+
+        if (latencies == NULL) {
+            return false;
+        }
+
+        pipeline->latencies = latencies;
+        pipeline->latencyCapacity = capacity;
+    }
+
+    pipeline->latencies[report->batchCount] = latency;
+
+    return true;
+}
+
+/** Appends pressure readings the way HMOGraph does, one x unit per sample.  Returns false if the extrema could not
+ grow, with the readings appended so far counted in pressureCount.
+*/
+static bool AppendReadings(HMOReplayPipeline *pipeline, const HMOReplayOptions *options, size_t count, size_t *pressureCount) {
+    for (size_t i = 0; i < count; i++) {
+        if (pipeline->types[i] != kHMORecordTypePressure) {
+            continue;
+        }
+
+        double x = (pipeline->series.count > 0) ? *HMOTimeSeriesTimestamps(&pipeline->series, 1) + 1.0 : 1.0;
+
+        if (!LineGraphWindowExtremaPush(&pipeline->extrema, x, pipeline->values[i])) {
+            return false;
+        }
+
+        HMOTimeSeriesAppend(&pipeline->series, x, pipeline->values[i]);
+        LineGraphWindowExtremaEvictBefore(&pipeline->extrema, x - options->visibleSampleCount + 1);
+        *pressureCount += 1;
+
+        if (x - pipeline->plotXOrigin > HMO_REPLAY_MAXIMUM_PLOT_X) {
+            pipeline->plotXOrigin = x - options->visibleSampleCount;
+        }
+    }
+
+    return true;
+}
+
+/** Reduces the visible samples to a path and folds it into the report's checksum */
+static void BuildPath(HMOReplayPipeline *pipeline, const HMOReplayOptions *options, HMOReplayReport *report) {
+    size_t count = pipeline->series.count;
+    const double *timestamps = HMOTimeSeriesTimestamps(&pipeline->series, count);
+    const float *values = HMOTimeSeriesValues(&pipeline->series, count);
+
+    for (size_t i = 0; i < count; i++) {
+        pipeline->xs[i] = (float)(timestamps[i] - pipeline->plotXOrigin);
+    }
+
+    memcpy(pipeline->ys, values, sizeof(float) * count);
+
+    float span = (count > 1) ? pipeline->xs[count - 1] - pipeline->xs[0] : 0;
+    float columnWidth = (span > 0) ? span / options->columnCount : 1;
+    size_t pathCount = LineGraphDecimateMinMax(pipeline->xs, pipeline->ys, count, columnWidth, pipeline->pathXs, pipeline->pathYs);
+    double range[2] = { LineGraphWindowExtremaMin(&pipeline->extrema), LineGraphWindowExtremaMax(&pipeline->extrema) };
+
+    report->pathChecksum = HMOChecksumUpdate(report->pathChecksum, pipeline->pathXs, sizeof(float) * pathCount);
+    report->pathChecksum = HMOChecksumUpdate(report->pathChecksum, pipeline->pathYs, sizeof(float) * pathCount);
+    report->pathChecksum = HMOChecksumUpdate(report->pathChecksum, range, sizeof(range));
+    report->pathCount += 1;
+    report->pathPointCount += pathCount;
+}
+
+/** Decodes the whole records waiting in the assembler and updates the path, returns false if storage ran out */
+static bool Flush(HMOReplayPipeline *pipeline, const HMOReplayOptions *options, HMOReplayReport *report, double deliveryTime) {
+    size_t length = HMOFrameAssemblerReadRecords(&pipeline->assembler, pipeline->recordBytes, sizeof(pipeline->recordBytes));
+
+    if (length == 0) {
+        return true;
+    }
+
+    HMORecordColumns columns = { pipeline->types, pipeline->timestamps, pipeline->values, HMO_RECORD_BATCH_CAPACITY };
+    size_t count = HMORecordDecode(pipeline->recordBytes, length, deliveryTime, &columns);
+    size_t pressureCount = 0;
+    size_t poppedCount;
+    bool isAppended = true;
+
+    // Hand the records over through the ring, as the ingestion engine does between its threads
+    HMORecordRingPush(&pipeline->ring, &columns, count);
+
+    while ((poppedCount = HMORecordRingPop(&pipeline->ring, &columns)) > 0) {
+        isAppended = isAppended && AppendReadings(pipeline, options, poppedCount, &pressureCount);
+    }
+
+    if (!isAppended) {
+        return false;
+    }
+
+    if (pressureCount > 0) {
+        BuildPath(pipeline, options, report);
+    }
+
+    if (!RecordLatency(pipeline, report, MonotonicTime() - deliveryTime)) {
+        return false;
+    }
+
+    report->batchCount += 1;
+    report->recordCount += count;
+    report->pressureCount += pressureCount;
+
+    return true;
+}
+
+void HMOReplayOptionsInit(HMOReplayOptions *options, HMOReplaySourceNext next, void *context) {
+    options->next = next;
+    options->context = context;
+    options->speed = 0;
+    options->flushLength = 64;
+    options->visibleSampleCount = 20;
+    options->columnCount = 320;
+}
+
+static void PipelineDestroy(HMOReplayPipeline *pipeline) {
+    HMORecordRingDestroy(&pipeline->ring);
+    HMOTimeSeriesDestroy(&pipeline->series);
+    LineGraphWindowExtremaDestroy(&pipeline->extrema);
+    free(pipeline->xs);
+    free(pipeline->ys);
+    free(pipeline->pathXs);
+    free(pipeline->pathYs);
+    free(pipeline->latencies);
+    free(pipeline);
+}
+
+bool HMOReplayRun(const HMOReplayOptions *options, HMOReplayReport *report) {
+    memset(report, 0, sizeof(HMOReplayReport));
+
+    HMOReplayPipeline *pipeline = calloc(1, sizeof(HMOReplayPipeline));
+    size_t visibleCount = (options->visibleSampleCount > 0) ? options->visibleSampleCount : 1;
+
+    if (pipeline == NULL) {
+        return false;
+    }
+
+    HMOFrameAssemblerInit(&pipeline->assembler);
+    LineGraphWindowExtremaInit(&pipeline->extrema);
+
+    pipeline->xs = malloc(sizeof(float) * visibleCount);
+    pipeline->ys = malloc(sizeof(float) * visibleCount);
+    pipeline->pathXs = malloc(sizeof(float) * visibleCount);
+    pipeline->pathYs = malloc(sizeof(float) * visibleCount);
+
+    if (!HMORecordRingInit(&pipeline->ring, HMO_REPLAY_RING_CAPACITY) ||
+        !HMOTimeSeriesInit(&pipeline->series, visibleCount) ||
+        pipeline->xs == NULL || pipeline->ys == NULL || pipeline->pathXs == NULL || pipeline->pathYs == NULL) {
+        PipelineDestroy(pipeline);
+        return false;
+    }
+
+    HMOCaptureNotification notification;
+    double startTime = MonotonicTime();
+    double firstReceiveTime = 0;
+    bool isAllocated = true;
+
+    while (isAllocated && options->next(options->context, &notification)) {
+        double deliveryTime;
+
+        if (report->notificationCount == 0) {
+            firstReceiveTime = notification.receiveTime;
+        }
+
+        if (options->speed > 0) {
+            // Latency counts from when the notification was due, so falling behind shows up in it
+            deliveryTime = startTime + (notification.receiveTime - firstReceiveTime) / options->speed;
+            WaitUntil(deliveryTime);
+        } else {
+            deliveryTime = MonotonicTime();
+        }
+
+        HMOFrameAssemblerAppend(&pipeline->assembler, notification.bytes, notification.length);
+
+        report->notificationCount += 1;
+        report->byteCount += notification.length;
+
+        bool isEndOfBatch = (notification.length < HMO_REPLAY_FULL_NOTIFICATION_LENGTH);
+
+        if (isEndOfBatch) {
+            HMOFrameAssemblerDiscardPartialRecord(&pipeline->assembler);
+        }
+
+        if (isEndOfBatch || HMOFrameAssemblerRecordBytes(&pipeline->assembler) >= options->flushLength) {
+            isAllocated = Flush(pipeline, options, report, deliveryTime);
+        }
+    }
+
+    report->elapsedTime = MonotonicTime() - startTime;
+    report->recordsPerSecond = (report->elapsedTime > 0) ? report->recordCount / report->elapsedTime : 0;
+    report->overflowCount = pipeline->assembler.overflowCount;
+    report->droppedByteCount = pipeline->assembler.droppedByteCount;
+    report->ringDroppedCount = HMORecordRingDroppedCount(&pipeline->ring);
+
+    if (report->batchCount > 0) {
+        qsort(pipeline->latencies, report->batchCount, sizeof(double), CompareLatencies);
+    }
+
+    report->latencyMedian = Percentile(pipeline->latencies, report->batchCount, 0.5);
+    report->latency90 = Percentile(pipeline->latencies, report->batchCount, 0.9);
+    report->latency99 = Percentile(pipeline->latencies, report->batchCount, 0.99);
+    report->latencyMax = Percentile(pipeline->latencies, report->batchCount, 1.0);
+
+    PipelineDestroy(pipeline);
+
+    return isAllocated;
+}
+
+bool HMOReplayCaptureSourceNext(void *context, HMOCaptureNotification *notification) {
+    return HMOCaptureReaderNext(context, notification);
+}
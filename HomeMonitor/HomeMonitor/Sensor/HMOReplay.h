@@ -0,0 +1,75 @@
+//
+//  HMOReplay.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOReplay_h
+#define HomeMonitor_HMOReplay_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HMOCapture.h"
+
+/** Hands out the next notification to replay, returns false when there are no more.  Receive times must not
+ go backwards. */
+typedef bool (*HMOReplaySourceNext)(void *context, HMOCaptureNotification *notification);
+
+typedef struct {
+    HMOReplaySourceNext next;
+    void *context;
+    /** Playback rate relative to the receive times, 1 for real time, 0 for as fast as the pipeline goes */
+    double speed;
+    /** Record bytes gathered before they are decoded, as BLE does */
+    size_t flushLength;
+    /** Pressure samples kept in the series and reduced to a path after every batch */
+    size_t visibleSampleCount;
+    /** Pixel columns the path is reduced to */
+    size_t columnCount;
+} HMOReplayOptions;
+
+typedef struct {
+    uint64_t notificationCount;
+    uint64_t byteCount;
+    /** Decoded record batches, each followed by a path update when it holds pressure readings */
+    uint64_t batchCount;
+    uint64_t recordCount;
+    uint64_t pressureCount;
+    uint64_t pathCount;
+    uint64_t pathPointCount;
+    /** Frame assembler counters, see HMOFrameAssembler */
+    uint64_t overflowCount;
+    uint64_t droppedByteCount;
+    /** Records the ring between decoding and the series had no room for */
+    uint64_t ringDroppedCount;
+    /** HMOChecksumUpdate of every path, the same for every run of the same notifications at any speed */
+    uint32_t pathChecksum;
+    /** Wall clock seconds the replay took */
+    double elapsedTime;
+    double recordsPerSecond;
+    /** Seconds from the delivery of the notification completing a batch until its path was built */
+    double latencyMedian;
+    double latency90;
+    double latency99;
+    double latencyMax;
+} HMOReplayReport;
+
+/** Options matching the app: 64-byte flushes and a 20 sample graph, replayed as fast as possible. */
+void HMOReplayOptionsInit(HMOReplayOptions *options, HMOReplaySourceNext next, void *context);
+
+/**
+ Feeds notifications through the same portable stages the app runs them through: frame assembly with BLE's
+ batching rules, record decoding, the record ring, the pressure series with its windowed extrema, and min/max reduction of the
+ visible samples to a path.  Runs on the calling thread, without any Apple frameworks.
+
+ @return false if storage could not be allocated.
+*/
+bool HMOReplayRun(const HMOReplayOptions *options, HMOReplayReport *report);
+
+/** HMOReplaySourceNext reading from an open HMOCaptureReader passed as context */
+bool HMOReplayCaptureSourceNext(void *context, HMOCaptureNotification *notification);
+
+#endif
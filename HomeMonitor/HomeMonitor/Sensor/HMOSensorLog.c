@@ -0,0 +1,542 @@
+//
+//  HMOSensorLog.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "HMOChecksum.h"
+#include "HMOSensorLog.h"
+
+#define HMO_SENSOR_LOG_MAGIC 0x474C4F48u
+#define HMO_SENSOR_LOG_VERSION 1
+
+#define HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET (HMO_SENSOR_LOG_HEADER_SLOT_SIZE * 2)
+#define HMO_SENSOR_LOG_VALUE_COLUMN_OFFSET (HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET + HMO_SENSOR_LOG_SEGMENT_CAPACITY * 4)
+
+static uint32_t HeaderChecksum(const HMOSensorLogSegmentHeader *header) {
+    return HMOChecksumUpdate(0, header, offsetof(HMOSensorLogSegmentHeader, checksum));
+}
+
+static bool HeaderIsValid(const HMOSensorLogSegmentHeader *header) {
+    return (header->magic == HMO_SENSOR_LOG_MAGIC &&
+            header->version == HMO_SENSOR_LOG_VERSION &&
+            header->headerSize == sizeof(HMOSensorLogSegmentHeader) &&
+            header->count > 0 &&
+            header->count <= HMO_SENSOR_LOG_SEGMENT_CAPACITY &&
+            header->checksum == HeaderChecksum(header));
+}
+
+static const HMOSensorLogSegmentHeader *SegmentSlot(const uint8_t *segment, size_t slot) {
+    return (const HMOSensorLogSegmentHeader *)(segment + slot * HMO_SENSOR_LOG_HEADER_SLOT_SIZE);
+}
+
+static const uint32_t *SegmentTimestamps(const uint8_t *segment) {
+    return (const uint32_t *)(segment + HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET);
+}
+
+static const float *SegmentValues(const uint8_t *segment) {
+    return (const float *)(segment + HMO_SENSOR_LOG_VALUE_COLUMN_OFFSET);
+}
+
+static bool SequenceIsNewer(uint32_t sequence, uint32_t other) {
+    return (int32_t)(sequence - other) > 0;
+}
+
+/** Index of the valid slot with the newest sequence, -1 if neither is valid */
+static int SegmentCurrentSlot(const uint8_t *segment) {
+    int current = -1;
+
+    for (int slot = 0; slot < 2; slot++) {
+        const HMOSensorLogSegmentHeader *header = SegmentSlot(segment, slot);
+
+        if (HeaderIsValid(header) && (current < 0 || SequenceIsNewer(header->sequence, SegmentSlot(segment, current)->sequence))) {
+            current = slot;
+        }
+    }
+
+    return current;
+}
+
+static bool SegmentColumnsMatch(const uint8_t *segment, const HMOSensorLogSegmentHeader *header) {
+    return (HMOChecksumUpdate(0, SegmentTimestamps(segment), header->count * 4) == header->timestampChecksum &&
+            HMOChecksumUpdate(0, SegmentValues(segment), header->count * 4) == header->valueChecksum);
+}
+
+static bool WriteFully(int fd, const void *bytes, size_t length, off_t offset) {
+    const uint8_t *byte = bytes;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fd, byte, length, offset);
+
+        if (written < 0) {
+            return false;
+        }
+
+        byte += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+
+    return true;
+}
+
+static bool ReadFully(int fd, void *bytes, size_t length, off_t offset) {
+    uint8_t *byte = bytes;
+
+    while (length > 0) {
+        ssize_t readLength = pread(fd, byte, length, offset);
+
+        if (readLength <= 0) {
+            return false;
+        }
+
+        byte += readLength;
+        length -= (size_t)readLength;
+        offset += readLength;
+    }
+
+    return true;
+}
+
+static bool Remap(HMOSensorLog *log) {
+    size_t length = log->fileSegmentCount * HMO_SENSOR_LOG_SEGMENT_SIZE;
+
+    if (length == log->mapLength) {
+        return true;
+    }
+
+    if (log->map != NULL) {
+        munmap((void *)log->map, log->mapLength);
+        log->map = NULL;
+        log->mapLength = 0;
+    }
+
+    if (length == 0) {
+        return true;
+    }
+
+    void *map = mmap(NULL, length, PROT_READ, MAP_SHARED, log->fd, 0);
+
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    log->map = map;
+    log->mapLength = length;
+
+    return true;
+}
+
+/** Drops segments from the end of the file until the last one has a header and columns that agree, and makes
+ that header the only valid one so readers can not pick a newer header that was written without its columns.
+*/
+static bool Recover(HMOSensorLog *log) {
+    struct stat status;
+
+    if (fstat(log->fd, &status) != 0) {
+        return false;
+    }
+
+    size_t segmentCount = (size_t)status.st_size / HMO_SENSOR_LOG_SEGMENT_SIZE;
+
+    if ((size_t)status.st_size % HMO_SENSOR_LOG_SEGMENT_SIZE != 0) {
+        // Extending the file was interrupted
+        if (ftruncate(log->fd, (off_t)(segmentCount * HMO_SENSOR_LOG_SEGMENT_SIZE)) != 0) {
+            return false;
+        }
+    }
+
+    while (segmentCount > 0) {
+        off_t offset = (off_t)((segmentCount - 1) * HMO_SENSOR_LOG_SEGMENT_SIZE);
+
+        if (!ReadFully(log->fd, log->active, HMO_SENSOR_LOG_SEGMENT_SIZE, offset)) {
+            return false;
+        }
+
+        int current = -1;
+
+        for (int slot = 0; slot < 2; slot++) {
+            const HMOSensorLogSegmentHeader *header = SegmentSlot(log->active, slot);
+
+            if (HeaderIsValid(header) && SegmentColumnsMatch(log->active, header) &&
+                (current < 0 || SequenceIsNewer(header->sequence, SegmentSlot(log->active, current)->sequence))) {
+                current = slot;
+            }
+        }
+
+        if (current >= 0) {
+            int other = 1 - current;
+
+            if (SegmentCurrentSlot(log->active) != current) {
+                uint8_t empty[HMO_SENSOR_LOG_HEADER_SLOT_SIZE] = { 0 };
+
+                if (!WriteFully(log->fd, empty, sizeof(empty), offset + other * HMO_SENSOR_LOG_HEADER_SLOT_SIZE) || fsync(log->fd) != 0) {
+                    return false;
+                }
+
+                memset(log->active + other * HMO_SENSOR_LOG_HEADER_SLOT_SIZE, 0, HMO_SENSOR_LOG_HEADER_SLOT_SIZE);
+            }
+
+            memcpy(&log->activeHeader, SegmentSlot(log->active, current), sizeof(HMOSensorLogSegmentHeader));
+            break;
+        }
+
+        segmentCount -= 1;
+        log->discardedSegmentCount += 1;
+
+        if (ftruncate(log->fd, (off_t)(segmentCount * HMO_SENSOR_LOG_SEGMENT_SIZE)) != 0 || fsync(log->fd) != 0) {
+            return false;
+        }
+    }
+
+    log->fileSegmentCount = segmentCount;
+
+    if (segmentCount > 0 && log->activeHeader.count < HMO_SENSOR_LOG_SEGMENT_CAPACITY) {
+        log->hasActive = true;
+        log->activeIndex = segmentCount - 1;
+        log->syncedCount = log->activeHeader.count;
+    }
+
+    return true;
+}
+
+bool HMOSensorLogOpen(HMOSensorLog *log, const char *path) {
+    memset(log, 0, sizeof(HMOSensorLog));
+    log->syncInterval = HMO_SENSOR_LOG_DEFAULT_SYNC_INTERVAL;
+    log->fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (log->fd < 0) {
+        return false;
+    }
+
+    log->active = malloc(HMO_SENSOR_LOG_SEGMENT_SIZE);
+
+    if (log->active == NULL || !Recover(log) || !Remap(log)) {
+        free(log->active);
+        close(log->fd);
+        memset(log, 0, sizeof(HMOSensorLog));
+        log->fd = -1;
+
+        return false;
+    }
+
+    return true;
+}
+
+void HMOSensorLogClose(HMOSensorLog *log) {
+    if (log->fd < 0) {
+        return;
+    }
+
+    HMOSensorLogSync(log);
+
+    if (log->map != NULL) {
+        munmap((void *)log->map, log->mapLength);
+    }
+
+    free(log->active);
+    close(log->fd);
+    memset(log, 0, sizeof(HMOSensorLog));
+    log->fd = -1;
+}
+
+bool HMOSensorLogSync(HMOSensorLog *log) {
+    if (!log->hasActive || log->activeHeader.count == log->syncedCount) {
+        return true;
+    }
+
+    off_t offset = (off_t)(log->activeIndex * HMO_SENSOR_LOG_SEGMENT_SIZE);
+
+    if (log->activeIndex == log->fileSegmentCount) {
+        if (ftruncate(log->fd, offset + HMO_SENSOR_LOG_SEGMENT_SIZE) != 0) {
+            return false;
+        }
+
+        log->fileSegmentCount += 1;
+    }
+
+    // Columns first, they are past the committed count and invisible until the header below lands
+    size_t start = log->syncedCount * 4;
+    size_t length = (log->activeHeader.count - log->syncedCount) * 4;
+
+    if (!WriteFully(log->fd, log->active + HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET + start, length, offset + HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET + start) ||
+        !WriteFully(log->fd, log->active + HMO_SENSOR_LOG_VALUE_COLUMN_OFFSET + start, length, offset + HMO_SENSOR_LOG_VALUE_COLUMN_OFFSET + start)) {
+        return false;
+    }
+
+    HMOSensorLogSegmentHeader header = log->activeHeader;
+    int current = SegmentCurrentSlot(log->active);
+    size_t slot = (current == 0) ? 1 : 0;
+
+    header.sequence = (current < 0) ? 1 : SegmentSlot(log->active, current)->sequence + 1;
+    header.checksum = HeaderChecksum(&header);
+
+    uint8_t slotBytes[HMO_SENSOR_LOG_HEADER_SLOT_SIZE] = { 0 };
+
+    memcpy(slotBytes, &header, sizeof(header));
+
+    if (!WriteFully(log->fd, slotBytes, sizeof(slotBytes), offset + slot * HMO_SENSOR_LOG_HEADER_SLOT_SIZE) || fsync(log->fd) != 0) {
+        return false;
+    }
+
+    memcpy(log->active + slot * HMO_SENSOR_LOG_HEADER_SLOT_SIZE, slotBytes, sizeof(slotBytes));
+    log->activeHeader = header;
+    log->syncedCount = header.count;
+
+    if (header.count == HMO_SENSOR_LOG_SEGMENT_CAPACITY) {
+        log->hasActive = false;
+    }
+
+    return Remap(log);
+}
+
+static void StartSegment(HMOSensorLog *log, double timestamp, float value) {
+    memset(log->active, 0, HMO_SENSOR_LOG_SEGMENT_SIZE);
+    memset(&log->activeHeader, 0, sizeof(HMOSensorLogSegmentHeader));
+
+    log->activeHeader.magic = HMO_SENSOR_LOG_MAGIC;
+    log->activeHeader.version = HMO_SENSOR_LOG_VERSION;
+    log->activeHeader.headerSize = sizeof(HMOSensorLogSegmentHeader);
+    log->activeHeader.baseTimestamp = timestamp;
+    log->activeHeader.baseValue = value;
+    log->activeHeader.lastTimestamp = timestamp;
+    log->activeHeader.minValue = value;
+    log->activeHeader.maxValue = value;
+
+    log->activeIndex = log->fileSegmentCount;
+    log->hasActive = true;
+    log->syncedCount = 0;
+}
+
+/** Encodes a sample against the active segment's base, returns false if it can not be stored exactly */
+static bool EncodeSample(const HMOSensorLogSegmentHeader *header, double timestamp, float value, uint32_t *offset, float *delta) {
+    double milliseconds = round((timestamp - header->baseTimestamp) * 1000.0);
+
+    if (!(milliseconds >= 0 && milliseconds <= UINT32_MAX)) {
+        return false;
+    }
+
+    if (header->count == 0) {
+        *delta = 0;
+    } else {
+        *delta = (float)((double)value - header->baseValue);
+
+        float decoded = (float)(header->baseValue + *delta);
+
+        if (decoded != value && !(isnan(decoded) && isnan(value))) {
+            return false;
+        }
+    }
+
+    *offset = (uint32_t)milliseconds;
+
+    return true;
+}
+
+bool HMOSensorLogAppend(HMOSensorLog *log, double timestamp, float value) {
+    if (log->fd < 0) {
+        return false;
+    }
+
+    size_t segmentCount = HMOSensorLogSegmentCount(log);
+    const HMOSensorLogSegmentHeader *last = (segmentCount > 0) ? HMOSensorLogSegmentHeaderAt(log, segmentCount - 1) : NULL;
+
+    if (last != NULL) {
+        // The last timestamp is stored rounded, so the new one is compared as it would be stored next to it
+        double milliseconds = round((timestamp - last->baseTimestamp) * 1000.0);
+
+        if (isfinite(milliseconds)) {
+            timestamp = last->baseTimestamp + milliseconds / 1000.0;
+        }
+
+        if (timestamp < last->lastTimestamp) {
+            return false;
+        }
+    }
+
+    uint32_t offset;
+    float delta;
+
+    if (!log->hasActive || log->activeHeader.count == HMO_SENSOR_LOG_SEGMENT_CAPACITY ||
+        !EncodeSample(&log->activeHeader, timestamp, value, &offset, &delta)) {
+        if (log->hasActive && !HMOSensorLogSync(log)) {
+            return false;
+        }
+
+        StartSegment(log, timestamp, value);
+        EncodeSample(&log->activeHeader, timestamp, value, &offset, &delta);
+    }
+
+    HMOSensorLogSegmentHeader *header = &log->activeHeader;
+
+    memcpy(log->active + HMO_SENSOR_LOG_TIMESTAMP_COLUMN_OFFSET + header->count * 4, &offset, 4);
+    memcpy(log->active + HMO_SENSOR_LOG_VALUE_COLUMN_OFFSET + header->count * 4, &delta, 4);
+
+    header->timestampChecksum = HMOChecksumUpdate(header->timestampChecksum, &offset, 4);
+    header->valueChecksum = HMOChecksumUpdate(header->valueChecksum, &delta, 4);
+    header->lastTimestamp = header->baseTimestamp + offset / 1000.0;
+    header->minValue = fminf(header->minValue, value);
+    header->maxValue = fmaxf(header->maxValue, value);
+    header->count += 1;
+
+    if (header->count == HMO_SENSOR_LOG_SEGMENT_CAPACITY ||
+        (log->syncInterval > 0 && header->count - log->syncedCount >= log->syncInterval)) {
+        return HMOSensorLogSync(log);
+    }
+
+    return true;
+}
+
+/** Bytes and current header of a segment, the buffered copy for the active segment so pending samples are seen */
+static const uint8_t *SegmentAt(const HMOSensorLog *log, size_t segment, const HMOSensorLogSegmentHeader **header) {
+    *header = NULL;
+
+    if (log->hasActive && segment == log->activeIndex && log->activeHeader.count > 0) {
+        *header = &log->activeHeader;
+        return log->active;
+    }
+
+    if (segment >= log->mapLength / HMO_SENSOR_LOG_SEGMENT_SIZE) {
+        return NULL;
+    }
+
+    const uint8_t *bytes = log->map + segment * HMO_SENSOR_LOG_SEGMENT_SIZE;
+    int slot = SegmentCurrentSlot(bytes);
+
+    if (slot < 0) {
+        return NULL;
+    }
+
+    *header = SegmentSlot(bytes, slot);
+
+    return bytes;
+}
+
+double HMOSensorLogLastTimestamp(const HMOSensorLog *log) {
+    size_t segmentCount = HMOSensorLogSegmentCount(log);
+    const HMOSensorLogSegmentHeader *header = (segmentCount > 0) ? HMOSensorLogSegmentHeaderAt(log, segmentCount - 1) : NULL;
+
+    return (header != NULL) ? header->lastTimestamp : -INFINITY;
+}
+
+size_t HMOSensorLogSegmentCount(const HMOSensorLog *log) {
+    size_t count = log->mapLength / HMO_SENSOR_LOG_SEGMENT_SIZE;
+
+    if (log->hasActive && log->activeHeader.count > 0 && log->activeIndex >= count) {
+        count = log->activeIndex + 1;
+    }
+
+    return count;
+}
+
+const HMOSensorLogSegmentHeader *HMOSensorLogSegmentHeaderAt(const HMOSensorLog *log, size_t segment) {
+    const HMOSensorLogSegmentHeader *header;
+
+    SegmentAt(log, segment, &header);
+
+    return header;
+}
+
+size_t HMOSensorLogFindSegment(const HMOSensorLog *log, double timestamp) {
+    size_t low = 0, high = HMOSensorLogSegmentCount(log);
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        const HMOSensorLogSegmentHeader *header = HMOSensorLogSegmentHeaderAt(log, middle);
+
+        if (header == NULL || header->lastTimestamp < timestamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+size_t HMOSensorLogFindSample(const HMOSensorLog *log, size_t segment, double timestamp) {
+    const HMOSensorLogSegmentHeader *header;
+    const uint8_t *bytes = SegmentAt(log, segment, &header);
+
+    if (bytes == NULL) {
+        return 0;
+    }
+
+    const uint32_t *offsets = SegmentTimestamps(bytes);
+    size_t low = 0, high = header->count;
+
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+
+        if (header->baseTimestamp + offsets[middle] / 1000.0 < timestamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+size_t HMOSensorLogReadSegment(const HMOSensorLog *log, size_t segment, size_t start, size_t maxCount, double *timestamps, float *values) {
+    const HMOSensorLogSegmentHeader *header;
+    const uint8_t *bytes = SegmentAt(log, segment, &header);
+
+    if (bytes == NULL || start >= header->count) {
+        return 0;
+    }
+
+    const uint32_t *offsets = SegmentTimestamps(bytes);
+    const float *deltas = SegmentValues(bytes);
+    size_t count = header->count - start;
+
+    if (count > maxCount) {
+        count = maxCount;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        timestamps[i] = header->baseTimestamp + offsets[start + i] / 1000.0;
+        values[i] = (float)(header->baseValue + deltas[start + i]);
+    }
+
+    return count;
+}
+
+size_t HMOSensorLogReadLatest(const HMOSensorLog *log, size_t maxCount, double *timestamps, float *values) {
+    size_t remaining = maxCount;
+    size_t segment = HMOSensorLogSegmentCount(log);
+
+    // Fill the buffers from the end, newest segment first
+    while (remaining > 0 && segment > 0) {
+        segment -= 1;
+
+        const HMOSensorLogSegmentHeader *header = HMOSensorLogSegmentHeaderAt(log, segment);
+
+        if (header == NULL) {
+            continue;
+        }
+
+        size_t count = (header->count < remaining) ? header->count : remaining;
+
+        remaining -= count;
+        HMOSensorLogReadSegment(log, segment, header->count - count, count, timestamps + remaining, values + remaining);
+    }
+
+    if (remaining > 0) {
+        size_t count = maxCount - remaining;
+
+        memmove(timestamps, timestamps + remaining, sizeof(double) * count);
+        memmove(values, values + remaining, sizeof(float) * count);
+    }
+
+    return maxCount - remaining;
+}
@@ -0,0 +1,128 @@
+//
+//  HMOSensorLog.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOSensorLog_h
+#define HomeMonitor_HMOSensorLog_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Size of a segment in the file, a multiple of the page size so segments can be mapped */
+#define HMO_SENSOR_LOG_SEGMENT_SIZE 65536
+
+/** Every segment starts with two header slots, the one with the newest valid header is current */
+#define HMO_SENSOR_LOG_HEADER_SLOT_SIZE 64
+
+/** Samples in a full segment, each takes a 4-byte timestamp offset and a 4-byte value delta */
+#define HMO_SENSOR_LOG_SEGMENT_CAPACITY ((HMO_SENSOR_LOG_SEGMENT_SIZE - HMO_SENSOR_LOG_HEADER_SLOT_SIZE * 2) / 8)
+
+/** Samples appended between two automatic syncs unless set otherwise, a minute of 10 Hz readings */
+#define HMO_SENSOR_LOG_DEFAULT_SYNC_INTERVAL 600
+
+/**
+ Header of a segment, also the index entry used to find samples by time.  Stored in native byte order.
+
+ Timestamps are stored as milliseconds after baseTimestamp, values as float differences from baseValue.  A
+ sample that can not be stored exactly that way starts a new segment.
+*/
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    /** Incremented by every header write, the slot holding the higher one is current */
+    uint32_t sequence;
+    uint32_t count;
+    double baseTimestamp;
+    double baseValue;
+    double lastTimestamp;
+    float minValue;
+    float maxValue;
+    /** HMOChecksumUpdate of the first count entries of each column */
+    uint32_t timestampChecksum;
+    uint32_t valueChecksum;
+    uint32_t reserved;
+    /** HMOChecksumUpdate of all the fields above */
+    uint32_t checksum;
+} HMOSensorLogSegmentHeader;
+
+/**
+ Append-only log of (timestamp, value) samples of one sensor, stored in fixed-size columnar segments.
+
+ Appends are buffered and written in batches, each batch with a single fsync.  A batch only becomes visible
+ once its header is written to the segment's spare header slot, and the header carries checksums of the
+ columns, so after a crash the log reopens at the last batch that made it to disk.  Committed segments are
+ read straight from a read-only mapping of the file, opening a log costs the same however much it holds.
+ Reads also see the samples still waiting for a sync.
+
+ Not thread safe, all calls on a log must come from the same thread or queue.
+*/
+typedef struct {
+    int fd;
+    /** Segments in the file, including the one being appended to once it has been synced */
+    size_t fileSegmentCount;
+    const uint8_t *map;
+    size_t mapLength;
+
+    /** Copy of the segment being appended to, laid out as in the file */
+    uint8_t *active;
+    HMOSensorLogSegmentHeader activeHeader;
+    size_t activeIndex;
+    bool hasActive;
+    /** Samples of the active segment written to the file */
+    uint32_t syncedCount;
+
+    /** Appended samples that trigger a sync, 0 to only sync when asked to */
+    size_t syncInterval;
+    /** Segments dropped when opening because none of their headers or columns could be trusted */
+    size_t discardedSegmentCount;
+} HMOSensorLog;
+
+/** Opens or creates the log at path, recovering from an interrupted write.  Returns false on I/O errors. */
+bool HMOSensorLogOpen(HMOSensorLog *log, const char *path);
+
+/** Syncs pending samples and closes the file. */
+void HMOSensorLogClose(HMOSensorLog *log);
+
+/** Adds a sample.  Timestamps are stored to the millisecond.
+
+ @return false if timestamp is earlier than the last sample once both are rounded to the millisecond, or writing
+ a batch failed.
+*/
+bool HMOSensorLogAppend(HMOSensorLog *log, double timestamp, float value);
+
+/** Writes and commits the pending samples.  Returns false on I/O errors, the samples stay pending. */
+bool HMOSensorLogSync(HMOSensorLog *log);
+
+/** Timestamp of the newest sample as it reads back, rounded to the millisecond.  -INFINITY if the log is empty. */
+double HMOSensorLogLastTimestamp(const HMOSensorLog *log);
+
+/** Number of segments holding samples */
+size_t HMOSensorLogSegmentCount(const HMOSensorLog *log);
+
+/** Current header of a segment, NULL if segment is out of range. */
+const HMOSensorLogSegmentHeader *HMOSensorLogSegmentHeaderAt(const HMOSensorLog *log, size_t segment);
+
+/** Index of the first segment holding samples at or after timestamp, the segment count if none does. */
+size_t HMOSensorLogFindSegment(const HMOSensorLog *log, double timestamp);
+
+/** Index of the first sample of a segment at or after timestamp, the segment's sample count if none is. */
+size_t HMOSensorLogFindSample(const HMOSensorLog *log, size_t segment, double timestamp);
+
+/** Decodes up to maxCount samples of a segment, starting with sample start.
+
+ @return Number of samples written to timestamps and values.
+*/
+size_t HMOSensorLogReadSegment(const HMOSensorLog *log, size_t segment, size_t start, size_t maxCount, double *timestamps, float *values);
+
+/** Decodes the newest maxCount samples, oldest first.
+
+ @return Number of samples written to timestamps and values.
+*/
+size_t HMOSensorLogReadLatest(const HMOSensorLog *log, size_t maxCount, double *timestamps, float *values);
+
+#endif
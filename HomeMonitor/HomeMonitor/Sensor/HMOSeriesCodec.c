@@ -0,0 +1,360 @@
+//
+//  HMOSeriesCodec.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <math.h>
+#include <string.h>
+
+#include "HMOChecksum.h"
+#include "HMOSeriesCodec.h"
+
+#define HMO_SERIES_CODEC_MAGIC 0x53434F48u
+
+/** Header layout, all fields little endian */
+#define HMO_SERIES_CODEC_MAGIC_OFFSET 0
+#define HMO_SERIES_CODEC_COUNT_OFFSET 4
+#define HMO_SERIES_CODEC_BIT_LENGTH_OFFSET 8
+#define HMO_SERIES_CODEC_CHECKSUM_OFFSET 12
+
+static void StoreLittleEndian32(uint8_t *bytes, uint32_t value) {
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+    bytes[2] = (uint8_t)(value >> 16);
+    bytes[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t LoadLittleEndian32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+static uint32_t FloatBits(float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits) {
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+/** Writes the low count bits of value, most significant first */
+static void WriteBits(HMOSeriesEncoder *encoder, uint64_t value, unsigned count) {
+    uint8_t *payload = encoder->block + HMO_SERIES_CODEC_HEADER_SIZE;
+
+    while (count > 0) {
+        unsigned used = encoder->bitLength & 7;
+        unsigned take = 8 - used;
+
+        if (take > count) {
+            take = count;
+        }
+
+        if (used == 0) {
+            payload[encoder->bitLength >> 3] = 0;
+        }
+
+        uint8_t bits = (uint8_t)((value >> (count - take)) & ((1u << take) - 1));
+
+        payload[encoder->bitLength >> 3] |= (uint8_t)(bits << (8 - used - take));
+        encoder->bitLength += take;
+        count -= take;
+    }
+}
+
+/** Reads count bits, returns false past the end of the payload */
+static bool ReadBits(HMOSeriesDecoder *decoder, unsigned count, uint64_t *value) {
+    if (decoder->bitPosition + count > decoder->bitLength) {
+        return false;
+    }
+
+    uint64_t result = 0;
+
+    while (count > 0) {
+        unsigned used = decoder->bitPosition & 7;
+        unsigned take = 8 - used;
+
+        if (take > count) {
+            take = count;
+        }
+
+        uint8_t byte = decoder->payload[decoder->bitPosition >> 3];
+
+        result = (result << take) | ((byte >> (8 - used - take)) & ((1u << take) - 1));
+        decoder->bitPosition += take;
+        count -= take;
+    }
+
+    *value = result;
+
+    return true;
+}
+
+/** Counts leading one bits up to limit, the prefix of a variable length field */
+static bool ReadPrefix(HMOSeriesDecoder *decoder, unsigned limit, unsigned *ones) {
+    uint64_t bit;
+
+    for (*ones = 0; *ones < limit; (*ones)++) {
+        if (!ReadBits(decoder, 1, &bit)) {
+            return false;
+        }
+
+        if (bit == 0) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+void HMOSeriesEncoderInit(HMOSeriesEncoder *encoder) {
+    encoder->bitLength = 0;
+    encoder->count = 0;
+    encoder->lastTimestamp = 0;
+    encoder->lastDelta = 0;
+    encoder->lastValue = 0;
+    // No difference has 32 leading zeros, so the first one always describes its window
+    encoder->leadingZeros = 32;
+    encoder->trailingZeros = 0;
+}
+
+static void EncodeTimestamp(HMOSeriesEncoder *encoder, int64_t timestamp) {
+    int64_t delta = timestamp - encoder->lastTimestamp;
+    int64_t deltaOfDelta = delta - encoder->lastDelta;
+
+    // Ranges are lopsided by one so a field of n bits holds an offset from -(2^(n-1) - 1)
+    if (deltaOfDelta == 0) {
+        WriteBits(encoder, 0x0, 1);
+    } else if (deltaOfDelta >= -63 && deltaOfDelta <= 64) {
+        WriteBits(encoder, 0x2, 2);
+        WriteBits(encoder, (uint64_t)(deltaOfDelta + 63), 7);
+    } else if (deltaOfDelta >= -255 && deltaOfDelta <= 256) {
+        WriteBits(encoder, 0x6, 3);
+        WriteBits(encoder, (uint64_t)(deltaOfDelta + 255), 9);
+    } else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048) {
+        WriteBits(encoder, 0xE, 4);
+        WriteBits(encoder, (uint64_t)(deltaOfDelta + 2047), 12);
+    } else {
+        WriteBits(encoder, 0xF, 4);
+        WriteBits(encoder, (uint64_t)deltaOfDelta, 64);
+    }
+
+    encoder->lastTimestamp = timestamp;
+    encoder->lastDelta = delta;
+}
+
+static void EncodeValue(HMOSeriesEncoder *encoder, uint32_t value) {
+    uint32_t difference = value ^ encoder->lastValue;
+
+    encoder->lastValue = value;
+
+    if (difference == 0) {
+        WriteBits(encoder, 0x0, 1);
+        return;
+    }
+
+    unsigned leadingZeros = (unsigned)__builtin_clz(difference);
+    unsigned trailingZeros = (unsigned)__builtin_ctz(difference);
+
+    // Reuse the previous window when the changed bits fit in it, saving the window description
+    if (leadingZeros >= encoder->leadingZeros && trailingZeros >= encoder->trailingZeros) {
+        unsigned length = 32 - encoder->leadingZeros - encoder->trailingZeros;
+
+        WriteBits(encoder, 0x2, 2);
+        WriteBits(encoder, difference >> encoder->trailingZeros, length);
+        return;
+    }
+
+    unsigned length = 32 - leadingZeros - trailingZeros;
+
+    WriteBits(encoder, 0x3, 2);
+    WriteBits(encoder, leadingZeros, 5);
+    WriteBits(encoder, length - 1, 5);
+    WriteBits(encoder, difference >> trailingZeros, length);
+
+    encoder->leadingZeros = leadingZeros;
+    encoder->trailingZeros = trailingZeros;
+}
+
+bool HMOSeriesEncoderAppend(HMOSeriesEncoder *encoder, double timestamp, float value) {
+    if (encoder->count == HMO_SERIES_CODEC_BLOCK_CAPACITY) {
+        return false;
+    }
+
+    int64_t milliseconds = (int64_t)llround(timestamp * 1000.0);
+
+    if (encoder->count > 0 && milliseconds < encoder->lastTimestamp) {
+        return false;
+    }
+
+    if (encoder->count == 0) {
+        // The first sample is stored whole, the rest are differences from it
+        WriteBits(encoder, (uint64_t)milliseconds, 64);
+        WriteBits(encoder, FloatBits(value), 32);
+
+        encoder->lastTimestamp = milliseconds;
+        encoder->lastDelta = 0;
+        encoder->lastValue = FloatBits(value);
+        encoder->count = 1;
+
+        return true;
+    }
+
+    encoder->count += 1;
+
+    EncodeTimestamp(encoder, milliseconds);
+    EncodeValue(encoder, FloatBits(value));
+
+    return true;
+}
+
+const uint8_t *HMOSeriesEncoderFinishBlock(HMOSeriesEncoder *encoder, size_t *length) {
+    *length = 0;
+
+    if (encoder->count == 0) {
+        return NULL;
+    }
+
+    StoreLittleEndian32(encoder->block + HMO_SERIES_CODEC_MAGIC_OFFSET, HMO_SERIES_CODEC_MAGIC);
+    StoreLittleEndian32(encoder->block + HMO_SERIES_CODEC_COUNT_OFFSET, encoder->count);
+    StoreLittleEndian32(encoder->block + HMO_SERIES_CODEC_BIT_LENGTH_OFFSET, (uint32_t)encoder->bitLength);
+
+    size_t payloadLength = (encoder->bitLength + 7) / 8;
+    uint32_t checksum = HMOChecksumUpdate(0, encoder->block, HMO_SERIES_CODEC_CHECKSUM_OFFSET);
+
+    checksum = HMOChecksumUpdate(checksum, encoder->block + HMO_SERIES_CODEC_HEADER_SIZE, payloadLength);
+    StoreLittleEndian32(encoder->block + HMO_SERIES_CODEC_CHECKSUM_OFFSET, checksum);
+
+    *length = HMO_SERIES_CODEC_HEADER_SIZE + payloadLength;
+
+    HMOSeriesEncoderInit(encoder);
+
+    return encoder->block;
+}
+
+bool HMOSeriesDecoderInit(HMOSeriesDecoder *decoder, const uint8_t *bytes, size_t length) {
+    memset(decoder, 0, sizeof(HMOSeriesDecoder));
+
+    if (length < HMO_SERIES_CODEC_HEADER_SIZE || LoadLittleEndian32(bytes + HMO_SERIES_CODEC_MAGIC_OFFSET) != HMO_SERIES_CODEC_MAGIC) {
+        return false;
+    }
+
+    uint32_t count = LoadLittleEndian32(bytes + HMO_SERIES_CODEC_COUNT_OFFSET);
+    uint32_t bitLength = LoadLittleEndian32(bytes + HMO_SERIES_CODEC_BIT_LENGTH_OFFSET);
+    size_t payloadLength = ((size_t)bitLength + 7) / 8;
+
+    if (count == 0 || count > HMO_SERIES_CODEC_BLOCK_CAPACITY || payloadLength > length - HMO_SERIES_CODEC_HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t checksum = HMOChecksumUpdate(0, bytes, HMO_SERIES_CODEC_CHECKSUM_OFFSET);
+
+    checksum = HMOChecksumUpdate(checksum, bytes + HMO_SERIES_CODEC_HEADER_SIZE, payloadLength);
+
+    if (checksum != LoadLittleEndian32(bytes + HMO_SERIES_CODEC_CHECKSUM_OFFSET)) {
+        return false;
+    }
+
+    decoder->payload = bytes + HMO_SERIES_CODEC_HEADER_SIZE;
+    decoder->bitLength = bitLength;
+    decoder->count = count;
+    decoder->blockLength = HMO_SERIES_CODEC_HEADER_SIZE + payloadLength;
+
+    return true;
+}
+
+static bool DecodeTimestamp(HMOSeriesDecoder *decoder) {
+    static const unsigned fieldLengths[] = { 0, 7, 9, 12, 64 };
+    static const int64_t fieldBiases[] = { 0, 63, 255, 2047, 0 };
+
+    unsigned prefix;
+    uint64_t field = 0;
+
+    if (!ReadPrefix(decoder, 4, &prefix) || (fieldLengths[prefix] > 0 && !ReadBits(decoder, fieldLengths[prefix], &field))) {
+        return false;
+    }
+
+    int64_t deltaOfDelta = (int64_t)field - fieldBiases[prefix];
+
+    decoder->lastDelta += deltaOfDelta;
+    decoder->lastTimestamp += decoder->lastDelta;
+
+    return true;
+}
+
+static bool DecodeValue(HMOSeriesDecoder *decoder) {
+    unsigned prefix;
+    uint64_t field;
+
+    if (!ReadPrefix(decoder, 2, &prefix)) {
+        return false;
+    }
+
+    if (prefix == 0) {
+        return true;
+    }
+
+    if (prefix == 2) {
+        uint64_t leadingZeros, length;
+
+        if (!ReadBits(decoder, 5, &leadingZeros) || !ReadBits(decoder, 5, &length)) {
+            return false;
+        }
+
+        length += 1;
+
+        if (leadingZeros + length > 32) {
+            return false;
+        }
+
+        decoder->leadingZeros = (unsigned)leadingZeros;
+        decoder->trailingZeros = 32 - (unsigned)leadingZeros - (unsigned)length;
+    }
+
+    if (!ReadBits(decoder, 32 - decoder->leadingZeros - decoder->trailingZeros, &field)) {
+        return false;
+    }
+
+    decoder->lastValue ^= (uint32_t)(field << decoder->trailingZeros);
+
+    return true;
+}
+
+size_t HMOSeriesDecoderRead(HMOSeriesDecoder *decoder, double *timestamps, float *values, size_t maxCount) {
+    size_t count = 0;
+
+    while (count < maxCount && decoder->decodedCount < decoder->count) {
+        if (decoder->decodedCount == 0) {
+            uint64_t timestamp, value;
+
+            if (!ReadBits(decoder, 64, &timestamp) || !ReadBits(decoder, 32, &value)) {
+                break;
+            }
+
+            decoder->lastTimestamp = (int64_t)timestamp;
+            decoder->lastValue = (uint32_t)value;
+        } else if (!DecodeTimestamp(decoder) || !DecodeValue(decoder)) {
+            break;
+        }
+
+        timestamps[count] = decoder->lastTimestamp / 1000.0;
+        values[count] = BitsFloat(decoder->lastValue);
+        decoder->decodedCount += 1;
+        count += 1;
+    }
+
+    if (decoder->decodedCount < decoder->count && count < maxCount) {
+        // The payload ended early, which the checksum should have caught; stop rather than read past it
+        decoder->count = decoder->decodedCount;
+    }
+
+    return count;
+}
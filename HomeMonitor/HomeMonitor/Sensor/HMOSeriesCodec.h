@@ -0,0 +1,85 @@
+//
+//  HMOSeriesCodec.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOSeriesCodec_h
+#define HomeMonitor_HMOSeriesCodec_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Samples in a full block */
+#define HMO_SERIES_CODEC_BLOCK_CAPACITY 1024
+
+#define HMO_SERIES_CODEC_HEADER_SIZE 16
+
+/** Longest possible block, a sample never takes more than 15 bytes */
+#define HMO_SERIES_CODEC_MAX_BLOCK_SIZE (HMO_SERIES_CODEC_HEADER_SIZE + HMO_SERIES_CODEC_BLOCK_CAPACITY * 15)
+
+/**
+ Compresses a series of (timestamp, value) samples into self-contained blocks, in the style of Facebook's Gorilla.
+
+ Timestamps are kept to the millisecond and stored as the change in the difference between consecutive samples,
+ which is zero for a steady sampling rate.  Values are stored as the bits that differ from the previous value,
+ a handful for a slowly changing reading.  A block starts with a little endian header holding the sample count,
+ the payload length in bits and a checksum of both, so damaged blocks are detected and can be skipped.
+*/
+typedef struct {
+    uint8_t block[HMO_SERIES_CODEC_MAX_BLOCK_SIZE];
+    size_t bitLength;
+    uint32_t count;
+    int64_t lastTimestamp;
+    int64_t lastDelta;
+    uint32_t lastValue;
+    /** Window of the last value XOR written with its own window */
+    unsigned leadingZeros;
+    unsigned trailingZeros;
+} HMOSeriesEncoder;
+
+typedef struct {
+    const uint8_t *payload;
+    size_t bitLength;
+    size_t bitPosition;
+    uint32_t count;
+    uint32_t decodedCount;
+    int64_t lastTimestamp;
+    int64_t lastDelta;
+    uint32_t lastValue;
+    unsigned leadingZeros;
+    unsigned trailingZeros;
+    /** Bytes taken by the block, the next block starts right after it */
+    size_t blockLength;
+} HMOSeriesDecoder;
+
+void HMOSeriesEncoderInit(HMOSeriesEncoder *encoder);
+
+/** Adds a sample to the current block.
+
+ @return false if the block is full or timestamp is earlier than the previous sample.
+*/
+bool HMOSeriesEncoderAppend(HMOSeriesEncoder *encoder, double timestamp, float value);
+
+/** Closes the current block and starts a new one.
+
+ @param length Length of the returned block.
+ @return The finished block, valid until the next append.  NULL if no samples were appended.
+*/
+const uint8_t *HMOSeriesEncoderFinishBlock(HMOSeriesEncoder *encoder, size_t *length);
+
+/** Starts decoding the block at the beginning of bytes.
+
+ @return false if bytes is too short to hold the block or its checksum does not match.
+*/
+bool HMOSeriesDecoderInit(HMOSeriesDecoder *decoder, const uint8_t *bytes, size_t length);
+
+/** Decodes up to maxCount more samples of the block.
+
+ @return Number of samples written to timestamps and values, 0 once the block is exhausted.
+*/
+size_t HMOSeriesDecoderRead(HMOSeriesDecoder *decoder, double *timestamps, float *values, size_t maxCount);
+
+#endif
@@ -0,0 +1,271 @@
+//
+//  HMOSeriesRollup.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "HMOSeriesRollup.h"
+
+/** Samples read from the log at a time when scanning it */
+#define HMO_SERIES_ROLLUP_SCAN_BATCH 256
+
+static const double HMOSeriesRollupWidths[HMO_SERIES_ROLLUP_LEVEL_COUNT] = { 60.0, 3600.0, 86400.0 };
+
+/** A week of minutes and a leap year of hours, days are kept forever */
+static const size_t HMOSeriesRollupRetentions[HMO_SERIES_ROLLUP_LEVEL_COUNT] = { 7 * 24 * 60, 366 * 24, 0 };
+
+static void SummaryAdd(HMOSeriesSummary *summary, float value) {
+    if (summary->count == 0) {
+        summary->min = value;
+        summary->max = value;
+    } else {
+        summary->min = fminf(summary->min, value);
+        summary->max = fmaxf(summary->max, value);
+    }
+
+    summary->sum += value;
+    summary->count += 1;
+}
+
+static void SummaryMerge(HMOSeriesSummary *summary, const HMOSeriesSummary *next) {
+    if (next->count == 0) {
+        return;
+    }
+
+    if (summary->count == 0) {
+        *summary = *next;
+        return;
+    }
+
+    summary->min = fminf(summary->min, next->min);
+    summary->max = fmaxf(summary->max, next->max);
+    summary->sum += next->sum;
+    summary->count += next->count;
+}
+
+static void LevelRemoveAll(HMOSeriesRollupLevel *level) {
+    level->offset = 0;
+    level->count = 0;
+    level->firstIndex = 0;
+}
+
+static bool LevelPush(HMOSeriesRollupLevel *level) {
+    if (level->retention > 0 && level->count == level->retention) {
+        level->offset += 1;
+        level->count -= 1;
+        level->firstIndex += 1;
+    }
+
+    if (level->offset + level->count == level->capacity) {
+        if (level->offset > 0 && level->offset >= level->count) {
+            // More than half of the storage holds dropped buckets, reuse it before growing
+            memmove(level->buckets, level->buckets + level->offset, sizeof(HMOSeriesSummary) * level->count);
+            level->offset = 0;
+        } else {
+            size_t capacity = (level->capacity > 0) ? level->capacity * 2 : 64;
+            HMOSeriesSummary *buckets = realloc(level->buckets, sizeof(HMOSeriesSummary) * capacity);
+
+            if (buckets == NULL) {
+                return false;
+            }
+
+            level->buckets = buckets;
+            level->capacity = capacity;
+        }
+    }
+
+    memset(&level->buckets[level->offset + level->count], 0, sizeof(HMOSeriesSummary));
+    level->count += 1;
+
+    return true;
+}
+
+static bool LevelAppend(HMOSeriesRollupLevel *level, double timestamp, float value) {
+    int64_t index = (int64_t)floor(timestamp / level->width);
+
+    if (level->count == 0 || (level->retention > 0 && index - level->firstIndex >= (int64_t)(level->count + level->retention))) {
+        // Every bucket held would be dropped while filling the gap
+        LevelRemoveAll(level);
+        level->firstIndex = index;
+
+        if (!LevelPush(level)) {
+            return false;
+        }
+    }
+
+    while (level->firstIndex + (int64_t)level->count <= index) {
+        if (!LevelPush(level)) {
+            return false;
+        }
+    }
+
+    SummaryAdd(&level->buckets[level->offset + level->count - 1], value);
+
+    return true;
+}
+
+void HMOSeriesRollupInit(HMOSeriesRollup *rollup, const HMOSensorLog *log) {
+    memset(rollup, 0, sizeof(HMOSeriesRollup));
+
+    for (size_t i = 0; i < HMO_SERIES_ROLLUP_LEVEL_COUNT; i++) {
+        rollup->levels[i].width = HMOSeriesRollupWidths[i];
+        rollup->levels[i].retention = HMOSeriesRollupRetentions[i];
+    }
+
+    rollup->log = log;
+    rollup->lastTimestamp = -INFINITY;
+}
+
+void HMOSeriesRollupDestroy(HMOSeriesRollup *rollup) {
+    for (size_t i = 0; i < HMO_SERIES_ROLLUP_LEVEL_COUNT; i++) {
+        free(rollup->levels[i].buckets);
+    }
+
+    HMOSeriesRollupInit(rollup, rollup->log);
+}
+
+bool HMOSeriesRollupAppend(HMOSeriesRollup *rollup, double timestamp, float value) {
+    if (timestamp < rollup->lastTimestamp) {
+        return false;
+    }
+
+    rollup->lastTimestamp = timestamp;
+
+    for (size_t i = 0; i < HMO_SERIES_ROLLUP_LEVEL_COUNT; i++) {
+        if (!LevelAppend(&rollup->levels[i], timestamp, value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool HMOSeriesRollupRebuild(HMOSeriesRollup *rollup) {
+    for (size_t i = 0; i < HMO_SERIES_ROLLUP_LEVEL_COUNT; i++) {
+        LevelRemoveAll(&rollup->levels[i]);
+    }
+
+    rollup->lastTimestamp = -INFINITY;
+
+    double timestamps[HMO_SERIES_ROLLUP_SCAN_BATCH];
+    float values[HMO_SERIES_ROLLUP_SCAN_BATCH];
+    size_t segmentCount = HMOSensorLogSegmentCount(rollup->log);
+
+    for (size_t segment = 0; segment < segmentCount; segment++) {
+        size_t start = 0, count;
+
+        while ((count = HMOSensorLogReadSegment(rollup->log, segment, start, HMO_SERIES_ROLLUP_SCAN_BATCH, timestamps, values)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                if (!HMOSeriesRollupAppend(rollup, timestamps[i], values[i])) {
+                    return false;
+                }
+            }
+
+            start += count;
+        }
+    }
+
+    return true;
+}
+
+/** Adds the samples in the log from startTime to endTime */
+static void SummarizeSamples(const HMOSeriesRollup *rollup, double startTime, double endTime, HMOSeriesSummary *summary) {
+    double timestamps[HMO_SERIES_ROLLUP_SCAN_BATCH];
+    float values[HMO_SERIES_ROLLUP_SCAN_BATCH];
+    size_t segmentCount = HMOSensorLogSegmentCount(rollup->log);
+    size_t segment = HMOSensorLogFindSegment(rollup->log, startTime);
+    size_t start = HMOSensorLogFindSample(rollup->log, segment, startTime);
+
+    for (; segment < segmentCount; segment++, start = 0) {
+        size_t count;
+
+        while ((count = HMOSensorLogReadSegment(rollup->log, segment, start, HMO_SERIES_ROLLUP_SCAN_BATCH, timestamps, values)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                if (timestamps[i] >= endTime) {
+                    return;
+                }
+
+                SummaryAdd(summary, values[i]);
+            }
+
+            start += count;
+        }
+    }
+}
+
+/** Adds [startTime, endTime) from the whole buckets of a level inside it, and the rest from finer levels, down to
+ the samples themselves below the finest level.
+*/
+static void Summarize(const HMOSeriesRollup *rollup, size_t levelCount, double startTime, double endTime, HMOSeriesSummary *summary) {
+    if (startTime >= endTime) {
+        return;
+    }
+
+    if (levelCount == 0) {
+        SummarizeSamples(rollup, startTime, endTime, summary);
+        return;
+    }
+
+    const HMOSeriesRollupLevel *level = &rollup->levels[levelCount - 1];
+    int64_t first = (int64_t)ceil(startTime / level->width);
+    int64_t end = (int64_t)floor(endTime / level->width);
+
+    // Dropped buckets are read from finer levels, buckets past the newest one are empty
+    if (first < level->firstIndex) {
+        first = level->firstIndex;
+    }
+
+    if (end > level->firstIndex + (int64_t)level->count) {
+        end = level->firstIndex + (int64_t)level->count;
+    }
+
+    if (level->count == 0 || first >= end) {
+        Summarize(rollup, levelCount - 1, startTime, endTime, summary);
+        return;
+    }
+
+    Summarize(rollup, levelCount - 1, startTime, first * level->width, summary);
+
+    const HMOSeriesSummary *buckets = level->buckets + level->offset + (first - level->firstIndex);
+
+    for (int64_t i = 0; i < end - first; i++) {
+        SummaryMerge(summary, &buckets[i]);
+    }
+
+    Summarize(rollup, levelCount - 1, end * level->width, endTime, summary);
+}
+
+size_t HMOSeriesRollupQuery(const HMOSeriesRollup *rollup, double startTime, double endTime, double bucketWidth, HMOSeriesSummaryColumns *columns) {
+    if (!(bucketWidth > 0) || !(endTime > startTime)) {
+        return 0;
+    }
+
+    size_t count = 0;
+
+    for (double bucketStart = startTime; bucketStart < endTime && count < columns->capacity; count++) {
+        double bucketEnd = fmin(startTime + (count + 1) * bucketWidth, endTime);
+        HMOSeriesSummary summary = { 0 };
+
+        Summarize(rollup, HMO_SERIES_ROLLUP_LEVEL_COUNT, bucketStart, bucketEnd, &summary);
+
+        columns->startTimes[count] = bucketStart;
+        columns->counts[count] = summary.count;
+
+        if (summary.count > 0) {
+            columns->minValues[count] = summary.min;
+            columns->maxValues[count] = summary.max;
+            columns->meanValues[count] = (float)(summary.sum / summary.count);
+        } else {
+            columns->minValues[count] = columns->maxValues[count] = columns->meanValues[count] = NAN;
+        }
+
+        bucketStart = bucketEnd;
+    }
+
+    return count;
+}
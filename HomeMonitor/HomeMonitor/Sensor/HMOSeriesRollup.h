@@ -0,0 +1,87 @@
+//
+//  HMOSeriesRollup.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOSeriesRollup_h
+#define HomeMonitor_HMOSeriesRollup_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HMOSensorLog.h"
+
+/** Rollup levels, minutes, hours and days */
+#define HMO_SERIES_ROLLUP_LEVEL_COUNT 3
+
+/** Summary of the samples in a time range */
+typedef struct {
+    double sum;
+    float min;
+    float max;
+    uint32_t count;
+} HMOSeriesSummary;
+
+typedef struct {
+    /** Seconds covered by a bucket, buckets start at multiples of it */
+    double width;
+    /** Buckets kept before the oldest ones are dropped, 0 to keep all */
+    size_t retention;
+    /** One bucket per width, empty ones included, the newest one still filling */
+    HMOSeriesSummary *buckets;
+    size_t capacity;
+    size_t offset;
+    size_t count;
+    /** Index of the first live bucket since the epoch, in widths */
+    int64_t firstIndex;
+} HMOSeriesRollupLevel;
+
+/** Structure-of-arrays output for HMOSeriesRollupQuery.  All arrays must hold at least capacity entries. */
+typedef struct {
+    double *startTimes;
+    /** NAN for buckets without samples */
+    float *minValues;
+    float *maxValues;
+    float *meanValues;
+    uint32_t *counts;
+    size_t capacity;
+} HMOSeriesSummaryColumns;
+
+/**
+ Minute, hour and day summaries of a sensor log, kept up to date as samples are appended.
+
+ A query for any range and bucket width is answered from the coarsest summaries that fit inside each bucket,
+ and only reads samples from the log for the parts of a bucket smaller than a minute, or older than the minute
+ and hour summaries are kept for.
+
+ Not thread safe, use it on the same thread or queue as its log.
+*/
+typedef struct {
+    HMOSeriesRollupLevel levels[HMO_SERIES_ROLLUP_LEVEL_COUNT];
+    const HMOSensorLog *log;
+    double lastTimestamp;
+} HMOSeriesRollup;
+
+void HMOSeriesRollupInit(HMOSeriesRollup *rollup, const HMOSensorLog *log);
+void HMOSeriesRollupDestroy(HMOSeriesRollup *rollup);
+
+/** Summarizes every sample already in the log, replacing the current summaries.  Returns false if storage could
+ not be grown. */
+bool HMOSeriesRollupRebuild(HMOSeriesRollup *rollup);
+
+/** Adds a sample that was just appended to the log, with its timestamp as HMOSensorLogLastTimestamp returns it.
+
+ @return false if timestamp is earlier than the last sample, or storage could not be grown.
+*/
+bool HMOSeriesRollupAppend(HMOSeriesRollup *rollup, double timestamp, float value);
+
+/** Summarizes [startTime, endTime) in consecutive buckets of bucketWidth seconds, the last one cut at endTime.
+
+ @return Number of buckets written to columns, at most its capacity.
+*/
+size_t HMOSeriesRollupQuery(const HMOSeriesRollup *rollup, double startTime, double endTime, double bucketWidth, HMOSeriesSummaryColumns *columns);
+
+#endif
@@ -0,0 +1,257 @@
+//
+//  HMOSimulator.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "HMOSimulator.h"
+
+/** Time between the notifications of a batch, about one BLE connection interval */
+#define HMO_SIMULATOR_NOTIFICATION_SPACING 0.0075
+
+static const uint8_t HMOSimulatorRecordCodes[kHMORecordTypeCount] = {
+    [kHMORecordTypeTemperature] = HMO_RECORD_CODE_TEMPERATURE,
+    [kHMORecordTypePressure] = HMO_RECORD_CODE_PRESSURE,
+    [kHMORecordTypeAltitude] = HMO_RECORD_CODE_ALTITUDE
+};
+
+/** xorshift64*, never returns the same sequence for different non-zero states */
+static uint64_t RandomNext(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/** Uniform in [0, 1) */
+static double RandomUniform(uint64_t *state) {
+    return (RandomNext(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static uint64_t RandomSeed(uint64_t seed) {
+    // splitmix64 spreads nearby seeds apart and never yields the zero state
+    uint64_t value = seed + 0x9E3779B97F4A7C15ULL;
+
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+
+    return (value != 0) ? value : 1;
+}
+
+void HMOSimulatorSignalInit(HMOSimulatorSignal *signal, const HMOSimulatorSignalModel *model, uint64_t seed) {
+    signal->model = *model;
+    signal->randomState = RandomSeed(seed);
+}
+
+float HMOSimulatorSignalSample(HMOSimulatorSignal *signal, double time) {
+    const HMOSimulatorSignalModel *model = &signal->model;
+    double value = model->baseValue + model->drift * time + (RandomUniform(&signal->randomState) * 2.0 - 1.0) * model->noise;
+
+    if (model->spikeProbability > 0 && RandomUniform(&signal->randomState) < model->spikeProbability) {
+        value += (RandomUniform(&signal->randomState) < 0.5) ? -model->spikeMagnitude : model->spikeMagnitude;
+    }
+
+    return (float)value;
+}
+
+void HMOSimulatorOptionsInit(HMOSimulatorOptions *options) {
+    memset(options, 0, sizeof(HMOSimulatorOptions));
+
+    options->deviceCount = 1;
+    options->rates[kHMORecordTypeTemperature] = 1.0;
+    options->rates[kHMORecordTypePressure] = 10.0;
+    options->rates[kHMORecordTypeAltitude] = 1.0;
+    options->models[kHMORecordTypeTemperature] = (HMOSimulatorSignalModel){ 21.0, 0.0001, 0.5, 0.001, 10.0 };
+    options->models[kHMORecordTypePressure] = (HMOSimulatorSignalModel){ 99700.0, -0.01, 10.0, 0.001, 300.0 };
+    options->models[kHMORecordTypeAltitude] = (HMOSimulatorSignalModel){ 120.0, 0.0008, 1.0, 0.001, 25.0 };
+    options->batchInterval = 0.1;
+    options->dropProbability = 0.01;
+    options->duplicateProbability = 0.005;
+    options->truncateProbability = 0.005;
+}
+
+bool HMOSimulatorInit(HMOSimulator *simulator, const HMOSimulatorOptions *options) {
+    memset(simulator, 0, sizeof(HMOSimulator));
+
+    simulator->options = *options;
+    simulator->randomState = RandomSeed(options->seed);
+    simulator->lastReceiveTime = -INFINITY;
+
+    size_t deviceCount = options->deviceCount;
+    size_t channelCount = deviceCount * kHMORecordTypeCount;
+
+    simulator->signals = malloc(sizeof(HMOSimulatorSignal) * channelCount);
+    simulator->nextReadingTimes = malloc(sizeof(double) * channelCount);
+    simulator->nextBatchTimes = malloc(sizeof(double) * deviceCount);
+
+    if (channelCount > 0 && (simulator->signals == NULL || simulator->nextReadingTimes == NULL || simulator->nextBatchTimes == NULL)) {
+        HMOSimulatorDestroy(simulator);
+        return false;
+    }
+
+    for (size_t device = 0; device < deviceCount; device++) {
+        // Devices start a fraction of a batch apart, like boards that were not switched on together
+        simulator->nextBatchTimes[device] = options->startTime + options->batchInterval * RandomUniform(&simulator->randomState);
+
+        for (size_t type = 0; type < kHMORecordTypeCount; type++) {
+            size_t channel = device * kHMORecordTypeCount + type;
+
+            HMOSimulatorSignalInit(&simulator->signals[channel], &options->models[type], options->seed ^ RandomNext(&simulator->randomState));
+            simulator->nextReadingTimes[channel] = (options->rates[type] > 0) ? simulator->nextBatchTimes[device] : INFINITY;
+        }
+    }
+
+    return true;
+}
+
+void HMOSimulatorDestroy(HMOSimulator *simulator) {
+    free(simulator->signals);
+    free(simulator->nextReadingTimes);
+    free(simulator->nextBatchTimes);
+
+    simulator->signals = NULL;
+    simulator->nextReadingTimes = NULL;
+    simulator->nextBatchTimes = NULL;
+}
+
+static void AppendRecord(HMOSimulator *simulator, uint8_t code, int32_t value) {
+    uint8_t *record = simulator->batch + simulator->batchLength;
+    uint32_t bits = (uint32_t)value;
+
+    record[0] = code;
+    record[1] = (uint8_t)(bits >> 24);
+    record[2] = (uint8_t)(bits >> 16);
+    record[3] = (uint8_t)(bits >> 8);
+    record[4] = (uint8_t)bits;
+
+    simulator->batchLength += HMO_RECORD_LENGTH;
+}
+
+/** Fills the batch with the readings due on the device whose batch is next, returns false once time is up */
+static bool NextBatch(HMOSimulator *simulator) {
+    const HMOSimulatorOptions *options = &simulator->options;
+    size_t device = 0;
+
+    if (options->deviceCount == 0 || !(options->batchInterval > 0)) {
+        return false;
+    }
+
+    for (size_t i = 1; i < options->deviceCount; i++) {
+        if (simulator->nextBatchTimes[i] < simulator->nextBatchTimes[device]) {
+            device = i;
+        }
+    }
+
+    double time = simulator->nextBatchTimes[device];
+
+    if (options->duration > 0 && time >= options->startTime + options->duration) {
+        return false;
+    }
+
+    simulator->batchLength = 0;
+    simulator->batchOffset = 0;
+    simulator->batchNotificationIndex = 0;
+    // A batch carrying a backlog goes out once the one before it has
+    simulator->batchTime = simulator->isBacklogged ? fmax(time, simulator->lastReceiveTime + HMO_SIMULATOR_NOTIFICATION_SPACING) : time;
+
+    double *readingTimes = simulator->nextReadingTimes + device * kHMORecordTypeCount;
+    bool isDue = true;
+
+    // One due reading of every type in turn, until none are left or the batch is full
+    while (isDue && simulator->batchLength < sizeof(simulator->batch)) {
+        isDue = false;
+
+        for (size_t type = 0; type < kHMORecordTypeCount && simulator->batchLength < sizeof(simulator->batch); type++) {
+            if (readingTimes[type] > time) {
+                continue;
+            }
+
+            float value = HMOSimulatorSignalSample(&simulator->signals[device * kHMORecordTypeCount + type], readingTimes[type] - options->startTime);
+
+            // The board sends whole units
+            AppendRecord(simulator, HMOSimulatorRecordCodes[type], (int32_t)lroundf(value));
+
+            readingTimes[type] += 1.0 / options->rates[type];
+            simulator->readingCount += 1;
+            isDue = true;
+        }
+    }
+
+    simulator->isBacklogged = false;
+
+    for (size_t type = 0; type < kHMORecordTypeCount; type++) {
+        simulator->isBacklogged = simulator->isBacklogged || readingTimes[type] <= time;
+    }
+
+    // The device stays due at the same time until its backlog is sent
+    if (!simulator->isBacklogged) {
+        simulator->nextBatchTimes[device] += options->batchInterval;
+    }
+
+    // A batch filling its notifications exactly ends with an empty one, so the receiver sees where it ends
+    simulator->batchNotificationCount = (simulator->batchLength > 0) ? simulator->batchLength / HMO_SIMULATOR_NOTIFICATION_LENGTH + 1 : 0;
+
+    return true;
+}
+
+bool HMOSimulatorNext(void *context, HMOCaptureNotification *notification) {
+    HMOSimulator *simulator = context;
+
+    if (simulator->hasDuplicate) {
+        *notification = simulator->duplicate;
+        simulator->hasDuplicate = false;
+
+        return true;
+    }
+
+    while (true) {
+        // An empty batch sends nothing, like a board with no readings due
+        while (simulator->batchNotificationIndex >= simulator->batchNotificationCount) {
+            if (!NextBatch(simulator)) {
+                return false;
+            }
+        }
+
+        size_t notificationIndex = simulator->batchNotificationIndex++;
+        size_t length = simulator->batchLength - simulator->batchOffset;
+
+        if (length > HMO_SIMULATOR_NOTIFICATION_LENGTH) {
+            length = HMO_SIMULATOR_NOTIFICATION_LENGTH;
+        }
+
+        const uint8_t *bytes = simulator->batch + simulator->batchOffset;
+
+        simulator->batchOffset += length;
+
+        if (RandomUniform(&simulator->randomState) < simulator->options.dropProbability) {
+            simulator->droppedCount += 1;
+            continue;
+        }
+
+        if (length > 1 && RandomUniform(&simulator->randomState) < simulator->options.truncateProbability) {
+            length = 1 + (size_t)(RandomUniform(&simulator->randomState) * (length - 1));
+            simulator->truncatedCount += 1;
+        }
+
+        // A long batch can run into the next device's batch, which then waits for the link
+        notification->receiveTime = fmax(simulator->batchTime + notificationIndex * HMO_SIMULATOR_NOTIFICATION_SPACING, simulator->lastReceiveTime);
+        simulator->lastReceiveTime = notification->receiveTime;
+        notification->length = length;
+        memcpy(notification->bytes, bytes, length);
+
+        if (RandomUniform(&simulator->randomState) < simulator->options.duplicateProbability) {
+            simulator->duplicate = *notification;
+            simulator->hasDuplicate = true;
+            simulator->duplicatedCount += 1;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,113 @@
+//
+//  HMOSimulator.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOSimulator_h
+#define HomeMonitor_HMOSimulator_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HMOCapture.h"
+#include "HMORecordDecoder.h"
+
+/** Most records a device sends in one batch, readings due beyond it follow in more batches straight after */
+#define HMO_SIMULATOR_MAX_BATCH_RECORDS 96
+
+/** Payload of a full BLE notification, a batch is sent in notifications of this length and a shorter last one,
+ empty when the batch fills its notifications exactly */
+#define HMO_SIMULATOR_NOTIFICATION_LENGTH 20
+
+/** Shape of a simulated reading over time */
+typedef struct {
+    double baseValue;
+    /** Change of the value per second */
+    double drift;
+    /** Readings vary uniformly by up to this much around the drifting value */
+    double noise;
+    /** Chance of a reading being a spike, offset by spikeMagnitude in a random direction */
+    double spikeProbability;
+    double spikeMagnitude;
+} HMOSimulatorSignalModel;
+
+typedef struct {
+    HMOSimulatorSignalModel model;
+    uint64_t randomState;
+} HMOSimulatorSignal;
+
+typedef struct {
+    size_t deviceCount;
+    /** Readings per second each device sends, indexed by record type, 0 to leave a type out */
+    double rates[kHMORecordTypeCount];
+    HMOSimulatorSignalModel models[kHMORecordTypeCount];
+    /** Seconds between the batches a device sends */
+    double batchInterval;
+    /** Chances of a notification being lost, delivered twice, or cut short in the middle of a record */
+    double dropProbability;
+    double duplicateProbability;
+    double truncateProbability;
+    /** Receive time of the first batch, and seconds to simulate, 0 to never stop */
+    double startTime;
+    double duration;
+    /** Runs with the same options and seed produce the same notifications */
+    uint64_t seed;
+} HMOSimulatorOptions;
+
+/**
+ Generates the notifications a set of sensor boards would send, for feeding the pipeline without hardware.
+
+ Every device sends its due readings in batches, split into full notifications and a shorter last one, in the
+ record format of the real board.  Batches are filled with the due readings of every type in turn, so a fast
+ type cannot crowd the others out, and a device with more readings due than a batch holds sends them in
+ further batches, each after the one before on the link.  Batches of different devices never interleave.  Notifications are handed out
+ in receive time order, as fast as they are asked for.
+*/
+typedef struct {
+    HMOSimulatorOptions options;
+    uint64_t randomState;
+    /** Per device and record type */
+    HMOSimulatorSignal *signals;
+    double *nextReadingTimes;
+    /** Per device */
+    double *nextBatchTimes;
+
+    uint8_t batch[HMO_SIMULATOR_MAX_BATCH_RECORDS * HMO_RECORD_LENGTH];
+    size_t batchLength;
+    size_t batchOffset;
+    /** Notifications of the batch, including the short one ending it, and how many were handed out */
+    size_t batchNotificationCount;
+    size_t batchNotificationIndex;
+    double batchTime;
+    /** The last batch left readings due, which the next batch of the same device carries */
+    bool isBacklogged;
+    double lastReceiveTime;
+    HMOCaptureNotification duplicate;
+    bool hasDuplicate;
+
+    uint64_t readingCount;
+    uint64_t droppedCount;
+    uint64_t duplicatedCount;
+    uint64_t truncatedCount;
+} HMOSimulator;
+
+void HMOSimulatorSignalInit(HMOSimulatorSignal *signal, const HMOSimulatorSignalModel *model, uint64_t seed);
+
+/** Value of the signal at time seconds after it started */
+float HMOSimulatorSignalSample(HMOSimulatorSignal *signal, double time);
+
+/** A board reporting temperature and altitude every second and pressure ten times a second, over a flaky link */
+void HMOSimulatorOptionsInit(HMOSimulatorOptions *options);
+
+/** Returns false if storage could not be allocated. */
+bool HMOSimulatorInit(HMOSimulator *simulator, const HMOSimulatorOptions *options);
+void HMOSimulatorDestroy(HMOSimulator *simulator);
+
+/** Hands out the next notification, false once the duration has passed.  Works as an HMOReplaySourceNext with
+ the simulator as context. */
+bool HMOSimulatorNext(void *context, HMOCaptureNotification *notification);
+
+#endif
@@ -0,0 +1,84 @@
+//
+//  HMOTimeSeries.c
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <stdlib.h>
+
+#include "HMOTimeSeries.h"
+
+bool HMOTimeSeriesInit(HMOTimeSeries *series, size_t capacity) {
+    series->timestamps = malloc(sizeof(double) * capacity * 2);
+    series->values = malloc(sizeof(float) * capacity * 2);
+    series->capacity = capacity;
+    series->start = 0;
+    series->count = 0;
+
+    if (series->timestamps == NULL || series->values == NULL || capacity == 0) {
+        HMOTimeSeriesDestroy(series);
+        return false;
+    }
+
+    return true;
+}
+
+void HMOTimeSeriesDestroy(HMOTimeSeries *series) {
+    free(series->timestamps);
+    free(series->values);
+
+    series->timestamps = NULL;
+    series->values = NULL;
+    series->capacity = 0;
+    series->start = 0;
+    series->count = 0;
+}
+
+bool HMOTimeSeriesAppend(HMOTimeSeries *series, double timestamp, float value) {
+    size_t index = series->start + series->count;
+
+    if (index >= series->capacity) {
+        index -= series->capacity;
+    }
+
+    series->timestamps[index] = timestamp;
+    series->timestamps[index + series->capacity] = timestamp;
+    series->values[index] = value;
+    series->values[index + series->capacity] = value;
+
+    if (series->count < series->capacity) {
+        series->count += 1;
+        return false;
+    }
+
+    series->start += 1;
+
+    if (series->start == series->capacity) {
+        series->start = 0;
+    }
+
+    return true;
+}
+
+void HMOTimeSeriesRemoveOldest(HMOTimeSeries *series, size_t count) {
+    if (count > series->count) {
+        count = series->count;
+    }
+
+    series->start = (series->start + count) % series->capacity;
+    series->count -= count;
+}
+
+void HMOTimeSeriesRemoveAll(HMOTimeSeries *series) {
+    series->start = 0;
+    series->count = 0;
+}
+
+const double *HMOTimeSeriesTimestamps(const HMOTimeSeries *series, size_t count) {
+    return series->timestamps + series->start + (series->count - count);
+}
+
+const float *HMOTimeSeriesValues(const HMOTimeSeries *series, size_t count) {
+    return series->values + series->start + (series->count - count);
+}
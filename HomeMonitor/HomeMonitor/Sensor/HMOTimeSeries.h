@@ -0,0 +1,49 @@
+//
+//  HMOTimeSeries.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOTimeSeries_h
+#define HomeMonitor_HMOTimeSeries_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ Fixed-capacity ring buffer of (timestamp, value) samples with O(1) append and eviction.
+
+ Timestamps and values live in separate arrays.  Every sample is written twice, capacity
+ entries apart, so the live samples are always readable as one contiguous run starting at
+ the oldest sample, without copying.
+*/
+typedef struct {
+    double *timestamps;
+    float *values;
+    size_t capacity;
+    size_t start;
+    size_t count;
+} HMOTimeSeries;
+
+/** Allocates storage for capacity samples.  Returns false if allocation fails. */
+bool HMOTimeSeriesInit(HMOTimeSeries *series, size_t capacity);
+void HMOTimeSeriesDestroy(HMOTimeSeries *series);
+
+/** Appends a sample, evicting the oldest one if the series is full.
+
+ @return true if a sample was evicted.
+*/
+bool HMOTimeSeriesAppend(HMOTimeSeries *series, double timestamp, float value);
+
+/** Removes up to count of the oldest samples. */
+void HMOTimeSeriesRemoveOldest(HMOTimeSeries *series, size_t count);
+void HMOTimeSeriesRemoveAll(HMOTimeSeries *series);
+
+/** Contiguous timestamps of the newest count samples.  count must not exceed series->count. */
+const double *HMOTimeSeriesTimestamps(const HMOTimeSeries *series, size_t count);
+
+/** Contiguous values of the newest count samples.  count must not exceed series->count. */
+const float *HMOTimeSeriesValues(const HMOTimeSeries *series, size_t count);
+
+#endif
@@ -0,0 +1,251 @@
+//
+//  HMOCaptureTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "HMOCapture.h"
+}
+
+namespace {
+
+struct Notification {
+    double receiveTime;
+    std::vector<uint8_t> bytes;
+};
+
+/** Empty, half and largest payloads and then BLE sized ones, at irregular receive times */
+std::vector<Notification> RandomNotifications(size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<Notification> notifications;
+    double receiveTime = 4e8 + 0.123;
+
+    for (size_t i = 0; i < count; i++) {
+        Notification notification;
+
+        receiveTime += (double)(random() % 100000) / 1e6;
+        notification.receiveTime = receiveTime;
+        notification.bytes.resize((i < 3) ? i * HMO_CAPTURE_MAX_PAYLOAD_LENGTH / 2 : random() % 21);
+
+        for (uint8_t &byte : notification.bytes) {
+            byte = (uint8_t)random();
+        }
+
+        notifications.push_back(notification);
+    }
+
+    return notifications;
+}
+
+void WriteCapture(const std::string &path, const std::vector<Notification> &notifications) {
+    HMOCaptureWriter writer;
+
+    ASSERT_TRUE(HMOCaptureWriterOpen(&writer, path.c_str()));
+
+    for (const Notification &notification : notifications) {
+        ASSERT_TRUE(HMOCaptureWriterAppend(&writer, notification.receiveTime, notification.bytes.data(), notification.bytes.size()));
+    }
+
+    EXPECT_EQ(notifications.size(), writer.count);
+    ASSERT_TRUE(HMOCaptureWriterClose(&writer));
+}
+
+/** Reads the capture back until it ends or turns out damaged */
+std::vector<Notification> ReadCapture(const std::string &path, bool *isDamaged) {
+    HMOCaptureReader reader;
+    HMOCaptureNotification notification;
+    std::vector<Notification> notifications;
+
+    EXPECT_TRUE(HMOCaptureReaderOpen(&reader, path.c_str()));
+
+    while (HMOCaptureReaderNext(&reader, &notification)) {
+        notifications.push_back({ notification.receiveTime, std::vector<uint8_t>(notification.bytes, notification.bytes + notification.length) });
+    }
+
+    EXPECT_EQ(notifications.size(), reader.count);
+    *isDamaged = reader.isDamaged;
+
+    // Nothing more is handed out after the end
+    EXPECT_FALSE(HMOCaptureReaderNext(&reader, &notification));
+
+    HMOCaptureReaderClose(&reader);
+
+    return notifications;
+}
+
+void ExpectNotifications(const std::vector<Notification> &expected, const std::vector<Notification> &read) {
+    ASSERT_EQ(expected.size(), read.size());
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        ASSERT_EQ(0, memcmp(&expected[i].receiveTime, &read[i].receiveTime, sizeof(double))) << "notification " << i;
+        ASSERT_EQ(expected[i].bytes, read[i].bytes) << "notification " << i;
+    }
+}
+
+long FileLength(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+
+    fseek(file, 0, SEEK_END);
+
+    long length = ftell(file);
+
+    fclose(file);
+
+    return length;
+}
+
+class CaptureFile {
+public:
+    const std::string path;
+
+    explicit CaptureFile(const char *name) : path(testing::TempDir() + name) {
+        unlink(path.c_str());
+    }
+
+    ~CaptureFile() {
+        unlink(path.c_str());
+    }
+};
+
+}
+
+TEST(HMOCapture, RoundTripsNotifications) {
+    CaptureFile capture("HMOCaptureRoundTrip.cap");
+    std::vector<Notification> notifications = RandomNotifications(2000, 1);
+    bool isDamaged;
+
+    WriteCapture(capture.path, notifications);
+    ExpectNotifications(notifications, ReadCapture(capture.path, &isDamaged));
+    EXPECT_FALSE(isDamaged);
+}
+
+TEST(HMOCapture, EmptyCaptureHasNoNotifications) {
+    CaptureFile capture("HMOCaptureEmpty.cap");
+    bool isDamaged;
+
+    WriteCapture(capture.path, {});
+
+    EXPECT_TRUE(ReadCapture(capture.path, &isDamaged).empty());
+    EXPECT_FALSE(isDamaged);
+}
+
+TEST(HMOCapture, RefusesOversizePayloads) {
+    CaptureFile capture("HMOCaptureOversize.cap");
+    HMOCaptureWriter writer;
+    std::vector<uint8_t> bytes(HMO_CAPTURE_MAX_PAYLOAD_LENGTH + 1);
+    bool isDamaged;
+
+    ASSERT_TRUE(HMOCaptureWriterOpen(&writer, capture.path.c_str()));
+    EXPECT_FALSE(HMOCaptureWriterAppend(&writer, 1.0, bytes.data(), bytes.size()));
+    EXPECT_TRUE(HMOCaptureWriterAppend(&writer, 2.0, bytes.data(), HMO_CAPTURE_MAX_PAYLOAD_LENGTH));
+    EXPECT_EQ(1u, writer.count);
+    ASSERT_TRUE(HMOCaptureWriterClose(&writer));
+
+    // The refused payload left nothing behind
+    std::vector<Notification> read = ReadCapture(capture.path, &isDamaged);
+
+    ASSERT_EQ(1u, read.size());
+    EXPECT_EQ(2.0, read[0].receiveTime);
+    EXPECT_FALSE(isDamaged);
+}
+
+TEST(HMOCapture, EmptyNotificationsNeedNoBytes) {
+    CaptureFile capture("HMOCaptureNoBytes.cap");
+    HMOCaptureWriter writer;
+    bool isDamaged;
+
+    ASSERT_TRUE(HMOCaptureWriterOpen(&writer, capture.path.c_str()));
+    EXPECT_TRUE(HMOCaptureWriterAppend(&writer, 1.0, nullptr, 0));
+    EXPECT_TRUE(HMOCaptureWriterAppend(&writer, 2.0, nullptr, 0));
+    ASSERT_TRUE(HMOCaptureWriterClose(&writer));
+
+    ExpectNotifications({ { 1.0, {} }, { 2.0, {} } }, ReadCapture(capture.path, &isDamaged));
+    EXPECT_FALSE(isDamaged);
+}
+
+TEST(HMOCapture, CutOffCaptureReadsUpToTheLastWholeEntry) {
+    CaptureFile capture("HMOCaptureCutOff.cap");
+    std::vector<Notification> notifications = RandomNotifications(40, 2);
+
+    WriteCapture(capture.path, notifications);
+
+    long length = FileLength(capture.path);
+    long lastEntryLength = 14 + (long)notifications.back().bytes.size();
+
+    // Cut anywhere in the last entry, as when the app is killed while recording
+    for (long cut = 1; cut <= lastEntryLength; cut++) {
+        bool isDamaged;
+
+        ASSERT_EQ(0, truncate(capture.path.c_str(), length - cut));
+
+        ExpectNotifications(std::vector<Notification>(notifications.begin(), notifications.end() - 1), ReadCapture(capture.path, &isDamaged));
+        EXPECT_EQ(cut < lastEntryLength, isDamaged) << "cut " << cut;
+    }
+}
+
+TEST(HMOCapture, DamagedEntryEndsTheCapture) {
+    CaptureFile capture("HMOCaptureDamaged.cap");
+    std::vector<Notification> notifications = RandomNotifications(10, 3);
+
+    WriteCapture(capture.path, notifications);
+
+    // Entry 5 starts after the header and the entries in front of it
+    long offset = 12;
+
+    for (size_t i = 0; i < 5; i++) {
+        offset += 14 + (long)notifications[i].bytes.size();
+    }
+
+    // Every byte of the entry header, and the payload, is covered by its checksum
+    for (long position = offset; position < offset + 14 + (long)notifications[5].bytes.size(); position++) {
+        bool isDamaged;
+
+        WriteCapture(capture.path, notifications);
+
+        FILE *file = fopen(capture.path.c_str(), "r+b");
+        uint8_t byte;
+
+        ASSERT_NE(nullptr, file);
+        fseek(file, position, SEEK_SET);
+        ASSERT_EQ(1u, fread(&byte, 1, 1, file));
+        byte ^= 0x10;
+        fseek(file, position, SEEK_SET);
+        ASSERT_EQ(1u, fwrite(&byte, 1, 1, file));
+        fclose(file);
+
+        ExpectNotifications(std::vector<Notification>(notifications.begin(), notifications.begin() + 5), ReadCapture(capture.path, &isDamaged));
+        EXPECT_TRUE(isDamaged) << "position " << position;
+    }
+}
+
+TEST(HMOCapture, RefusesOtherFiles) {
+    CaptureFile capture("HMOCaptureOther.cap");
+    HMOCaptureReader reader;
+
+    EXPECT_FALSE(HMOCaptureReaderOpen(&reader, capture.path.c_str()));
+
+    FILE *file = fopen(capture.path.c_str(), "wb");
+
+    fputs("HMOCAPT2 and then some", file);
+    fclose(file);
+
+    EXPECT_FALSE(HMOCaptureReaderOpen(&reader, capture.path.c_str()));
+
+    // A header cut short
+    WriteCapture(capture.path, {});
+    ASSERT_EQ(0, truncate(capture.path.c_str(), 11));
+
+    EXPECT_FALSE(HMOCaptureReaderOpen(&reader, capture.path.c_str()));
+}
@@ -0,0 +1,39 @@
+//
+//  HMOChecksumTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+extern "C" {
+#include "HMOChecksum.h"
+}
+
+TEST(HMOChecksum, MatchesTheCastagnoliCheckValue) {
+    const char *check = "123456789";
+
+    EXPECT_EQ(0xE3069283u, HMOChecksumUpdate(0, check, strlen(check)));
+    EXPECT_EQ(0u, HMOChecksumUpdate(0, check, 0));
+}
+
+TEST(HMOChecksum, PiecesGiveTheSameChecksum) {
+    uint8_t bytes[1000];
+
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        bytes[i] = (uint8_t)(i * 7 + i / 13);
+    }
+
+    uint32_t whole = HMOChecksumUpdate(0, bytes, sizeof(bytes));
+
+    for (size_t split = 0; split <= sizeof(bytes); split += 37) {
+        EXPECT_EQ(whole, HMOChecksumUpdate(HMOChecksumUpdate(0, bytes, split), bytes + split, sizeof(bytes) - split));
+    }
+
+    // Any flipped bit changes it
+    bytes[500] ^= 0x10;
+    EXPECT_NE(whole, HMOChecksumUpdate(0, bytes, sizeof(bytes)));
+}
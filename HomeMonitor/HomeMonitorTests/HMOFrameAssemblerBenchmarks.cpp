@@ -0,0 +1,97 @@
+//
+//  HMOFrameAssemblerBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+extern "C" {
+#include "HMOFrameAssembler.h"
+}
+
+namespace {
+
+/** Batches of records split into 20-byte notifications and a shorter last one, like the board sends */
+std::vector<std::vector<uint8_t>> Notifications(size_t batchCount, size_t recordsPerBatch) {
+    std::vector<std::vector<uint8_t>> notifications;
+    uint8_t code = 0x0A;
+
+    for (size_t batch = 0; batch < batchCount; batch++) {
+        std::vector<uint8_t> bytes;
+
+        for (size_t i = 0; i < recordsPerBatch; i++) {
+            uint8_t record[HMO_RECORD_LENGTH] = { code, 0, 1, (uint8_t)(i >> 8), (uint8_t)i };
+
+            bytes.insert(bytes.end(), record, record + HMO_RECORD_LENGTH);
+            code = (code == 0x0C) ? 0x0A : code + 1;
+        }
+
+        for (size_t offset = 0; offset < bytes.size(); offset += 20) {
+            size_t length = std::min<size_t>(20, bytes.size() - offset);
+
+            notifications.push_back(std::vector<uint8_t>(bytes.begin() + offset, bytes.begin() + offset + length));
+        }
+    }
+
+    return notifications;
+}
+
+}
+
+/** BLE's path: append, end the batch on a short notification, flush at 64 record bytes */
+static void HMOFrameAssemblerReplay(benchmark::State &state) {
+    std::vector<std::vector<uint8_t>> notifications = Notifications(1024, (size_t)state.range(0));
+    HMOFrameAssembler assembler;
+    uint8_t output[HMO_FRAME_ASSEMBLER_CAPACITY];
+    size_t recordBytes = 0;
+
+    HMOFrameAssemblerInit(&assembler);
+
+    for (auto _ : state) {
+        for (const std::vector<uint8_t> &notification : notifications) {
+            HMOFrameAssemblerAppend(&assembler, notification.data(), notification.size());
+
+            bool endOfBatch = (notification.size() < 20);
+
+            if (endOfBatch) {
+                HMOFrameAssemblerDiscardPartialRecord(&assembler);
+            }
+
+            if (endOfBatch || HMOFrameAssemblerRecordBytes(&assembler) >= 64) {
+                recordBytes += HMOFrameAssemblerReadRecords(&assembler, output, sizeof(output));
+            }
+        }
+    }
+
+    benchmark::DoNotOptimize(recordBytes);
+
+    // Items are notifications, bytes are the whole records handed out
+    state.SetItemsProcessed(state.iterations() * notifications.size());
+    state.SetBytesProcessed(recordBytes);
+}
+
+BENCHMARK(HMOFrameAssemblerReplay)->Arg(3)->Arg(13)->Arg(96);
+
+/** Appends with nothing read out, so every append past the first 512 bytes evicts */
+static void HMOFrameAssemblerOverflow(benchmark::State &state) {
+    std::vector<std::vector<uint8_t>> notifications = Notifications(256, 13);
+    HMOFrameAssembler assembler;
+
+    HMOFrameAssemblerInit(&assembler);
+
+    for (auto _ : state) {
+        for (const std::vector<uint8_t> &notification : notifications) {
+            HMOFrameAssemblerAppend(&assembler, notification.data(), notification.size());
+        }
+    }
+
+    benchmark::DoNotOptimize(assembler.overflowCount);
+
+    state.SetItemsProcessed(state.iterations() * notifications.size());
+}
+
+BENCHMARK(HMOFrameAssemblerOverflow);
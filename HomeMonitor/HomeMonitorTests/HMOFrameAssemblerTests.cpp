@@ -0,0 +1,172 @@
+//
+//  HMOFrameAssemblerTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern "C" {
+#include "HMOFrameAssembler.h"
+}
+
+namespace {
+
+/** Record bytes that start with type i and carry i as their value, so misaligned reads show */
+std::vector<uint8_t> Records(size_t first, size_t count) {
+    std::vector<uint8_t> bytes;
+
+    for (size_t i = first; i < first + count; i++) {
+        uint8_t record[HMO_RECORD_LENGTH] = { (uint8_t)i, 0, 0, (uint8_t)(i >> 8), (uint8_t)i };
+
+        bytes.insert(bytes.end(), record, record + HMO_RECORD_LENGTH);
+    }
+
+    return bytes;
+}
+
+/** Runs notifications through BLE's batching rules and returns the record bytes of every flush */
+std::vector<std::vector<uint8_t>> Flushes(HMOFrameAssembler *assembler, const std::vector<std::vector<uint8_t>> &notifications) {
+    std::vector<std::vector<uint8_t>> flushes;
+    uint8_t output[HMO_FRAME_ASSEMBLER_CAPACITY];
+
+    for (const std::vector<uint8_t> &notification : notifications) {
+        HMOFrameAssemblerAppend(assembler, notification.data(), notification.size());
+
+        bool endOfBatch = (notification.size() < 20);
+
+        if (endOfBatch) {
+            HMOFrameAssemblerDiscardPartialRecord(assembler);
+        }
+
+        if (endOfBatch || HMOFrameAssemblerRecordBytes(assembler) >= 64) {
+            size_t length = HMOFrameAssemblerReadRecords(assembler, output, sizeof(output));
+
+            if (length > 0) {
+                flushes.push_back(std::vector<uint8_t>(output, output + length));
+            }
+        }
+    }
+
+    return flushes;
+}
+
+}
+
+TEST(HMOFrameAssembler, JoinsRecordsSplitAcrossNotifications) {
+    HMOFrameAssembler assembler;
+    std::vector<uint8_t> bytes = Records(1, 4);
+    uint8_t output[64];
+
+    HMOFrameAssemblerInit(&assembler);
+
+    // 3 + 9 + 8 bytes, no notification boundary on a record boundary
+    HMOFrameAssemblerAppend(&assembler, bytes.data(), 3);
+    EXPECT_EQ(0u, HMOFrameAssemblerRecordBytes(&assembler));
+
+    HMOFrameAssemblerAppend(&assembler, bytes.data() + 3, 9);
+    EXPECT_EQ(10u, HMOFrameAssemblerRecordBytes(&assembler));
+
+    HMOFrameAssemblerAppend(&assembler, bytes.data() + 12, 8);
+    ASSERT_EQ(20u, HMOFrameAssemblerReadRecords(&assembler, output, sizeof(output)));
+    EXPECT_EQ(bytes, std::vector<uint8_t>(output, output + 20));
+    EXPECT_EQ(0u, assembler.overflowCount);
+    EXPECT_EQ(0u, assembler.droppedByteCount);
+}
+
+TEST(HMOFrameAssembler, ReadsOnlyWholeRecordsThatFit) {
+    HMOFrameAssembler assembler;
+    std::vector<uint8_t> bytes = Records(1, 3);
+    uint8_t output[12];
+
+    HMOFrameAssemblerInit(&assembler);
+    HMOFrameAssemblerAppend(&assembler, bytes.data(), bytes.size() - 2);
+
+    // Room for two records, but only the first two are whole
+    ASSERT_EQ(10u, HMOFrameAssemblerReadRecords(&assembler, output, sizeof(output)));
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin(), bytes.begin() + 10), std::vector<uint8_t>(output, output + 10));
+
+    HMOFrameAssemblerAppend(&assembler, bytes.data() + bytes.size() - 2, 2);
+    ASSERT_EQ(5u, HMOFrameAssemblerReadRecords(&assembler, output, sizeof(output)));
+    EXPECT_EQ(std::vector<uint8_t>(bytes.begin() + 10, bytes.end()), std::vector<uint8_t>(output, output + 5));
+}
+
+TEST(HMOFrameAssembler, EvictsOldestWholeRecordsWhenFull) {
+    HMOFrameAssembler assembler;
+    size_t recordCount = HMO_FRAME_ASSEMBLER_CAPACITY / HMO_RECORD_LENGTH + 10;
+    std::vector<uint8_t> bytes = Records(0, recordCount);
+    std::vector<uint8_t> output(HMO_FRAME_ASSEMBLER_CAPACITY);
+
+    HMOFrameAssemblerInit(&assembler);
+
+    // Odd chunk lengths so the ring wraps in the middle of records
+    for (size_t offset = 0; offset < bytes.size(); offset += 7) {
+        size_t length = std::min<size_t>(7, bytes.size() - offset);
+
+        HMOFrameAssemblerAppend(&assembler, bytes.data() + offset, length);
+    }
+
+    size_t length = HMOFrameAssemblerReadRecords(&assembler, output.data(), output.size());
+    size_t keptCount = length / HMO_RECORD_LENGTH;
+
+    ASSERT_EQ(0u, length % HMO_RECORD_LENGTH);
+    EXPECT_EQ(recordCount - keptCount, assembler.overflowCount);
+    EXPECT_EQ(HMO_FRAME_ASSEMBLER_CAPACITY / HMO_RECORD_LENGTH, keptCount);
+
+    // The most recent records survive, in order
+    output.resize(length);
+    EXPECT_EQ(std::vector<uint8_t>(bytes.end() - length, bytes.end()), output);
+}
+
+TEST(HMOFrameAssembler, ShortNotificationDropsPartialRecord) {
+    HMOFrameAssembler assembler;
+    std::vector<uint8_t> first = Records(1, 4);
+    std::vector<uint8_t> second = Records(5, 2);
+
+    HMOFrameAssemblerInit(&assembler);
+
+    // A full notification, then a batch end cut off two bytes into its third record
+    std::vector<uint8_t> truncated = Records(9, 3);
+
+    truncated.resize(12);
+
+    std::vector<std::vector<uint8_t>> flushes = Flushes(&assembler, { first, truncated, second });
+
+    ASSERT_EQ(2u, flushes.size());
+    EXPECT_EQ(30u, flushes[0].size());
+    EXPECT_EQ(std::vector<uint8_t>(first.begin(), first.end()), std::vector<uint8_t>(flushes[0].begin(), flushes[0].begin() + 20));
+    EXPECT_EQ(2u, assembler.droppedByteCount);
+
+    // The next batch starts on a record boundary again
+    EXPECT_EQ(second, flushes[1]);
+}
+
+TEST(HMOFrameAssembler, FlushesOnceSixtyFourRecordBytesAreBuffered) {
+    HMOFrameAssembler assembler;
+    std::vector<uint8_t> bytes = Records(1, 16);
+    std::vector<std::vector<uint8_t>> notifications;
+
+    HMOFrameAssemblerInit(&assembler);
+
+    for (size_t offset = 0; offset < bytes.size(); offset += 20) {
+        notifications.push_back(std::vector<uint8_t>(bytes.begin() + offset, bytes.begin() + offset + 20));
+    }
+
+    // Four full notifications make 80 bytes, the first time 64 is reached
+    std::vector<std::vector<uint8_t>> flushes = Flushes(&assembler, notifications);
+
+    ASSERT_EQ(1u, flushes.size());
+    EXPECT_EQ(bytes, flushes[0]);
+
+    // Three full notifications stay buffered until a short one ends the batch
+    flushes = Flushes(&assembler, { notifications[0], notifications[1], notifications[2] });
+    EXPECT_TRUE(flushes.empty());
+    EXPECT_EQ(60u, HMOFrameAssemblerRecordBytes(&assembler));
+
+    flushes = Flushes(&assembler, { std::vector<uint8_t>(bytes.begin(), bytes.begin() + 5) });
+    ASSERT_EQ(1u, flushes.size());
+    EXPECT_EQ(65u, flushes[0].size());
+}
@@ -0,0 +1,119 @@
+//
+//  HMORecordDecoderBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+extern "C" {
+#include "HMORecordDecoder.h"
+}
+
+namespace {
+
+const size_t HMORecordDecoderBenchmarkCount = 10000000;
+
+/** Temperature, pressure and altitude readings in turn */
+const std::vector<uint8_t> &RecordBytes() {
+    static std::vector<uint8_t> bytes;
+
+    if (bytes.empty()) {
+        bytes.resize(HMORecordDecoderBenchmarkCount * HMO_RECORD_LENGTH);
+
+        for (size_t i = 0; i < HMORecordDecoderBenchmarkCount; i++) {
+            uint8_t *record = &bytes[i * HMO_RECORD_LENGTH];
+
+            record[0] = HMO_RECORD_CODE_TEMPERATURE + (uint8_t)(i % 3);
+            record[1] = 0;
+            record[2] = 1;
+            record[3] = (uint8_t)(i >> 8);
+            record[4] = (uint8_t)i;
+        }
+    }
+
+    return bytes;
+}
+
+}
+
+/** 10M records decoded in one call */
+static void HMORecordDecodeAll(benchmark::State &state) {
+    const std::vector<uint8_t> &bytes = RecordBytes();
+    std::vector<uint8_t> types(HMORecordDecoderBenchmarkCount);
+    std::vector<double> timestamps(HMORecordDecoderBenchmarkCount);
+    std::vector<float> values(HMORecordDecoderBenchmarkCount);
+    HMORecordColumns columns = { types.data(), timestamps.data(), values.data(), HMORecordDecoderBenchmarkCount };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HMORecordDecode(bytes.data(), bytes.size(), 1.0, &columns));
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * HMORecordDecoderBenchmarkCount);
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(HMORecordDecodeAll)->Unit(benchmark::kMillisecond);
+
+/** 10M records decoded a frame assembler read at a time, as the app does */
+static void HMORecordDecodeBatches(benchmark::State &state) {
+    const std::vector<uint8_t> &bytes = RecordBytes();
+    uint8_t types[HMO_RECORD_BATCH_CAPACITY];
+    double timestamps[HMO_RECORD_BATCH_CAPACITY];
+    float values[HMO_RECORD_BATCH_CAPACITY];
+    HMORecordColumns columns = { types, timestamps, values, HMO_RECORD_BATCH_CAPACITY };
+    size_t batchLength = HMO_RECORD_BATCH_CAPACITY * HMO_RECORD_LENGTH;
+
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < bytes.size(); offset += batchLength) {
+            size_t length = std::min(batchLength, bytes.size() - offset);
+
+            benchmark::DoNotOptimize(HMORecordDecode(bytes.data() + offset, length, 1.0, &columns));
+            benchmark::ClobberMemory();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * HMORecordDecoderBenchmarkCount);
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(HMORecordDecodeBatches)->Unit(benchmark::kMillisecond);
+
+/** The loop bleDidReceiveData: used to run, shifting each value together and branching on the type, without the
+ per-record logging and label updates
+*/
+static void HMORecordDecodeShiftLoop(benchmark::State &state) {
+    const std::vector<uint8_t> &bytes = RecordBytes();
+    std::vector<float> values(HMORecordDecoderBenchmarkCount);
+
+    for (auto _ : state) {
+        const uint8_t *data = bytes.data();
+        size_t count = 0;
+        float temperature = 0;
+
+        for (size_t i = 0; i < bytes.size(); i += 5) {
+            float readingValue = (float)(int32_t)((uint32_t)data[i + 1] << 24 | data[i + 2] << 16 | data[i + 3] << 8 | data[i + 4]);
+
+            if (data[i] == HMO_RECORD_CODE_TEMPERATURE) {
+                temperature = readingValue;
+            } else if (data[i] == HMO_RECORD_CODE_PRESSURE) {
+                values[count++] = readingValue;
+            } else if (data[i] == HMO_RECORD_CODE_ALTITUDE) {
+                benchmark::DoNotOptimize(readingValue);
+            }
+        }
+
+        benchmark::DoNotOptimize(temperature);
+        benchmark::DoNotOptimize(count);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * HMORecordDecoderBenchmarkCount);
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+BENCHMARK(HMORecordDecodeShiftLoop)->Unit(benchmark::kMillisecond);
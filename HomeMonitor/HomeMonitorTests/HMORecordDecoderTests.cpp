@@ -0,0 +1,113 @@
+//
+//  HMORecordDecoderTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+extern "C" {
+#include "HMORecordDecoder.h"
+}
+
+namespace {
+
+void AppendRecord(std::vector<uint8_t> &bytes, uint8_t code, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    uint8_t record[HMO_RECORD_LENGTH] = { code, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+
+    for (uint8_t byte : record) {
+        bytes.push_back(byte);
+    }
+}
+
+struct Columns {
+    std::vector<uint8_t> types;
+    std::vector<double> timestamps;
+    std::vector<float> values;
+    HMORecordColumns columns;
+
+    explicit Columns(size_t capacity) : types(capacity), timestamps(capacity), values(capacity) {
+        columns = { types.data(), timestamps.data(), values.data(), capacity };
+    }
+};
+
+}
+
+TEST(HMORecordDecoder, DecodesKnownCodesAsSignedBigEndian) {
+    std::vector<uint8_t> bytes;
+    Columns output(8);
+
+    AppendRecord(bytes, HMO_RECORD_CODE_TEMPERATURE, 23);
+    AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, 99732);
+    AppendRecord(bytes, HMO_RECORD_CODE_ALTITUDE, -10);
+
+    ASSERT_EQ(3u, HMORecordDecode(bytes.data(), bytes.size(), 12.5, &output.columns));
+
+    EXPECT_EQ(kHMORecordTypeTemperature, output.types[0]);
+    EXPECT_EQ(kHMORecordTypePressure, output.types[1]);
+    EXPECT_EQ(kHMORecordTypeAltitude, output.types[2]);
+    EXPECT_FLOAT_EQ(23.0f, output.values[0]);
+    EXPECT_FLOAT_EQ(99732.0f, output.values[1]);
+    EXPECT_FLOAT_EQ(-10.0f, output.values[2]);
+
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_EQ(12.5, output.timestamps[i]);
+    }
+}
+
+TEST(HMORecordDecoder, SkipsUnknownCodes) {
+    std::vector<uint8_t> bytes;
+    Columns output(8);
+
+    AppendRecord(bytes, 0x00, 1);
+    AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, 2);
+    AppendRecord(bytes, 0x0D, 3);
+    AppendRecord(bytes, 0xFF, 4);
+    AppendRecord(bytes, HMO_RECORD_CODE_TEMPERATURE, 5);
+
+    ASSERT_EQ(2u, HMORecordDecode(bytes.data(), bytes.size(), 0, &output.columns));
+    EXPECT_EQ(kHMORecordTypePressure, output.types[0]);
+    EXPECT_FLOAT_EQ(2.0f, output.values[0]);
+    EXPECT_EQ(kHMORecordTypeTemperature, output.types[1]);
+    EXPECT_FLOAT_EQ(5.0f, output.values[1]);
+}
+
+TEST(HMORecordDecoder, StopsAtCapacityAndIgnoresPartialRecords) {
+    std::vector<uint8_t> bytes;
+    Columns output(2);
+
+    for (int32_t i = 0; i < 4; i++) {
+        AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, i);
+    }
+
+    EXPECT_EQ(2u, HMORecordDecode(bytes.data(), bytes.size(), 0, &output.columns));
+    EXPECT_FLOAT_EQ(1.0f, output.values[1]);
+
+    Columns wide(8);
+
+    EXPECT_EQ(3u, HMORecordDecode(bytes.data(), bytes.size() - 1, 0, &wide.columns));
+    EXPECT_EQ(0u, HMORecordDecode(bytes.data(), HMO_RECORD_LENGTH - 1, 0, &wide.columns));
+}
+
+TEST(HMORecordDecoder, MatchesShiftAndConvertOfEveryValue) {
+    std::vector<uint8_t> bytes;
+    std::vector<int32_t> expected;
+    Columns output(HMO_RECORD_BATCH_CAPACITY);
+    uint32_t state = 12345;
+
+    for (size_t i = 0; i < HMO_RECORD_BATCH_CAPACITY; i++) {
+        state = state * 1664525 + 1013904223;
+        expected.push_back((int32_t)state);
+        AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, (int32_t)state);
+    }
+
+    ASSERT_EQ(expected.size(), HMORecordDecode(bytes.data(), bytes.size(), 0, &output.columns));
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        EXPECT_EQ((float)expected[i], output.values[i]) << "record " << i;
+    }
+}
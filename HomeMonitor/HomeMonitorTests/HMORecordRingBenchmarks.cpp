@@ -0,0 +1,99 @@
+//
+//  HMORecordRingBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "HMORecordRing.h"
+}
+
+namespace {
+
+/** Same as the ingestion engine's ring */
+const size_t HMORecordRingBenchmarkCapacity = 4096;
+
+struct Columns {
+    std::vector<uint8_t> types;
+    std::vector<double> timestamps;
+    std::vector<float> values;
+    HMORecordColumns columns;
+
+    explicit Columns(size_t capacity) : types(capacity, 1), timestamps(capacity, 1.0), values(capacity, 1.0f) {
+        columns.types = types.data();
+        columns.timestamps = timestamps.data();
+        columns.values = values.data();
+        columns.capacity = capacity;
+    }
+};
+
+}
+
+/** A BLE read's worth of records pushed and popped on one thread */
+static void HMORecordRingPushPop(benchmark::State &state) {
+    HMORecordRing ring;
+    size_t batchSize = (size_t)state.range(0);
+    Columns input(batchSize), output(HMORecordRingBenchmarkCapacity);
+
+    HMORecordRingInit(&ring, HMORecordRingBenchmarkCapacity);
+
+    for (auto _ : state) {
+        HMORecordRingPush(&ring, &input.columns, batchSize);
+        benchmark::DoNotOptimize(HMORecordRingPop(&ring, &output.columns));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    HMORecordRingDestroy(&ring);
+}
+
+/** A producer thread pushing batches while the consumer drains, every iteration takes 65536 records */
+static void HMORecordRingTwoThreads(benchmark::State &state) {
+    HMORecordRing ring;
+    size_t batchSize = (size_t)state.range(0);
+    Columns output(256);
+    std::atomic<bool> isRunning(true);
+
+    HMORecordRingInit(&ring, HMORecordRingBenchmarkCapacity);
+
+    std::thread producer([&ring, &isRunning, batchSize] {
+        Columns input(batchSize);
+
+        while (isRunning.load(std::memory_order_relaxed)) {
+            if (HMORecordRingPush(&ring, &input.columns, batchSize) == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (auto _ : state) {
+        for (size_t popped = 0; popped < 65536;) {
+            size_t count = HMORecordRingPop(&ring, &output.columns);
+
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+
+            popped += count;
+        }
+    }
+
+    isRunning = false;
+    producer.join();
+
+    state.SetItemsProcessed(state.iterations() * 65536);
+    state.counters["dropped"] = (double)HMORecordRingDroppedCount(&ring);
+
+    HMORecordRingDestroy(&ring);
+}
+
+// 3 records fit in one BLE notification, 13 is a typical read, 96 a backlog
+BENCHMARK(HMORecordRingPushPop)->Arg(3)->Arg(13)->Arg(96);
+BENCHMARK(HMORecordRingTwoThreads)->Arg(13)->Arg(96)->UseRealTime();
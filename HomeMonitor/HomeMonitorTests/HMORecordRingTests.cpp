@@ -0,0 +1,211 @@
+//
+//  HMORecordRingTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "HMORecordRing.h"
+}
+
+namespace {
+
+/** Columns for a batch of records, each record carrying its sequence number in all three fields */
+struct Batch {
+    std::vector<uint8_t> types;
+    std::vector<double> timestamps;
+    std::vector<float> values;
+    HMORecordColumns columns;
+
+    explicit Batch(size_t capacity) : types(capacity), timestamps(capacity), values(capacity) {
+        columns.types = types.data();
+        columns.timestamps = timestamps.data();
+        columns.values = values.data();
+        columns.capacity = capacity;
+    }
+
+    void Fill(size_t first, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            types[i] = (uint8_t)((first + i) & 0xff);
+            timestamps[i] = (double)(first + i);
+            values[i] = (float)((first + i) % 1000);
+        }
+    }
+
+    void ExpectRecord(size_t index, size_t sequence) const {
+        ASSERT_EQ((uint8_t)(sequence & 0xff), types[index]);
+        ASSERT_EQ((double)sequence, timestamps[index]);
+        ASSERT_EQ((float)(sequence % 1000), values[index]);
+    }
+};
+
+}
+
+TEST(HMORecordRing, WrapsAroundInOrder) {
+    HMORecordRing ring;
+    Batch input(5), output(3);
+    size_t pushed = 0, popped = 0;
+
+    ASSERT_TRUE(HMORecordRingInit(&ring, 6));
+    EXPECT_EQ(7u, ring.mask);
+
+    // Batches of 5 in and 3 out cross the end of the storage at every offset
+    for (int lap = 0; lap < 40; lap++) {
+        input.Fill(pushed, 5);
+        pushed += HMORecordRingPush(&ring, &input.columns, 5);
+
+        for (size_t count; (count = HMORecordRingPop(&ring, &output.columns)) > 0; popped += count) {
+            for (size_t i = 0; i < count; i++) {
+                output.ExpectRecord(i, popped + i);
+            }
+        }
+    }
+
+    EXPECT_EQ(200u, pushed);
+    EXPECT_EQ(pushed, popped);
+    EXPECT_EQ(0u, HMORecordRingDroppedCount(&ring));
+
+    HMORecordRingDestroy(&ring);
+}
+
+TEST(HMORecordRing, DropsRecordsThatDoNotFit) {
+    HMORecordRing ring;
+    Batch input(6), output(8);
+
+    ASSERT_TRUE(HMORecordRingInit(&ring, 8));
+
+    input.Fill(0, 6);
+    EXPECT_EQ(6u, HMORecordRingPush(&ring, &input.columns, 6));
+
+    // Only the first two of the next batch fit, the rest of it is dropped
+    input.Fill(6, 6);
+    EXPECT_EQ(2u, HMORecordRingPush(&ring, &input.columns, 6));
+    EXPECT_EQ(4u, HMORecordRingDroppedCount(&ring));
+
+    EXPECT_EQ(0u, HMORecordRingPush(&ring, &input.columns, 1));
+    EXPECT_EQ(5u, HMORecordRingDroppedCount(&ring));
+
+    ASSERT_EQ(8u, HMORecordRingPop(&ring, &output.columns));
+
+    for (size_t i = 0; i < 8; i++) {
+        output.ExpectRecord(i, i);
+    }
+
+    EXPECT_EQ(0u, HMORecordRingPop(&ring, &output.columns));
+
+    HMORecordRingDestroy(&ring);
+}
+
+TEST(HMORecordRing, TwoThreadsLoseNothingWhenTheProducerRetries) {
+    const size_t recordCount = 2000000;
+    HMORecordRing ring;
+
+    ASSERT_TRUE(HMORecordRingInit(&ring, 100));
+
+    std::thread producer([&ring, recordCount] {
+        Batch input(37);
+
+        for (size_t next = 0; next < recordCount;) {
+            size_t count = std::min(next % 37 + 1, recordCount - next);
+
+            input.Fill(next, count);
+
+            for (size_t pushed = 0; pushed < count;) {
+                HMORecordColumns rest = { input.types.data() + pushed, input.timestamps.data() + pushed, input.values.data() + pushed, 37 };
+                size_t pushCount = HMORecordRingPush(&ring, &rest, count - pushed);
+
+                if (pushCount == 0) {
+                    std::this_thread::yield();
+                }
+
+                pushed += pushCount;
+            }
+
+            next += count;
+        }
+    });
+
+    Batch output(50);
+    size_t popped = 0;
+
+    while (popped < recordCount) {
+        size_t count = HMORecordRingPop(&ring, &output.columns);
+
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            output.ExpectRecord(i, popped + i);
+        }
+
+        popped += count;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(0u, HMORecordRingPop(&ring, &output.columns));
+
+    HMORecordRingDestroy(&ring);
+}
+
+TEST(HMORecordRing, TwoThreadsAccountForEveryRecord) {
+    const size_t recordCount = 2000000;
+    HMORecordRing ring;
+    size_t pushedCount = 0;
+
+    ASSERT_TRUE(HMORecordRingInit(&ring, 64));
+
+    // Like BLE reads, batches that do not fit are cut short and never retried
+    std::thread producer([&ring, &pushedCount, recordCount] {
+        Batch input(20);
+
+        for (size_t next = 0; next < recordCount;) {
+            size_t count = std::min(next % 20 + 1, recordCount - next);
+
+            input.Fill(next, count);
+            pushedCount += HMORecordRingPush(&ring, &input.columns, count);
+            next += count;
+
+            if (next % 1000 < 20) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    Batch output(16);
+    size_t popped = 0;
+    double lastSequence = -1;
+
+    // Every record is either popped or dropped in the end
+    while (popped + HMORecordRingDroppedCount(&ring) < recordCount) {
+        size_t count = HMORecordRingPop(&ring, &output.columns);
+
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+
+        // Drops leave gaps, but records never arrive out of order
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_GT(output.timestamps[i], lastSequence);
+            output.ExpectRecord(i, (size_t)output.timestamps[i]);
+            lastSequence = output.timestamps[i];
+        }
+
+        popped += count;
+    }
+
+    producer.join();
+
+    EXPECT_EQ(pushedCount, popped);
+    EXPECT_EQ(recordCount, popped + HMORecordRingDroppedCount(&ring));
+
+    HMORecordRingDestroy(&ring);
+}
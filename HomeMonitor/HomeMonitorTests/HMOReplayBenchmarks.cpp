@@ -0,0 +1,56 @@
+//
+//  HMOReplayBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+extern "C" {
+#include "HMOReplay.h"
+#include "HMOSimulator.h"
+}
+
+/** A minute of simulated boards replayed through the pipeline as fast as it goes, pressure sent at the given rate */
+static void HMOReplaySimulatedDevices(benchmark::State &state) {
+    HMOSimulatorOptions simulatorOptions;
+    HMOReplayReport report = {};
+
+    HMOSimulatorOptionsInit(&simulatorOptions);
+    simulatorOptions.deviceCount = (size_t)state.range(0);
+    simulatorOptions.rates[kHMORecordTypePressure] = (double)state.range(1);
+    simulatorOptions.duration = 60;
+    simulatorOptions.seed = 1;
+
+    uint64_t recordCount = 0, byteCount = 0;
+
+    for (auto _ : state) {
+        HMOSimulator simulator;
+        HMOReplayOptions options;
+
+        if (!HMOSimulatorInit(&simulator, &simulatorOptions)) {
+            state.SkipWithError("Simulator could not be allocated");
+            break;
+        }
+
+        HMOReplayOptionsInit(&options, HMOSimulatorNext, &simulator);
+
+        if (!HMOReplayRun(&options, &report)) {
+            state.SkipWithError("Replay could not be allocated");
+        }
+
+        HMOSimulatorDestroy(&simulator);
+
+        recordCount += report.recordCount;
+        byteCount += report.byteCount;
+    }
+
+    state.SetItemsProcessed((int64_t)recordCount);
+    state.SetBytesProcessed((int64_t)byteCount);
+    state.counters["p99us"] = report.latency99 * 1e6;
+    state.counters["dropped"] = (double)(report.overflowCount + report.ringDroppedCount);
+}
+
+// One board as the app ships, fifty of them, and boards sampling pressure at 1 kHz
+BENCHMARK(HMOReplaySimulatedDevices)->Args({ 1, 10 })->Args({ 50, 10 })->Args({ 5, 1000 })->Unit(benchmark::kMillisecond);
@@ -0,0 +1,235 @@
+//
+//  HMOReplayTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "HMORecordDecoder.h"
+#include "HMOReplay.h"
+}
+
+namespace {
+
+void AppendRecord(std::vector<uint8_t> &bytes, uint8_t code, int32_t value) {
+    uint32_t bits = (uint32_t)value;
+    uint8_t record[HMO_RECORD_LENGTH] = { code, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+
+    for (uint8_t byte : record) {
+        bytes.push_back(byte);
+    }
+}
+
+/** Notifications handed out in order from memory */
+struct Notifications {
+    std::vector<HMOCaptureNotification> notifications;
+    size_t position = 0;
+
+    void Append(double receiveTime, const uint8_t *bytes, size_t length) {
+        HMOCaptureNotification notification;
+
+        notification.receiveTime = receiveTime;
+        notification.length = length;
+        memcpy(notification.bytes, bytes, length);
+        notifications.push_back(notification);
+    }
+
+    static bool Next(void *context, HMOCaptureNotification *notification) {
+        Notifications *self = static_cast<Notifications *>(context);
+
+        if (self->position == self->notifications.size()) {
+            return false;
+        }
+
+        *notification = self->notifications[self->position++];
+
+        return true;
+    }
+};
+
+/** Batches of five records, two of them pressure, sent as a full notification and a 5 byte one 2 ms apart.
+ lastLength cuts the last notification of every batch short. */
+Notifications Batches(size_t count, int32_t pressureOffset = 0, size_t lastLength = 5) {
+    Notifications batches;
+    double receiveTime = 100.0;
+
+    for (size_t i = 0; i < count; i++) {
+        std::vector<uint8_t> bytes;
+
+        AppendRecord(bytes, HMO_RECORD_CODE_TEMPERATURE, 21);
+        AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, 99700 + (int32_t)(i % 13) + pressureOffset);
+        AppendRecord(bytes, HMO_RECORD_CODE_ALTITUDE, 120);
+        AppendRecord(bytes, HMO_RECORD_CODE_PRESSURE, 99701 + (int32_t)(i % 7));
+        AppendRecord(bytes, HMO_RECORD_CODE_ALTITUDE, 121);
+
+        batches.Append(receiveTime, bytes.data(), 20);
+        batches.Append(receiveTime + 0.001, bytes.data() + 20, lastLength);
+        receiveTime += 0.002;
+    }
+
+    return batches;
+}
+
+HMOReplayReport Replay(Notifications notifications, double speed = 0) {
+    HMOReplayOptions options;
+    HMOReplayReport report;
+
+    HMOReplayOptionsInit(&options, Notifications::Next, &notifications);
+    options.speed = speed;
+
+    EXPECT_TRUE(HMOReplayRun(&options, &report));
+
+    return report;
+}
+
+class CaptureFile {
+public:
+    const std::string path;
+
+    CaptureFile(const char *name, const Notifications &notifications) : path(testing::TempDir() + name) {
+        HMOCaptureWriter writer;
+
+        unlink(path.c_str());
+        EXPECT_TRUE(HMOCaptureWriterOpen(&writer, path.c_str()));
+
+        for (const HMOCaptureNotification &notification : notifications.notifications) {
+            EXPECT_TRUE(HMOCaptureWriterAppend(&writer, notification.receiveTime, notification.bytes, notification.length));
+        }
+
+        EXPECT_TRUE(HMOCaptureWriterClose(&writer));
+    }
+
+    ~CaptureFile() {
+        unlink(path.c_str());
+    }
+
+    HMOReplayReport Replay(bool *isDamaged) const {
+        HMOCaptureReader reader;
+        HMOReplayOptions options;
+        HMOReplayReport report;
+
+        EXPECT_TRUE(HMOCaptureReaderOpen(&reader, path.c_str()));
+        HMOReplayOptionsInit(&options, HMOReplayCaptureSourceNext, &reader);
+
+        EXPECT_TRUE(HMOReplayRun(&options, &report));
+
+        *isDamaged = reader.isDamaged;
+        HMOCaptureReaderClose(&reader);
+
+        return report;
+    }
+};
+
+}
+
+TEST(HMOReplay, CountsEveryRecord) {
+    HMOReplayReport report = Replay(Batches(2000));
+
+    EXPECT_EQ(4000u, report.notificationCount);
+    EXPECT_EQ(50000u, report.byteCount);
+    EXPECT_EQ(2000u, report.batchCount);
+    EXPECT_EQ(10000u, report.recordCount);
+    EXPECT_EQ(4000u, report.pressureCount);
+    EXPECT_EQ(2000u, report.pathCount);
+    EXPECT_LE(report.pathPointCount, report.pathCount * 20);
+    EXPECT_EQ(0u, report.overflowCount);
+    EXPECT_EQ(0u, report.droppedByteCount);
+    EXPECT_EQ(0u, report.ringDroppedCount);
+
+    EXPECT_LE(report.latencyMedian, report.latency90);
+    EXPECT_LE(report.latency99, report.latencyMax);
+}
+
+TEST(HMOReplay, CaptureReplaysLikeItsNotifications) {
+    Notifications notifications = Batches(500);
+    CaptureFile capture("HMOReplayCapture.cap", notifications);
+    HMOReplayReport expected = Replay(notifications);
+    bool isDamaged;
+    HMOReplayReport report = capture.Replay(&isDamaged);
+
+    EXPECT_FALSE(isDamaged);
+    EXPECT_EQ(expected.notificationCount, report.notificationCount);
+    EXPECT_EQ(expected.recordCount, report.recordCount);
+    EXPECT_EQ(expected.pathPointCount, report.pathPointCount);
+    EXPECT_EQ(expected.pathChecksum, report.pathChecksum);
+}
+
+TEST(HMOReplay, ChecksumIsTheSameAtAnySpeed) {
+    // A second of batches, replayed in a tenth of that
+    HMOReplayReport fastest = Replay(Batches(500));
+    HMOReplayReport timed = Replay(Batches(500), 10);
+
+    EXPECT_EQ(fastest.pathChecksum, timed.pathChecksum);
+    EXPECT_EQ(fastest.recordCount, timed.recordCount);
+    EXPECT_GE(timed.elapsedTime, 0.09);
+
+    EXPECT_EQ(fastest.pathChecksum, Replay(Batches(500)).pathChecksum);
+
+    // But not for different readings
+    EXPECT_NE(fastest.pathChecksum, Replay(Batches(500, 1)).pathChecksum);
+}
+
+TEST(HMOReplay, CutShortNotificationsLoseTheirPartialRecord) {
+    HMOReplayReport report = Replay(Batches(100, 0, 3));
+
+    // Every batch still starts on a record boundary
+    EXPECT_EQ(400u, report.recordCount);
+    EXPECT_EQ(200u, report.pressureCount);
+    EXPECT_EQ(300u, report.droppedByteCount);
+}
+
+TEST(HMOReplay, DamagedCaptureReplaysItsIntactEntries) {
+    CaptureFile capture("HMOReplayDamaged.cap", Batches(100));
+    FILE *file = fopen(capture.path.c_str(), "rb");
+
+    ASSERT_NE(nullptr, file);
+    fseek(file, 0, SEEK_END);
+
+    long length = ftell(file);
+
+    fclose(file);
+    ASSERT_EQ(0, truncate(capture.path.c_str(), length - 3));
+
+    bool isDamaged;
+    HMOReplayReport report = capture.Replay(&isDamaged);
+
+    // The last batch never ends, so its full notification is never decoded
+    EXPECT_TRUE(isDamaged);
+    EXPECT_EQ(199u, report.notificationCount);
+    EXPECT_EQ(99u, report.batchCount);
+    EXPECT_EQ(495u, report.recordCount);
+}
+
+TEST(HMOReplay, FailedAllocationIsReported) {
+    bool isReplayed = false;
+
+    for (long allowedCount = 0; !isReplayed; allowedCount++) {
+        Notifications notifications = Batches(2000);
+        HMOReplayOptions options;
+        HMOReplayReport report;
+
+        HMOReplayOptionsInit(&options, Notifications::Next, &notifications);
+
+        {
+            HMOTestAllocationFailure failure(allowedCount);
+
+            isReplayed = HMOReplayRun(&options, &report);
+        }
+
+        // Fails at the pipeline, its series and the latencies growing, until every allocation succeeds
+        EXPECT_TRUE(allowedCount > 0 || !isReplayed);
+        ASSERT_LT(allowedCount, 100);
+    }
+}
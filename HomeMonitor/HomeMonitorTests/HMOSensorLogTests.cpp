@@ -0,0 +1,569 @@
+//
+//  HMOSensorLogTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "HMOTestFileOperations.h"
+
+extern "C" {
+#include "HMOChecksum.h"
+#include "HMOSensorLog.h"
+}
+
+namespace {
+
+/** Can not be stored as a difference from a pressure reading, so it starts a new segment */
+const float HMOSensorLogTestSegmentBreakingValue = 1e-45f;
+
+const size_t HMOSensorLogTestTimestampColumnOffset = HMO_SENSOR_LOG_HEADER_SLOT_SIZE * 2;
+
+struct Sample {
+    double timestamp;
+    float value;
+
+    bool operator==(const Sample &other) const {
+        return timestamp == other.timestamp && value == other.value;
+    }
+};
+
+void PrintTo(const Sample &sample, std::ostream *stream) {
+    *stream << "(" << sample.timestamp << ", " << sample.value << ")";
+}
+
+double SampleTimestamp(size_t index) {
+    return 1000.0 + index * 0.1;
+}
+
+/** Samples more than 49 days apart can not share a segment, so every period samples start a new one */
+double SegmentedTimestamp(size_t index, size_t period) {
+    return SampleTimestamp(index) + (double)(index / period) * 5e6;
+}
+
+float SampleValue(size_t index) {
+    return 101325.0f + (float)(index % 7) * 0.25f;
+}
+
+std::string TemporaryPath(const char *name) {
+    std::string path = testing::TempDir() + name;
+
+    unlink(path.c_str());
+
+    return path;
+}
+
+std::vector<uint8_t> ReadFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string &path, const std::vector<uint8_t> &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    file.write((const char *)bytes.data(), (std::streamsize)bytes.size());
+}
+
+std::vector<Sample> ReadSamples(const HMOSensorLog *log) {
+    std::vector<Sample> samples;
+    std::vector<double> timestamps(HMO_SENSOR_LOG_SEGMENT_CAPACITY);
+    std::vector<float> values(HMO_SENSOR_LOG_SEGMENT_CAPACITY);
+
+    for (size_t segment = 0; segment < HMOSensorLogSegmentCount(log); segment++) {
+        size_t count = HMOSensorLogReadSegment(log, segment, 0, HMO_SENSOR_LOG_SEGMENT_CAPACITY, timestamps.data(), values.data());
+
+        for (size_t i = 0; i < count; i++) {
+            samples.push_back({ timestamps[i], values[i] });
+        }
+    }
+
+    return samples;
+}
+
+/** Samples of the log at path after opening it, as the app finds them after a crash */
+std::vector<Sample> RecoveredSamples(const std::string &path) {
+    HMOSensorLog log;
+    std::vector<Sample> samples;
+
+    if (!HMOSensorLogOpen(&log, path.c_str())) {
+        ADD_FAILURE() << "Could not open " << path;
+        return samples;
+    }
+
+    samples = ReadSamples(&log);
+    HMOSensorLogClose(&log);
+
+    return samples;
+}
+
+std::vector<Sample> Prefix(const std::vector<Sample> &samples, size_t count) {
+    return std::vector<Sample>(samples.begin(), samples.begin() + count);
+}
+
+size_t SyncCount(const std::vector<HMOTestFileOperation> &operations) {
+    return (size_t)std::count_if(operations.begin(), operations.end(), [](const HMOTestFileOperation &operation) {
+        return operation.type == HMOTestFileOperation::kSync;
+    });
+}
+
+/** How much of an operation reached the disk before the crash */
+enum OperationExtent {
+    kOperationSkipped,
+    kOperationHalfDone,
+    kOperationAllButOneByte,
+    kOperationDone,
+    kOperationExtentCount
+};
+
+void Apply(std::vector<uint8_t> &image, const HMOTestFileOperation &operation, OperationExtent extent) {
+    if (extent == kOperationSkipped) {
+        return;
+    }
+
+    if (operation.type == HMOTestFileOperation::kTruncate) {
+        size_t length = (size_t)operation.offset;
+
+        // An interrupted extension leaves the file somewhere between its old and new length
+        if (length > image.size() && extent == kOperationHalfDone) {
+            length = image.size() + (length - image.size()) / 2;
+        } else if (length > image.size() && extent == kOperationAllButOneByte) {
+            length -= 1;
+        }
+
+        image.resize(length);
+    } else if (operation.type == HMOTestFileOperation::kWrite) {
+        size_t length = operation.bytes.size();
+
+        if (extent == kOperationHalfDone) {
+            length /= 2;
+        } else if (extent == kOperationAllButOneByte) {
+            length -= 1;
+        }
+
+        size_t offset = (size_t)operation.offset;
+
+        if (image.size() < offset + length) {
+            image.resize(offset + length);
+        }
+
+        std::copy(operation.bytes.begin(), operation.bytes.begin() + (ptrdiff_t)length, image.begin() + (ptrdiff_t)offset);
+    }
+}
+
+HMOSensorLogSegmentHeader SlotHeader(const std::vector<uint8_t> &image, size_t segment, size_t slot) {
+    HMOSensorLogSegmentHeader header;
+
+    memcpy(&header, image.data() + segment * HMO_SENSOR_LOG_SEGMENT_SIZE + slot * HMO_SENSOR_LOG_HEADER_SLOT_SIZE, sizeof(header));
+
+    return header;
+}
+
+/** Stores a header in a slot with a checksum that matches it */
+void SetSlotHeader(std::vector<uint8_t> &image, size_t segment, size_t slot, HMOSensorLogSegmentHeader header) {
+    header.checksum = HMOChecksumUpdate(0, &header, offsetof(HMOSensorLogSegmentHeader, checksum));
+
+    memcpy(image.data() + segment * HMO_SENSOR_LOG_SEGMENT_SIZE + slot * HMO_SENSOR_LOG_HEADER_SLOT_SIZE, &header, sizeof(header));
+}
+
+uint8_t &TimestampByte(std::vector<uint8_t> &image, size_t segment, size_t sample) {
+    return image[segment * HMO_SENSOR_LOG_SEGMENT_SIZE + HMOSensorLogTestTimestampColumnOffset + sample * 4];
+}
+
+/** A one segment log committed in two batches, 10 samples in slot 0 and 20 in slot 1 */
+std::vector<uint8_t> TwoBatchLog(const std::string &path, std::vector<Sample> *samples) {
+    HMOSensorLog log;
+
+    EXPECT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+    log.syncInterval = 0;
+
+    for (size_t i = 0; i < 20; i++) {
+        EXPECT_TRUE(HMOSensorLogAppend(&log, SampleTimestamp(i), SampleValue(i)));
+
+        if (i == 9) {
+            EXPECT_TRUE(HMOSensorLogSync(&log));
+        }
+    }
+
+    EXPECT_TRUE(HMOSensorLogSync(&log));
+    *samples = ReadSamples(&log);
+    HMOSensorLogClose(&log);
+
+    std::vector<uint8_t> image = ReadFile(path);
+
+    EXPECT_EQ((size_t)HMO_SENSOR_LOG_SEGMENT_SIZE, image.size());
+    EXPECT_EQ(1u, SlotHeader(image, 0, 0).sequence);
+    EXPECT_EQ(10u, SlotHeader(image, 0, 0).count);
+    EXPECT_EQ(2u, SlotHeader(image, 0, 1).sequence);
+    EXPECT_EQ(20u, SlotHeader(image, 0, 1).count);
+
+    return image;
+}
+
+}
+
+TEST(HMOSensorLog, ReadsBackAcrossSegmentsAndReopens) {
+    std::string path = TemporaryPath("HMOSensorLogReadBack.log");
+    HMOSensorLog log;
+    std::vector<Sample> samples;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+    EXPECT_EQ(-INFINITY, HMOSensorLogLastTimestamp(&log));
+
+    for (size_t i = 0; i < 50; i++) {
+        ASSERT_TRUE(HMOSensorLogAppend(&log, SegmentedTimestamp(i, 20), SampleValue(i)));
+        samples.push_back({ HMOSensorLogLastTimestamp(&log), SampleValue(i) });
+    }
+
+    EXPECT_EQ(3u, HMOSensorLogSegmentCount(&log));
+
+    // Pending samples read back the same as synced ones
+    for (size_t i = 0; i < samples.size(); i++) {
+        EXPECT_NEAR(SegmentedTimestamp(i, 20), samples[i].timestamp, 0.0005);
+    }
+
+    EXPECT_EQ(samples, ReadSamples(&log));
+
+    double timestamps[8];
+    float values[8];
+
+    ASSERT_EQ(8u, HMOSensorLogReadLatest(&log, 8, timestamps, values));
+    EXPECT_EQ(samples[42].timestamp, timestamps[0]);
+    EXPECT_EQ(samples[49].value, values[7]);
+
+    EXPECT_EQ(1u, HMOSensorLogFindSegment(&log, samples[25].timestamp));
+    EXPECT_EQ(5u, HMOSensorLogFindSample(&log, 1, samples[25].timestamp));
+
+    HMOSensorLogClose(&log);
+
+    EXPECT_EQ(samples, RecoveredSamples(path));
+
+    unlink(path.c_str());
+}
+
+TEST(HMOSensorLog, AcceptsSamplesWithinTheLastStoredMillisecond) {
+    std::string path = TemporaryPath("HMOSensorLogRounding.log");
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+
+    ASSERT_TRUE(HMOSensorLogAppend(&log, 100.0, 1));
+    ASSERT_TRUE(HMOSensorLogAppend(&log, 100.0006, 2));
+    EXPECT_DOUBLE_EQ(100.001, HMOSensorLogLastTimestamp(&log));
+
+    // Newer than the last sample, though earlier than it reads back
+    EXPECT_TRUE(HMOSensorLogAppend(&log, 100.0009, 3));
+
+    // Also when it starts a new segment, it is stored on the millisecond of the last one
+    EXPECT_TRUE(HMOSensorLogAppend(&log, 100.0008, HMOSensorLogTestSegmentBreakingValue));
+    EXPECT_EQ(2u, HMOSensorLogSegmentCount(&log));
+
+    // Earlier once rounded
+    EXPECT_FALSE(HMOSensorLogAppend(&log, 100.0004, 4));
+
+    std::vector<Sample> samples = ReadSamples(&log);
+
+    ASSERT_EQ(4u, samples.size());
+    EXPECT_EQ(100.0, samples[0].timestamp);
+
+    for (size_t i = 1; i < samples.size(); i++) {
+        EXPECT_EQ(samples[1].timestamp, samples[i].timestamp);
+    }
+
+    HMOSensorLogClose(&log);
+    unlink(path.c_str());
+}
+
+TEST(HMOSensorLog, CrashAtAnyPointKeepsTheDurablePrefix) {
+    const size_t sampleCount = 40;
+    std::string path = TemporaryPath("HMOSensorLogCrash.log");
+    std::string crashPath = TemporaryPath("HMOSensorLogCrashed.log");
+    std::vector<HMOTestFileOperation> operations;
+    // Samples committed by each fsync
+    std::vector<size_t> durableCounts;
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+    log.syncInterval = 4;
+
+    {
+        HMOTestFileOperationRecorder recorder;
+
+        for (size_t i = 0; i < sampleCount; i++) {
+            size_t syncCount = SyncCount(recorder.operations());
+            ASSERT_TRUE(HMOSensorLogAppend(&log, SegmentedTimestamp(i, 11), SampleValue(i)));
+
+            size_t pendingCount = log.hasActive ? log.activeHeader.count - log.syncedCount : 0;
+
+            ASSERT_LE(SyncCount(recorder.operations()), syncCount + 1);
+
+            if (SyncCount(recorder.operations()) > syncCount) {
+                durableCounts.push_back(i + 1 - pendingCount);
+            }
+        }
+
+        if (log.activeHeader.count > log.syncedCount) {
+            ASSERT_TRUE(HMOSensorLogSync(&log));
+            durableCounts.push_back(sampleCount);
+        }
+
+        operations = recorder.operations();
+    }
+
+    std::vector<Sample> samples = ReadSamples(&log);
+
+    ASSERT_EQ(sampleCount, samples.size());
+    ASSERT_EQ(4u, HMOSensorLogSegmentCount(&log));
+    ASSERT_EQ(durableCounts.size(), SyncCount(operations));
+
+    HMOSensorLogClose(&log);
+
+    // Writes between two fsyncs can reach the disk in any order and partly, the file holds all the writes before them
+    std::vector<uint8_t> durableImage;
+    size_t previousCount = 0, windowStart = 0, window = 0;
+
+    for (size_t end = 0; end < operations.size(); end++) {
+        if (operations[end].type != HMOTestFileOperation::kSync) {
+            continue;
+        }
+
+        std::vector<uint8_t> completeImage = durableImage;
+        size_t stateCount = 1;
+
+        for (size_t i = windowStart; i < end; i++) {
+            Apply(completeImage, operations[i], kOperationDone);
+            stateCount *= kOperationExtentCount;
+        }
+
+        for (size_t state = 0; state < stateCount; state++) {
+            std::vector<uint8_t> image = durableImage;
+
+            for (size_t i = windowStart, extents = state; i < end; i++, extents /= kOperationExtentCount) {
+                Apply(image, operations[i], (OperationExtent)(extents % kOperationExtentCount));
+            }
+
+            // A partial write can leave the same bytes as a whole one when the rest already matched
+            size_t expectedCount = (image == completeImage) ? durableCounts[window] : previousCount;
+
+            WriteFile(crashPath, image);
+            ASSERT_EQ(Prefix(samples, expectedCount), RecoveredSamples(crashPath)) << "fsync " << window << ", state " << state;
+
+            // The recovered log takes new samples, and reopens with them
+            HMOSensorLog recovered;
+
+            ASSERT_TRUE(HMOSensorLogOpen(&recovered, crashPath.c_str()));
+            ASSERT_TRUE(HMOSensorLogAppend(&recovered, SegmentedTimestamp(expectedCount, 11), SampleValue(expectedCount)));
+            HMOSensorLogClose(&recovered);
+
+            std::vector<Sample> continued = RecoveredSamples(crashPath);
+
+            ASSERT_EQ(expectedCount + 1, continued.size()) << "fsync " << window << ", state " << state;
+            EXPECT_EQ(Prefix(samples, expectedCount), Prefix(continued, expectedCount));
+        }
+
+        durableImage = completeImage;
+        previousCount = durableCounts[window];
+        windowStart = end + 1;
+        window += 1;
+    }
+
+    EXPECT_EQ(durableCounts.size(), window);
+
+    unlink(path.c_str());
+    unlink(crashPath.c_str());
+}
+
+TEST(HMOSensorLog, TruncatedFileKeepsItsWholeSegments) {
+    std::string path = TemporaryPath("HMOSensorLogTruncated.log");
+    std::string truncatedPath = TemporaryPath("HMOSensorLogTruncatedCopy.log");
+    std::vector<size_t> segmentEnds;
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+
+    for (size_t i = 0; i < 60; i++) {
+        ASSERT_TRUE(HMOSensorLogAppend(&log, SegmentedTimestamp(i, 13), SampleValue(i)));
+    }
+
+    ASSERT_TRUE(HMOSensorLogSync(&log));
+
+    std::vector<Sample> samples = ReadSamples(&log);
+
+    for (size_t segment = 0; segment < HMOSensorLogSegmentCount(&log); segment++) {
+        size_t previousEnd = segmentEnds.empty() ? 0 : segmentEnds.back();
+
+        segmentEnds.push_back(previousEnd + HMOSensorLogSegmentHeaderAt(&log, segment)->count);
+    }
+
+    HMOSensorLogClose(&log);
+
+    std::vector<uint8_t> image = ReadFile(path);
+
+    ASSERT_EQ(segmentEnds.size() * HMO_SENSOR_LOG_SEGMENT_SIZE, image.size());
+
+    for (size_t quarter = 0; quarter <= image.size(); quarter += HMO_SENSOR_LOG_SEGMENT_SIZE / 4) {
+        for (size_t length : { quarter - 1, quarter, quarter + 1 }) {
+            if (length > image.size()) {
+                continue;
+            }
+
+            size_t wholeSegmentCount = length / HMO_SENSOR_LOG_SEGMENT_SIZE;
+            size_t expectedCount = (wholeSegmentCount == 0) ? 0 : segmentEnds[wholeSegmentCount - 1];
+
+            WriteFile(truncatedPath, std::vector<uint8_t>(image.begin(), image.begin() + (ptrdiff_t)length));
+            ASSERT_EQ(Prefix(samples, expectedCount), RecoveredSamples(truncatedPath)) << "length " << length;
+            EXPECT_EQ(wholeSegmentCount * HMO_SENSOR_LOG_SEGMENT_SIZE, ReadFile(truncatedPath).size());
+        }
+    }
+
+    unlink(path.c_str());
+    unlink(truncatedPath.c_str());
+}
+
+TEST(HMOSensorLog, NewerHeaderWithDamagedColumnsIsDropped) {
+    std::string path = TemporaryPath("HMOSensorLogDamagedColumns.log");
+    std::vector<Sample> samples;
+    std::vector<uint8_t> image = TwoBatchLog(path, &samples);
+
+    // Only the second batch covers sample 15
+    TimestampByte(image, 0, 15) ^= 0x01;
+    WriteFile(path, image);
+
+    EXPECT_EQ(Prefix(samples, 10), RecoveredSamples(path));
+
+    // The newer slot is cleared, so a reader mapping the file can not pick it
+    std::vector<uint8_t> recoveredImage = ReadFile(path);
+
+    EXPECT_TRUE(std::all_of(recoveredImage.begin() + HMO_SENSOR_LOG_HEADER_SLOT_SIZE, recoveredImage.begin() + HMO_SENSOR_LOG_HEADER_SLOT_SIZE * 2, [](uint8_t byte) {
+        return byte == 0;
+    }));
+
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+
+    for (size_t i = 10; i < 15; i++) {
+        ASSERT_TRUE(HMOSensorLogAppend(&log, SampleTimestamp(i), SampleValue(i)));
+    }
+
+    HMOSensorLogClose(&log);
+
+    EXPECT_EQ(Prefix(samples, 15), RecoveredSamples(path));
+
+    unlink(path.c_str());
+}
+
+TEST(HMOSensorLog, HeaderWithABadChecksumIsIgnored) {
+    std::string path = TemporaryPath("HMOSensorLogBadChecksum.log");
+    std::vector<Sample> samples;
+    std::vector<uint8_t> image = TwoBatchLog(path, &samples);
+    size_t fieldOffsets[] = {
+        offsetof(HMOSensorLogSegmentHeader, sequence),
+        offsetof(HMOSensorLogSegmentHeader, count),
+        offsetof(HMOSensorLogSegmentHeader, lastTimestamp),
+        offsetof(HMOSensorLogSegmentHeader, valueChecksum),
+        offsetof(HMOSensorLogSegmentHeader, checksum)
+    };
+
+    for (size_t fieldOffset : fieldOffsets) {
+        // A damaged newer header falls back to the older one
+        std::vector<uint8_t> damaged = image;
+
+        damaged[HMO_SENSOR_LOG_HEADER_SLOT_SIZE + fieldOffset] ^= 0x04;
+        WriteFile(path, damaged);
+        EXPECT_EQ(Prefix(samples, 10), RecoveredSamples(path)) << "field at " << fieldOffset;
+
+        // A damaged older header does not matter
+        damaged = image;
+        damaged[fieldOffset] ^= 0x04;
+        WriteFile(path, damaged);
+        EXPECT_EQ(samples, RecoveredSamples(path)) << "field at " << fieldOffset;
+    }
+
+    unlink(path.c_str());
+}
+
+TEST(HMOSensorLog, NewestSequenceWinsAcrossWrapAround) {
+    std::string path = TemporaryPath("HMOSensorLogSequence.log");
+    std::vector<Sample> samples;
+    std::vector<uint8_t> image = TwoBatchLog(path, &samples);
+    HMOSensorLogSegmentHeader first = SlotHeader(image, 0, 0);
+    HMOSensorLogSegmentHeader second = SlotHeader(image, 0, 1);
+
+    // Slot 0 is older, though its sequence is higher
+    first.sequence = UINT32_MAX;
+    second.sequence = 0;
+    SetSlotHeader(image, 0, 0, first);
+    SetSlotHeader(image, 0, 1, second);
+    WriteFile(path, image);
+
+    EXPECT_EQ(samples, RecoveredSamples(path));
+
+    // The next batch goes to slot 0 and becomes the newest
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+    ASSERT_TRUE(HMOSensorLogAppend(&log, SampleTimestamp(20), SampleValue(20)));
+    HMOSensorLogClose(&log);
+
+    std::vector<uint8_t> appendedImage = ReadFile(path);
+
+    EXPECT_EQ(1u, SlotHeader(appendedImage, 0, 0).sequence);
+    EXPECT_EQ(21u, SlotHeader(appendedImage, 0, 0).count);
+    EXPECT_EQ(21u, RecoveredSamples(path).size());
+
+    // The other way around, slot 1 is older
+    first.sequence = 0;
+    second.sequence = UINT32_MAX;
+    SetSlotHeader(image, 0, 0, first);
+    SetSlotHeader(image, 0, 1, second);
+    WriteFile(path, image);
+
+    EXPECT_EQ(Prefix(samples, 10), RecoveredSamples(path));
+
+    unlink(path.c_str());
+}
+
+TEST(HMOSensorLog, SegmentWithoutATrustedHeaderIsDiscarded) {
+    std::string path = TemporaryPath("HMOSensorLogDiscarded.log");
+    HMOSensorLog log;
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+
+    for (size_t i = 0; i < 10; i++) {
+        ASSERT_TRUE(HMOSensorLogAppend(&log, SampleTimestamp(i), (i == 5) ? HMOSensorLogTestSegmentBreakingValue : SampleValue(i)));
+    }
+
+    std::vector<Sample> samples = ReadSamples(&log);
+
+    HMOSensorLogClose(&log);
+
+    // Both headers of the second segment cover its first sample
+    std::vector<uint8_t> image = ReadFile(path);
+
+    ASSERT_EQ(2u * HMO_SENSOR_LOG_SEGMENT_SIZE, image.size());
+    TimestampByte(image, 1, 0) ^= 0x01;
+    WriteFile(path, image);
+
+    ASSERT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+    EXPECT_EQ(1u, log.discardedSegmentCount);
+    EXPECT_EQ(Prefix(samples, 5), ReadSamples(&log));
+    HMOSensorLogClose(&log);
+
+    EXPECT_EQ((size_t)HMO_SENSOR_LOG_SEGMENT_SIZE, ReadFile(path).size());
+
+    unlink(path.c_str());
+}
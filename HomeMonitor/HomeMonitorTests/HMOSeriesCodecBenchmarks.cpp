@@ -0,0 +1,147 @@
+//
+//  HMOSeriesCodecBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "HMOSeriesCodec.h"
+}
+
+namespace {
+
+const size_t HMOSeriesCodecBenchmarkCount = 1 << 20;
+
+/** A raw sample, the double timestamp and float value the codec is fed */
+const size_t HMOSeriesCodecBenchmarkRawSampleSize = 12;
+
+struct Series {
+    std::vector<double> timestamps;
+    std::vector<float> values;
+    std::vector<uint8_t> blocks;
+};
+
+/** Encodes series into blocks, back to back */
+void EncodeSeries(HMOSeriesEncoder *encoder, const Series &series, std::vector<uint8_t> &blocks) {
+    size_t length;
+
+    blocks.clear();
+
+    for (size_t i = 0; i < series.timestamps.size(); i++) {
+        if (!HMOSeriesEncoderAppend(encoder, series.timestamps[i], series.values[i])) {
+            const uint8_t *block = HMOSeriesEncoderFinishBlock(encoder, &length);
+
+            blocks.insert(blocks.end(), block, block + length);
+            HMOSeriesEncoderAppend(encoder, series.timestamps[i], series.values[i]);
+        }
+    }
+
+    const uint8_t *block = HMOSeriesEncoderFinishBlock(encoder, &length);
+
+    blocks.insert(blocks.end(), block, block + length);
+}
+
+/** 1 Hz readings with jitter of temperature, pressure and altitude, at the resolution the board reports them */
+const Series &SensorSeries(int64_t type) {
+    static Series series[3];
+    static const double startValues[] = { 21.5, 99700, 120 };
+    static const double steps[] = { 0.01, 2, 0.15 };
+    static const float resolutions[] = { 0.01f, 1, 0.1f };
+
+    Series &typeSeries = series[type];
+
+    if (typeSeries.timestamps.empty()) {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<double> jitter(-0.01, 0.01);
+        std::uniform_real_distribution<double> change(-steps[type], steps[type]);
+        double timestamp = 4e8, value = startValues[type];
+
+        for (size_t i = 0; i < HMOSeriesCodecBenchmarkCount; i++) {
+            timestamp += 1.0 + jitter(random);
+            value += change(random);
+
+            typeSeries.timestamps.push_back(timestamp);
+            typeSeries.values.push_back(roundf((float)value / resolutions[type]) * resolutions[type]);
+        }
+
+        HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+
+        HMOSeriesEncoderInit(encoder);
+        EncodeSeries(encoder, typeSeries, typeSeries.blocks);
+
+        delete encoder;
+    }
+
+    return typeSeries;
+}
+
+const char *SeriesName(int64_t type) {
+    static const char *names[] = { "temperature", "pressure", "altitude" };
+
+    return names[type];
+}
+
+}
+
+/** 1M readings of a sensor encoded, MB/s counted in raw 12 byte samples */
+static void HMOSeriesEncode(benchmark::State &state) {
+    const Series &series = SensorSeries(state.range(0));
+    HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+    std::vector<uint8_t> blocks;
+
+    blocks.reserve(series.blocks.size());
+    HMOSeriesEncoderInit(encoder);
+
+    for (auto _ : state) {
+        EncodeSeries(encoder, series, blocks);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(SeriesName(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * HMOSeriesCodecBenchmarkCount);
+    state.SetBytesProcessed(state.iterations() * HMOSeriesCodecBenchmarkCount * HMOSeriesCodecBenchmarkRawSampleSize);
+    state.counters["bytes_per_sample"] = (double)blocks.size() / HMOSeriesCodecBenchmarkCount;
+
+    delete encoder;
+}
+
+/** The same readings decoded in reads of 256 samples */
+static void HMOSeriesDecode(benchmark::State &state) {
+    const Series &series = SensorSeries(state.range(0));
+    double timestamps[256];
+    float values[256];
+
+    for (auto _ : state) {
+        HMOSeriesDecoder decoder;
+        size_t decodedCount = 0;
+
+        for (size_t offset = 0; offset < series.blocks.size(); offset += decoder.blockLength) {
+            HMOSeriesDecoderInit(&decoder, series.blocks.data() + offset, series.blocks.size() - offset);
+
+            size_t count;
+
+            while ((count = HMOSeriesDecoderRead(&decoder, timestamps, values, 256)) > 0) {
+                decodedCount += count;
+                benchmark::DoNotOptimize(values);
+            }
+        }
+
+        benchmark::DoNotOptimize(decodedCount);
+    }
+
+    state.SetLabel(SeriesName(state.range(0)));
+    state.SetItemsProcessed(state.iterations() * HMOSeriesCodecBenchmarkCount);
+    state.SetBytesProcessed(state.iterations() * HMOSeriesCodecBenchmarkCount * HMOSeriesCodecBenchmarkRawSampleSize);
+    state.counters["bytes_per_sample"] = (double)series.blocks.size() / HMOSeriesCodecBenchmarkCount;
+}
+
+BENCHMARK(HMOSeriesEncode)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
+BENCHMARK(HMOSeriesDecode)->DenseRange(0, 2)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,292 @@
+//
+//  HMOSeriesCodecTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "HMOSeriesCodec.h"
+}
+
+namespace {
+
+struct Series {
+    std::vector<double> timestamps;
+    std::vector<float> values;
+};
+
+/** Readings of a sensor sampled at 1 Hz with some jitter, at the resolution the board reports them */
+Series SensorSeries(double start, double value, double step, float resolution, size_t count, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> jitter(-0.01, 0.01);
+    std::uniform_real_distribution<double> change(-step, step);
+    Series series;
+    double timestamp = start;
+
+    for (size_t i = 0; i < count; i++) {
+        timestamp += 1.0 + jitter(random);
+        value += change(random);
+
+        series.timestamps.push_back(timestamp);
+        series.values.push_back(roundf((float)value / resolution) * resolution);
+    }
+
+    return series;
+}
+
+/** Encodes the series into as many blocks as it takes, back to back */
+std::vector<uint8_t> Encode(const Series &series) {
+    HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+    std::vector<uint8_t> bytes;
+    size_t length;
+
+    HMOSeriesEncoderInit(encoder);
+
+    for (size_t i = 0; i < series.timestamps.size(); i++) {
+        if (!HMOSeriesEncoderAppend(encoder, series.timestamps[i], series.values[i])) {
+            const uint8_t *block = HMOSeriesEncoderFinishBlock(encoder, &length);
+
+            bytes.insert(bytes.end(), block, block + length);
+            EXPECT_TRUE(HMOSeriesEncoderAppend(encoder, series.timestamps[i], series.values[i]));
+        }
+    }
+
+    const uint8_t *block = HMOSeriesEncoderFinishBlock(encoder, &length);
+
+    if (block != NULL) {
+        bytes.insert(bytes.end(), block, block + length);
+    }
+
+    delete encoder;
+
+    return bytes;
+}
+
+Series Decode(const std::vector<uint8_t> &bytes, size_t readCount) {
+    Series series;
+    std::vector<double> timestamps(readCount);
+    std::vector<float> values(readCount);
+    HMOSeriesDecoder decoder;
+
+    for (size_t offset = 0; offset < bytes.size(); offset += decoder.blockLength) {
+        if (!HMOSeriesDecoderInit(&decoder, bytes.data() + offset, bytes.size() - offset)) {
+            ADD_FAILURE() << "Block at " << offset << " does not decode";
+            break;
+        }
+
+        size_t count;
+
+        while ((count = HMOSeriesDecoderRead(&decoder, timestamps.data(), values.data(), readCount)) > 0) {
+            series.timestamps.insert(series.timestamps.end(), timestamps.begin(), timestamps.begin() + (ptrdiff_t)count);
+            series.values.insert(series.values.end(), values.begin(), values.begin() + (ptrdiff_t)count);
+        }
+
+        EXPECT_EQ(decoder.count, decoder.decodedCount);
+    }
+
+    return series;
+}
+
+/** Values come back bit for bit, timestamps to the millisecond */
+void ExpectRoundTrip(const Series &expected, const Series &decoded) {
+    ASSERT_EQ(expected.timestamps.size(), decoded.timestamps.size());
+    ASSERT_EQ(expected.values.size(), decoded.values.size());
+
+    for (size_t i = 0; i < expected.timestamps.size(); i++) {
+        ASSERT_EQ(llround(expected.timestamps[i] * 1000.0) / 1000.0, decoded.timestamps[i]) << "sample " << i;
+        ASSERT_EQ(0, memcmp(&expected.values[i], &decoded.values[i], sizeof(float))) << "sample " << i;
+    }
+}
+
+float FloatWithBits(uint32_t bits) {
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+}
+
+TEST(HMOSeriesCodec, RoundTripsSensorReadings) {
+    Series temperature = SensorSeries(4e8, 21.5, 0.01, 0.01f, 5000, 1);
+    Series pressure = SensorSeries(4e8, 99700, 2, 1, 5000, 2);
+    Series altitude = SensorSeries(4e8, 120, 0.15, 0.1f, 5000, 3);
+
+    for (const Series *series : { &temperature, &pressure, &altitude }) {
+        std::vector<uint8_t> bytes = Encode(*series);
+
+        // Five blocks, far smaller than the 12 bytes a raw sample takes
+        EXPECT_LT(bytes.size(), series->timestamps.size() * 4);
+
+        ExpectRoundTrip(*series, Decode(bytes, 100));
+        ExpectRoundTrip(*series, Decode(bytes, 1));
+    }
+}
+
+TEST(HMOSeriesCodec, SteadyReadingsTakeTwoBitsEach) {
+    HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+    size_t length;
+
+    HMOSeriesEncoderInit(encoder);
+
+    for (size_t i = 0; i < HMO_SERIES_CODEC_BLOCK_CAPACITY; i++) {
+        ASSERT_TRUE(HMOSeriesEncoderAppend(encoder, 100.0 + i * 0.1, 42.0f));
+    }
+
+    ASSERT_NE(nullptr, HMOSeriesEncoderFinishBlock(encoder, &length));
+
+    // The first sample whole, 12 bits for the second's delta of 100 ms and 1 for its value, then a bit each
+    size_t bitLength = 96 + 12 + 1 + (HMO_SERIES_CODEC_BLOCK_CAPACITY - 2) * 2;
+
+    EXPECT_EQ(HMO_SERIES_CODEC_HEADER_SIZE + (bitLength + 7) / 8, length);
+
+    delete encoder;
+}
+
+TEST(HMOSeriesCodec, RoundTripsTimestampChangesAtEveryFieldBoundary) {
+    const int64_t changes[] = {
+        0, -63, 63, 64, -64, -64, 64, 65, -65,
+        -255, 255, 256, -256, -256, 256, 257, -257,
+        -2047, 2047, 2048, -2048, -2048, 2048, 2049, -2049,
+        3000000000LL, -3000000000LL, 0
+    };
+    Series series;
+    int64_t milliseconds = -5000, delta = 5000;
+
+    for (int64_t change : changes) {
+        delta += change;
+        milliseconds += delta;
+
+        series.timestamps.push_back(milliseconds / 1000.0);
+        series.values.push_back((float)series.values.size());
+    }
+
+    ExpectRoundTrip(series, Decode(Encode(series), 3));
+}
+
+TEST(HMOSeriesCodec, RoundTripsSpecialValues) {
+    Series series;
+    float values[] = {
+        NAN, FloatWithBits(0x7fc12345), FloatWithBits(0xffbfffff), INFINITY, -INFINITY, 0.0f, -0.0f,
+        FLT_MIN, -FLT_MIN, FloatWithBits(1), FloatWithBits(0x807fffff), FLT_MAX, -FLT_MAX, 1.0f, 1.0f
+    };
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        // Repeated timestamps as well
+        series.timestamps.push_back(1e9 + (double)(i / 2) * 0.001);
+        series.values.push_back(values[i]);
+    }
+
+    ExpectRoundTrip(series, Decode(Encode(series), 4));
+}
+
+TEST(HMOSeriesCodec, RoundTripsRandomSamples) {
+    std::mt19937 random(7);
+    Series series;
+    double timestamp = 0;
+
+    for (size_t i = 0; i < 20000; i++) {
+        // Runs of steady samples between arbitrary bit patterns and gaps
+        if (random() % 4 == 0 || series.values.empty()) {
+            timestamp += (double)(random() % 100000000) / 1000.0;
+            series.values.push_back(FloatWithBits((uint32_t)random()));
+        } else {
+            timestamp += 0.1;
+            series.values.push_back(series.values.back());
+        }
+
+        series.timestamps.push_back(timestamp);
+    }
+
+    std::vector<uint8_t> bytes = Encode(series);
+
+    ExpectRoundTrip(series, Decode(bytes, 1000));
+    ExpectRoundTrip(series, Decode(bytes, 7));
+}
+
+TEST(HMOSeriesCodec, WorstCaseBlockFits) {
+    HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+    double timestamp = 0;
+    size_t length;
+
+    HMOSeriesEncoderInit(encoder);
+
+    // Alternating huge and tiny gaps, and values with every bit changing
+    for (size_t i = 0; i < HMO_SERIES_CODEC_BLOCK_CAPACITY; i++) {
+        timestamp += (i % 2 == 0) ? 1e7 : 0.001;
+        ASSERT_TRUE(HMOSeriesEncoderAppend(encoder, timestamp, FloatWithBits((i % 2 == 0) ? 0x80000001u : 0x7ffffffeu)));
+    }
+
+    EXPECT_FALSE(HMOSeriesEncoderAppend(encoder, timestamp + 1, 0));
+
+    const uint8_t *block = HMOSeriesEncoderFinishBlock(encoder, &length);
+
+    ASSERT_NE(nullptr, block);
+    EXPECT_LE(length, (size_t)HMO_SERIES_CODEC_MAX_BLOCK_SIZE);
+
+    delete encoder;
+}
+
+TEST(HMOSeriesCodec, RefusesEarlierTimestamps) {
+    HMOSeriesEncoder *encoder = new HMOSeriesEncoder;
+    size_t length;
+
+    HMOSeriesEncoderInit(encoder);
+
+    EXPECT_EQ(nullptr, HMOSeriesEncoderFinishBlock(encoder, &length));
+    EXPECT_EQ(0u, length);
+
+    ASSERT_TRUE(HMOSeriesEncoderAppend(encoder, 10.0, 1));
+    EXPECT_FALSE(HMOSeriesEncoderAppend(encoder, 9.998, 2));
+
+    // Within the same millisecond once rounded
+    EXPECT_TRUE(HMOSeriesEncoderAppend(encoder, 9.9996, 3));
+
+    ASSERT_NE(nullptr, HMOSeriesEncoderFinishBlock(encoder, &length));
+
+    // A new block starts over
+    EXPECT_TRUE(HMOSeriesEncoderAppend(encoder, 1.0, 4));
+
+    delete encoder;
+}
+
+TEST(HMOSeriesCodec, DamagedBlocksAreRejected) {
+    Series series = SensorSeries(4e8, 99700, 2, 1, 300, 5);
+    std::vector<uint8_t> bytes = Encode(series);
+    HMOSeriesDecoder decoder;
+
+    ASSERT_TRUE(HMOSeriesDecoderInit(&decoder, bytes.data(), bytes.size()));
+    ASSERT_EQ(bytes.size(), decoder.blockLength);
+
+    // Every flipped bit, in the header or the payload, is caught
+    for (size_t bit = 0; bit < bytes.size() * 8; bit++) {
+        std::vector<uint8_t> damaged = bytes;
+
+        damaged[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        ASSERT_FALSE(HMOSeriesDecoderInit(&decoder, damaged.data(), damaged.size())) << "bit " << bit;
+    }
+
+    for (size_t length = 0; length < bytes.size(); length++) {
+        ASSERT_FALSE(HMOSeriesDecoderInit(&decoder, bytes.data(), length)) << "length " << length;
+    }
+
+    // A damaged block is skipped by the caller, the next one still decodes
+    std::vector<uint8_t> twoBlocks = bytes;
+
+    twoBlocks.insert(twoBlocks.end(), bytes.begin(), bytes.end());
+    twoBlocks[HMO_SERIES_CODEC_HEADER_SIZE + 5] ^= 0x20;
+
+    ASSERT_FALSE(HMOSeriesDecoderInit(&decoder, twoBlocks.data(), twoBlocks.size()));
+    ExpectRoundTrip(series, Decode(std::vector<uint8_t>(twoBlocks.begin() + (ptrdiff_t)bytes.size(), twoBlocks.end()), 64));
+}
@@ -0,0 +1,218 @@
+//
+//  HMOSeriesRollupTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "HMOSeriesRollup.h"
+}
+
+namespace {
+
+const size_t HMOSeriesRollupTestCapacity = 400;
+
+/** Query output with its own storage */
+struct Summaries {
+    std::vector<double> startTimes;
+    std::vector<float> minValues;
+    std::vector<float> maxValues;
+    std::vector<float> meanValues;
+    std::vector<uint32_t> counts;
+    HMOSeriesSummaryColumns columns;
+
+    explicit Summaries(size_t capacity) : startTimes(capacity), minValues(capacity), maxValues(capacity), meanValues(capacity), counts(capacity) {
+        columns = { startTimes.data(), minValues.data(), maxValues.data(), meanValues.data(), counts.data(), capacity };
+    }
+};
+
+/** A sensor log with its rollup kept up to date, and the samples as they read back */
+class LoggedSeries {
+public:
+    const std::string path;
+    HMOSensorLog log;
+    HMOSeriesRollup rollup;
+    std::vector<double> timestamps;
+    std::vector<float> values;
+
+    explicit LoggedSeries(const char *name) : path(testing::TempDir() + name) {
+        unlink(path.c_str());
+        EXPECT_TRUE(HMOSensorLogOpen(&log, path.c_str()));
+        HMOSeriesRollupInit(&rollup, &log);
+    }
+
+    ~LoggedSeries() {
+        HMOSeriesRollupDestroy(&rollup);
+        HMOSensorLogClose(&log);
+        unlink(path.c_str());
+    }
+
+    void Append(double timestamp, float value) {
+        ASSERT_TRUE(HMOSensorLogAppend(&log, timestamp, value));
+        ASSERT_TRUE(HMOSeriesRollupAppend(&rollup, HMOSensorLogLastTimestamp(&log), value));
+
+        timestamps.push_back(HMOSensorLogLastTimestamp(&log));
+        values.push_back(value);
+    }
+
+    /** Checks a query against the samples summarized one by one */
+    void ExpectQuery(const HMOSeriesRollup *queried, double startTime, double endTime, double bucketWidth) const {
+        Summaries summaries(HMOSeriesRollupTestCapacity);
+        size_t count = HMOSeriesRollupQuery(queried, startTime, endTime, bucketWidth, &summaries.columns);
+        size_t expectedCount = std::min((size_t)ceil((endTime - startTime) / bucketWidth), HMOSeriesRollupTestCapacity);
+
+        ASSERT_NEAR((double)expectedCount, (double)count, 1);
+
+        for (size_t i = 0; i < count; i++) {
+            double bucketStart = summaries.startTimes[i];
+            double bucketEnd = (i + 1 < count) ? summaries.startTimes[i + 1] : std::min(startTime + (i + 1) * bucketWidth, endTime);
+            size_t first = (size_t)(std::lower_bound(timestamps.begin(), timestamps.end(), bucketStart) - timestamps.begin());
+            size_t end = (size_t)(std::lower_bound(timestamps.begin(), timestamps.end(), bucketEnd) - timestamps.begin());
+
+            ASSERT_EQ(end - first, summaries.counts[i]) << "bucket " << i << " of [" << startTime << ", " << endTime << ") by " << bucketWidth;
+
+            if (first == end) {
+                ASSERT_TRUE(isnan(summaries.meanValues[i]));
+                ASSERT_TRUE(isnan(summaries.minValues[i]));
+                continue;
+            }
+
+            double sum = 0;
+
+            for (size_t j = first; j < end; j++) {
+                sum += values[j];
+            }
+
+            ASSERT_EQ(*std::min_element(values.begin() + (ptrdiff_t)first, values.begin() + (ptrdiff_t)end), summaries.minValues[i]);
+            ASSERT_EQ(*std::max_element(values.begin() + (ptrdiff_t)first, values.begin() + (ptrdiff_t)end), summaries.maxValues[i]);
+            ASSERT_NEAR(sum / (double)(end - first), summaries.meanValues[i], 0.01);
+        }
+    }
+};
+
+/** About twelve days of pressure readings every few seconds to a minute, with a gap longer than the minutes are kept */
+void AppendReadings(LoggedSeries &series, std::mt19937 &random) {
+    std::uniform_real_distribution<double> interval(2, 60);
+    double timestamp = 4e8 + 17.3;
+
+    for (size_t i = 0; i < 24000; i++) {
+        timestamp += (i == 12000) ? 8 * 86400.0 : interval(random);
+        series.Append(timestamp, 99700.0f + (float)(random() % 20));
+    }
+}
+
+}
+
+TEST(HMOSeriesRollup, QueriesMatchTheSamples) {
+    LoggedSeries series("HMOSeriesRollupQueries.log");
+    std::mt19937 random(1);
+
+    AppendReadings(series, random);
+
+    double first = series.timestamps.front(), last = series.timestamps.back();
+    std::uniform_real_distribution<double> start(first - 100, last + 100);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    for (int query = 0; query < 100; query++) {
+        double startTime = start(random);
+        // Spans from minutes to weeks, in buckets from a second to days
+        double length = (query % 2 == 0) ? unit(random) * 7200 : unit(random) * 14 * 86400;
+        double bucketWidth = std::max(1.0, length / (1 + unit(random) * 300));
+
+        series.ExpectQuery(&series.rollup, startTime, startTime + length, bucketWidth);
+    }
+
+    // Bucket edges on whole minutes, hours and days
+    series.ExpectQuery(&series.rollup, floor(first / 86400) * 86400, last + 1, 86400);
+    series.ExpectQuery(&series.rollup, floor(last / 3600) * 3600 - 86400, last + 1, 3600);
+    series.ExpectQuery(&series.rollup, floor(last / 60) * 60 - 3600, last + 1, 60);
+}
+
+TEST(HMOSeriesRollup, RebuildMatchesAppending) {
+    LoggedSeries series("HMOSeriesRollupRebuild.log");
+    std::mt19937 random(2);
+    HMOSeriesRollup rebuilt;
+
+    AppendReadings(series, random);
+
+    HMOSeriesRollupInit(&rebuilt, &series.log);
+    ASSERT_TRUE(HMOSeriesRollupRebuild(&rebuilt));
+
+    for (double bucketWidth : { 60.0, 3600.0, 86400.0, 1000.0 }) {
+        Summaries appended(HMOSeriesRollupTestCapacity), summarized(HMOSeriesRollupTestCapacity);
+        double startTime = series.timestamps.front() + 123.4;
+        double endTime = startTime + bucketWidth * 300;
+        size_t count = HMOSeriesRollupQuery(&series.rollup, startTime, endTime, bucketWidth, &appended.columns);
+
+        ASSERT_EQ(count, HMOSeriesRollupQuery(&rebuilt, startTime, endTime, bucketWidth, &summarized.columns));
+        EXPECT_EQ(appended.counts, summarized.counts);
+        EXPECT_EQ(appended.startTimes, summarized.startTimes);
+
+        series.ExpectQuery(&rebuilt, startTime, endTime, bucketWidth);
+    }
+
+    // Appending carries on from the rebuilt summaries
+    series.Append(series.timestamps.back() + 30, 99000);
+    ASSERT_TRUE(HMOSeriesRollupAppend(&rebuilt, series.timestamps.back(), 99000));
+    series.ExpectQuery(&rebuilt, series.timestamps.back() - 86400, series.timestamps.back() + 1, 600);
+
+    HMOSeriesRollupDestroy(&rebuilt);
+}
+
+TEST(HMOSeriesRollup, EmptyAndInvalidQueries) {
+    LoggedSeries series("HMOSeriesRollupEmpty.log");
+    Summaries summaries(4);
+
+    EXPECT_EQ(0u, HMOSeriesRollupQuery(&series.rollup, 0, 100, 0, &summaries.columns));
+    EXPECT_EQ(0u, HMOSeriesRollupQuery(&series.rollup, 100, 100, 10, &summaries.columns));
+    EXPECT_EQ(0u, HMOSeriesRollupQuery(&series.rollup, 0, 100, NAN, &summaries.columns));
+
+    // Nothing logged yet
+    ASSERT_EQ(2u, HMOSeriesRollupQuery(&series.rollup, 0, 100, 60, &summaries.columns));
+    EXPECT_EQ(0u, summaries.counts[0]);
+    EXPECT_TRUE(isnan(summaries.meanValues[1]));
+
+    series.Append(1000, 5);
+    series.Append(1030, 7);
+
+    // Cut at the capacity
+    ASSERT_EQ(4u, HMOSeriesRollupQuery(&series.rollup, 900, 2000, 30, &summaries.columns));
+    EXPECT_EQ(1u, summaries.counts[3]);
+
+    // The last bucket is cut at the end time
+    series.ExpectQuery(&series.rollup, 990, 1045, 20);
+}
+
+TEST(HMOSeriesRollup, RefusesEarlierSamples) {
+    LoggedSeries series("HMOSeriesRollupOrder.log");
+
+    series.Append(500, 1);
+
+    EXPECT_FALSE(HMOSeriesRollupAppend(&series.rollup, 499.999, 2));
+    EXPECT_TRUE(HMOSeriesRollupAppend(&series.rollup, 500, 3));
+}
+
+TEST(HMOSeriesRollup, FailedGrowthIsReported) {
+    LoggedSeries series("HMOSeriesRollupAllocation.log");
+
+    {
+        HMOTestAllocationFailure failure(0);
+
+        EXPECT_FALSE(HMOSeriesRollupAppend(&series.rollup, 500, 1));
+    }
+
+    EXPECT_TRUE(HMOSeriesRollupAppend(&series.rollup, 600, 1));
+}
@@ -0,0 +1,256 @@
+//
+//  HMOSimulatorTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "HMOReplay.h"
+#include "HMOSimulator.h"
+}
+
+namespace {
+
+struct Notification {
+    double receiveTime;
+    std::vector<uint8_t> bytes;
+
+    bool operator==(const Notification &other) const {
+        return memcmp(&receiveTime, &other.receiveTime, sizeof(double)) == 0 && bytes == other.bytes;
+    }
+};
+
+/** Three devices over a flaky link for a minute */
+HMOSimulatorOptions FlakyOptions(uint64_t seed) {
+    HMOSimulatorOptions options;
+
+    HMOSimulatorOptionsInit(&options);
+    options.deviceCount = 3;
+    options.startTime = 4e8;
+    options.duration = 60;
+    options.dropProbability = 0.05;
+    options.duplicateProbability = 0.05;
+    options.truncateProbability = 0.05;
+    options.seed = seed;
+
+    return options;
+}
+
+/** Every notification of a run, with the simulator's counters as they end up */
+std::vector<Notification> Simulate(const HMOSimulatorOptions &options, HMOSimulator *finished) {
+    HMOSimulator simulator;
+    HMOCaptureNotification notification;
+    std::vector<Notification> notifications;
+
+    EXPECT_TRUE(HMOSimulatorInit(&simulator, &options));
+
+    while (HMOSimulatorNext(&simulator, &notification)) {
+        notifications.push_back({ notification.receiveTime, std::vector<uint8_t>(notification.bytes, notification.bytes + notification.length) });
+    }
+
+    HMOSimulatorDestroy(&simulator);
+    *finished = simulator;
+
+    return notifications;
+}
+
+HMOReplayReport Replay(const HMOSimulatorOptions &simulatorOptions) {
+    HMOSimulator simulator;
+    HMOReplayOptions options;
+    HMOReplayReport report;
+
+    EXPECT_TRUE(HMOSimulatorInit(&simulator, &simulatorOptions));
+    HMOReplayOptionsInit(&options, HMOSimulatorNext, &simulator);
+
+    EXPECT_TRUE(HMOReplayRun(&options, &report));
+
+    HMOSimulatorDestroy(&simulator);
+
+    return report;
+}
+
+}
+
+TEST(HMOSimulator, SameSeedSendsTheSameNotifications) {
+    HMOSimulator first, second, other;
+    std::vector<Notification> notifications = Simulate(FlakyOptions(42), &first);
+
+    ASSERT_GT(notifications.size(), 1000u);
+    EXPECT_TRUE(notifications == Simulate(FlakyOptions(42), &second));
+    EXPECT_EQ(first.readingCount, second.readingCount);
+    EXPECT_EQ(first.droppedCount, second.droppedCount);
+    EXPECT_EQ(first.duplicatedCount, second.duplicatedCount);
+    EXPECT_EQ(first.truncatedCount, second.truncatedCount);
+
+    // Every kind of flakiness shows up in a minute
+    EXPECT_GT(first.droppedCount, 0u);
+    EXPECT_GT(first.duplicatedCount, 0u);
+    EXPECT_GT(first.truncatedCount, 0u);
+
+    EXPECT_FALSE(notifications == Simulate(FlakyOptions(43), &other));
+}
+
+TEST(HMOSimulator, SameSeedReplaysToTheSameChecksum) {
+    HMOReplayReport report = Replay(FlakyOptions(7));
+    HMOReplayReport repeated = Replay(FlakyOptions(7));
+
+    EXPECT_GT(report.pathCount, 0u);
+    EXPECT_EQ(report.notificationCount, repeated.notificationCount);
+    EXPECT_EQ(report.recordCount, repeated.recordCount);
+    EXPECT_EQ(report.droppedByteCount, repeated.droppedByteCount);
+    EXPECT_EQ(report.pathChecksum, repeated.pathChecksum);
+
+    EXPECT_NE(report.pathChecksum, Replay(FlakyOptions(8)).pathChecksum);
+}
+
+TEST(HMOSimulator, NotificationsArriveInOrderInBatches) {
+    HMOSimulatorOptions options = FlakyOptions(1);
+    HMOSimulator simulator;
+
+    options.deviceCount = 5;
+    options.rates[kHMORecordTypePressure] = 500;
+    options.duration = 10;
+
+    std::vector<Notification> notifications = Simulate(options, &simulator);
+    size_t shortCount = 0;
+
+    ASSERT_FALSE(notifications.empty());
+    EXPECT_GE(notifications.front().receiveTime, options.startTime);
+
+    for (size_t i = 0; i < notifications.size(); i++) {
+        size_t length = notifications[i].bytes.size();
+
+        ASSERT_LE(length, (size_t)HMO_SIMULATOR_NOTIFICATION_LENGTH);
+
+        if (i > 0) {
+            ASSERT_GE(notifications[i].receiveTime, notifications[i - 1].receiveTime) << "notification " << i;
+        }
+
+        shortCount += (length < HMO_SIMULATOR_NOTIFICATION_LENGTH);
+    }
+
+    // At least the last notification of every batch that was not dropped is short
+    EXPECT_GE(shortCount, 5 * 10 / options.batchInterval * 0.9);
+}
+
+TEST(HMOSimulator, ReliableLinkDeliversEveryReading) {
+    HMOSimulatorOptions options = FlakyOptions(3);
+    HMOSimulator simulator;
+
+    options.dropProbability = 0;
+    options.duplicateProbability = 0;
+    options.truncateProbability = 0;
+
+    ASSERT_TRUE(HMOSimulatorInit(&simulator, &options));
+
+    HMOReplayOptions replayOptions;
+    HMOReplayReport report;
+
+    HMOReplayOptionsInit(&replayOptions, HMOSimulatorNext, &simulator);
+    ASSERT_TRUE(HMOReplayRun(&replayOptions, &report));
+
+    // A minute of readings from each device, ten times a second for pressure
+    EXPECT_EQ(simulator.readingCount, report.recordCount);
+    EXPECT_NEAR(3 * 60 * 12, (double)report.recordCount, 3 * 3);
+    EXPECT_NEAR(3 * 60 * 10, (double)report.pressureCount, 3);
+    EXPECT_EQ(0u, report.droppedByteCount);
+    EXPECT_EQ(0u, simulator.droppedCount + simulator.duplicatedCount + simulator.truncatedCount);
+
+    HMOSimulatorDestroy(&simulator);
+}
+
+TEST(HMOSimulator, FastTypeDoesNotCrowdOutTheOthers) {
+    HMOSimulatorOptions options = FlakyOptions(4);
+    HMOSimulator simulator;
+
+    options.deviceCount = 1;
+    options.rates[kHMORecordTypePressure] = 1000;
+    options.dropProbability = 0;
+    options.duplicateProbability = 0;
+    options.truncateProbability = 0;
+
+    std::vector<Notification> notifications = Simulate(options, &simulator);
+    size_t counts[256] = {};
+    size_t batchLength = 0, batchCount = 0;
+
+    for (const Notification &notification : notifications) {
+        batchLength += notification.bytes.size();
+
+        // Every batch ends with a short notification, on a record boundary
+        if (notification.bytes.size() < HMO_SIMULATOR_NOTIFICATION_LENGTH) {
+            ASSERT_EQ(0u, batchLength % HMO_RECORD_LENGTH);
+            ASSERT_LE(batchLength, (size_t)HMO_SIMULATOR_MAX_BATCH_RECORDS * HMO_RECORD_LENGTH);
+
+            for (size_t i = 0; i + HMO_RECORD_LENGTH <= notification.bytes.size(); i += HMO_RECORD_LENGTH) {
+                counts[notification.bytes[i]] += 1;
+            }
+
+            batchLength = 0;
+            batchCount += 1;
+        } else {
+            for (size_t i = 0; i < notification.bytes.size(); i += HMO_RECORD_LENGTH) {
+                counts[notification.bytes[i]] += 1;
+            }
+        }
+    }
+
+    EXPECT_EQ(0u, batchLength);
+    EXPECT_GE(batchCount, 600u);
+
+    // A minute of readings of every type, however fast pressure is sent, less those due after the last batch
+    EXPECT_NEAR(60, (double)counts[HMO_RECORD_CODE_TEMPERATURE], 1);
+    EXPECT_NEAR(60000, (double)counts[HMO_RECORD_CODE_PRESSURE], 1000 * options.batchInterval);
+    EXPECT_NEAR(60, (double)counts[HMO_RECORD_CODE_ALTITUDE], 1);
+    EXPECT_EQ(simulator.readingCount, counts[HMO_RECORD_CODE_TEMPERATURE] + counts[HMO_RECORD_CODE_PRESSURE] + counts[HMO_RECORD_CODE_ALTITUDE]);
+
+    // The pipeline sees every batch end and decodes every reading
+    HMOReplayReport report = Replay(options);
+
+    EXPECT_EQ(simulator.readingCount, report.recordCount);
+    EXPECT_EQ(0u, report.droppedByteCount);
+    EXPECT_EQ(0u, report.overflowCount);
+}
+
+TEST(HMOSimulator, SignalFollowsItsModel) {
+    HMOSimulatorSignalModel model = { 100.0, 0.5, 0.0, 0.0, 0.0 };
+    HMOSimulatorSignal signal, noisy, repeated;
+
+    HMOSimulatorSignalInit(&signal, &model, 1);
+
+    EXPECT_EQ(100.0f, HMOSimulatorSignalSample(&signal, 0));
+    EXPECT_EQ(105.0f, HMOSimulatorSignalSample(&signal, 10));
+
+    model.noise = 2.0;
+    HMOSimulatorSignalInit(&noisy, &model, 9);
+    HMOSimulatorSignalInit(&repeated, &model, 9);
+
+    for (int i = 0; i < 1000; i++) {
+        float value = HMOSimulatorSignalSample(&noisy, i);
+
+        ASSERT_NEAR(100.0 + 0.5 * i, value, 2.0001);
+        ASSERT_EQ(value, HMOSimulatorSignalSample(&repeated, i));
+    }
+}
+
+TEST(HMOSimulator, FailedInitIsReported) {
+    HMOSimulatorOptions options = FlakyOptions(1);
+    HMOSimulator simulator;
+
+    {
+        HMOTestAllocationFailure failure(2);
+
+        EXPECT_FALSE(HMOSimulatorInit(&simulator, &options));
+    }
+
+    EXPECT_EQ(nullptr, simulator.signals);
+    EXPECT_EQ(nullptr, simulator.nextBatchTimes);
+}
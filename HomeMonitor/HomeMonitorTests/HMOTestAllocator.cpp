@@ -0,0 +1,63 @@
+//
+//  HMOTestAllocator.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <stddef.h>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+}
+
+namespace {
+
+/** Allocations left before they start failing, negative while failures are off */
+long HMOTestAllowedAllocationCount = -1;
+
+bool ShouldFail() {
+    if (HMOTestAllowedAllocationCount < 0) {
+        return false;
+    }
+
+    if (HMOTestAllowedAllocationCount == 0) {
+        return true;
+    }
+
+    HMOTestAllowedAllocationCount -= 1;
+
+    return false;
+}
+
+}
+
+extern "C" {
+
+void *__wrap_malloc(size_t size) {
+    return ShouldFail() ? NULL : __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    return ShouldFail() ? NULL : __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    return ShouldFail() ? NULL : __real_realloc(pointer, size);
+}
+
+}
+
+HMOTestAllocationFailure::HMOTestAllocationFailure(long allowedCount) {
+    HMOTestAllowedAllocationCount = allowedCount;
+}
+
+HMOTestAllocationFailure::~HMOTestAllocationFailure() {
+    HMOTestAllowedAllocationCount = -1;
+}
@@ -0,0 +1,27 @@
+//
+//  HMOTestAllocator.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOTestAllocator_h
+#define HomeMonitor_HMOTestAllocator_h
+
+/**
+ Makes malloc, calloc and realloc calls from the portable cores fail, to test their out of memory paths.
+
+ The test executable is linked with malloc, calloc and realloc wrapped, so only calls made from C code are
+ affected, not allocations by the C++ runtime.
+*/
+class HMOTestAllocationFailure {
+public:
+    /** Lets the next allowedCount allocations succeed and fails every one after them */
+    explicit HMOTestAllocationFailure(long allowedCount);
+    ~HMOTestAllocationFailure();
+
+    HMOTestAllocationFailure(const HMOTestAllocationFailure &) = delete;
+    HMOTestAllocationFailure &operator=(const HMOTestAllocationFailure &) = delete;
+};
+
+#endif
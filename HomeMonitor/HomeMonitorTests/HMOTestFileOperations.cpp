@@ -0,0 +1,88 @@
+//
+//  HMOTestFileOperations.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <unistd.h>
+
+#include "HMOTestFileOperations.h"
+
+extern "C" {
+
+ssize_t __real_pwrite(int fd, const void *bytes, size_t length, off_t offset);
+int __real_ftruncate(int fd, off_t length);
+int __real_fsync(int fd);
+
+}
+
+namespace {
+
+bool HMOTestIsRecording = false;
+
+std::vector<HMOTestFileOperation> &RecordedOperations() {
+    static std::vector<HMOTestFileOperation> operations;
+
+    return operations;
+}
+
+void Record(HMOTestFileOperation::Type type, int fd, off_t offset, const void *bytes, size_t length) {
+    if (!HMOTestIsRecording) {
+        return;
+    }
+
+    const uint8_t *byte = static_cast<const uint8_t *>(bytes);
+
+    RecordedOperations().push_back({ type, fd, offset, std::vector<uint8_t>(byte, byte + length) });
+}
+
+}
+
+extern "C" {
+
+ssize_t __wrap_pwrite(int fd, const void *bytes, size_t length, off_t offset) {
+    ssize_t written = __real_pwrite(fd, bytes, length, offset);
+
+    if (written > 0) {
+        Record(HMOTestFileOperation::kWrite, fd, offset, bytes, (size_t)written);
+    }
+
+    return written;
+}
+
+int __wrap_ftruncate(int fd, off_t length) {
+    int result = __real_ftruncate(fd, length);
+
+    if (result == 0) {
+        Record(HMOTestFileOperation::kTruncate, fd, length, nullptr, 0);
+    }
+
+    return result;
+}
+
+int __wrap_fsync(int fd) {
+    int result = __real_fsync(fd);
+
+    if (result == 0) {
+        Record(HMOTestFileOperation::kSync, fd, 0, nullptr, 0);
+    }
+
+    return result;
+}
+
+}
+
+HMOTestFileOperationRecorder::HMOTestFileOperationRecorder() {
+    RecordedOperations().clear();
+    HMOTestIsRecording = true;
+}
+
+HMOTestFileOperationRecorder::~HMOTestFileOperationRecorder() {
+    HMOTestIsRecording = false;
+    RecordedOperations().clear();
+}
+
+const std::vector<HMOTestFileOperation> &HMOTestFileOperationRecorder::operations() const {
+    return RecordedOperations();
+}
@@ -0,0 +1,50 @@
+//
+//  HMOTestFileOperations.h
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#ifndef HomeMonitor_HMOTestFileOperations_h
+#define HomeMonitor_HMOTestFileOperations_h
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+/** A pwrite, ftruncate or fsync call made by the portable cores */
+struct HMOTestFileOperation {
+    enum Type {
+        kWrite,
+        kTruncate,
+        kSync
+    };
+
+    Type type;
+    int fd;
+    /** Where bytes were written, or the length a file was truncated to */
+    off_t offset;
+    std::vector<uint8_t> bytes;
+};
+
+/**
+ Records the file operations of the portable cores while it exists, so a test can rebuild a file as a crash at any
+ point would have left it.
+
+ The test executable is linked with pwrite, ftruncate and fsync wrapped, like the allocation functions.  The calls
+ still go through, only C code is recorded.
+*/
+class HMOTestFileOperationRecorder {
+public:
+    HMOTestFileOperationRecorder();
+    ~HMOTestFileOperationRecorder();
+
+    HMOTestFileOperationRecorder(const HMOTestFileOperationRecorder &) = delete;
+    HMOTestFileOperationRecorder &operator=(const HMOTestFileOperationRecorder &) = delete;
+
+    /** Operations made so far, oldest first */
+    const std::vector<HMOTestFileOperation> &operations() const;
+};
+
+#endif
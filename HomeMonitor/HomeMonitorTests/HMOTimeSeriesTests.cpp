@@ -0,0 +1,72 @@
+//
+//  HMOTimeSeriesTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+extern "C" {
+#include "HMOTimeSeries.h"
+}
+
+TEST(HMOTimeSeries, KeepsTheNewestSamplesContiguous) {
+    HMOTimeSeries series;
+
+    ASSERT_TRUE(HMOTimeSeriesInit(&series, 5));
+
+    for (int i = 0; i < 23; i++) {
+        EXPECT_EQ(i >= 5, HMOTimeSeriesAppend(&series, i, i * 10.0f));
+        ASSERT_EQ((size_t)std::min(i + 1, 5), series.count);
+
+        // Every suffix of the live samples reads as one run, wherever the ring has wrapped to
+        for (size_t count = 1; count <= series.count; count++) {
+            const double *timestamps = HMOTimeSeriesTimestamps(&series, count);
+            const float *values = HMOTimeSeriesValues(&series, count);
+
+            for (size_t j = 0; j < count; j++) {
+                double expected = i - (double)(count - 1) + j;
+
+                ASSERT_EQ(expected, timestamps[j]);
+                ASSERT_EQ((float)(expected * 10.0), values[j]);
+            }
+        }
+    }
+
+    HMOTimeSeriesDestroy(&series);
+}
+
+TEST(HMOTimeSeries, RemovesOldestSamples) {
+    HMOTimeSeries series;
+
+    ASSERT_TRUE(HMOTimeSeriesInit(&series, 4));
+
+    for (int i = 0; i < 6; i++) {
+        HMOTimeSeriesAppend(&series, i, (float)i);
+    }
+
+    HMOTimeSeriesRemoveOldest(&series, 3);
+    ASSERT_EQ(1u, series.count);
+    EXPECT_EQ(5.0, *HMOTimeSeriesTimestamps(&series, 1));
+
+    HMOTimeSeriesAppend(&series, 6, 6.0f);
+    EXPECT_EQ(5.0, HMOTimeSeriesTimestamps(&series, 2)[0]);
+    EXPECT_EQ(6.0f, HMOTimeSeriesValues(&series, 2)[1]);
+
+    HMOTimeSeriesRemoveOldest(&series, 10);
+    EXPECT_EQ(0u, series.count);
+
+    HMOTimeSeriesAppend(&series, 7, 7.0f);
+    HMOTimeSeriesRemoveAll(&series);
+    EXPECT_EQ(0u, series.count);
+
+    HMOTimeSeriesDestroy(&series);
+}
+
+TEST(HMOTimeSeries, RejectsZeroCapacity) {
+    HMOTimeSeries series;
+
+    EXPECT_FALSE(HMOTimeSeriesInit(&series, 0));
+    EXPECT_EQ(nullptr, series.timestamps);
+}
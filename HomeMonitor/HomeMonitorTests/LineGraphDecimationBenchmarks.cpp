@@ -0,0 +1,86 @@
+//
+//  LineGraphDecimationBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "LineGraphDecimation.h"
+}
+
+namespace {
+
+/** 320 points wide plot on a 2x screen */
+const float LineGraphDecimationBenchmarkWidth = 320.0f;
+const float LineGraphDecimationBenchmarkColumnWidth = 0.5f;
+
+struct Points {
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> outXs;
+    std::vector<float> outYs;
+
+    explicit Points(size_t count) : outXs(count), outYs(count) {
+        for (size_t i = 0; i < count; i++) {
+            xs.push_back(i * LineGraphDecimationBenchmarkWidth / count);
+            ys.push_back(99700.0f + 10.0f * std::sin(i * 0.001f) + ((i % 77777 == 0) ? 300.0f : 0.0f));
+        }
+    }
+};
+
+}
+
+/** Points passed on as they are, what every path cost before decimation */
+static void LineGraphDecimateNone(benchmark::State &state) {
+    Points points((size_t)state.range(0));
+
+    for (auto _ : state) {
+        std::memcpy(points.outXs.data(), points.xs.data(), sizeof(float) * points.xs.size());
+        std::memcpy(points.outYs.data(), points.ys.data(), sizeof(float) * points.ys.size());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["output"] = (double)points.xs.size();
+}
+
+static void LineGraphDecimateMinMax(benchmark::State &state) {
+    Points points((size_t)state.range(0));
+    size_t count = 0;
+
+    for (auto _ : state) {
+        count = LineGraphDecimateMinMax(points.xs.data(), points.ys.data(), points.xs.size(), LineGraphDecimationBenchmarkColumnWidth,
+                                        points.outXs.data(), points.outYs.data());
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["output"] = (double)count;
+}
+
+static void LineGraphDecimateLargestTriangle(benchmark::State &state) {
+    Points points((size_t)state.range(0));
+    size_t threshold = LineGraphDecimationThreshold(LineGraphDecimationBenchmarkWidth, LineGraphDecimationBenchmarkColumnWidth);
+    size_t count = 0;
+
+    for (auto _ : state) {
+        count = LineGraphDecimateLargestTriangle(points.xs.data(), points.ys.data(), points.xs.size(), threshold,
+                                                 points.outXs.data(), points.outYs.data());
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["output"] = (double)count;
+}
+
+// 20 points is the app's live graph, 864000 is a day of 10 Hz readings
+BENCHMARK(LineGraphDecimateNone)->Arg(20)->Arg(864000);
+BENCHMARK(LineGraphDecimateMinMax)->Arg(20)->Arg(10000)->Arg(864000);
+BENCHMARK(LineGraphDecimateLargestTriangle)->Arg(10000)->Arg(864000);
@@ -0,0 +1,154 @@
+//
+//  LineGraphDecimationTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+extern "C" {
+#include "LineGraphDecimation.h"
+}
+
+namespace {
+
+struct Points {
+    std::vector<float> xs;
+    std::vector<float> ys;
+};
+
+/** Noisy sine with jittered spacing and a few spikes */
+Points Series(size_t count, float width, unsigned seed) {
+    Points points;
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> jitter(0.0f, 0.5f);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+    for (size_t i = 0; i < count; i++) {
+        float y = 50.0f * std::sin(i * 0.01f) + noise(random);
+
+        if (i % 997 == 500) {
+            y += (i % 2) ? 400.0f : -400.0f;
+        }
+
+        points.xs.push_back((i + jitter(random)) * width / count);
+        points.ys.push_back(y);
+    }
+
+    return points;
+}
+
+}
+
+TEST(LineGraphDecimation, MinMaxKeepsFirstLastMinAndMaxOfEveryColumn) {
+    const float columnWidth = 0.5f;
+    Points points = Series(100000, 320.0f, 1);
+    std::vector<float> outXs(points.xs.size()), outYs(points.ys.size());
+
+    size_t count = LineGraphDecimateMinMax(points.xs.data(), points.ys.data(), points.xs.size(), columnWidth, outXs.data(), outYs.data());
+
+    // Reference: the points of each column, by the column they fall in
+    std::map<long, std::vector<size_t>> columns;
+
+    for (size_t i = 0; i < points.xs.size(); i++) {
+        columns[(long)std::floor(points.xs[i] / columnWidth)].push_back(i);
+    }
+
+    std::set<std::pair<float, float>> expected;
+    size_t expectedMaximumCount = 0;
+
+    for (const auto &column : columns) {
+        const std::vector<size_t> &indexes = column.second;
+        size_t min = indexes[0], max = indexes[0];
+
+        for (size_t i : indexes) {
+            min = (points.ys[i] < points.ys[min]) ? i : min;
+            max = (points.ys[i] > points.ys[max]) ? i : max;
+        }
+
+        for (size_t i : { indexes.front(), indexes.back(), min, max }) {
+            expected.insert(std::make_pair(points.xs[i], points.ys[i]));
+        }
+
+        expectedMaximumCount += std::min<size_t>(4, indexes.size());
+    }
+
+    std::set<std::pair<float, float>> decimated;
+
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0) {
+            ASSERT_LE(outXs[i - 1], outXs[i]);
+        }
+
+        decimated.insert(std::make_pair(outXs[i], outYs[i]));
+    }
+
+    EXPECT_EQ(expected, decimated);
+    EXPECT_LE(count, expectedMaximumCount);
+    EXPECT_EQ(*std::max_element(points.ys.begin(), points.ys.end()), *std::max_element(outYs.begin(), outYs.begin() + count));
+    EXPECT_EQ(*std::min_element(points.ys.begin(), points.ys.end()), *std::min_element(outYs.begin(), outYs.begin() + count));
+}
+
+TEST(LineGraphDecimation, MinMaxHandlesTinyRuns) {
+    float xs[] = { 0.0f, 0.1f, 0.2f };
+    float ys[] = { 3.0f, 1.0f, 2.0f };
+    float outXs[3], outYs[3];
+
+    EXPECT_EQ(0u, LineGraphDecimateMinMax(xs, ys, 0, 1.0f, outXs, outYs));
+    EXPECT_EQ(1u, LineGraphDecimateMinMax(xs, ys, 1, 1.0f, outXs, outYs));
+
+    // Every point is the first, last, minimum or maximum of the one column
+    ASSERT_EQ(3u, LineGraphDecimateMinMax(xs, ys, 3, 1.0f, outXs, outYs));
+    EXPECT_EQ(1.0f, outYs[1]);
+}
+
+TEST(LineGraphDecimation, LargestTriangleKeepsThresholdPointsInOrder) {
+    Points points = Series(50000, 320.0f, 2);
+    size_t threshold = LineGraphDecimationThreshold(320.0f, 0.5f);
+    std::vector<float> outXs(points.xs.size()), outYs(points.ys.size());
+
+    size_t count = LineGraphDecimateLargestTriangle(points.xs.data(), points.ys.data(), points.xs.size(), threshold, outXs.data(), outYs.data());
+
+    ASSERT_EQ(threshold, count);
+    EXPECT_EQ(points.xs.front(), outXs[0]);
+    EXPECT_EQ(points.xs.back(), outXs[count - 1]);
+
+    // Every kept point is one of the input points, taken from its own bucket
+    double bucketSize = (double)(points.xs.size() - 2) / (double)(threshold - 2);
+
+    for (size_t i = 1; i + 1 < count; i++) {
+        ASSERT_LT(outXs[i - 1], outXs[i]);
+
+        size_t index = std::lower_bound(points.xs.begin(), points.xs.end(), outXs[i]) - points.xs.begin();
+
+        ASSERT_LT(index, points.xs.size());
+        ASSERT_EQ(points.ys[index], outYs[i]);
+        EXPECT_GE(index, (size_t)((i - 1) * bucketSize) + 1) << "point " << i;
+        EXPECT_LT(index, (size_t)(i * bucketSize) + 1) << "point " << i;
+    }
+}
+
+TEST(LineGraphDecimation, LargestTriangleCopiesRunsBelowThreshold) {
+    Points points = Series(100, 10.0f, 3);
+    std::vector<float> outXs(100), outYs(100);
+
+    ASSERT_EQ(100u, LineGraphDecimateLargestTriangle(points.xs.data(), points.ys.data(), 100, 100, outXs.data(), outYs.data()));
+    EXPECT_EQ(points.xs, outXs);
+    EXPECT_EQ(points.ys, outYs);
+
+    ASSERT_EQ(100u, LineGraphDecimateLargestTriangle(points.xs.data(), points.ys.data(), 100, 2, outXs.data(), outYs.data()));
+}
+
+TEST(LineGraphDecimation, ThresholdKeepsTwoPointsPerColumn) {
+    EXPECT_EQ(3u, LineGraphDecimationThreshold(0.0f, 0.5f));
+    EXPECT_EQ(642u, LineGraphDecimationThreshold(160.0f, 0.5f));
+    EXPECT_EQ(642u, LineGraphDecimationThreshold(-160.0f, 0.5f));
+}
@@ -0,0 +1,201 @@
+//
+//  LineGraphInterpolationTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "LineGraphInterpolation.h"
+}
+
+namespace {
+
+/** The nested loop LineGraphView used before, on plots without gaps */
+void ReferenceInterpolate(const std::vector<float> &plotXs, const std::vector<float> &xs, const std::vector<float> &ys,
+                          const std::vector<float> &targets, std::vector<float> &outXs, std::vector<float> &outYs) {
+    size_t count = xs.size();
+    size_t last = 0;
+    bool reachedEnd = false;
+
+    outXs.assign(targets.size(), 0.0f);
+    outYs.assign(targets.size(), 0.0f);
+    outXs[0] = xs[0];
+    outYs[0] = ys[0];
+
+    for (size_t i = 1; i < targets.size(); i++) {
+        float x = targets[i];
+        float lastX = xs[last], lastY = ys[last], lastPlotX = plotXs[last];
+
+        if (reachedEnd) {
+            outXs[i] = xs[count - 1];
+            outYs[i] = ys[count - 1];
+            continue;
+        }
+
+        if (x <= lastPlotX) {
+            outXs[i] = lastX;
+            outYs[i] = lastY;
+            continue;
+        }
+
+        bool found = false;
+
+        for (size_t next = last + 1; next < count && !found; next++) {
+            if (x < plotXs[next]) {
+                float xPoint = lastX + ((xs[next] - lastX) * ((x - lastPlotX) / (plotXs[next] - lastPlotX)));
+
+                outXs[i] = xPoint;
+                outYs[i] = lastY + ((ys[next] - lastY) * ((xPoint - lastX) / (xs[next] - lastX)));
+                found = true;
+            } else if (x == plotXs[next]) {
+                outXs[i] = xs[next];
+                outYs[i] = ys[next];
+                last = next;
+                found = true;
+            } else {
+                last = next;
+                lastX = xs[next];
+                lastY = ys[next];
+                lastPlotX = plotXs[next];
+            }
+        }
+
+        if (!found) {
+            outXs[i] = xs[count - 1];
+            outYs[i] = ys[count - 1];
+            reachedEnd = true;
+        }
+    }
+}
+
+struct Plot {
+    std::vector<float> plotXs;
+    std::vector<float> xs;
+    std::vector<float> ys;
+
+    Plot(size_t count, std::mt19937 &random) {
+        float x = (float)(random() % 5);
+
+        for (size_t i = 0; i < count; i++) {
+            x += (float)(1 + random() % 4);
+            xs.push_back(x);
+            plotXs.push_back(x * 3.0f + 1.0f);
+            ys.push_back((float)(random() % 100));
+        }
+    }
+
+    LineGraphInterpolationSource Source() const {
+        LineGraphInterpolationSource source = { plotXs.data(), xs.data(), ys.data(), xs.size() };
+        return source;
+    }
+};
+
+}
+
+TEST(LineGraphInterpolation, MergeKeepsAscendingUniqueValues) {
+    const float first[] = { 1, 3, NAN, 5, 7 };
+    const float second[] = { NAN, 2, 3, 7, 9 };
+    float out[10];
+
+    size_t count = LineGraphMergeSortedUnique(first, 5, second, 5, out);
+
+    const float expected[] = { 1, 2, 3, 5, 7, 9 };
+
+    ASSERT_EQ(6u, count);
+
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(expected[i], out[i]) << i;
+    }
+
+    EXPECT_EQ(0u, LineGraphMergeSortedUnique(first, 0, second, 1, out));
+}
+
+TEST(LineGraphInterpolation, MatchesTheNestedLoopWithoutGaps) {
+    std::mt19937 random(9);
+
+    for (int run = 0; run < 3000; run++) {
+        Plot from(1 + random() % 60, random);
+        Plot to(1 + random() % 60, random);
+        std::vector<float> targets(from.xs.size() + to.xs.size());
+
+        targets.resize(LineGraphMergeSortedUnique(from.plotXs.data(), from.xs.size(), to.plotXs.data(), to.xs.size(), targets.data()));
+
+        for (size_t i = 1; i < targets.size(); i++) {
+            ASSERT_LT(targets[i - 1], targets[i]);
+        }
+
+        std::vector<float> outXs(targets.size()), outYs(targets.size());
+        std::vector<float> expectedXs, expectedYs;
+        LineGraphInterpolationSource source = from.Source();
+
+        LineGraphInterpolateAtPlotX(&source, targets.data(), targets.size(), outXs.data(), outYs.data());
+        ReferenceInterpolate(from.plotXs, from.xs, from.ys, targets, expectedXs, expectedYs);
+
+        // Bit for bit, so replace animations look exactly as they did
+        for (size_t i = 0; i < targets.size(); i++) {
+            ASSERT_EQ(expectedXs[i], outXs[i]) << "run " << run << " target " << i;
+            ASSERT_EQ(expectedYs[i], outYs[i]) << "run " << run << " target " << i;
+        }
+    }
+}
+
+TEST(LineGraphInterpolation, HoldsThePointBeforeAGap) {
+    // Points at plot x 0, 10, gap, 30, 40
+    const float plotXs[] = { 0, 10, NAN, 30, 40 };
+    const float xs[] = { 0, 1, NAN, 3, 4 };
+    const float ys[] = { 0, 10, NAN, 30, 20 };
+    const float targets[] = { 0, 5, 10, 15, 30, 35, 50 };
+    float outXs[7], outYs[7];
+
+    LineGraphInterpolationSource source = { plotXs, xs, ys, 5 };
+
+    LineGraphInterpolateAtPlotX(&source, targets, 7, outXs, outYs);
+
+    const float expectedXs[] = { 0, 0.5f, 1, 1, 3, 3.5f, 4 };
+    const float expectedYs[] = { 0, 5, 10, 10, 30, 25, 20 };
+
+    for (size_t i = 0; i < 7; i++) {
+        EXPECT_FLOAT_EQ(expectedXs[i], outXs[i]) << i;
+        EXPECT_FLOAT_EQ(expectedYs[i], outYs[i]) << i;
+    }
+}
+
+TEST(LineGraphInterpolation, NeverCrossesAGap) {
+    std::mt19937 random(10);
+
+    for (int run = 0; run < 1000; run++) {
+        Plot from(5 + random() % 40, random);
+        Plot to(1 + random() % 40, random);
+        std::vector<float> targets(from.xs.size() + to.xs.size());
+
+        targets.resize(LineGraphMergeSortedUnique(from.plotXs.data(), from.xs.size(), to.plotXs.data(), to.xs.size(), targets.data()));
+
+        size_t gap = 1 + random() % (from.xs.size() - 2);
+        float before = from.plotXs[gap - 1];
+        float after = from.plotXs[gap + 1];
+
+        from.plotXs[gap] = from.xs[gap] = from.ys[gap] = NAN;
+
+        std::vector<float> outXs(targets.size()), outYs(targets.size());
+        LineGraphInterpolationSource source = from.Source();
+
+        LineGraphInterpolateAtPlotX(&source, targets.data(), targets.size(), outXs.data(), outYs.data());
+
+        for (size_t i = 0; i < targets.size(); i++) {
+            ASSERT_FALSE(std::isnan(outXs[i]));
+            ASSERT_FALSE(std::isnan(outYs[i]));
+
+            if (targets[i] > before && targets[i] < after) {
+                ASSERT_EQ(from.xs[gap - 1], outXs[i]);
+                ASSERT_EQ(from.ys[gap - 1], outYs[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,137 @@
+//
+//  LineGraphLabelExtentsTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "LineGraphLabelExtents.h"
+}
+
+namespace {
+
+void ExpectMatches(const std::deque<LineGraphLabelExtent> &expected, const LineGraphLabelExtents &extents) {
+    float maxWidth = 0, maxHeight = 0;
+
+    ASSERT_EQ(expected.size(), extents.count);
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        const LineGraphLabelExtent *extent = LineGraphLabelExtentsAt(&extents, i);
+
+        ASSERT_EQ(expected[i].value, extent->value);
+        ASSERT_EQ(expected[i].width, extent->width);
+        ASSERT_EQ(expected[i].height, extent->height);
+
+        maxWidth = std::max(maxWidth, extent->width);
+        maxHeight = std::max(maxHeight, extent->height);
+    }
+
+    ASSERT_EQ(maxWidth, extents.maxWidth);
+    ASSERT_EQ(maxHeight, extents.maxHeight);
+}
+
+}
+
+TEST(LineGraphLabelExtents, ScrollingKeepsLabelsAndMaxima) {
+    LineGraphLabelExtents extents;
+    std::deque<LineGraphLabelExtent> expected;
+    std::mt19937 random(1);
+    float low = 0, high = 0;
+
+    LineGraphLabelExtentsInit(&extents);
+
+    for (int i = 0; i < 20000; i++) {
+        // Few distinct sizes, so several labels often share the maximum
+        LineGraphLabelExtent extent = { 0, (float)(10 + random() % 6), (float)(12 + random() % 3) };
+
+        if (expected.empty() || random() % 2 == 0) {
+            extent.value = expected.empty() ? high : ++high;
+            ASSERT_TRUE(LineGraphLabelExtentsAppend(&extents, extent.value, extent.width, extent.height));
+            expected.push_back(extent);
+        } else {
+            extent.value = --low;
+            ASSERT_TRUE(LineGraphLabelExtentsPrepend(&extents, extent.value, extent.width, extent.height));
+            expected.push_front(extent);
+        }
+
+        // The visible range wanders, trimming labels from either end
+        if (expected.size() > 20) {
+            float minValue = expected.front().value + (float)(random() % 4);
+            float maxValue = expected.back().value - (float)(random() % 4);
+
+            LineGraphLabelExtentsTrim(&extents, minValue, maxValue);
+
+            while (!expected.empty() && expected.front().value < minValue) {
+                expected.pop_front();
+            }
+
+            while (!expected.empty() && expected.back().value > maxValue) {
+                expected.pop_back();
+            }
+
+            if (!expected.empty()) {
+                low = expected.front().value;
+                high = expected.back().value;
+            }
+        }
+
+        ExpectMatches(expected, extents);
+        ASSERT_TRUE(extents.isAscending);
+    }
+
+    LineGraphLabelExtentsDestroy(&extents);
+}
+
+TEST(LineGraphLabelExtents, TrimmingEverythingResets) {
+    LineGraphLabelExtents extents;
+
+    LineGraphLabelExtentsInit(&extents);
+
+    ASSERT_TRUE(LineGraphLabelExtentsAppend(&extents, 1, 30, 10));
+    ASSERT_TRUE(LineGraphLabelExtentsAppend(&extents, 1, 20, 10));
+    EXPECT_FALSE(extents.isAscending);
+
+    LineGraphLabelExtentsTrim(&extents, 5, 6);
+
+    EXPECT_EQ(0u, extents.count);
+    EXPECT_EQ(0, extents.maxWidth);
+    EXPECT_TRUE(extents.isAscending);
+
+    ASSERT_TRUE(LineGraphLabelExtentsPrepend(&extents, 2, 15, 11));
+    EXPECT_EQ(15, extents.maxWidth);
+    EXPECT_EQ(11, extents.maxHeight);
+
+    LineGraphLabelExtentsDestroy(&extents);
+}
+
+TEST(LineGraphLabelExtents, FailedAppendLeavesLabelsUnchanged) {
+    LineGraphLabelExtents extents;
+
+    LineGraphLabelExtentsInit(&extents);
+
+    for (int i = 0; i < 16; i++) {
+        ASSERT_TRUE(LineGraphLabelExtentsAppend(&extents, (float)i, 10, 10));
+    }
+
+    {
+        HMOTestAllocationFailure failure(0);
+
+        EXPECT_FALSE(LineGraphLabelExtentsAppend(&extents, 16, 50, 50));
+        EXPECT_FALSE(LineGraphLabelExtentsPrepend(&extents, -1, 50, 50));
+    }
+
+    EXPECT_EQ(16u, extents.count);
+    EXPECT_EQ(10, extents.maxWidth);
+    EXPECT_EQ(16u, extents.maxWidthCount);
+
+    LineGraphLabelExtentsDestroy(&extents);
+}
@@ -0,0 +1,132 @@
+//
+//  LineGraphPointIndexBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "LineGraphPointIndex.h"
+}
+
+namespace {
+
+const size_t LineGraphPointIndexBenchmarkCount = 1000000;
+const size_t LineGraphPointIndexBenchmarkLookups = 4096;
+
+/** Series kinds, passed as the benchmark argument */
+enum { Uniform, Jittered, Gapped };
+
+struct Series {
+    LineGraphPointIndex index;
+    std::vector<float> lookups;
+
+    explicit Series(int kind) {
+        std::mt19937 random(1);
+        std::vector<float> xs;
+        std::vector<float> ys(LineGraphPointIndexBenchmarkCount, 0.0f);
+
+        for (size_t i = 0; i < LineGraphPointIndexBenchmarkCount; i++) {
+            float x = (float)i;
+
+            if (kind == Jittered) {
+                x += (float)((int)(random() % 100) - 50) / 150.0f;
+            } else if (kind == Gapped && i > LineGraphPointIndexBenchmarkCount / 2) {
+                x += 5000.0f;
+            }
+
+            xs.push_back(x);
+        }
+
+        LineGraphPointIndexInit(&index);
+        LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size());
+
+        std::uniform_real_distribution<float> distribution(xs.front(), xs.back());
+
+        for (size_t i = 0; i < LineGraphPointIndexBenchmarkLookups; i++) {
+            lookups.push_back(distribution(random));
+        }
+    }
+
+    ~Series() {
+        LineGraphPointIndexDestroy(&index);
+    }
+};
+
+/** Interpolation search, the other way of guessing a position from the values, kept here for comparison */
+size_t InterpolationSearch(const float *xs, size_t count, float x) {
+    size_t low = 0, high = count;
+
+    while (low < high) {
+        float lowX = xs[low], highX = xs[high - 1];
+
+        if (x <= lowX) {
+            return low;
+        }
+
+        if (x > highX) {
+            return high;
+        }
+
+        size_t position = low + (size_t)((double)(x - lowX) / (highX - lowX) * (double)(high - 1 - low));
+
+        if (xs[position] < x) {
+            low = position + 1;
+        } else {
+            high = position;
+        }
+    }
+
+    return low;
+}
+
+}
+
+/** Index arithmetic on evenly spaced series, which falls back to binary search on gapped ones */
+static void LineGraphPointIndexLowerBound(benchmark::State &state) {
+    Series series((int)state.range(0));
+    size_t lookup = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LineGraphPointIndexLowerBound(&series.index, series.lookups[lookup]));
+        lookup = (lookup + 1) % LineGraphPointIndexBenchmarkLookups;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["spacing"] = series.index.spacing;
+}
+
+static void LineGraphPointIndexBinarySearch(benchmark::State &state) {
+    Series series((int)state.range(0));
+    size_t lookup = 0;
+
+    series.index.spacing = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(LineGraphPointIndexLowerBound(&series.index, series.lookups[lookup]));
+        lookup = (lookup + 1) % LineGraphPointIndexBenchmarkLookups;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void LineGraphPointIndexInterpolationSearch(benchmark::State &state) {
+    Series series((int)state.range(0));
+    size_t lookup = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(InterpolationSearch(series.index.xs, series.index.count, series.lookups[lookup]));
+        lookup = (lookup + 1) % LineGraphPointIndexBenchmarkLookups;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(LineGraphPointIndexLowerBound)->Arg(Uniform)->Arg(Jittered)->Arg(Gapped);
+BENCHMARK(LineGraphPointIndexBinarySearch)->Arg(Uniform)->Arg(Jittered)->Arg(Gapped);
+BENCHMARK(LineGraphPointIndexInterpolationSearch)->Arg(Uniform)->Arg(Jittered)->Arg(Gapped);
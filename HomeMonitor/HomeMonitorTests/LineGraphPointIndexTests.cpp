@@ -0,0 +1,185 @@
+//
+//  LineGraphPointIndexTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "LineGraphPointIndex.h"
+}
+
+namespace {
+
+enum class Spacing { Uniform, Jittered, Gapped };
+
+std::vector<float> MakeXs(Spacing spacing, size_t count, std::mt19937 &random) {
+    std::vector<float> xs;
+
+    for (size_t i = 0; i < count; i++) {
+        float x = (float)i;
+
+        if (spacing == Spacing::Jittered) {
+            x += (float)((int)(random() % 100) - 50) / 150.0f;
+        } else if (spacing == Spacing::Gapped && i > count / 2) {
+            x += 5000.0f;
+        }
+
+        xs.push_back(x);
+    }
+
+    return xs;
+}
+
+void ExpectLookupsMatch(const LineGraphPointIndex &index, std::mt19937 &random, float low, float high) {
+    std::uniform_real_distribution<float> distribution(low, high);
+    std::vector<float> xs(index.xs, index.xs + index.count);
+
+    for (int i = 0; i < 5000; i++) {
+        // Half of the lookups land exactly on a point
+        float x = (i % 2 == 0) ? distribution(random) : xs[random() % xs.size()];
+        size_t lowerBound = (size_t)(std::lower_bound(xs.begin(), xs.end(), x) - xs.begin());
+
+        ASSERT_EQ(lowerBound, LineGraphPointIndexLowerBound(&index, x)) << "x " << x;
+
+        // Ties go to the higher point
+        size_t closest = lowerBound;
+
+        if (lowerBound == xs.size() || (lowerBound > 0 && x - xs[lowerBound - 1] < xs[lowerBound] - x)) {
+            closest = lowerBound - 1;
+        }
+
+        ASSERT_EQ(closest, LineGraphPointIndexClosest(&index, x)) << "x " << x;
+    }
+}
+
+}
+
+TEST(LineGraphPointIndex, DetectsEvenSpacing) {
+    std::mt19937 random(1);
+    LineGraphPointIndex index;
+
+    LineGraphPointIndexInit(&index);
+
+    std::vector<float> xs = MakeXs(Spacing::Uniform, 1000, random);
+    std::vector<float> ys(xs.size(), 1.0f);
+
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+    EXPECT_FLOAT_EQ(1.0f, index.spacing);
+
+    LineGraphPointIndexRemoveAll(&index);
+    xs = MakeXs(Spacing::Jittered, 1000, random);
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+    EXPECT_GT(index.spacing, 0.0f);
+
+    LineGraphPointIndexRemoveAll(&index);
+    xs = MakeXs(Spacing::Gapped, 1000, random);
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+    EXPECT_EQ(0.0f, index.spacing);
+
+    LineGraphPointIndexDestroy(&index);
+}
+
+TEST(LineGraphPointIndex, LookupsMatchBinarySearch) {
+    std::mt19937 random(2);
+
+    for (Spacing spacing : { Spacing::Uniform, Spacing::Jittered, Spacing::Gapped }) {
+        LineGraphPointIndex index;
+        std::vector<float> xs = MakeXs(spacing, 100000, random);
+        std::vector<float> ys(xs.size(), 1.0f);
+
+        LineGraphPointIndexInit(&index);
+        ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+
+        // Lookups reach past both ends of the points
+        ExpectLookupsMatch(index, random, -100.0f, xs.back() + 100.0f);
+
+        LineGraphPointIndexDestroy(&index);
+    }
+}
+
+TEST(LineGraphPointIndex, SmallIndexesMatchBinarySearch) {
+    std::mt19937 random(3);
+
+    for (int run = 0; run < 500; run++) {
+        LineGraphPointIndex index;
+        std::vector<float> xs;
+        std::vector<float> ys;
+
+        for (size_t i = 1 + random() % 12; i > 0; i--) {
+            xs.push_back((float)(xs.size() * 2 + random() % 3));
+            ys.push_back(0.0f);
+        }
+
+        LineGraphPointIndexInit(&index);
+        ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+
+        ExpectLookupsMatch(index, random, -3.0f, 30.0f);
+
+        LineGraphPointIndexDestroy(&index);
+    }
+}
+
+TEST(LineGraphPointIndex, MergesRunsInXOrder) {
+    LineGraphPointIndex index;
+
+    LineGraphPointIndexInit(&index);
+
+    const float firstXs[] = { 0, 2, 4, 6 };
+    const float firstYs[] = { 10, 12, 14, 16 };
+
+    // The second run is unsorted, and its point at 4 comes after the one already merged
+    const float secondXs[] = { 5, 1, 4, 7 };
+    const float secondYs[] = { 25, 21, 24, 27 };
+
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, firstXs, firstYs, 4));
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, secondXs, secondYs, 4));
+
+    const float expectedXs[] = { 0, 1, 2, 4, 4, 5, 6, 7 };
+    const float expectedYs[] = { 10, 21, 12, 14, 24, 25, 16, 27 };
+
+    ASSERT_EQ(8u, index.count);
+
+    for (size_t i = 0; i < 8; i++) {
+        EXPECT_EQ(expectedXs[i], index.xs[i]) << i;
+        EXPECT_EQ(expectedYs[i], index.ys[i]) << i;
+    }
+
+    EXPECT_EQ(3u, LineGraphPointIndexLowerBound(&index, 4));
+    EXPECT_EQ(5u, LineGraphPointIndexClosest(&index, 4.5f));
+
+    LineGraphPointIndexDestroy(&index);
+}
+
+TEST(LineGraphPointIndex, FailedMergeLeavesTheIndexUnchanged) {
+    LineGraphPointIndex index;
+    std::vector<float> xs(64);
+    std::vector<float> ys(64, 0.0f);
+
+    for (size_t i = 0; i < xs.size(); i++) {
+        xs[i] = (float)i;
+    }
+
+    LineGraphPointIndexInit(&index);
+    ASSERT_TRUE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+
+    {
+        HMOTestAllocationFailure failure(0);
+
+        EXPECT_FALSE(LineGraphPointIndexMergePoints(&index, xs.data(), ys.data(), xs.size()));
+    }
+
+    EXPECT_EQ(64u, index.count);
+    EXPECT_EQ(1.0f, index.spacing);
+    EXPECT_EQ(40u, LineGraphPointIndexLowerBound(&index, 39.5f));
+
+    LineGraphPointIndexDestroy(&index);
+}
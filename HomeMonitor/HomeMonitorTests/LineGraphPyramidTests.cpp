@@ -0,0 +1,207 @@
+//
+//  LineGraphPyramidTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "LineGraphPyramid.h"
+}
+
+namespace {
+
+// Points are appended at x = index, so a bucket's x range is also its index range
+void ExpectSummary(const std::vector<float> &ys, size_t first, size_t last, const LineGraphPyramidBucket &bucket) {
+    ASSERT_LE(first, last);
+    ASSERT_LT(last, ys.size());
+
+    float min = *std::min_element(ys.begin() + first, ys.begin() + last + 1);
+    float max = *std::max_element(ys.begin() + first, ys.begin() + last + 1);
+    double sum = 0;
+
+    for (size_t i = first; i <= last; i++) {
+        sum += ys[i];
+    }
+
+    EXPECT_EQ((double)first, bucket.firstX);
+    EXPECT_EQ((double)last, bucket.lastX);
+    EXPECT_EQ(last - first + 1, bucket.count);
+    EXPECT_EQ(min, bucket.min);
+    EXPECT_EQ(max, bucket.max);
+    EXPECT_EQ(sum, bucket.sum);
+    EXPECT_EQ(min, ys[(size_t)bucket.minX]);
+    EXPECT_EQ(max, ys[(size_t)bucket.maxX]);
+}
+
+// Checks every level against the live points, which start at evicted
+void ExpectLevelsMatch(const LineGraphPyramid &pyramid, const std::vector<float> &ys, size_t evicted) {
+    for (size_t level = 0; level < pyramid.levelCount; level++) {
+        const LineGraphPyramidLevel &pyramidLevel = pyramid.levels[level];
+        size_t count = 0;
+        const LineGraphPyramidBucket *buckets = LineGraphPyramidBucketsInRange(&pyramid, level, -INFINITY, INFINITY, &count);
+
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_GE(buckets[i].firstX, (double)evicted);
+            ExpectSummary(ys, (size_t)buckets[i].firstX, (size_t)buckets[i].lastX, buckets[i]);
+        }
+
+        // The tail covers every live point after the last completed bucket
+        size_t tailFirst = evicted;
+
+        if (pyramidLevel.count > 0) {
+            tailFirst = std::max(tailFirst, (size_t)pyramidLevel.buckets[pyramidLevel.offset + pyramidLevel.count - 1].lastX + 1);
+        }
+
+        LineGraphPyramidBucket tail;
+
+        if (tailFirst < ys.size()) {
+            ASSERT_TRUE(LineGraphPyramidTailBucket(&pyramid, level, &tail)) << "level " << level;
+            ExpectSummary(ys, tailFirst, ys.size() - 1, tail);
+        } else {
+            EXPECT_FALSE(LineGraphPyramidTailBucket(&pyramid, level, &tail)) << "level " << level;
+        }
+    }
+}
+
+}
+
+TEST(LineGraphPyramid, LevelsSummarizeTheirPoints) {
+    LineGraphPyramid pyramid;
+    std::mt19937 random(1);
+    std::vector<float> ys;
+
+    LineGraphPyramidInit(&pyramid);
+
+    for (int i = 0; i < 100003; i++) {
+        ys.push_back((float)(random() % 1000));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+    }
+
+    // 100003 points fill 12500 base buckets, which complete a bucket on level 13 and start one on level 14
+    EXPECT_EQ(15u, pyramid.levelCount);
+    ExpectLevelsMatch(pyramid, ys, 0);
+
+    EXPECT_FALSE(LineGraphPyramidAppend(&pyramid, 5, 1));
+    EXPECT_FALSE(pyramid.isValid);
+
+    LineGraphPyramidDestroy(&pyramid);
+}
+
+TEST(LineGraphPyramid, TailKeepsTheLivePartOfPartlyEvictedPendingBuckets) {
+    LineGraphPyramid pyramid;
+    std::vector<float> ys;
+
+    LineGraphPyramidInit(&pyramid);
+
+    // 120 points complete a 64 point bucket on level 3, which is also pending on level 4
+    for (int i = 0; i < 120; i++) {
+        ys.push_back((float)((i * 37) % 101));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+    }
+
+    ASSERT_EQ(64u, pyramid.levels[4].pending.count);
+
+    // Level 3 is left with a partly evicted bucket only
+    LineGraphPyramidEvictBefore(&pyramid, 32);
+
+    EXPECT_EQ(3u, pyramid.levelCount);
+    ExpectLevelsMatch(pyramid, ys, 32);
+
+    // Completing the first level 4 bucket brings levels 3 and 4 back, with a pending bucket on level 5 that is
+    // a quarter evicted
+    for (int i = 120; i < 192; i++) {
+        ys.push_back((float)((i * 37) % 101));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+    }
+
+    ASSERT_EQ(6u, pyramid.levelCount);
+    ASSERT_EQ(128u, pyramid.levels[5].pending.count);
+
+    // The live part is rebuilt from the levels below
+    LineGraphPyramidBucket tail;
+
+    ASSERT_TRUE(LineGraphPyramidTailBucket(&pyramid, 5, &tail));
+    ExpectSummary(ys, 32, 191, tail);
+    ExpectLevelsMatch(pyramid, ys, 32);
+
+    LineGraphPyramidDestroy(&pyramid);
+}
+
+TEST(LineGraphPyramid, SlidingWindowMatchesItsPoints) {
+    LineGraphPyramid pyramid;
+    std::mt19937 random(2);
+    std::vector<float> ys;
+    size_t evicted = 0;
+
+    LineGraphPyramidInit(&pyramid);
+
+    for (int i = 0; i < 60000; i++) {
+        ys.push_back((float)(random() % 1000));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+
+        // Points of a partly evicted base bucket are gone, so evict on base bucket boundaries only
+        size_t window = 2000 + (i / 7000) * 1500;
+
+        if (ys.size() > window && (ys.size() - window) % 8 == 0 && (ys.size() - window) / 8 % 25 == 0) {
+            evicted = ys.size() - window;
+            LineGraphPyramidEvictBefore(&pyramid, evicted);
+        }
+
+        if (i % 997 == 0) {
+            ExpectLevelsMatch(pyramid, ys, evicted);
+        }
+    }
+
+    ExpectLevelsMatch(pyramid, ys, evicted);
+
+    LineGraphPyramidDestroy(&pyramid);
+}
+
+TEST(LineGraphPyramid, EvictionShrinksLevelCount) {
+    LineGraphPyramid pyramid;
+    std::vector<float> ys;
+
+    LineGraphPyramidInit(&pyramid);
+
+    for (int i = 0; i < 4096; i++) {
+        ys.push_back((float)(i % 17));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+    }
+
+    // 4096 points complete a single 4096 point bucket on level 9, which is pending on level 10
+    ASSERT_EQ(11u, pyramid.levelCount);
+
+    // The last 16 points are whole buckets on levels 0 and 1 only
+    LineGraphPyramidEvictBefore(&pyramid, 4080);
+
+    EXPECT_EQ(2u, pyramid.levelCount);
+    ExpectLevelsMatch(pyramid, ys, 4080);
+
+    size_t level = 0;
+
+    EXPECT_TRUE(LineGraphPyramidLevelForColumnWidth(&pyramid, 1000, &level));
+    EXPECT_EQ(1u, level);
+
+    LineGraphPyramidEvictBefore(&pyramid, 4096);
+
+    EXPECT_EQ(0u, pyramid.levelCount);
+
+    // The pyramid grows back from empty levels, without the evicted bucket pending on level 10
+    for (int i = 4096; i < 4096 + 64; i++) {
+        ys.push_back((float)(i % 5));
+        ASSERT_TRUE(LineGraphPyramidAppend(&pyramid, i, ys.back()));
+    }
+
+    EXPECT_EQ(5u, pyramid.levelCount);
+    EXPECT_EQ(0u, pyramid.levels[10].pending.count);
+    ExpectLevelsMatch(pyramid, ys, 4096);
+
+    LineGraphPyramidDestroy(&pyramid);
+}
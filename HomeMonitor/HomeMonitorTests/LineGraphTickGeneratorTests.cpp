@@ -0,0 +1,299 @@
+//
+//  LineGraphTickGeneratorTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "LineGraphTickGenerator.h"
+}
+
+namespace {
+
+/**
+ Exact decimal arithmetic standing in for NSDecimalNumber, with a 128-bit mantissa so the values used here
+ never lose digits.  Results are rounded to a scale with NSRoundPlain, halfway cases away from zero.
+*/
+struct ReferenceDecimal {
+    __int128 mantissa;
+    int exponent;
+
+    static ReferenceDecimal Parse(const std::string &string) {
+        ReferenceDecimal decimal = { 0, 0 };
+        bool isNegative = false;
+        bool hasPoint = false;
+
+        for (char character : string) {
+            if (character == '-') {
+                isNegative = true;
+            } else if (character == '.') {
+                hasPoint = true;
+            } else {
+                decimal.mantissa = decimal.mantissa * 10 + (character - '0');
+                decimal.exponent -= hasPoint ? 1 : 0;
+            }
+        }
+
+        if (isNegative) {
+            decimal.mantissa = -decimal.mantissa;
+        }
+
+        return decimal;
+    }
+
+    static __int128 PowerOfTen(int power) {
+        __int128 result = 1;
+
+        for (int i = 0; i < power; i++) {
+            result *= 10;
+        }
+
+        return result;
+    }
+
+    ReferenceDecimal WithExponent(int newExponent) const {
+        return { mantissa * PowerOfTen(exponent - newExponent), newExponent };
+    }
+
+    ReferenceDecimal operator+(const ReferenceDecimal &other) const {
+        int common = std::min(exponent, other.exponent);
+        return { WithExponent(common).mantissa + other.WithExponent(common).mantissa, common };
+    }
+
+    ReferenceDecimal operator-(const ReferenceDecimal &other) const {
+        return *this + ReferenceDecimal { -other.mantissa, other.exponent };
+    }
+
+    ReferenceDecimal operator*(const ReferenceDecimal &other) const {
+        return { mantissa * other.mantissa, exponent + other.exponent };
+    }
+
+    bool operator<=(const ReferenceDecimal &other) const {
+        int common = std::min(exponent, other.exponent);
+        return WithExponent(common).mantissa <= other.WithExponent(common).mantissa;
+    }
+
+    ReferenceDecimal Rounded(short scale) const {
+        if (scale == LINE_GRAPH_DECIMAL_NO_SCALE || -scale <= exponent) {
+            return *this;
+        }
+
+        __int128 unit = PowerOfTen(-scale - exponent);
+        __int128 quotient = mantissa / unit;
+        __int128 remainder = mantissa % unit;
+
+        if (remainder * 2 >= unit) {
+            quotient += 1;
+        } else if (-remainder * 2 >= unit) {
+            quotient -= 1;
+        }
+
+        return { quotient, -scale };
+    }
+
+    std::string String() const {
+        __int128 value = mantissa;
+        int valueExponent = exponent;
+
+        if (value == 0) {
+            return "0";
+        }
+
+        while (value % 10 == 0) {
+            value /= 10;
+            valueExponent += 1;
+        }
+
+        std::string digits;
+
+        for (__int128 magnitude = (value < 0) ? -value : value; magnitude > 0; magnitude /= 10) {
+            digits.insert(digits.begin(), (char)('0' + (int)(magnitude % 10)));
+        }
+
+        if (valueExponent >= 0) {
+            digits.append((size_t)valueExponent, '0');
+        } else {
+            size_t fractionLength = (size_t)-valueExponent;
+
+            if (digits.size() <= fractionLength) {
+                digits.insert(0, fractionLength - digits.size() + 1, '0');
+            }
+
+            digits.insert(digits.size() - fractionLength, ".");
+        }
+
+        return (value < 0) ? "-" + digits : digits;
+    }
+
+    double DoubleValue() const {
+        return std::strtod(String().c_str(), nullptr);
+    }
+};
+
+/** The loop -[LineGraphTickInterval ticksForStart:end:] ran before, which also stops once the interval no
+ longer advances */
+std::vector<std::string> ReferenceTicks(const std::string &interval, const std::string &offset, short scale, double start, double end) {
+    ReferenceDecimal decimalInterval = ReferenceDecimal::Parse(interval);
+    ReferenceDecimal decimalOffset = ReferenceDecimal::Parse(offset);
+    double steps = std::floor((start + decimalOffset.DoubleValue()) / decimalInterval.DoubleValue());
+    ReferenceDecimal value = ((ReferenceDecimal { (__int128)steps, 0 } * decimalInterval).Rounded(scale) - decimalOffset).Rounded(scale);
+    std::vector<std::string> ticks;
+
+    while (value.DoubleValue() <= end && ticks.size() < 1000) {
+        if (value.DoubleValue() >= start) {
+            ticks.push_back(value.String());
+        }
+
+        ReferenceDecimal next = (value + decimalInterval).Rounded(scale);
+
+        if (next <= value) {
+            break;
+        }
+
+        value = next;
+    }
+
+    return ticks;
+}
+
+std::vector<std::string> GeneratedTicks(const std::string &interval, const std::string &offset, short scale, double start, double end) {
+    LineGraphDecimal decimalInterval, decimalOffset;
+    LineGraphDecimal ticks[1000];
+    char string[LINE_GRAPH_DECIMAL_STRING_LENGTH];
+    std::vector<std::string> labels;
+
+    EXPECT_TRUE(LineGraphDecimalParse(interval.c_str(), &decimalInterval));
+    EXPECT_TRUE(LineGraphDecimalParse(offset.c_str(), &decimalOffset));
+
+    long count = LineGraphTicksGenerate(decimalInterval, std::atof(interval.c_str()), decimalOffset, std::atof(offset.c_str()),
+                                        scale, start, end, ticks, 1000);
+
+    EXPECT_GE(count, 0);
+
+    for (long i = 0; i < count; i++) {
+        LineGraphDecimalFormat(ticks[i], string);
+        labels.push_back(string);
+
+        EXPECT_EQ(std::strtod(string, nullptr), LineGraphDecimalToDouble(ticks[i])) << string;
+    }
+
+    return labels;
+}
+
+}
+
+TEST(LineGraphTickGenerator, ParsesAndFormatsPlainDecimals) {
+    const char *strings[] = { "0", "1", "-12.5", "0.001", "-0.25", "1000", "123456789.123456789" };
+    char string[LINE_GRAPH_DECIMAL_STRING_LENGTH];
+
+    for (const char *expected : strings) {
+        LineGraphDecimal decimal;
+
+        ASSERT_TRUE(LineGraphDecimalParse(expected, &decimal)) << expected;
+        LineGraphDecimalFormat(decimal, string);
+        EXPECT_STREQ(expected, string);
+    }
+
+    LineGraphDecimal decimal;
+
+    // Trailing zeros are dropped like NSDecimalNumber does
+    ASSERT_TRUE(LineGraphDecimalParse("-12.50", &decimal));
+    LineGraphDecimalFormat(decimal, string);
+    EXPECT_STREQ("-12.5", string);
+
+    EXPECT_FALSE(LineGraphDecimalParse("1e5", &decimal));
+    EXPECT_FALSE(LineGraphDecimalParse("", &decimal));
+    EXPECT_FALSE(LineGraphDecimalParse("-", &decimal));
+    EXPECT_FALSE(LineGraphDecimalParse("1.2.3", &decimal));
+    EXPECT_FALSE(LineGraphDecimalParse("12345678901234567890", &decimal));
+}
+
+TEST(LineGraphTickGenerator, MatchesDecimalArithmeticOnRandomRanges) {
+    const char *intervals[] = { "1", "2", "5", "0.5", "0.25", "0.1", "0.2", "0.3", "10", "25", "100", "0.05", "0.001",
+                                "1.5", "3", "7.5", "0.125", "1000", "0.0001", "0.33", "0.7" };
+    const char *offsets[] = { "0", "0.5", "-0.25", "1", "0.1", "-3", "2.5", "0.05", "0.001" };
+    const short scales[] = { LINE_GRAPH_DECIMAL_NO_SCALE, 0, 1, 2, 3, -1 };
+    const double widths[] = { 1, 10, 100, 3.3, 0.5, 50 };
+    std::mt19937 random(4);
+    std::uniform_real_distribution<double> unit(0, 1);
+    size_t tickCount = 0;
+
+    for (int run = 0; run < 4000; run++) {
+        std::string interval = intervals[random() % 21];
+        std::string offset = offsets[random() % 9];
+        short scale = scales[random() % 6];
+        double start = unit(random) * 2000 - 1000;
+
+        if (run % 5 == 0) {
+            start = std::round(start);
+        }
+
+        double end = start + widths[random() % 6] * unit(random);
+
+        std::vector<std::string> expected = ReferenceTicks(interval, offset, scale, start, end);
+
+        ASSERT_EQ(expected, GeneratedTicks(interval, offset, scale, start, end))
+            << "interval " << interval << " offset " << offset << " scale " << scale << " range " << start << " " << end;
+
+        tickCount += expected.size();
+    }
+
+    // Enough ticks to cover every rounding case
+    EXPECT_GT(tickCount, 100000u);
+}
+
+TEST(LineGraphTickGenerator, StopsWhenTheIntervalRoundsAway) {
+    LineGraphDecimal interval, offset;
+    LineGraphDecimal ticks[10];
+
+    ASSERT_TRUE(LineGraphDecimalParse("0.25", &interval));
+    ASSERT_TRUE(LineGraphDecimalParse("0", &offset));
+
+    // With no decimal places, 0 + 0.25 rounds back to 0, which used to loop forever
+    EXPECT_EQ(1, LineGraphTicksGenerate(interval, 0.25, offset, 0, 0, 0, 10, ticks, 10));
+}
+
+TEST(LineGraphTickGenerator, ReportsRangesTooLargeForFixedPoint) {
+    LineGraphDecimal interval, offset;
+    LineGraphDecimal ticks[10];
+
+    ASSERT_TRUE(LineGraphDecimalParse("0.000000001", &interval));
+    ASSERT_TRUE(LineGraphDecimalParse("0", &offset));
+
+    EXPECT_EQ(-1, LineGraphTicksGenerate(interval, 1e-9, offset, 0, LINE_GRAPH_DECIMAL_NO_SCALE, 1e12, 1e12 + 1, ticks, 10));
+}
+
+TEST(LineGraphTickGenerator, NiceStepsAreOneTwoOrFiveTimesAPowerOfTen) {
+    const double minimumSteps[] = { 1, 1.0001, 2, 2.5, 5, 7, 10, 0.003, 0.0011, 999, 1e-7 };
+    const char *expected[] = { "1", "2", "2", "5", "5", "10", "10", "0.005", "0.002", "1000", "0.0000001" };
+    char string[LINE_GRAPH_DECIMAL_STRING_LENGTH];
+
+    for (size_t i = 0; i < sizeof(minimumSteps) / sizeof(minimumSteps[0]); i++) {
+        LineGraphDecimalFormat(LineGraphNiceStep(minimumSteps[i]), string);
+        EXPECT_STREQ(expected[i], string) << minimumSteps[i];
+    }
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<double> exponent(-6, 6);
+
+    for (int i = 0; i < 10000; i++) {
+        double minimumStep = std::pow(10, exponent(random));
+        LineGraphDecimal step = LineGraphNiceStep(minimumStep);
+        double value = LineGraphDecimalToDouble(step);
+
+        // The smallest such step, so the one below it is too small
+        ASSERT_TRUE(step.mantissa == 1 || step.mantissa == 2 || step.mantissa == 5);
+        ASSERT_GE(value, minimumStep * (1 - 1e-12));
+        ASSERT_LT(LineGraphDecimalToDouble(LineGraphNiceStepBelow(step)), minimumStep);
+    }
+}
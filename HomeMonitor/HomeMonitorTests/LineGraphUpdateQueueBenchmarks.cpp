@@ -0,0 +1,122 @@
+//
+//  LineGraphUpdateQueueBenchmarks.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+extern "C" {
+#include "LineGraphUpdateQueue.h"
+}
+
+namespace {
+
+/** Same as LineGraphUpdateScheduler */
+const size_t LineGraphUpdateQueueBenchmarkCapacity = 1024;
+
+}
+
+/** One frame's worth of appends pushed and drained on a single thread */
+static void LineGraphUpdateQueuePushPop(benchmark::State &state) {
+    LineGraphUpdateQueue queue;
+    LineGraphUpdate updates[LineGraphUpdateQueueBenchmarkCapacity];
+    size_t batchSize = (size_t)state.range(0);
+
+    LineGraphUpdateQueueInit(&queue, LineGraphUpdateQueueBenchmarkCapacity);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < batchSize; i++) {
+            LineGraphUpdate update = { kLineGraphUpdateAppend, (uint32_t)(i % 3), 0, 1 };
+            LineGraphUpdateQueuePush(&queue, &update);
+        }
+
+        benchmark::DoNotOptimize(LineGraphUpdateQueuePopBatch(&queue, updates, LineGraphUpdateQueueBenchmarkCapacity));
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+/** Sensor threads pushing while the main thread drains, every iteration takes 4096 updates */
+static void LineGraphUpdateQueueProducers(benchmark::State &state) {
+    LineGraphUpdateQueue queue;
+    LineGraphUpdate updates[LineGraphUpdateQueueBenchmarkCapacity];
+    std::atomic<bool> isRunning(true);
+    std::thread producers[4];
+    int producerCount = (int)state.range(0);
+
+    LineGraphUpdateQueueInit(&queue, LineGraphUpdateQueueBenchmarkCapacity);
+
+    for (int i = 0; i < producerCount; i++) {
+        producers[i] = std::thread([&queue, &isRunning, i] {
+            LineGraphUpdate update = { kLineGraphUpdateAppend, (uint32_t)i, 0, 1 };
+
+            while (isRunning.load(std::memory_order_relaxed)) {
+                if (!LineGraphUpdateQueuePush(&queue, &update)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto _ : state) {
+        for (size_t poppedCount = 0; poppedCount < 4096;) {
+            size_t count = LineGraphUpdateQueuePopBatch(&queue, updates, LineGraphUpdateQueueBenchmarkCapacity);
+
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+
+            poppedCount += count;
+        }
+    }
+
+    isRunning = false;
+
+    for (int i = 0; i < producerCount; i++) {
+        producers[i].join();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 4096);
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+/** Merging a full queue of appends spread over a few plots, as resolveAppendOperations then sees them */
+static void LineGraphUpdatesMergeFrame(benchmark::State &state) {
+    LineGraphUpdate source[LineGraphUpdateQueueBenchmarkCapacity];
+    LineGraphUpdate updates[LineGraphUpdateQueueBenchmarkCapacity];
+    size_t mergedCount = 0;
+
+    // Runs of appends to the same plot, interleaved with an insert now and then
+    for (size_t i = 0; i < LineGraphUpdateQueueBenchmarkCapacity; i++) {
+        LineGraphUpdate update = { kLineGraphUpdateAppend, (uint32_t)(i / 16 % 3), 0, 1 };
+
+        if (i % 100 == 99) {
+            update.type = kLineGraphUpdateInsert;
+            update.row = (int64_t)i;
+        }
+
+        source[i] = update;
+    }
+
+    for (auto _ : state) {
+        std::copy(source, source + LineGraphUpdateQueueBenchmarkCapacity, updates);
+        mergedCount = LineGraphUpdatesMerge(updates, LineGraphUpdateQueueBenchmarkCapacity);
+        benchmark::DoNotOptimize(updates);
+    }
+
+    state.SetItemsProcessed(state.iterations() * LineGraphUpdateQueueBenchmarkCapacity);
+    state.counters["merged"] = (double)mergedCount;
+}
+
+BENCHMARK(LineGraphUpdateQueuePushPop)->Arg(1)->Arg(16)->Arg(1024);
+BENCHMARK(LineGraphUpdateQueueProducers)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(LineGraphUpdatesMergeFrame);
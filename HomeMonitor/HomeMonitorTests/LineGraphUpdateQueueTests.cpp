@@ -0,0 +1,369 @@
+//
+//  LineGraphUpdateQueueTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "LineGraphUpdateQueue.h"
+}
+
+namespace {
+
+/** Rows of every plot, original rows by their index before the updates and inserted ones as -1 */
+typedef std::vector<std::vector<int64_t>> Plots;
+
+Plots OriginalPlots(const std::vector<int64_t> &pointCounts) {
+    Plots plots;
+
+    for (int64_t pointCount : pointCounts) {
+        std::vector<int64_t> rows;
+
+        for (int64_t row = 0; row < pointCount; row++) {
+            rows.push_back(row);
+        }
+
+        plots.push_back(rows);
+    }
+
+    return plots;
+}
+
+int64_t PointCount(void *context, uint32_t plot) {
+    const std::vector<int64_t> *pointCounts = static_cast<const std::vector<int64_t> *>(context);
+
+    return (plot < pointCounts->size()) ? (*pointCounts)[plot] : 0;
+}
+
+/** Applies the updates one after another, the way they were pushed */
+Plots ApplyInOrder(Plots plots, const std::vector<LineGraphUpdate> &updates) {
+    for (const LineGraphUpdate &update : updates) {
+        std::vector<int64_t> &rows = plots[update.plot];
+
+        switch (update.type) {
+            case kLineGraphUpdateInsert:
+                rows.insert(rows.begin() + update.row, (size_t)update.count, -1);
+                break;
+
+            case kLineGraphUpdateDelete:
+                rows.erase(rows.begin() + update.row, rows.begin() + update.row + update.count);
+                break;
+
+            case kLineGraphUpdateAppend:
+                rows.insert(rows.end(), (size_t)update.count, -1);
+                break;
+        }
+    }
+
+    return plots;
+}
+
+/** Applies a rebased batch the way an update block does, deletes before the batch and then inserts after it */
+Plots ApplyAsBatch(Plots plots, const LineGraphUpdate *batch, size_t count) {
+    const int64_t deleted = -2;
+
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i].type == kLineGraphUpdateDelete) {
+            std::vector<int64_t> &rows = plots[batch[i].plot];
+
+            EXPECT_LE(batch[i].row + batch[i].count, (int64_t)rows.size());
+
+            for (int64_t row = batch[i].row; row < batch[i].row + batch[i].count; row++) {
+                EXPECT_NE(deleted, rows[row]) << "row " << row << " deleted twice";
+                rows[row] = deleted;
+            }
+        }
+    }
+
+    for (std::vector<int64_t> &rows : plots) {
+        rows.erase(std::remove(rows.begin(), rows.end(), deleted), rows.end());
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (batch[i].type == kLineGraphUpdateInsert) {
+            std::vector<int64_t> &rows = plots[batch[i].plot];
+
+            EXPECT_LE(batch[i].row, (int64_t)rows.size());
+            rows.insert(rows.begin() + batch[i].row, (size_t)batch[i].count, -1);
+        } else {
+            EXPECT_EQ(kLineGraphUpdateDelete, batch[i].type);
+        }
+    }
+
+    return plots;
+}
+
+}
+
+TEST(LineGraphUpdateQueue, PopsInPushOrder) {
+    LineGraphUpdateQueue queue;
+    LineGraphUpdate updates[8];
+
+    ASSERT_TRUE(LineGraphUpdateQueueInit(&queue, 5));
+
+    // Capacity rounds up to a power of two
+    EXPECT_EQ(7u, queue.mask);
+
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 6; i++) {
+            LineGraphUpdate update = { kLineGraphUpdateInsert, 1, lap * 10 + i, 1 };
+            ASSERT_TRUE(LineGraphUpdateQueuePush(&queue, &update));
+        }
+
+        ASSERT_EQ(4u, LineGraphUpdateQueuePopBatch(&queue, updates, 4));
+        ASSERT_EQ(2u, LineGraphUpdateQueuePopBatch(&queue, updates + 4, 8));
+        ASSERT_EQ(0u, LineGraphUpdateQueuePopBatch(&queue, updates, 8));
+
+        for (int i = 0; i < 6; i++) {
+            EXPECT_EQ(lap * 10 + i, updates[i].row);
+        }
+    }
+
+    EXPECT_FALSE(LineGraphUpdateQueueTakeOverflow(&queue));
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+TEST(LineGraphUpdateQueue, FullQueueMarksOverflow) {
+    LineGraphUpdateQueue queue;
+    LineGraphUpdate update = { kLineGraphUpdateAppend, 0, 0, 1 };
+    LineGraphUpdate updates[4];
+
+    ASSERT_TRUE(LineGraphUpdateQueueInit(&queue, 4));
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(LineGraphUpdateQueuePush(&queue, &update));
+    }
+
+    EXPECT_FALSE(LineGraphUpdateQueuePush(&queue, &update));
+    EXPECT_TRUE(LineGraphUpdateQueueTakeOverflow(&queue));
+    EXPECT_FALSE(LineGraphUpdateQueueTakeOverflow(&queue));
+
+    EXPECT_EQ(4u, LineGraphUpdateQueuePopBatch(&queue, updates, 4));
+    EXPECT_TRUE(LineGraphUpdateQueuePush(&queue, &update));
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+TEST(LineGraphUpdateQueue, ScheduleIsClaimedOnceUntilReleased) {
+    LineGraphUpdateQueue queue;
+    LineGraphUpdate update = { kLineGraphUpdateAppend, 0, 0, 1 };
+    LineGraphUpdate updates[4];
+
+    ASSERT_TRUE(LineGraphUpdateQueueInit(&queue, 4));
+
+    EXPECT_TRUE(LineGraphUpdateQueueClaimSchedule(&queue));
+    EXPECT_FALSE(LineGraphUpdateQueueClaimSchedule(&queue));
+
+    // An empty queue is released
+    EXPECT_FALSE(LineGraphUpdateQueueReleaseSchedule(&queue));
+    EXPECT_TRUE(LineGraphUpdateQueueClaimSchedule(&queue));
+
+    // An update pushed while scheduled keeps the consumer draining
+    ASSERT_TRUE(LineGraphUpdateQueuePush(&queue, &update));
+    EXPECT_FALSE(LineGraphUpdateQueueClaimSchedule(&queue));
+    EXPECT_TRUE(LineGraphUpdateQueueReleaseSchedule(&queue));
+
+    EXPECT_EQ(1u, LineGraphUpdateQueuePopBatch(&queue, updates, 4));
+    EXPECT_FALSE(LineGraphUpdateQueueReleaseSchedule(&queue));
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+TEST(LineGraphUpdateQueue, KeepsEachProducersOrder) {
+    const int producerCount = 4;
+    const int64_t updateCount = 200000;
+    LineGraphUpdateQueue queue;
+
+    ASSERT_TRUE(LineGraphUpdateQueueInit(&queue, 1000));
+
+    std::vector<std::thread> producers;
+
+    for (int producer = 0; producer < producerCount; producer++) {
+        producers.emplace_back([&queue, producer, updateCount] {
+            for (int64_t i = 0; i < updateCount; i++) {
+                LineGraphUpdate update = { kLineGraphUpdateAppend, (uint32_t)producer, i, 1 };
+
+                while (!LineGraphUpdateQueuePush(&queue, &update)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int64_t> nextRows(producerCount, 0);
+    int64_t poppedCount = 0;
+    LineGraphUpdate updates[64];
+
+    while (poppedCount < producerCount * updateCount) {
+        size_t count = LineGraphUpdateQueuePopBatch(&queue, updates, 64);
+
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(nextRows[updates[i].plot], updates[i].row);
+            nextRows[updates[i].plot] += 1;
+        }
+
+        poppedCount += (int64_t)count;
+    }
+
+    for (std::thread &producer : producers) {
+        producer.join();
+    }
+
+    EXPECT_EQ(0u, LineGraphUpdateQueuePopBatch(&queue, updates, 64));
+
+    LineGraphUpdateQueueDestroy(&queue);
+}
+
+TEST(LineGraphUpdateQueue, MergesNeighbouringUpdates) {
+    LineGraphUpdate updates[] = {
+        { kLineGraphUpdateAppend, 0, 0, 1 },
+        { kLineGraphUpdateAppend, 0, 0, 2 },
+        // Inserted within and right after the block
+        { kLineGraphUpdateInsert, 0, 5, 2 },
+        { kLineGraphUpdateInsert, 0, 7, 1 },
+        { kLineGraphUpdateInsert, 0, 5, 1 },
+        // Another plot starts a new update
+        { kLineGraphUpdateInsert, 1, 5, 1 },
+        // Deleted at the same row, then right before it
+        { kLineGraphUpdateDelete, 1, 3, 2 },
+        { kLineGraphUpdateDelete, 1, 3, 1 },
+        { kLineGraphUpdateDelete, 1, 1, 2 },
+        // Not adjacent to the block
+        { kLineGraphUpdateDelete, 1, 10, 1 },
+        { kLineGraphUpdateAppend, 0, 0, 4 }
+    };
+
+    ASSERT_EQ(6u, LineGraphUpdatesMerge(updates, 11));
+
+    EXPECT_EQ(kLineGraphUpdateAppend, updates[0].type);
+    EXPECT_EQ(3, updates[0].count);
+    EXPECT_EQ(kLineGraphUpdateInsert, updates[1].type);
+    EXPECT_EQ(5, updates[1].row);
+    EXPECT_EQ(4, updates[1].count);
+    EXPECT_EQ(1u, updates[2].plot);
+    EXPECT_EQ(kLineGraphUpdateDelete, updates[3].type);
+    EXPECT_EQ(1, updates[3].row);
+    EXPECT_EQ(5, updates[3].count);
+    EXPECT_EQ(10, updates[4].row);
+    EXPECT_EQ(4, updates[5].count);
+
+    EXPECT_EQ(0u, LineGraphUpdatesMerge(updates, 0));
+}
+
+TEST(LineGraphUpdateQueue, RebasesInterleavedInsertsAndDeletes) {
+    std::vector<int64_t> pointCounts = { 20, 10 };
+    std::vector<LineGraphUpdate> updates = {
+        // A window sliding by a point twice, each update in the rows the one before left
+        { kLineGraphUpdateDelete, 0, 0, 1 },
+        { kLineGraphUpdateInsert, 0, 19, 1 },
+        { kLineGraphUpdateDelete, 0, 0, 1 },
+        { kLineGraphUpdateInsert, 0, 19, 1 },
+        // The second insert moves the first one along
+        { kLineGraphUpdateInsert, 1, 5, 1 },
+        { kLineGraphUpdateInsert, 1, 2, 1 }
+    };
+    LineGraphUpdate batch[6];
+    size_t batchCount;
+
+    ASSERT_TRUE(LineGraphUpdatesRebase(updates.data(), updates.size(), PointCount, &pointCounts, batch, &batchCount));
+    ASSERT_EQ(4u, batchCount);
+
+    EXPECT_EQ(kLineGraphUpdateDelete, batch[0].type);
+    EXPECT_EQ(0u, batch[0].plot);
+    EXPECT_EQ(0, batch[0].row);
+    EXPECT_EQ(2, batch[0].count);
+
+    EXPECT_EQ(kLineGraphUpdateInsert, batch[1].type);
+    EXPECT_EQ(0u, batch[1].plot);
+    EXPECT_EQ(18, batch[1].row);
+    EXPECT_EQ(2, batch[1].count);
+
+    EXPECT_EQ(1u, batch[2].plot);
+    EXPECT_EQ(2, batch[2].row);
+    EXPECT_EQ(1, batch[2].count);
+    EXPECT_EQ(1u, batch[3].plot);
+    EXPECT_EQ(6, batch[3].row);
+
+    // Rows inserted and deleted again within the batch drop out, appends land at the end
+    updates = {
+        { kLineGraphUpdateAppend, 1, 0, 3 },
+        { kLineGraphUpdateDelete, 1, 9, 2 },
+        { kLineGraphUpdateInsert, 1, 0, 1 }
+    };
+
+    ASSERT_TRUE(LineGraphUpdatesRebase(updates.data(), updates.size(), PointCount, &pointCounts, batch, &batchCount));
+    ASSERT_EQ(3u, batchCount);
+    EXPECT_EQ(kLineGraphUpdateDelete, batch[0].type);
+    EXPECT_EQ(9, batch[0].row);
+    EXPECT_EQ(1, batch[0].count);
+    EXPECT_EQ(0, batch[1].row);
+    EXPECT_EQ(10, batch[2].row);
+    EXPECT_EQ(2, batch[2].count);
+    EXPECT_TRUE(ApplyInOrder(OriginalPlots(pointCounts), updates) == ApplyAsBatch(OriginalPlots(pointCounts), batch, batchCount));
+}
+
+TEST(LineGraphUpdateQueue, RebasedBatchEndsLikeTheUpdatesInOrder) {
+    std::mt19937 random(5);
+
+    for (int run = 0; run < 2000; run++) {
+        std::vector<int64_t> pointCounts = { (int64_t)(random() % 12), (int64_t)(random() % 12) };
+        std::vector<int64_t> lengths = pointCounts;
+        std::vector<LineGraphUpdate> updates;
+
+        for (size_t i = 0, count = random() % 12; i < count; i++) {
+            uint32_t plot = random() % 2;
+            uint32_t type = random() % 3;
+            int64_t &length = lengths[plot];
+
+            if (type == kLineGraphUpdateDelete && length > 0) {
+                int64_t row = random() % length;
+                int64_t deleteCount = 1 + random() % (length - row);
+
+                updates.push_back({ type, plot, row, deleteCount });
+                length -= deleteCount;
+            } else if (type != kLineGraphUpdateDelete) {
+                int64_t insertCount = 1 + random() % 3;
+
+                updates.push_back({ type, plot, (type == kLineGraphUpdateInsert) ? (int64_t)(random() % (length + 1)) : 0, insertCount });
+                length += insertCount;
+            }
+        }
+
+        std::vector<LineGraphUpdate> batch(updates.size() + 1);
+        size_t batchCount;
+
+        ASSERT_TRUE(LineGraphUpdatesRebase(updates.data(), updates.size(), PointCount, &pointCounts, batch.data(), &batchCount));
+        ASSERT_LE(batchCount, updates.size());
+        ASSERT_TRUE(ApplyInOrder(OriginalPlots(pointCounts), updates) == ApplyAsBatch(OriginalPlots(pointCounts), batch.data(), batchCount)) << "run " << run;
+    }
+}
+
+TEST(LineGraphUpdateQueue, RebaseRefusesRowsPastTheEnd) {
+    std::vector<int64_t> pointCounts = { 5 };
+    LineGraphUpdate batch[2];
+    size_t batchCount;
+
+    LineGraphUpdate insert[] = { { kLineGraphUpdateDelete, 0, 0, 2 }, { kLineGraphUpdateInsert, 0, 4, 1 } };
+    LineGraphUpdate remove[] = { { kLineGraphUpdateAppend, 0, 0, 1 }, { kLineGraphUpdateDelete, 0, 5, 2 } };
+    LineGraphUpdate otherPlot[] = { { kLineGraphUpdateDelete, 1, 0, 1 } };
+
+    EXPECT_FALSE(LineGraphUpdatesRebase(insert, 2, PointCount, &pointCounts, batch, &batchCount));
+    EXPECT_FALSE(LineGraphUpdatesRebase(remove, 2, PointCount, &pointCounts, batch, &batchCount));
+    EXPECT_FALSE(LineGraphUpdatesRebase(otherPlot, 1, PointCount, &pointCounts, batch, &batchCount));
+
+    EXPECT_TRUE(LineGraphUpdatesRebase(insert, 1, PointCount, &pointCounts, batch, &batchCount));
+    EXPECT_EQ(1u, batchCount);
+}
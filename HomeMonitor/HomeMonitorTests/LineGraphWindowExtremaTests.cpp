@@ -0,0 +1,80 @@
+//
+//  LineGraphWindowExtremaTests.cpp
+//  HomeMonitor
+//
+//  Copyright (c) 2014 Hipo. All rights reserved.
+//
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "HMOTestAllocator.h"
+
+extern "C" {
+#include "LineGraphWindowExtrema.h"
+}
+
+TEST(LineGraphWindowExtrema, MatchesAScanOfTheWindow) {
+    LineGraphWindowExtrema extrema;
+    std::mt19937 random(1);
+    std::vector<double> ys;
+
+    LineGraphWindowExtremaInit(&extrema);
+
+    for (int i = 0; i < 20000; i++) {
+        ys.push_back((double)(random() % 1000));
+        ASSERT_TRUE(LineGraphWindowExtremaPush(&extrema, i, ys.back()));
+
+        // Window widths change as it slides, including down to a single point
+        int width = 1 + (i / 500) % 50;
+        int first = std::max(0, i - width + 1);
+
+        LineGraphWindowExtremaEvictBefore(&extrema, first);
+
+        ASSERT_EQ(*std::min_element(ys.begin() + first, ys.end()), LineGraphWindowExtremaMin(&extrema));
+        ASSERT_EQ(*std::max_element(ys.begin() + first, ys.end()), LineGraphWindowExtremaMax(&extrema));
+    }
+
+    LineGraphWindowExtremaEvictBefore(&extrema, 20000);
+    EXPECT_TRUE(LineGraphWindowExtremaIsEmpty(&extrema));
+
+    LineGraphWindowExtremaDestroy(&extrema);
+}
+
+TEST(LineGraphWindowExtrema, FailedPushLeavesBothDequesUnchanged) {
+    LineGraphWindowExtrema extrema;
+
+    LineGraphWindowExtremaInit(&extrema);
+
+    // Falling values fill the maximum deque, while the minimum deque only keeps the last one
+    for (int i = 0; i < 16; i++) {
+        ASSERT_TRUE(LineGraphWindowExtremaPush(&extrema, i, 100 - i));
+    }
+
+    ASSERT_EQ(extrema.maximums.capacity, extrema.maximums.count);
+
+    {
+        HMOTestAllocationFailure failure(0);
+
+        // Fits the minimum deque, but the maximum deque has to grow
+        EXPECT_FALSE(LineGraphWindowExtremaPush(&extrema, 16, 0));
+    }
+
+    EXPECT_EQ(15, extrema.lastX);
+    EXPECT_EQ(1u, extrema.minimums.count);
+    EXPECT_EQ(16u, extrema.maximums.count);
+    EXPECT_EQ(85, LineGraphWindowExtremaMin(&extrema));
+    EXPECT_EQ(100, LineGraphWindowExtremaMax(&extrema));
+
+    // Once memory is back the same push goes through, and eviction keeps both deques in step
+    ASSERT_TRUE(LineGraphWindowExtremaPush(&extrema, 16, 0));
+    LineGraphWindowExtremaEvictBefore(&extrema, 10);
+
+    EXPECT_EQ(0, LineGraphWindowExtremaMin(&extrema));
+    EXPECT_EQ(90, LineGraphWindowExtremaMax(&extrema));
+
+    LineGraphWindowExtremaDestroy(&extrema);
+}